@@ -23,6 +23,8 @@
 
 import re
 import os
+import json
+import time
 import sys
 
 # Add parent directory to the system path for module imports
@@ -42,7 +44,7 @@ class hdmiCECClass():
     HDMI CEC (Consumer Electronics Control) operations in the test environment.
     """
 
-    def __init__(self, moduleConfigProfileFile:str, session=None,testSuite:str="L3 HDMICEC Functions", targetWorkspace:str="/tmp", copyArtifacts:bool=True):
+    def __init__(self, moduleConfigProfileFile:str, session=None,testSuite:str="L3 HDMICEC Functions", targetWorkspace:str="/tmp", copyArtifacts:bool=True, eventOutput:str=None, eventSession=None):
         """
         Initialize the HDMI CEC Class with configuration settings.
 
@@ -50,6 +52,10 @@ class hdmiCECClass():
             moduleConfigProfileFile (str): Path to the profile configuration file for the HDMI CEC module.
             session: Optional session object for managing interactions with the device.
             targetWorkspace (str, optional): Target workspace directory on the device. Defaults to "/tmp".
+            eventOutput (str, optional): JSON-lines event file passed to the test binary with "-j", relative to
+                                         targetWorkspace unless absolute. Defaults to None.
+            eventSession (optional): Second console session on the device, used by readEvents() to read the
+                                     event file while the test binary runs in session. Defaults to None.
 
         Returns:
             None
@@ -65,6 +71,12 @@ class hdmiCECClass():
         cecResponseFileOnTarget = os.path.join(targetWorkspace, cecResponseFile)
         self.testConfig    = ConfigRead(self.testConfigFile, self.moduleName)
         self.testConfig.test.execute = os.path.join(targetWorkspace, self.testConfig.test.execute) + f" -p {profileOnTarget}" + f" -p {cecResponseFileOnTarget}"
+        self.eventFile     = None
+        self.eventSession  = eventSession
+        self.eventLines    = 0
+        if eventOutput:
+            self.eventFile = os.path.join(targetWorkspace, eventOutput)
+            self.testConfig.test.execute += f" -j {self.eventFile}"
         self.utMenu        = UTSuiteNavigatorClass(self.testConfig, None, session)
         self.testSession   = session
         self.utils         = utBaseUtils()
@@ -257,12 +269,15 @@ class hdmiCECClass():
                 
         return status
 
-    def readCallbackDetails (self):
+    def readCallbackDetails (self, waitForOpcode:str=None, timeout:float=2.0, interval:float=0.1):
         """
         Parses the callback logs from the device.
 
         Args:
-            None.
+            waitForOpcode (str, optional): Keep reading until a frame with this opcode is received or the timeout expires.
+                                           Defaults to None, parsing what has been logged so far.
+            timeout (float, optional): Maximum time to wait in seconds. Defaults to 2.0.
+            interval (float, optional): Time between reads in seconds. Defaults to 0.1.
 
         Returns:
             dict: A dictionary with two keys:
@@ -278,6 +293,12 @@ class hdmiCECClass():
         result = {"Received": [], "Response": []}
 
         callbackLogs = self.testSession.read_all()
+        if waitForOpcode is not None:
+            expected = re.compile(r"Received Opcode: \[0x%02X\]" % int(str(waitForOpcode), 16), re.IGNORECASE)
+            start = time.monotonic()
+            while not expected.search(callbackLogs) and time.monotonic() - start < timeout:
+                time.sleep(interval)
+                callbackLogs += self.testSession.read_all()
 
         received_pattern = re.compile(
             r"Received Opcode: \[([^\]]+)\] \[([^\]]+)\] Initiator: \[([^\]]+)\], Destination: \[([^\]]+)\] Data: \[(.*?)\]"
@@ -312,6 +333,116 @@ class hdmiCECClass():
 
         return result
 
+    def runCecScript(self, commands:list):
+        """
+        Runs a list of script commands back to back through the "Run CEC Script" test.
+
+        Args:
+            commands (list): Script lines, e.g. ["add_la 4", "tx 0 8f", "wait 90 2000"].
+
+        Returns:
+            dict: A dictionary with two keys:
+                - "Commands": A list of dictionaries, one per command, with the keys
+                  "Line", "Command", "Detail", "Elapsed" (ms, float) and "Verdict" (bool).
+                - "Summary": A dictionary with the keys "Commands", "Passed", "Failed" and "Duration" (ms, float),
+                  or None if the summary was not found.
+        """
+        promptWithAnswers = [
+                {
+                    "query_type": "direct",
+                    "query": "Enter script path",
+                    "input": "-\n" + "\n".join(commands) + "\nend"
+                }
+        ]
+
+        output = self.utMenu.select( self.testSuite, "Run CEC Script", promptWithAnswers)
+
+        result = {"Commands": [], "Summary": None}
+
+        command_pattern = re.compile(
+            r"SCRIPT \[(\d+)\] cmd:\[(.*?)\] (.*) elapsed:\[([\d.]+) ms\] verdict:\[(PASS|FAIL)\]"
+        )
+        summary_pattern = re.compile(
+            r"SCRIPT SUMMARY commands:\[(\d+)\] passed:\[(\d+)\] failed:\[(\d+)\] duration:\[([\d.]+) ms\]"
+        )
+
+        for match in command_pattern.finditer(output):
+            line, command, detail, elapsed, verdict = match.groups()
+            result["Commands"].append({
+                "Line": int(line),
+                "Command": command,
+                "Detail": detail,
+                "Elapsed": float(elapsed),
+                "Verdict": verdict == "PASS"
+            })
+
+        match = summary_pattern.search(output)
+        if match:
+            commands, passed, failed, duration = match.groups()
+            result["Summary"] = {
+                "Commands": int(commands),
+                "Passed": int(passed),
+                "Failed": int(failed),
+                "Duration": float(duration)
+            }
+
+        return result
+
+    def readEvents(self, eventType:str=None, timeout:float=2.0, interval:float=0.1):
+        """
+        Reads the JSON-lines events written to the event file since the last read.
+
+        The file is read through eventSession, so the test binary output in session is left to readCallbackDetails().
+        Lines already returned are skipped, a line still being written is left for the next read.
+
+        Args:
+            eventType (str, optional): Only return events of this type, "hal_call", "rx_frame" or "tx_response".
+                                       Defaults to None, returning all events.
+            timeout (float, optional): Maximum time to wait for the file to be read in seconds. Defaults to 2.0.
+            interval (float, optional): Time between reads in seconds. Defaults to 0.1.
+
+        Returns:
+            list: Event dictionaries in the order they were emitted. Each has "ts_ns" (monotonic, int) and "event",
+                  plus the event specific fields, e.g. "api" and "status" for "hal_call",
+                  "initiator", "destination", "opcode", "len" and "data" for frames.
+                  Empty when eventOutput or eventSession was not given.
+        """
+        events = []
+
+        if self.eventFile is None or self.eventSession is None:
+            return events
+
+        # The quotes keep the echoed command line from matching the markers
+        self.eventSession.write(f'echo EVENTS_""BEGIN; tail -n +{self.eventLines + 1} {self.eventFile} 2>/dev/null; echo EVENTS_""END')
+        output = self.eventSession.read_all()
+        start = time.monotonic()
+        while "EVENTS_END" not in output and time.monotonic() - start < timeout:
+            time.sleep(interval)
+            output += self.eventSession.read_all()
+        if "EVENTS_BEGIN" not in output or "EVENTS_END" not in output:
+            return events
+
+        output = output.split("EVENTS_BEGIN", 1)[1].split("EVENTS_END", 1)[0]
+        lines = [line.strip() for line in output.splitlines() if line.strip()]
+        parsed = []
+        for line in lines:
+            try:
+                parsed.append(json.loads(line))
+            except ValueError:
+                parsed.append(None)
+
+        # A last line that does not parse is still being written, read it again next time
+        if parsed and parsed[-1] is None:
+            lines.pop()
+            parsed.pop()
+        self.eventLines += len(lines)
+
+        for event in parsed:
+            if event is not None and (eventType is None or event.get("event") == eventType):
+                events.append(event)
+
+        return events
+
     def getDeviceType(self):
         """
         Retrieves the type of dut.
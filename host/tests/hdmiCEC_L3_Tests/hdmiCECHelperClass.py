@@ -23,6 +23,7 @@
 
 import os
 import sys
+import time
 
 dir_path = os.path.dirname(os.path.realpath(__file__))
 sys.path.append(os.path.join(dir_path, "../../"))
@@ -96,6 +97,30 @@ class hdmiCECHelperClass(utHelperClass):
 
         return True
 
+    def waitForMessageReceived(self, sourceLogicalAddress:str, destinationLogicalAddress:str, cecOpcode:str, payload:list=None, timeout:float=2.0, interval:float=0.1):
+        """
+        Polls the CEC controller until the message is seen or the timeout expires.
+
+        Args:
+            sourceLogicalAddress (str): Expected initiator.
+            destinationLogicalAddress (str): Expected destination.
+            cecOpcode (str): Expected opcode.
+            payload (list, optional): Expected payload. Defaults to None.
+            timeout (float, optional): Maximum time to wait in seconds. Defaults to 2.0.
+            interval (float, optional): Time between polls in seconds. Defaults to 0.1.
+
+        Returns:
+            bool: True if the message was received.
+        """
+        start = time.monotonic()
+        while True:
+            if self.hdmiCECController.checkMessageReceived(sourceLogicalAddress, destinationLogicalAddress, cecOpcode, payload=payload):
+                self.log.info(f'Message {cecOpcode} received after {time.monotonic() - start:.3f}s')
+                return True
+            if time.monotonic() - start >= timeout:
+                return False
+            time.sleep(interval)
+
     def testEndFunction(self, powerOff=True):
 
         super().testEndFunction(powerOff)
@@ -23,7 +23,6 @@
 
 import os
 import sys
-import time
 
 # Append the current and parent directory paths to sys.path for module imports
 dir_path = os.path.dirname(os.path.realpath(__file__))
@@ -124,11 +123,9 @@ class hdmiCEC_test01_TransmitCECCommands(hdmiCECHelperClass):
 
                 finalResult &= txResults
 
-                time.sleep(2)
-
                 self.log.stepStart(f'HdmiCecTx Receive Source: {deviceLogicalAddress} Destination: {destinationLogicalAddress} CEC OPCode: {cec} Payload: {payload}')
                 # Validate the transmission
-                rxResult = self.hdmiCECController.checkMessageReceived(deviceLogicalAddress, destinationLogicalAddress, cec, payload=payload)
+                rxResult = self.waitForMessageReceived(deviceLogicalAddress, destinationLogicalAddress, cec, payload=payload)
 
                 self.log.stepResult(rxResult, f'HdmiCecTx Receive Source: {deviceLogicalAddress} Destination: {destinationLogicalAddress} CEC OPCode: {cec} Payload: {payload}')
 
@@ -145,7 +145,7 @@ class hdmiCEC_test02_ReceiveCECCommands(hdmiCECHelperClass):
                 self.hdmiCECController.sendMessage(cecAdapterLogicalAddress, destinationLogicalAddress, cecOpcode, payload)
 
                 # Read the callback details and verify the received data
-                callbackData = self.testhdmiCEC.readCallbackDetails()
+                callbackData = self.testhdmiCEC.readCallbackDetails(waitForOpcode=cecOpcode)
                 result = self.testVerifyReceivedData(callbackData, cecAdapterLogicalAddress, destinationLogicalAddress, cecOpcode, payload)
 
                 finalResult &= result
@@ -0,0 +1,528 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file hdmiCecProfileShim.c
+ *
+ * LD_PRELOAD shim profiling the HdmiCec* calls made by the middleware, for soak tests on the device.
+ *
+ * For every API, and for the time spent in the Rx and Tx callbacks, the shim keeps the call count,
+ * the failed calls, the mean and max latency and a latency histogram. It also tracks how many HAL
+ * calls are in flight at once: the highest concurrency per API, the calls that started while
+ * another call was in progress, and a histogram of the concurrency seen by each call.
+ *
+ * The counters are updated with relaxed atomics and nothing is allocated or locked on the call path,
+ * so the cost per call is two clock reads and a handful of atomic adds.
+ *
+ * The summary is written at exit and on SIGUSR1, to $HDMICEC_PROFILE_PATH (appended) or to stderr.
+ * The SIGUSR1 handler is only installed when the process has not installed its own.
+ *
+ * Usage: LD_PRELOAD=libhdmiCecProfile.so <middleware>, then kill -USR1 <pid> for a summary
+ */
+
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "hdmiCecShim.h"
+
+#define PROFILE_PATH_ENV            "HDMICEC_PROFILE_PATH"
+
+/* Histogram bucket i counts durations in [2^(i-1), 2^i) microseconds, bucket 0 is < 1us */
+#define PROFILE_HISTOGRAM_BUCKETS   24
+
+/* Concurrency histogram slot i counts calls that found i other calls in flight, the last slot counts the rest */
+#define PROFILE_CONCURRENCY_SLOTS   8
+
+typedef enum
+{
+  PROFILE_OPEN = 0,
+  PROFILE_CLOSE,
+  PROFILE_SET_LOGICAL_ADDRESS,
+  PROFILE_GET_PHYSICAL_ADDRESS,
+  PROFILE_ADD_LOGICAL_ADDRESS,
+  PROFILE_REMOVE_LOGICAL_ADDRESS,
+  PROFILE_GET_LOGICAL_ADDRESS,
+  PROFILE_SET_RX_CALLBACK,
+  PROFILE_SET_TX_CALLBACK,
+  PROFILE_TX,
+  PROFILE_TX_ASYNC,
+  PROFILE_RX_CALLBACK,
+  PROFILE_TX_CALLBACK,
+  PROFILE_MAX
+} profile_slot_t;
+
+typedef struct
+{
+  uint64_t count;
+  uint64_t errors;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint64_t contended;
+  uint32_t inflight;
+  uint32_t max_inflight;
+  uint64_t histogram[PROFILE_HISTOGRAM_BUCKETS];
+} profile_stats_t;
+
+typedef struct
+{
+  HdmiCecRxCallback_t callback;
+  void *data;
+} ProfileRxClient_t;
+
+typedef struct
+{
+  HdmiCecTxCallback_t callback;
+  void *data;
+} ProfileTxClient_t;
+
+static const char *gSlotNames[PROFILE_MAX] =
+{
+  "HdmiCecOpen", "HdmiCecClose", "HdmiCecSetLogicalAddress", "HdmiCecGetPhysicalAddress",
+  "HdmiCecAddLogicalAddress", "HdmiCecRemoveLogicalAddress", "HdmiCecGetLogicalAddress",
+  "HdmiCecSetRxCallback", "HdmiCecSetTxCallback", "HdmiCecTx", "HdmiCecTxAsync",
+  "Rx callback", "Tx callback"
+};
+
+static profile_stats_t gStats[PROFILE_MAX];
+static uint32_t gInflight;
+static uint32_t gMaxInflight;
+static uint64_t gConcurrency[PROFILE_CONCURRENCY_SLOTS];
+static uint64_t gStartNs;
+
+static ProfileRxClient_t gRxClient;
+static ProfileTxClient_t gTxClient;
+static pthread_mutex_t gClientMutex = PTHREAD_MUTEX_INITIALIZER;  //Keeps each callback and its data together
+
+static sem_t gDumpRequest;
+static pthread_t gDumpThread;
+static pthread_mutex_t gDumpMutex = PTHREAD_MUTEX_INITIALIZER;
+
+SHIM_DECLARE_REAL(HdmiCecOpen);
+SHIM_DECLARE_REAL(HdmiCecClose);
+SHIM_DECLARE_REAL(HdmiCecSetLogicalAddress);
+SHIM_DECLARE_REAL(HdmiCecGetPhysicalAddress);
+SHIM_DECLARE_REAL(HdmiCecAddLogicalAddress);
+SHIM_DECLARE_REAL(HdmiCecRemoveLogicalAddress);
+SHIM_DECLARE_REAL(HdmiCecGetLogicalAddress);
+SHIM_DECLARE_REAL(HdmiCecSetRxCallback);
+SHIM_DECLARE_REAL(HdmiCecSetTxCallback);
+SHIM_DECLARE_REAL(HdmiCecTx);
+SHIM_DECLARE_REAL(HdmiCecTxAsync);
+
+static void AtomicMax32(uint32_t *target, uint32_t value)
+{
+  uint32_t current = __atomic_load_n(target, __ATOMIC_RELAXED);
+
+  while(value > current && !__atomic_compare_exchange_n(target, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+  {
+  }
+}
+
+static void AtomicMax64(uint64_t *target, uint64_t value)
+{
+  uint64_t current = __atomic_load_n(target, __ATOMIC_RELAXED);
+
+  while(value > current && !__atomic_compare_exchange_n(target, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+  {
+  }
+}
+
+static uint32_t HistogramBucket(uint64_t duration_ns)
+{
+  uint64_t us = duration_ns / 1000;
+  uint32_t bucket = (us == 0) ? 0 : (uint32_t)(64 - __builtin_clzll(us));
+
+  return (bucket < PROFILE_HISTOGRAM_BUCKETS) ? bucket : PROFILE_HISTOGRAM_BUCKETS - 1;
+}
+
+/* Counts a call in flight, returns its start time. Callbacks are not HAL calls, the HAL thread
+ * running them is already inside the HAL, they only count towards their own concurrency */
+static uint64_t ProfileEnter(profile_slot_t slot)
+{
+  profile_stats_t *stats = &gStats[slot];
+  uint32_t inflight = __atomic_add_fetch(&stats->inflight, 1, __ATOMIC_RELAXED);
+
+  AtomicMax32(&stats->max_inflight, inflight);
+  if(slot < PROFILE_RX_CALLBACK)
+  {
+    uint32_t others = __atomic_fetch_add(&gInflight, 1, __ATOMIC_RELAXED);
+
+    AtomicMax32(&gMaxInflight, others + 1);
+    __atomic_fetch_add(&gConcurrency[(others < PROFILE_CONCURRENCY_SLOTS) ? others : PROFILE_CONCURRENCY_SLOTS - 1], 1, __ATOMIC_RELAXED);
+    if(others != 0)
+    {
+      __atomic_fetch_add(&stats->contended, 1, __ATOMIC_RELAXED);
+    }
+  }
+  return ShimNowNs();
+}
+
+static void ProfileExit(profile_slot_t slot, uint64_t start, HDMI_CEC_STATUS status)
+{
+  profile_stats_t *stats = &gStats[slot];
+  uint64_t duration = ShimNowNs() - start;
+
+  __atomic_fetch_add(&stats->count, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&stats->total_ns, duration, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&stats->histogram[HistogramBucket(duration)], 1, __ATOMIC_RELAXED);
+  AtomicMax64(&stats->max_ns, duration);
+  if(status != HDMI_CEC_IO_SUCCESS)
+  {
+    __atomic_fetch_add(&stats->errors, 1, __ATOMIC_RELAXED);
+  }
+  __atomic_fetch_sub(&stats->inflight, 1, __ATOMIC_RELAXED);
+  if(slot < PROFILE_RX_CALLBACK)
+  {
+    __atomic_fetch_sub(&gInflight, 1, __ATOMIC_RELAXED);
+  }
+}
+
+static void PrintStats(FILE *out, profile_slot_t slot)
+{
+  profile_stats_t *stats = &gStats[slot];
+  uint64_t count = __atomic_load_n(&stats->count, __ATOMIC_RELAXED);
+  uint64_t total = __atomic_load_n(&stats->total_ns, __ATOMIC_RELAXED);
+
+  if(count == 0)
+  {
+    return;
+  }
+  if(slot < PROFILE_RX_CALLBACK)
+  {
+    fprintf(out, "%-28s count %llu, errors %llu, mean %llu us, max %llu us, max in flight %u, contended %llu\n",
+            gSlotNames[slot], (unsigned long long)count,
+            (unsigned long long)__atomic_load_n(&stats->errors, __ATOMIC_RELAXED),
+            (unsigned long long)(total / count / 1000),
+            (unsigned long long)(__atomic_load_n(&stats->max_ns, __ATOMIC_RELAXED) / 1000),
+            __atomic_load_n(&stats->max_inflight, __ATOMIC_RELAXED),
+            (unsigned long long)__atomic_load_n(&stats->contended, __ATOMIC_RELAXED));
+  }
+  else
+  {
+    fprintf(out, "%-28s count %llu, mean %llu us, max %llu us, max in flight %u\n",
+            gSlotNames[slot], (unsigned long long)count,
+            (unsigned long long)(total / count / 1000),
+            (unsigned long long)(__atomic_load_n(&stats->max_ns, __ATOMIC_RELAXED) / 1000),
+            __atomic_load_n(&stats->max_inflight, __ATOMIC_RELAXED));
+  }
+  for(int i = 0; i < PROFILE_HISTOGRAM_BUCKETS; i++)
+  {
+    uint64_t value = __atomic_load_n(&stats->histogram[i], __ATOMIC_RELAXED);
+    if(value == 0)
+    {
+      continue;
+    }
+    if(i == 0)
+    {
+      fprintf(out, "  %10s < %8u us : %llu\n", "", 1, (unsigned long long)value);
+    }
+    else
+    {
+      fprintf(out, "  %8u us - %8u us : %llu\n", 1U << (i - 1), 1U << i, (unsigned long long)value);
+    }
+  }
+}
+
+/* The counters keep moving while they are printed, each line is consistent on its own */
+static void ProfileDump(const char *reason)
+{
+  const char *path = getenv(PROFILE_PATH_ENV);
+  FILE *out = stderr;
+
+  pthread_mutex_lock(&gDumpMutex);
+  if(path != NULL && path[0] != '\0')
+  {
+    out = fopen(path, "a");
+    if(out == NULL)
+    {
+      out = stderr;
+    }
+  }
+
+  fprintf(out, ">>>>>>> >>>>> >>>> >> >> >\n");
+  fprintf(out, "HDMI CEC HAL profile (%s), pid %d, %llu s after start\n", reason, (int)getpid(),
+          (unsigned long long)((ShimNowNs() - gStartNs) / 1000000000ULL));
+  for(int slot = 0; slot < PROFILE_MAX; slot++)
+  {
+    PrintStats(out, (profile_slot_t)slot);
+  }
+  fprintf(out, "HAL calls in flight: max %u\n", __atomic_load_n(&gMaxInflight, __ATOMIC_RELAXED));
+  for(int i = 0; i < PROFILE_CONCURRENCY_SLOTS; i++)
+  {
+    uint64_t value = __atomic_load_n(&gConcurrency[i], __ATOMIC_RELAXED);
+    if(value != 0)
+    {
+      fprintf(out, "  %s%d other calls in flight : %llu\n", (i == PROFILE_CONCURRENCY_SLOTS - 1) ? ">=" : "  ", i, (unsigned long long)value);
+    }
+  }
+  fprintf(out, "=================================\n");
+
+  if(out != stderr)
+  {
+    fclose(out);
+  }
+  else
+  {
+    fflush(out);
+  }
+  pthread_mutex_unlock(&gDumpMutex);
+}
+
+/* Only sem_post() is async signal safe, the summary is written by the dump thread */
+static void ProfileSignalHandler(int signal)
+{
+  sem_post(&gDumpRequest);
+}
+
+static void* ProfileDumpThread(void *arg)
+{
+  while(true)
+  {
+    if(sem_wait(&gDumpRequest) == 0)
+    {
+      ProfileDump("SIGUSR1");
+    }
+  }
+  return NULL;
+}
+
+__attribute__((constructor)) static void ProfileInit(void)
+{
+  struct sigaction action;
+
+  gStartNs = ShimNowNs();
+  if(sigaction(SIGUSR1, NULL, &action) != 0 || action.sa_handler != SIG_DFL)
+  {
+    return;
+  }
+  if(sem_init(&gDumpRequest, 0, 0) != 0 || pthread_create(&gDumpThread, NULL, ProfileDumpThread, NULL) != 0)
+  {
+    fprintf(stderr, "hdmicec profile: no summary on SIGUSR1\n");
+    return;
+  }
+  pthread_detach(gDumpThread);
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = ProfileSignalHandler;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGUSR1, &action, NULL);
+}
+
+__attribute__((destructor)) static void ProfileFini(void)
+{
+  ProfileDump("exit");
+}
+
+static void ProfileRxCallback(int handle, void *callbackData, unsigned char *buf, int len)
+{
+  ProfileRxClient_t client;
+  uint64_t start = ProfileEnter(PROFILE_RX_CALLBACK);
+
+  (void)callbackData;
+  pthread_mutex_lock(&gClientMutex);
+  client = gRxClient;
+  pthread_mutex_unlock(&gClientMutex);
+  if(client.callback != NULL)
+  {
+    client.callback(handle, client.data, buf, len);
+  }
+  ProfileExit(PROFILE_RX_CALLBACK, start, HDMI_CEC_IO_SUCCESS);
+}
+
+static void ProfileTxCallback(int handle, void *callbackData, int result)
+{
+  ProfileTxClient_t client;
+  uint64_t start = ProfileEnter(PROFILE_TX_CALLBACK);
+
+  (void)callbackData;
+  pthread_mutex_lock(&gClientMutex);
+  client = gTxClient;
+  pthread_mutex_unlock(&gClientMutex);
+  if(client.callback != NULL)
+  {
+    client.callback(handle, client.data, result);
+  }
+  ProfileExit(PROFILE_TX_CALLBACK, start, HDMI_CEC_IO_SUCCESS);
+}
+
+HDMI_CEC_STATUS HdmiCecOpen(int* handle)
+{
+  uint64_t start = ProfileEnter(PROFILE_OPEN);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecOpen) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecOpen)(handle);
+  }
+  ProfileExit(PROFILE_OPEN, start, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecClose(int handle)
+{
+  uint64_t start = ProfileEnter(PROFILE_CLOSE);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecClose) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecClose)(handle);
+  }
+  ProfileExit(PROFILE_CLOSE, start, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecSetLogicalAddress(int handle, int* logicalAddresses, int num)
+{
+  uint64_t start = ProfileEnter(PROFILE_SET_LOGICAL_ADDRESS);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecSetLogicalAddress) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecSetLogicalAddress)(handle, logicalAddresses, num);
+  }
+  ProfileExit(PROFILE_SET_LOGICAL_ADDRESS, start, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecGetPhysicalAddress(int handle, unsigned int* physicalAddress)
+{
+  uint64_t start = ProfileEnter(PROFILE_GET_PHYSICAL_ADDRESS);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecGetPhysicalAddress) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecGetPhysicalAddress)(handle, physicalAddress);
+  }
+  ProfileExit(PROFILE_GET_PHYSICAL_ADDRESS, start, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecAddLogicalAddress(int handle, int logicalAddresses)
+{
+  uint64_t start = ProfileEnter(PROFILE_ADD_LOGICAL_ADDRESS);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecAddLogicalAddress) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecAddLogicalAddress)(handle, logicalAddresses);
+  }
+  ProfileExit(PROFILE_ADD_LOGICAL_ADDRESS, start, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecRemoveLogicalAddress(int handle, int logicalAddresses)
+{
+  uint64_t start = ProfileEnter(PROFILE_REMOVE_LOGICAL_ADDRESS);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecRemoveLogicalAddress) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecRemoveLogicalAddress)(handle, logicalAddresses);
+  }
+  ProfileExit(PROFILE_REMOVE_LOGICAL_ADDRESS, start, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecGetLogicalAddress(int handle, int* logicalAddress)
+{
+  uint64_t start = ProfileEnter(PROFILE_GET_LOGICAL_ADDRESS);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecGetLogicalAddress) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecGetLogicalAddress)(handle, logicalAddress);
+  }
+  ProfileExit(PROFILE_GET_LOGICAL_ADDRESS, start, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecSetRxCallback(int handle, HdmiCecRxCallback_t cbfunc, void* data)
+{
+  uint64_t start = ProfileEnter(PROFILE_SET_RX_CALLBACK);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  //The HAL keeps one callback, so does the shim
+  if(SHIM_REAL(HdmiCecSetRxCallback) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecSetRxCallback)(handle, (cbfunc != NULL) ? ProfileRxCallback : NULL, &gRxClient);
+  }
+  //A refused call leaves the current callback in place, as the HAL does
+  if(status == HDMI_CEC_IO_SUCCESS)
+  {
+    pthread_mutex_lock(&gClientMutex);
+    gRxClient.callback = cbfunc;
+    gRxClient.data = data;
+    pthread_mutex_unlock(&gClientMutex);
+  }
+  ProfileExit(PROFILE_SET_RX_CALLBACK, start, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecSetTxCallback(int handle, HdmiCecTxCallback_t cbfunc, void* data)
+{
+  uint64_t start = ProfileEnter(PROFILE_SET_TX_CALLBACK);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecSetTxCallback) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecSetTxCallback)(handle, (cbfunc != NULL) ? ProfileTxCallback : NULL, &gTxClient);
+  }
+  //A refused call leaves the current callback in place, as the HAL does
+  if(status == HDMI_CEC_IO_SUCCESS)
+  {
+    pthread_mutex_lock(&gClientMutex);
+    gTxClient.callback = cbfunc;
+    gTxClient.data = data;
+    pthread_mutex_unlock(&gClientMutex);
+  }
+  ProfileExit(PROFILE_SET_TX_CALLBACK, start, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecTx(int handle, const unsigned char* buf, int len, int* result)
+{
+  uint64_t start = ProfileEnter(PROFILE_TX);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecTx) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecTx)(handle, buf, len, result);
+  }
+  ProfileExit(PROFILE_TX, start, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecTxAsync(int handle, const unsigned char* buf, int len)
+{
+  uint64_t start = ProfileEnter(PROFILE_TX_ASYNC);
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecTxAsync) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecTxAsync)(handle, buf, len);
+  }
+  ProfileExit(PROFILE_TX_ASYNC, start, status);
+  return status;
+}
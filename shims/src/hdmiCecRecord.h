@@ -0,0 +1,78 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __HDMICECRECORD_H
+#define __HDMICECRECORD_H
+
+#include <stdint.h>
+
+/* API call log written by the record shim (libhdmiCecRecord.so) and read by hdmiCecReplay.
+ *
+ * The file is a header followed by fixed size records in native byte order, one per HAL call
+ * and one per callback invocation, in the order they completed. */
+
+#define HDMICEC_RECORD_MAGIC          "HCRC"
+#define HDMICEC_RECORD_VERSION        1
+#define HDMICEC_RECORD_PATH_ENV       "HDMICEC_RECORD_PATH"
+#define HDMICEC_RECORD_DEFAULT_PATH   "/tmp/hdmicec_api.rec"
+#define HDMICEC_RECORD_MAX_DATA       32
+
+typedef enum
+{
+  HDMICEC_RECORD_OPEN = 0,
+  HDMICEC_RECORD_CLOSE,
+  HDMICEC_RECORD_SET_LOGICAL_ADDRESS,
+  HDMICEC_RECORD_GET_PHYSICAL_ADDRESS,
+  HDMICEC_RECORD_ADD_LOGICAL_ADDRESS,
+  HDMICEC_RECORD_REMOVE_LOGICAL_ADDRESS,
+  HDMICEC_RECORD_GET_LOGICAL_ADDRESS,
+  HDMICEC_RECORD_SET_RX_CALLBACK,
+  HDMICEC_RECORD_SET_TX_CALLBACK,
+  HDMICEC_RECORD_TX,
+  HDMICEC_RECORD_TX_ASYNC,
+  HDMICEC_RECORD_RX_CALLBACK,
+  HDMICEC_RECORD_TX_CALLBACK,
+  HDMICEC_RECORD_MAX
+} hdmiCecRecord_event_t;
+
+typedef struct
+{
+  char magic[4];
+  uint32_t version;
+  uint64_t start_realtime_ns;         /* CLOCK_REALTIME when the log was opened */
+  uint32_t record_size;               /* sizeof(hdmiCecRecord_t) of the writer */
+  uint32_t reserved;
+} hdmiCecRecord_header_t;
+
+typedef struct
+{
+  uint64_t timestamp_ns;              /* Entry time, CLOCK_MONOTONIC ns since the log was opened */
+  uint64_t duration_ns;               /* Time spent in the call or in the callback */
+  uint32_t thread;                    /* Kernel thread id of the caller, or of the HAL thread for callbacks */
+  uint16_t event;                     /* hdmiCecRecord_event_t */
+  int16_t status;                     /* HDMI_CEC_STATUS returned, 0 for callbacks */
+  int32_t handle;
+  int32_t arg;                        /* Logical address, length of data, or 1 if a callback is set and 0 if it is cleared */
+  int32_t out;                        /* Value returned through a pointer (handle, address, Tx result), or the result of a Tx callback */
+  uint8_t len;                        /* Bytes used in data */
+  uint8_t reserved[3];
+  uint8_t data[HDMICEC_RECORD_MAX_DATA]; /* Frame of Tx, TxAsync and Rx callbacks, addresses of SetLogicalAddress */
+} hdmiCecRecord_t;
+
+#endif //__HDMICECRECORD_H
@@ -0,0 +1,417 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file hdmiCecRecordShim.c
+ *
+ * LD_PRELOAD shim recording every HdmiCec* call made by the middleware.
+ *
+ * Each call is forwarded to the real HAL and logged with its arguments, its return code, the value
+ * it returned through pointers, the calling thread and its entry time and duration. The Rx and Tx
+ * callbacks are wrapped so every invocation by the HAL is logged the same way. The log is written
+ * to $HDMICEC_RECORD_PATH (default /tmp/hdmicec_api.rec), see hdmiCecRecord.h for the format.
+ *
+ * The log is replayed with hdmiCecReplay.
+ *
+ * Usage: LD_PRELOAD=libhdmiCecRecord.so HDMICEC_RECORD_PATH=/tmp/boot.rec <middleware>
+ */
+
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "hdmiCecShim.h"
+#include "hdmiCecRecord.h"
+
+#define RECORD_FLUSH_INTERVAL_NS  (100ULL * 1000000ULL)
+
+typedef struct
+{
+  HdmiCecRxCallback_t callback;
+  void *data;
+} RecordRxClient_t;
+
+typedef struct
+{
+  HdmiCecTxCallback_t callback;
+  void *data;
+} RecordTxClient_t;
+
+static pthread_mutex_t gRecordMutex = PTHREAD_MUTEX_INITIALIZER;
+static FILE *gRecordFile = NULL;
+static uint64_t gRecordStartNs;
+static uint64_t gRecordLastFlushNs;
+static RecordRxClient_t gRxClient;
+static RecordTxClient_t gTxClient;
+static pthread_mutex_t gClientMutex = PTHREAD_MUTEX_INITIALIZER;  //Keeps each callback and its data together
+
+SHIM_DECLARE_REAL(HdmiCecOpen);
+SHIM_DECLARE_REAL(HdmiCecClose);
+SHIM_DECLARE_REAL(HdmiCecSetLogicalAddress);
+SHIM_DECLARE_REAL(HdmiCecGetPhysicalAddress);
+SHIM_DECLARE_REAL(HdmiCecAddLogicalAddress);
+SHIM_DECLARE_REAL(HdmiCecRemoveLogicalAddress);
+SHIM_DECLARE_REAL(HdmiCecGetLogicalAddress);
+SHIM_DECLARE_REAL(HdmiCecSetRxCallback);
+SHIM_DECLARE_REAL(HdmiCecSetTxCallback);
+SHIM_DECLARE_REAL(HdmiCecTx);
+SHIM_DECLARE_REAL(HdmiCecTxAsync);
+
+__attribute__((constructor)) static void RecordOpen(void)
+{
+  hdmiCecRecord_header_t header;
+  struct timespec ts;
+  const char *path = getenv(HDMICEC_RECORD_PATH_ENV);
+
+  if(path == NULL || path[0] == '\0')
+  {
+    path = HDMICEC_RECORD_DEFAULT_PATH;
+  }
+
+  gRecordFile = fopen(path, "wb");
+  if(gRecordFile == NULL)
+  {
+    fprintf(stderr, "hdmicec record: cannot open [%s], calls are not recorded\n", path);
+    return;
+  }
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, HDMICEC_RECORD_MAGIC, sizeof(header.magic));
+  header.version = HDMICEC_RECORD_VERSION;
+  header.start_realtime_ns = ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+  header.record_size = sizeof(hdmiCecRecord_t);
+  fwrite(&header, sizeof(header), 1, gRecordFile);
+
+  gRecordStartNs = ShimNowNs();
+  gRecordLastFlushNs = gRecordStartNs;
+}
+
+__attribute__((destructor)) static void RecordClose(void)
+{
+  pthread_mutex_lock(&gRecordMutex);
+  if(gRecordFile != NULL)
+  {
+    fclose(gRecordFile);
+    gRecordFile = NULL;
+  }
+  pthread_mutex_unlock(&gRecordMutex);
+}
+
+/* Fills in the fields common to every record */
+static void RecordInit(hdmiCecRecord_t *record, hdmiCecRecord_event_t event, int handle, uint64_t start_ns)
+{
+  memset(record, 0, sizeof(hdmiCecRecord_t));
+  record->timestamp_ns = start_ns - gRecordStartNs;
+  record->duration_ns = ShimNowNs() - start_ns;
+  record->thread = ShimThreadId();
+  record->event = (uint16_t)event;
+  record->handle = handle;
+}
+
+static void RecordData(hdmiCecRecord_t *record, const unsigned char *buf, int len)
+{
+  if(buf == NULL || len <= 0)
+  {
+    return;
+  }
+  record->len = (uint8_t)((len > HDMICEC_RECORD_MAX_DATA) ? HDMICEC_RECORD_MAX_DATA : len);
+  memcpy(record->data, buf, record->len);
+}
+
+static void RecordWrite(const hdmiCecRecord_t *record)
+{
+  pthread_mutex_lock(&gRecordMutex);
+  if(gRecordFile != NULL)
+  {
+    uint64_t now = ShimNowNs();
+    fwrite(record, sizeof(hdmiCecRecord_t), 1, gRecordFile);
+    //Keep the log usable if the process is killed
+    if(now - gRecordLastFlushNs >= RECORD_FLUSH_INTERVAL_NS)
+    {
+      fflush(gRecordFile);
+      gRecordLastFlushNs = now;
+    }
+  }
+  pthread_mutex_unlock(&gRecordMutex);
+}
+
+static void RecordRxCallback(int handle, void *callbackData, unsigned char *buf, int len)
+{
+  RecordRxClient_t client;
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+
+  (void)callbackData;
+  pthread_mutex_lock(&gClientMutex);
+  client = gRxClient;
+  pthread_mutex_unlock(&gClientMutex);
+  if(client.callback != NULL)
+  {
+    client.callback(handle, client.data, buf, len);
+  }
+  RecordInit(&record, HDMICEC_RECORD_RX_CALLBACK, handle, start);
+  record.arg = len;
+  RecordData(&record, buf, len);
+  RecordWrite(&record);
+}
+
+static void RecordTxCallback(int handle, void *callbackData, int result)
+{
+  RecordTxClient_t client;
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+
+  (void)callbackData;
+  pthread_mutex_lock(&gClientMutex);
+  client = gTxClient;
+  pthread_mutex_unlock(&gClientMutex);
+  if(client.callback != NULL)
+  {
+    client.callback(handle, client.data, result);
+  }
+  RecordInit(&record, HDMICEC_RECORD_TX_CALLBACK, handle, start);
+  record.out = result;
+  RecordWrite(&record);
+}
+
+HDMI_CEC_STATUS HdmiCecOpen(int* handle)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecOpen) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecOpen)(handle);
+  }
+  RecordInit(&record, HDMICEC_RECORD_OPEN, 0, start);
+  record.status = (int16_t)status;
+  if(status == HDMI_CEC_IO_SUCCESS && handle != NULL)
+  {
+    record.out = *handle;
+  }
+  RecordWrite(&record);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecClose(int handle)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecClose) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecClose)(handle);
+  }
+  RecordInit(&record, HDMICEC_RECORD_CLOSE, handle, start);
+  record.status = (int16_t)status;
+  RecordWrite(&record);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecSetLogicalAddress(int handle, int* logicalAddresses, int num)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecSetLogicalAddress) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecSetLogicalAddress)(handle, logicalAddresses, num);
+  }
+  RecordInit(&record, HDMICEC_RECORD_SET_LOGICAL_ADDRESS, handle, start);
+  record.status = (int16_t)status;
+  record.arg = num;
+  for(int i = 0; logicalAddresses != NULL && i < num && i < HDMICEC_RECORD_MAX_DATA; i++)
+  {
+    record.data[i] = (uint8_t)logicalAddresses[i];
+    record.len++;
+  }
+  RecordWrite(&record);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecGetPhysicalAddress(int handle, unsigned int* physicalAddress)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecGetPhysicalAddress) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecGetPhysicalAddress)(handle, physicalAddress);
+  }
+  RecordInit(&record, HDMICEC_RECORD_GET_PHYSICAL_ADDRESS, handle, start);
+  record.status = (int16_t)status;
+  if(status == HDMI_CEC_IO_SUCCESS && physicalAddress != NULL)
+  {
+    record.out = (int32_t)*physicalAddress;
+  }
+  RecordWrite(&record);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecAddLogicalAddress(int handle, int logicalAddresses)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecAddLogicalAddress) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecAddLogicalAddress)(handle, logicalAddresses);
+  }
+  RecordInit(&record, HDMICEC_RECORD_ADD_LOGICAL_ADDRESS, handle, start);
+  record.status = (int16_t)status;
+  record.arg = logicalAddresses;
+  RecordWrite(&record);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecRemoveLogicalAddress(int handle, int logicalAddresses)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecRemoveLogicalAddress) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecRemoveLogicalAddress)(handle, logicalAddresses);
+  }
+  RecordInit(&record, HDMICEC_RECORD_REMOVE_LOGICAL_ADDRESS, handle, start);
+  record.status = (int16_t)status;
+  record.arg = logicalAddresses;
+  RecordWrite(&record);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecGetLogicalAddress(int handle, int* logicalAddress)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecGetLogicalAddress) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecGetLogicalAddress)(handle, logicalAddress);
+  }
+  RecordInit(&record, HDMICEC_RECORD_GET_LOGICAL_ADDRESS, handle, start);
+  record.status = (int16_t)status;
+  if(status == HDMI_CEC_IO_SUCCESS && logicalAddress != NULL)
+  {
+    record.out = *logicalAddress;
+  }
+  RecordWrite(&record);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecSetRxCallback(int handle, HdmiCecRxCallback_t cbfunc, void* data)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  //The HAL keeps one callback, so does the shim
+  if(SHIM_REAL(HdmiCecSetRxCallback) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecSetRxCallback)(handle, (cbfunc != NULL) ? RecordRxCallback : NULL, &gRxClient);
+  }
+  //A refused call leaves the current callback in place, as the HAL does
+  if(status == HDMI_CEC_IO_SUCCESS)
+  {
+    pthread_mutex_lock(&gClientMutex);
+    gRxClient.callback = cbfunc;
+    gRxClient.data = data;
+    pthread_mutex_unlock(&gClientMutex);
+  }
+  RecordInit(&record, HDMICEC_RECORD_SET_RX_CALLBACK, handle, start);
+  record.status = (int16_t)status;
+  record.arg = (cbfunc != NULL);
+  RecordWrite(&record);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecSetTxCallback(int handle, HdmiCecTxCallback_t cbfunc, void* data)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecSetTxCallback) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecSetTxCallback)(handle, (cbfunc != NULL) ? RecordTxCallback : NULL, &gTxClient);
+  }
+  //A refused call leaves the current callback in place, as the HAL does
+  if(status == HDMI_CEC_IO_SUCCESS)
+  {
+    pthread_mutex_lock(&gClientMutex);
+    gTxClient.callback = cbfunc;
+    gTxClient.data = data;
+    pthread_mutex_unlock(&gClientMutex);
+  }
+  RecordInit(&record, HDMICEC_RECORD_SET_TX_CALLBACK, handle, start);
+  record.status = (int16_t)status;
+  record.arg = (cbfunc != NULL);
+  RecordWrite(&record);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecTx(int handle, const unsigned char* buf, int len, int* result)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecTx) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecTx)(handle, buf, len, result);
+  }
+  RecordInit(&record, HDMICEC_RECORD_TX, handle, start);
+  record.status = (int16_t)status;
+  record.arg = len;
+  RecordData(&record, buf, len);
+  if(result != NULL)
+  {
+    record.out = *result;
+  }
+  RecordWrite(&record);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecTxAsync(int handle, const unsigned char* buf, int len)
+{
+  hdmiCecRecord_t record;
+  uint64_t start = ShimNowNs();
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+
+  if(SHIM_REAL(HdmiCecTxAsync) != NULL)
+  {
+    status = SHIM_REAL(HdmiCecTxAsync)(handle, buf, len);
+  }
+  RecordInit(&record, HDMICEC_RECORD_TX_ASYNC, handle, start);
+  record.status = (int16_t)status;
+  record.arg = len;
+  RecordData(&record, buf, len);
+  RecordWrite(&record);
+  return status;
+}
@@ -0,0 +1,700 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file hdmiCecReplay.c
+ *
+ * Replays an API call log written by the record shim (see hdmiCecRecord.h) against a HAL library,
+ * e.g. a vendor libRCECHal.so in the lab, or the vComponent.
+ *
+ * Every thread that called the HAL in the log gets a replay thread, which issues the calls of that
+ * thread in order and at their original offset from the start of the log, so the concurrency of the
+ * original process is preserved. Handles returned by HdmiCecOpen() are mapped to the handles of the
+ * replay. The callbacks registered by the replay spend the time the original callbacks took, in the
+ * order they were invoked, so a HAL sees the same back pressure from its callbacks. Calls the
+ * middleware made from inside a callback are replayed from a thread of their own, at their original time.
+ *
+ * At the end the tool compares the latency and the status of each API with the log:
+ *
+ *  - count, mean and max latency per API, recorded and replayed
+ *  - calls returning a different status than recorded
+ *  - callbacks invoked, recorded and replayed
+ *  - how late the calls were issued compared to the original schedule
+ *
+ * The exit code is 0 when every call returned the recorded status, 1 when some did not and -1 on error.
+ *
+ * Usage: hdmiCecReplay [options] <log>
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <pthread.h>
+
+#include "hdmi_cec_driver.h"
+#include "hdmiCecRecord.h"
+
+#define DEFAULT_LIBRARY             "libRCECHal.so"
+#define UT_CONTROL_LIBRARY          "libut_control.so"
+#define MAX_HANDLES                 8
+#define DEFAULT_MAX_REPORTED        20
+
+typedef struct
+{
+  HDMI_CEC_STATUS (*open)(int*);
+  HDMI_CEC_STATUS (*close)(int);
+  HDMI_CEC_STATUS (*setLogicalAddress)(int, int*, int);
+  HDMI_CEC_STATUS (*getPhysicalAddress)(int, unsigned int*);
+  HDMI_CEC_STATUS (*addLogicalAddress)(int, int);
+  HDMI_CEC_STATUS (*removeLogicalAddress)(int, int);
+  HDMI_CEC_STATUS (*getLogicalAddress)(int, int*);
+  HDMI_CEC_STATUS (*setRxCallback)(int, HdmiCecRxCallback_t, void*);
+  HDMI_CEC_STATUS (*setTxCallback)(int, HdmiCecTxCallback_t, void*);
+  HDMI_CEC_STATUS (*tx)(int, const unsigned char*, int, int*);
+  HDMI_CEC_STATUS (*txAsync)(int, const unsigned char*, int);
+} replay_hal_t;
+
+/* Entry points of the vComponent, present when replaying against it */
+typedef struct
+{
+  void* (*initialize)(void);
+  int (*open)(void*, char*, bool);
+  int (*close)(void*);
+  int (*deinitialize)(void*);
+  void *instance;
+} replay_vcomponent_t;
+
+/* Outcome of one API call of the log */
+typedef struct
+{
+  bool issued;
+  int16_t status;
+  uint64_t duration_ns;
+  uint64_t lag_ns;
+} replay_result_t;
+
+typedef struct
+{
+  uint32_t thread;
+  uint32_t *records;
+  uint32_t count;
+  pthread_t id;
+} replay_thread_t;
+
+/* Time spent by the original Rx or Tx callback, consumed in order by the replay callbacks */
+typedef struct
+{
+  uint64_t *durations_ns;
+  uint32_t count;
+  uint32_t next;
+  uint32_t received;
+} replay_callback_t;
+
+typedef struct
+{
+  double speed;
+  bool emulateCallbacks;
+  uint32_t max_reported;
+} replay_options_t;
+
+static const char *gEventNames[HDMICEC_RECORD_MAX] =
+{
+  "HdmiCecOpen", "HdmiCecClose", "HdmiCecSetLogicalAddress", "HdmiCecGetPhysicalAddress",
+  "HdmiCecAddLogicalAddress", "HdmiCecRemoveLogicalAddress", "HdmiCecGetLogicalAddress",
+  "HdmiCecSetRxCallback", "HdmiCecSetTxCallback", "HdmiCecTx", "HdmiCecTxAsync",
+  "Rx callback", "Tx callback"
+};
+
+static bool gVerbose = false;
+static replay_options_t gOptions = { 1.0, true, DEFAULT_MAX_REPORTED };
+static replay_hal_t gHal;
+static hdmiCecRecord_t *gRecords;
+static replay_result_t *gResults;
+static uint32_t gNumRecords;
+static replay_callback_t gRxCallback;
+static replay_callback_t gTxCallback;
+static pthread_barrier_t gStartBarrier;
+static uint64_t gStartNs;
+
+static pthread_mutex_t gHandleMutex = PTHREAD_MUTEX_INITIALIZER;
+static int gRecordedHandles[MAX_HANDLES];
+static int gReplayHandles[MAX_HANDLES];
+static uint32_t gNumHandles;
+
+/* The vComponent logs through UT_logPrefix(). Errors are always shown, the rest with -v */
+void UT_logPrefix(const char *file, int line, const char *prefix, const char *format, ...)
+{
+  va_list args;
+
+  if(!gVerbose && strstr(prefix, "ERROR") == NULL)
+  {
+    return;
+  }
+  fprintf(stderr, "%s", prefix);
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fprintf(stderr, "\n");
+}
+
+static uint64_t NowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void SleepUntilNs(uint64_t deadline_ns)
+{
+  struct timespec ts;
+
+  ts.tv_sec = deadline_ns / 1000000000ULL;
+  ts.tv_nsec = deadline_ns % 1000000000ULL;
+  while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+  {
+  }
+}
+
+static bool IsApiCall(const hdmiCecRecord_t *record)
+{
+  return record->event < HDMICEC_RECORD_RX_CALLBACK;
+}
+
+static bool LoadLog(const char *path)
+{
+  hdmiCecRecord_header_t header;
+  FILE *file = fopen(path, "rb");
+  long size;
+
+  if(file == NULL)
+  {
+    fprintf(stderr, "Cannot open [%s]\n", path);
+    return false;
+  }
+  if(fread(&header, sizeof(header), 1, file) != 1 ||
+     memcmp(header.magic, HDMICEC_RECORD_MAGIC, sizeof(header.magic)) != 0 ||
+     header.version != HDMICEC_RECORD_VERSION ||
+     header.record_size != sizeof(hdmiCecRecord_t))
+  {
+    fprintf(stderr, "[%s] is not a version %d API log\n", path, HDMICEC_RECORD_VERSION);
+    fclose(file);
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  size = ftell(file) - (long)sizeof(header);
+  fseek(file, sizeof(header), SEEK_SET);
+  gNumRecords = (uint32_t)(size / sizeof(hdmiCecRecord_t));
+  if(size % sizeof(hdmiCecRecord_t) != 0)
+  {
+    fprintf(stderr, "[%s] is truncated, replaying the first %u records\n", path, gNumRecords);
+  }
+
+  gRecords = calloc(gNumRecords + 1, sizeof(hdmiCecRecord_t));
+  gResults = calloc(gNumRecords + 1, sizeof(replay_result_t));
+  if(gRecords == NULL || gResults == NULL ||
+     fread(gRecords, sizeof(hdmiCecRecord_t), gNumRecords, file) != gNumRecords)
+  {
+    fprintf(stderr, "Cannot read [%s]\n", path);
+    fclose(file);
+    return false;
+  }
+  fclose(file);
+  return true;
+}
+
+static bool LoadCallbackDurations(replay_callback_t *callback, hdmiCecRecord_event_t event)
+{
+  memset(callback, 0, sizeof(replay_callback_t));
+  callback->durations_ns = calloc(gNumRecords + 1, sizeof(uint64_t));
+  if(callback->durations_ns == NULL)
+  {
+    return false;
+  }
+  for(uint32_t i = 0; i < gNumRecords; i++)
+  {
+    if(gRecords[i].event == event)
+    {
+      callback->durations_ns[callback->count++] = gRecords[i].duration_ns;
+    }
+  }
+  return true;
+}
+
+/* Splits the API calls of the log by the thread that made them. Calls on one thread are sequential,
+ * so they are in the log in the order they were made. */
+static replay_thread_t* SplitThreads(uint32_t *numThreads)
+{
+  replay_thread_t *threads = calloc(gNumRecords + 1, sizeof(replay_thread_t));
+
+  *numThreads = 0;
+  if(threads == NULL)
+  {
+    return NULL;
+  }
+  for(uint32_t i = 0; i < gNumRecords; i++)
+  {
+    uint32_t t;
+
+    if(!IsApiCall(&gRecords[i]))
+    {
+      continue;
+    }
+    for(t = 0; t < *numThreads && threads[t].thread != gRecords[i].thread; t++)
+    {
+    }
+    if(t == *numThreads)
+    {
+      threads[t].thread = gRecords[i].thread;
+      threads[t].records = calloc(gNumRecords, sizeof(uint32_t));
+      if(threads[t].records == NULL)
+      {
+        for(t = 0; t < *numThreads; t++)
+        {
+          free(threads[t].records);
+        }
+        free(threads);
+        return NULL;
+      }
+      (*numThreads)++;
+    }
+    threads[t].records[threads[t].count++] = i;
+  }
+  return threads;
+}
+
+static void MapHandle(int recorded, int replayed)
+{
+  pthread_mutex_lock(&gHandleMutex);
+  for(uint32_t i = 0; i < gNumHandles; i++)
+  {
+    if(gRecordedHandles[i] == recorded)
+    {
+      gReplayHandles[i] = replayed;
+      pthread_mutex_unlock(&gHandleMutex);
+      return;
+    }
+  }
+  if(gNumHandles < MAX_HANDLES)
+  {
+    gRecordedHandles[gNumHandles] = recorded;
+    gReplayHandles[gNumHandles] = replayed;
+    gNumHandles++;
+  }
+  pthread_mutex_unlock(&gHandleMutex);
+}
+
+/* Handles never returned by the replay, e.g. invalid handles the middleware passed, are used as they are */
+static int LookupHandle(int recorded)
+{
+  int handle = recorded;
+
+  pthread_mutex_lock(&gHandleMutex);
+  for(uint32_t i = 0; i < gNumHandles; i++)
+  {
+    if(gRecordedHandles[i] == recorded)
+    {
+      handle = gReplayHandles[i];
+      break;
+    }
+  }
+  pthread_mutex_unlock(&gHandleMutex);
+  return handle;
+}
+
+static void EmulateCallback(replay_callback_t *callback)
+{
+  uint32_t index = __atomic_fetch_add(&callback->received, 1, __ATOMIC_RELAXED);
+
+  if(gOptions.emulateCallbacks && index < callback->count && callback->durations_ns[index] != 0)
+  {
+    SleepUntilNs(NowNs() + callback->durations_ns[index]);
+  }
+}
+
+static void ReplayRxCallback(int handle, void *callbackData, unsigned char *buf, int len)
+{
+  EmulateCallback(&gRxCallback);
+}
+
+static void ReplayTxCallback(int handle, void *callbackData, int result)
+{
+  EmulateCallback(&gTxCallback);
+}
+
+static HDMI_CEC_STATUS ReplayCall(const hdmiCecRecord_t *record)
+{
+  HDMI_CEC_STATUS status = HDMI_CEC_IO_OPERATION_NOT_SUPPORTED;
+  int handle = LookupHandle(record->handle);
+  int logicalAddresses[HDMICEC_RECORD_MAX_DATA];
+  unsigned int physicalAddress;
+  int value;
+
+  switch(record->event)
+  {
+    case HDMICEC_RECORD_OPEN:
+      status = gHal.open(&value);
+      if(status == HDMI_CEC_IO_SUCCESS && record->status == HDMI_CEC_IO_SUCCESS)
+      {
+        MapHandle(record->out, value);
+      }
+      break;
+    case HDMICEC_RECORD_CLOSE:
+      status = gHal.close(handle);
+      break;
+    case HDMICEC_RECORD_SET_LOGICAL_ADDRESS:
+      if(gHal.setLogicalAddress != NULL)
+      {
+        for(int i = 0; i < record->len; i++)
+        {
+          logicalAddresses[i] = record->data[i];
+        }
+        status = gHal.setLogicalAddress(handle, logicalAddresses, record->arg);
+      }
+      break;
+    case HDMICEC_RECORD_GET_PHYSICAL_ADDRESS:
+      status = gHal.getPhysicalAddress(handle, &physicalAddress);
+      break;
+    case HDMICEC_RECORD_ADD_LOGICAL_ADDRESS:
+      status = gHal.addLogicalAddress(handle, record->arg);
+      break;
+    case HDMICEC_RECORD_REMOVE_LOGICAL_ADDRESS:
+      status = gHal.removeLogicalAddress(handle, record->arg);
+      break;
+    case HDMICEC_RECORD_GET_LOGICAL_ADDRESS:
+      status = gHal.getLogicalAddress(handle, &value);
+      break;
+    case HDMICEC_RECORD_SET_RX_CALLBACK:
+      status = gHal.setRxCallback(handle, record->arg ? ReplayRxCallback : NULL, NULL);
+      break;
+    case HDMICEC_RECORD_SET_TX_CALLBACK:
+      status = gHal.setTxCallback(handle, record->arg ? ReplayTxCallback : NULL, NULL);
+      break;
+    case HDMICEC_RECORD_TX:
+      status = gHal.tx(handle, record->data, record->len, &value);
+      break;
+    case HDMICEC_RECORD_TX_ASYNC:
+      status = gHal.txAsync(handle, record->data, record->len);
+      break;
+    default:
+      break;
+  }
+  return status;
+}
+
+static void* ReplayThread(void *arg)
+{
+  replay_thread_t *thread = (replay_thread_t *)arg;
+
+  pthread_barrier_wait(&gStartBarrier);
+  for(uint32_t i = 0; i < thread->count; i++)
+  {
+    uint32_t index = thread->records[i];
+    replay_result_t *result = &gResults[index];
+    uint64_t deadline = gStartNs;
+    uint64_t start;
+
+    if(gOptions.speed > 0)
+    {
+      deadline += (uint64_t)((double)gRecords[index].timestamp_ns / gOptions.speed);
+      SleepUntilNs(deadline);
+    }
+    start = NowNs();
+    result->status = (int16_t)ReplayCall(&gRecords[index]);
+    result->duration_ns = NowNs() - start;
+    result->lag_ns = (gOptions.speed > 0 && start > deadline) ? start - deadline : 0;
+    result->issued = true;
+  }
+  return NULL;
+}
+
+static bool Replay(replay_thread_t *threads, uint32_t numThreads)
+{
+  uint32_t started = 0;
+
+  pthread_barrier_init(&gStartBarrier, NULL, numThreads + 1);
+  for(; started < numThreads; started++)
+  {
+    if(pthread_create(&threads[started].id, NULL, ReplayThread, &threads[started]) != 0)
+    {
+      fprintf(stderr, "Cannot start replay thread %u\n", started);
+      //The barrier will never be reached, abandon the threads already started
+      return false;
+    }
+  }
+
+  gStartNs = NowNs();
+  pthread_barrier_wait(&gStartBarrier);
+  for(uint32_t t = 0; t < numThreads; t++)
+  {
+    pthread_join(threads[t].id, NULL);
+  }
+  pthread_barrier_destroy(&gStartBarrier);
+  return true;
+}
+
+static int Report(uint32_t numThreads, uint64_t elapsed_ns)
+{
+  uint64_t recordedTotal[HDMICEC_RECORD_MAX] = { 0 }, recordedMax[HDMICEC_RECORD_MAX] = { 0 };
+  uint64_t replayTotal[HDMICEC_RECORD_MAX] = { 0 }, replayMax[HDMICEC_RECORD_MAX] = { 0 };
+  uint32_t count[HDMICEC_RECORD_MAX] = { 0 }, mismatches[HDMICEC_RECORD_MAX] = { 0 };
+  uint64_t lagTotal = 0, lagMax = 0;
+  uint32_t issued = 0, numMismatches = 0, reported = 0;
+
+  for(uint32_t i = 0; i < gNumRecords; i++)
+  {
+    const hdmiCecRecord_t *record = &gRecords[i];
+    const replay_result_t *result = &gResults[i];
+
+    if(record->event >= HDMICEC_RECORD_MAX)
+    {
+      continue;
+    }
+    count[record->event]++;
+    recordedTotal[record->event] += record->duration_ns;
+    if(record->duration_ns > recordedMax[record->event])
+    {
+      recordedMax[record->event] = record->duration_ns;
+    }
+    if(!result->issued)
+    {
+      continue;
+    }
+
+    issued++;
+    replayTotal[record->event] += result->duration_ns;
+    if(result->duration_ns > replayMax[record->event])
+    {
+      replayMax[record->event] = result->duration_ns;
+    }
+    lagTotal += result->lag_ns;
+    if(result->lag_ns > lagMax)
+    {
+      lagMax = result->lag_ns;
+    }
+    if(result->status != record->status)
+    {
+      mismatches[record->event]++;
+      numMismatches++;
+      if(reported++ < gOptions.max_reported)
+      {
+        printf("Status differs: t=%llu.%06llu s thread %u %s recorded %d replayed %d\n",
+               (unsigned long long)(record->timestamp_ns / 1000000000ULL),
+               (unsigned long long)((record->timestamp_ns % 1000000000ULL) / 1000),
+               record->thread, gEventNames[record->event], record->status, result->status);
+      }
+    }
+  }
+
+  printf("Replayed %u calls on %u threads in %llu ms\n", issued, numThreads, (unsigned long long)(elapsed_ns / 1000000));
+  printf("%-28s %8s %10s %10s %10s %10s %8s\n", "API", "count", "rec mean", "rec max", "rep mean", "rep max", "status");
+  for(int event = 0; event < HDMICEC_RECORD_RX_CALLBACK; event++)
+  {
+    if(count[event] == 0)
+    {
+      continue;
+    }
+    printf("%-28s %8u %7llu us %7llu us %7llu us %7llu us %8u\n", gEventNames[event], count[event],
+           (unsigned long long)(recordedTotal[event] / count[event] / 1000), (unsigned long long)(recordedMax[event] / 1000),
+           (unsigned long long)(replayTotal[event] / count[event] / 1000), (unsigned long long)(replayMax[event] / 1000),
+           mismatches[event]);
+  }
+  for(int event = HDMICEC_RECORD_RX_CALLBACK; event < HDMICEC_RECORD_MAX; event++)
+  {
+    replay_callback_t *callback = (event == HDMICEC_RECORD_RX_CALLBACK) ? &gRxCallback : &gTxCallback;
+    printf("%-28s recorded %u (mean %llu us, max %llu us), replayed %u\n", gEventNames[event], count[event],
+           (unsigned long long)(count[event] ? recordedTotal[event] / count[event] / 1000 : 0),
+           (unsigned long long)(recordedMax[event] / 1000), callback->received);
+  }
+  if(gOptions.speed > 0 && issued > 0)
+  {
+    printf("Schedule lag: mean %llu us, max %llu us\n", (unsigned long long)(lagTotal / issued / 1000), (unsigned long long)(lagMax / 1000));
+  }
+  return (numMismatches == 0) ? 0 : 1;
+}
+
+#define REPLAY_RESOLVE(field, name, required) \
+  do { \
+    *(void **)&gHal.field = dlsym(library, name); \
+    if(gHal.field == NULL && (required)) \
+    { \
+      fprintf(stderr, "%s not found: %s\n", name, dlerror()); \
+      return NULL; \
+    } \
+  } while(0)
+
+static void* LoadHal(const char *path, const char *profile, replay_vcomponent_t *vcomponent)
+{
+  void *library;
+
+  //The vComponent is built against ut-control, which the HAL under test does not need
+  if(profile != NULL && dlopen(UT_CONTROL_LIBRARY, RTLD_NOW | RTLD_GLOBAL) == NULL)
+  {
+    fprintf(stderr, "Cannot load %s: %s\n", UT_CONTROL_LIBRARY, dlerror());
+    return NULL;
+  }
+  library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if(library == NULL)
+  {
+    fprintf(stderr, "Cannot load [%s]: %s\n", path, dlerror());
+    return NULL;
+  }
+
+  REPLAY_RESOLVE(open, "HdmiCecOpen", true);
+  REPLAY_RESOLVE(close, "HdmiCecClose", true);
+  REPLAY_RESOLVE(setLogicalAddress, "HdmiCecSetLogicalAddress", false);
+  REPLAY_RESOLVE(getPhysicalAddress, "HdmiCecGetPhysicalAddress", true);
+  REPLAY_RESOLVE(addLogicalAddress, "HdmiCecAddLogicalAddress", true);
+  REPLAY_RESOLVE(removeLogicalAddress, "HdmiCecRemoveLogicalAddress", true);
+  REPLAY_RESOLVE(getLogicalAddress, "HdmiCecGetLogicalAddress", true);
+  REPLAY_RESOLVE(setRxCallback, "HdmiCecSetRxCallback", true);
+  REPLAY_RESOLVE(setTxCallback, "HdmiCecSetTxCallback", true);
+  REPLAY_RESOLVE(tx, "HdmiCecTx", true);
+  REPLAY_RESOLVE(txAsync, "HdmiCecTxAsync", true);
+
+  memset(vcomponent, 0, sizeof(replay_vcomponent_t));
+  if(profile == NULL)
+  {
+    return library;
+  }
+  *(void **)&vcomponent->initialize = dlsym(library, "vcHdmiCec_Initialize");
+  *(void **)&vcomponent->open = dlsym(library, "vcHdmiCec_Open");
+  *(void **)&vcomponent->close = dlsym(library, "vcHdmiCec_Close");
+  *(void **)&vcomponent->deinitialize = dlsym(library, "vcHdmiCec_Deinitialize");
+  if(vcomponent->initialize == NULL || vcomponent->open == NULL || vcomponent->close == NULL || vcomponent->deinitialize == NULL)
+  {
+    fprintf(stderr, "A profile is given but [%s] is not the vComponent\n", path);
+    return NULL;
+  }
+  vcomponent->instance = vcomponent->initialize();
+  if(vcomponent->instance == NULL || vcomponent->open(vcomponent->instance, (char *)profile, false) != 0)
+  {
+    fprintf(stderr, "Cannot open the vComponent with profile [%s]\n", profile);
+    return NULL;
+  }
+  return library;
+}
+
+static void Usage(const char *name)
+{
+  printf("Usage: %s [options] <log>\n", name);
+  printf("  -l library    HAL to replay against, default %s\n", DEFAULT_LIBRARY);
+  printf("  -p profile    vComponent profile, when replaying against the vComponent\n");
+  printf("  -s speed      Speed factor of the replay, 0 issues the calls back to back, default 1\n");
+  printf("  -c            Return from the callbacks immediately instead of taking the recorded time\n");
+  printf("  -n count      Status mismatches listed, default %d\n", DEFAULT_MAX_REPORTED);
+  printf("  -v            Verbose\n");
+}
+
+int main(int argc, char** argv)
+{
+  const char *libraryPath = DEFAULT_LIBRARY;
+  const char *profile = NULL;
+  replay_vcomponent_t vcomponent;
+  replay_thread_t *threads;
+  uint32_t numThreads = 0;
+  uint64_t start;
+  int opt, result = -1;
+
+  while ((opt = getopt(argc, argv, "l:p:s:cn:vh")) != -1)
+  {
+    switch(opt)
+    {
+      case 'l':
+        libraryPath = optarg;
+        break;
+      case 'p':
+        profile = optarg;
+        break;
+      case 's':
+        gOptions.speed = strtod(optarg, NULL);
+        if(gOptions.speed < 0)
+        {
+          fprintf(stderr, "Invalid speed [%s]\n", optarg);
+          return -1;
+        }
+        break;
+      case 'c':
+        gOptions.emulateCallbacks = false;
+        break;
+      case 'n':
+        gOptions.max_reported = strtoul(optarg, NULL, 0);
+        break;
+      case 'v':
+        gVerbose = true;
+        break;
+      case 'h':
+      default:
+        Usage(argv[0]);
+        return (opt == 'h') ? 0 : -1;
+    }
+  }
+  if(optind != argc - 1)
+  {
+    Usage(argv[0]);
+    return -1;
+  }
+
+  if(!LoadLog(argv[optind]) ||
+     !LoadCallbackDurations(&gRxCallback, HDMICEC_RECORD_RX_CALLBACK) ||
+     !LoadCallbackDurations(&gTxCallback, HDMICEC_RECORD_TX_CALLBACK))
+  {
+    return -1;
+  }
+  threads = SplitThreads(&numThreads);
+  if(threads == NULL)
+  {
+    fprintf(stderr, "Out of memory\n");
+    return -1;
+  }
+  if(LoadHal(libraryPath, profile, &vcomponent) == NULL)
+  {
+    return -1;
+  }
+
+  start = NowNs();
+  if(Replay(threads, numThreads))
+  {
+    result = Report(numThreads, NowNs() - start);
+  }
+
+  if(vcomponent.instance != NULL)
+  {
+    vcomponent.close(vcomponent.instance);
+    vcomponent.deinitialize(vcomponent.instance);
+  }
+  for(uint32_t t = 0; t < numThreads; t++)
+  {
+    free(threads[t].records);
+  }
+  free(threads);
+  free(gRxCallback.durations_ns);
+  free(gTxCallback.durations_ns);
+  free(gRecords);
+  free(gResults);
+  return result;
+}
@@ -0,0 +1,70 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __HDMICECSHIM_H
+#define __HDMICECSHIM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <sys/syscall.h>
+
+#include "hdmi_cec_driver.h"
+
+/* Helpers shared by the LD_PRELOAD shims. Each shim defines every HdmiCec* symbol and forwards the
+ * call to the next definition in the lookup order, i.e. the HAL the shim is preloaded in front of. */
+
+/* Declares the cache of the real function behind a wrapper */
+#define SHIM_DECLARE_REAL(name)   static void *gReal_##name = NULL
+
+/* The real function, resolved on first use */
+#define SHIM_REAL(name)           ((__typeof__(name) *)ShimResolve(&gReal_##name, #name))
+
+static inline void* ShimResolve(void **cache, const char *name)
+{
+  void *func = __atomic_load_n(cache, __ATOMIC_ACQUIRE);
+
+  if(func == NULL)
+  {
+    func = dlsym(RTLD_NEXT, name);
+    if(func == NULL)
+    {
+      fprintf(stderr, "hdmicec shim: %s not found in the HAL\n", name);
+    }
+    __atomic_store_n(cache, func, __ATOMIC_RELEASE);
+  }
+  return func;
+}
+
+static inline uint64_t ShimNowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint32_t ShimThreadId(void)
+{
+  return (uint32_t)syscall(SYS_gettid);
+}
+
+#endif //__HDMICECSHIM_H
@@ -62,8 +62,10 @@
 #include <string.h>
 #include <getopt.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <ut_log.h>
 #include <ut_kvp_profile.h>
+#include "test_events.h"
 
 #ifndef HALIF_TEST_TAG_VERSION
 #define HALIF_TEST_TAG_VERSION "Not Defined"
@@ -73,17 +75,40 @@ extern int register_hdmicec_hal_l1_tests( void );
 extern int register_hdmicec_hal_source_l2_tests( void );
 extern int register_hdmicec_hal_sink_l2_tests( void );
 extern int register_hdmicec_hal_l3_tests( void );
+extern int register_hdmicec_hal_l4_tests( void );
 
 #ifdef VCOMPONENT
 extern int register_vcomponent_tests ( char* profile );
-extern int test_vd_hdmi_cec_driver_register ( char* pValidationProfilePath );
+extern int test_vd_hdmi_cec_driver_register ( char* pValidationProfilePath, bool selfDriving, bool isolated );
 #endif
 
+/* Looks for "-j <path>" without getopt, which would reorder argv before UT_init() reads it */
+static const char* findEventOutput(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--") == 0)
+        {
+            break;
+        }
+        if (strcmp(argv[i], "-j") == 0)
+        {
+            return (i + 1 < argc) ? argv[i + 1] : NULL;
+        }
+        if (strncmp(argv[i], "-j", 2) == 0)
+        {
+            return &argv[i][2];
+        }
+    }
+    return NULL;
+}
+
 int main(int argc, char** argv)
 {
     ut_kvp_status_t status;
     char szReturnedString[UT_KVP_MAX_ELEMENT_SIZE];
     int registerReturn = 0;
+    const char* pEventPath;
 
     printf("\n\n==========================================================================\n");
     printf("\n\t\tHdmiCEC HALIF Test Version: \033[0;32m%s\033[0m\n",HALIF_TEST_TAG_VERSION);
@@ -93,8 +118,12 @@ int main(int argc, char** argv)
     int opt;
     char* pProfilePath = NULL;
     char* pValidationProfilePath = NULL;
+    bool selfDriving = false;
+    bool isolated = false;
 
-    while ((opt = getopt(argc, argv, "u:v:")) != -1)
+    /* The leading '-' keeps argv in order for UT_init(), its own switches are skipped here */
+    opterr = 0;
+    while ((opt = getopt(argc, argv, "-u:v:si")) != -1)
     {
         switch(opt)
         {
@@ -110,16 +139,33 @@ int main(int argc, char** argv)
                 strcpy(pValidationProfilePath, optarg);
                 pValidationProfilePath[strlen(optarg) + 1] = '\0';
                 break;
+            case 's':
+                UT_LOG ("Self driving validation tests\n");
+                selfDriving = true;
+                break;
+            case 'i':
+                UT_LOG ("Isolated validation tests, HAL opened per test\n");
+                isolated = true;
+                break;
 
-            case '?':
-            case ':':
-                UT_LOG("unknown option: %c\n", optopt);
+            default:
                 break;
         }
     }
     optind = 1; //Reset argv[] element pointer for further processing
+    opterr = 1;
 #endif
 
+    pEventPath = findEventOutput(argc, argv);
+    if (pEventPath != NULL)
+    {
+        UT_LOG ("Setting Event output [%s]\n",pEventPath);
+        if (test_events_open(pEventPath) != 0)
+        {
+            return -1;
+        }
+    }
+
     /* Register tests as required, then call the UT-main to support switches and triggering */
     UT_init( argc, argv );
 
@@ -140,7 +186,7 @@ int main(int argc, char** argv)
     }
 #ifdef VCOMPONENT
     register_vcomponent_tests(pProfilePath);
-    test_vd_hdmi_cec_driver_register (pValidationProfilePath);
+    test_vd_hdmi_cec_driver_register (pValidationProfilePath, selfDriving, isolated);
 #endif
 
     if(strncmp(szReturnedString,"source",UT_KVP_MAX_ELEMENT_SIZE) == 0) {
@@ -153,8 +199,12 @@ int main(int argc, char** argv)
 
     register_hdmicec_hal_l3_tests ();
 
+    register_hdmicec_hal_l4_tests ();
+
     UT_run_tests();
 
+    test_events_close();
+
 #ifdef VCOMPONENT
     if(pProfilePath != NULL)
     {
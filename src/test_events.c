@@ -0,0 +1,249 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @addtogroup HPK Hardware Porting Kit
+ * @{
+ *
+ */
+
+/**
+ * @addtogroup HDMI_CEC HDMI CEC Module
+ * @{
+ *
+ */
+
+/**
+ * @defgroup HDMI_CEC_HALTESTS HDMI CEC HAL Tests
+ * @{
+ *
+ */
+
+/**
+ * @defgroup HDMI_CEC_HALTESTS_Events HDMI CEC HAL Tests Event Output
+ * @{
+ *
+ */
+
+/**
+* @file test_events.c
+*
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <ut_log.h>
+
+#include "test_events.h"
+
+#define EVENT_MAX_LINE 1024
+#define EVENT_FD_PREFIX "fd:"
+
+static int32_t gEventFd = -1;
+static bool gEventOwnFd = false;
+static pthread_mutex_t gEventMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t getTimeNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/* Appends to an event line. pPos stops at the last byte, so a truncated line never moves it past the buffer */
+static void appendLineV(char *line, int32_t *pPos, const char *pFormat, va_list args)
+{
+    int32_t written;
+
+    if (*pPos >= EVENT_MAX_LINE - 1)
+    {
+        return;
+    }
+    written = vsnprintf(line + *pPos, EVENT_MAX_LINE - *pPos, pFormat, args);
+    if (written > 0)
+    {
+        *pPos += written;
+    }
+    if (*pPos > EVENT_MAX_LINE - 1)
+    {
+        *pPos = EVENT_MAX_LINE - 1;
+    }
+}
+
+static void appendLine(char *line, int32_t *pPos, const char *pFormat, ...)
+{
+    va_list args;
+
+    va_start(args, pFormat);
+    appendLineV(line, pPos, pFormat, args);
+    va_end(args);
+}
+
+/* Each event is written with a single write() so lines from the Rx thread and the test thread never interleave */
+static void writeLine(char *line, int32_t len)
+{
+    if (len >= EVENT_MAX_LINE - 1)
+    {
+        len = EVENT_MAX_LINE - 2;
+    }
+    line[len++] = '\n';
+
+    pthread_mutex_lock(&gEventMutex);
+    if (gEventFd >= 0)
+    {
+        const char *p = line;
+        while (len > 0)
+        {
+            ssize_t written = write(gEventFd, p, len);
+            if (written <= 0)
+            {
+                break;
+            }
+            p += written;
+            len -= written;
+        }
+    }
+    pthread_mutex_unlock(&gEventMutex);
+}
+
+int32_t test_events_open(const char *pTarget)
+{
+    int32_t fd;
+    bool ownFd = false;
+
+    if (pTarget == NULL)
+    {
+        return -1;
+    }
+
+    if (!strncmp(pTarget, EVENT_FD_PREFIX, strlen(EVENT_FD_PREFIX)))
+    {
+        char *pEnd;
+        fd = (int32_t)strtol(pTarget + strlen(EVENT_FD_PREFIX), &pEnd, 10);
+        if (*pEnd != '\0' || fd < 0 || fcntl(fd, F_GETFD) == -1)
+        {
+            UT_LOG_ERROR("Invalid event output file descriptor [%s]", pTarget);
+            return -1;
+        }
+    }
+    else
+    {
+        fd = open(pTarget, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            UT_LOG_ERROR("Failed to open event output [%s]", pTarget);
+            return -1;
+        }
+        ownFd = true;
+    }
+
+    test_events_close();
+
+    pthread_mutex_lock(&gEventMutex);
+    gEventFd = fd;
+    gEventOwnFd = ownFd;
+    pthread_mutex_unlock(&gEventMutex);
+
+    return 0;
+}
+
+void test_events_close(void)
+{
+    pthread_mutex_lock(&gEventMutex);
+    if (gEventFd >= 0 && gEventOwnFd)
+    {
+        close(gEventFd);
+    }
+    gEventFd = -1;
+    gEventOwnFd = false;
+    pthread_mutex_unlock(&gEventMutex);
+}
+
+bool test_events_enabled(void)
+{
+    return (gEventFd >= 0);
+}
+
+void test_events_hal_call(const char *pApi, const char *pStatus, const char *pFieldsFormat, ...)
+{
+    char line[EVENT_MAX_LINE];
+    int32_t len = 0;
+
+    if (!test_events_enabled())
+    {
+        return;
+    }
+
+    appendLine(line, &len, "{\"ts_ns\":%llu,\"event\":\"hal_call\",\"api\":\"%s\",\"status\":\"%s\"",
+               (unsigned long long)getTimeNs(), pApi, pStatus ? pStatus : "UNKNOWN");
+    if (pFieldsFormat != NULL)
+    {
+        va_list args;
+
+        appendLine(line, &len, ",");
+        va_start(args, pFieldsFormat);
+        appendLineV(line, &len, pFieldsFormat, args);
+        va_end(args);
+    }
+    appendLine(line, &len, "}");
+    writeLine(line, len);
+}
+
+void test_events_frame(const char *pEvent, uint64_t timestampNs, const uint8_t *pBuf, int32_t len, const char *pResult)
+{
+    char line[EVENT_MAX_LINE];
+    int32_t pos = 0;
+
+    if (!test_events_enabled() || pBuf == NULL || len <= 0)
+    {
+        return;
+    }
+
+    appendLine(line, &pos, "{\"ts_ns\":%llu,\"event\":\"%s\",\"initiator\":%d,\"destination\":%d,",
+               (unsigned long long)(timestampNs ? timestampNs : getTimeNs()), pEvent, (pBuf[0] >> 4) & 0x0F, pBuf[0] & 0x0F);
+    if (len > 1)
+    {
+        appendLine(line, &pos, "\"opcode\":\"0x%02X\",", pBuf[1]);
+    }
+    appendLine(line, &pos, "\"len\":%d,\"data\":\"", len);
+    for (int32_t i = 0; i < len && pos < EVENT_MAX_LINE - 4; i++)
+    {
+        appendLine(line, &pos, (i == 0) ? "%02X" : ":%02X", pBuf[i]);
+    }
+    if (pResult != NULL)
+    {
+        appendLine(line, &pos, "\",\"result\":\"%s\"}", pResult);
+    }
+    else
+    {
+        appendLine(line, &pos, "\"}");
+    }
+    writeLine(line, pos);
+}
+
+/** @} */ // End of HDMI CEC HAL Tests Event Output
+/** @} */ // End of HDMI CEC HAL Tests
+/** @} */ // End of HDMI CEC Module
+/** @} */ // End of HPK
@@ -0,0 +1,117 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @addtogroup HPK Hardware Porting Kit
+ * @{
+ *
+ */
+
+/**
+ * @addtogroup HDMI_CEC HDMI CEC Module
+ * @{
+ *
+ */
+
+/**
+ * @defgroup HDMI_CEC_HALTESTS HDMI CEC HAL Tests
+ * @{
+ *
+ */
+
+/**
+ * @defgroup HDMI_CEC_HALTESTS_Events HDMI CEC HAL Tests Event Output
+ * @{
+ * @parblock
+ *
+ * ### Structured event output for HDMI CEC HAL tests :
+ *
+ * Writes one JSON object per line for every HAL call result, received frame and transmitted response,
+ * so host scripts can consume test results without scraping the log.
+ *
+ * Each line carries a CLOCK_MONOTONIC timestamp in nanoseconds and an event type, e.g.
+ * @code
+ * {"ts_ns":1234567,"event":"hal_call","api":"HdmiCecTx","status":"HDMI_CEC_IO_SUCCESS","result":"HDMI_CEC_IO_SENT_AND_ACKD"}
+ * {"ts_ns":1234987,"event":"rx_frame","initiator":0,"destination":4,"opcode":"0x90","len":3,"data":"04:90:00"}
+ * {"ts_ns":1235012,"event":"tx_response","initiator":4,"destination":0,"opcode":"0x90","len":3,"data":"40:90:00","result":"HDMI_CEC_IO_SENT_AND_ACKD"}
+ * @endcode
+ *
+ * Output is disabled until test_events_open() is called, in which case every function is a no-op.
+ *
+ * @endparblock
+ *
+ */
+
+/**
+* @file test_events.h
+*
+*/
+
+#ifndef __TEST_EVENTS_H__
+#define __TEST_EVENTS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Opens the event output.
+ *
+ * @param[in] pTarget - "fd:<n>" to write to an already open file descriptor, otherwise a file path which is truncated
+ *
+ * @return 0 on success, -1 on failure
+ */
+int32_t test_events_open(const char *pTarget);
+
+/**
+ * @brief Closes the event output. File descriptors passed with "fd:<n>" are left open.
+ */
+void test_events_close(void);
+
+/**
+ * @brief Returns true if the event output is open.
+ */
+bool test_events_enabled(void);
+
+/**
+ * @brief Emits a "hal_call" event.
+ *
+ * @param[in] pApi - name of the HAL function
+ * @param[in] pStatus - returned status name
+ * @param[in] pFieldsFormat - optional printf format for extra JSON members, without the leading comma, e.g. "\"logical_address\":%d". May be NULL.
+ */
+void test_events_hal_call(const char *pApi, const char *pStatus, const char *pFieldsFormat, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief Emits a frame event, "rx_frame" for received frames and "tx_response" for transmitted responses.
+ *
+ * @param[in] pEvent - event type
+ * @param[in] timestampNs - CLOCK_MONOTONIC time of the frame, 0 for now
+ * @param[in] pBuf - CEC frame, header block first
+ * @param[in] len - length of the frame
+ * @param[in] pResult - transmit result name, NULL for received frames
+ */
+void test_events_frame(const char *pEvent, uint64_t timestampNs, const uint8_t *pBuf, int32_t len, const char *pResult);
+
+#endif //__TEST_EVENTS_H__
+
+/** @} */ // End of HDMI CEC HAL Tests Event Output
+/** @} */ // End of HDMI CEC HAL Tests
+/** @} */ // End of HDMI CEC Module
+/** @} */ // End of HPK
@@ -43,6 +43,10 @@
  * This module includes Level 3 functional test interfaces.
  * This Test Interfaces provides a scope to create a User Test cases for HDMI CEC Sink modules that can be either Manual or automated scripts.
  *
+ * Received frames are answered by a responder thread. The Rx callback only copies the frame
+ * into a lock-free single producer / single consumer queue, so the HAL receive thread is never
+ * blocked by a bus transmit. The responder reports the response latency when the module is closed.
+ *
  * **Pre-Conditions:**  None@n
  * **Dependencies:** None@n
  *
@@ -56,12 +60,19 @@
  *
  */
 
+#include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
 #include <ut.h>
 #include <ut_log.h>
 #include <ut_kvp_profile.h>
 #include <ut_control_plane.h>
 #include "hdmi_cec_driver.h"
+#include "test_events.h"
 
 #define TIMEOUT 5
 #define REPLY_TIMEOUT 5
@@ -71,6 +82,16 @@
 #define HDMI_CEC_KVP_SIZE 128
 #define HDMI_CEC_TYPE_SIZE 16
 #define HDMI_CEC_DEVICE_TYPE_SIZE  8
+#define HDMI_CEC_MAX_OPCODES 256
+
+#define RESPONDER_QUEUE_SIZE 64 //Must be a power of 2
+#define NSEC_PER_SEC 1000000000ULL
+#define NSEC_PER_MSEC 1000000ULL
+
+#define SCRIPT_MAX_LINE 256
+#define SCRIPT_MAX_PATH 256
+#define SCRIPT_DEFAULT_WAIT_MS 2000
+#define SCRIPT_END "end"
 
 #define UT_LOG_MENU_INFO UT_LOG_INFO
 
@@ -81,13 +102,15 @@ typedef struct
     int32_t dataLength;       // Number of data bytes required for the command
 } CecCommandMap;
 
+/* Ready to send response frame for one received opcode.
+ * frame[0] (header) depends on the sender and the current logical address, it is filled in when sending. */
 typedef struct cecResponse
 {
-    uint8_t cecCommand;    //CEC opcode
-    uint32_t payloadSize;  //CEC payload size
-    uint8_t type[UT_KVP_MAX_ELEMENT_SIZE];  //Type of the opcode Broadcast/ Direct
-    uint8_t payload[HDMI_CEC_MAX_PAYLOAD]; //CEC Payload
-    bool updatePhysicalAddress;
+    bool supported;              //false: Feature Abort is sent
+    bool broadcast;              //Type of the opcode Broadcast/ Direct
+    bool updatePhysicalAddress;  //payload[0..1] carries the physical address of the device
+    int32_t frameSize;           //Header + opcode + payload
+    uint8_t frame[HDMI_CEC_MAX_PAYLOAD];
 } cecResponse_t;
 
 CecCommandMap cecCommandTable[] = {
@@ -198,6 +221,45 @@ static uint32_t gPhysicalAddress = -1;
 static uint8_t  *gPhysicalAddressBytes;
 static uint8_t gBroadcastAddress = 0xF;
 static HDMI_CEC_DEVICE_TYPE gDeviceType = SINK;
+static cecResponse_t gResponseTable[HDMI_CEC_MAX_OPCODES];
+
+/* Frame as received in the Rx callback */
+typedef struct
+{
+    int32_t  handle;
+    uint64_t rxTimeNs;
+    int32_t  len;
+    uint8_t  buf[HDMI_CEC_MAX_PAYLOAD];
+} cecRxFrame_t;
+
+/* Responder worker.
+ * The queue has a single producer (the HAL Rx callback thread) and a single consumer (the worker).
+ * head is only written by the producer and tail only by the consumer. */
+typedef struct
+{
+    cecRxFrame_t     frames[RESPONDER_QUEUE_SIZE];
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    _Atomic uint32_t dropped;
+    atomic_bool      running;
+    sem_t            available;
+    pthread_t        thread;
+
+    //Updated by the worker only
+    uint32_t responses;
+    uint64_t latencyTotalNs;
+    uint64_t latencyMinNs;
+    uint64_t latencyMaxNs;
+    uint64_t txTotalNs;
+    uint64_t txMaxNs;
+} cecResponder_t;
+
+static cecResponder_t gResponder;
+
+/* Number of frames received per opcode, used by the "wait" script command */
+static uint32_t gRxOpcodeCount[HDMI_CEC_MAX_OPCODES];
+static pthread_mutex_t gRxOpcodeMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gRxOpcodeCond = PTHREAD_COND_INITIALIZER;
 /**
 * @brief CEC Command with data size mapping function.
 *
@@ -246,82 +308,118 @@ static void readHex(int32_t *value)
     readAndDiscardRestOfLine(stdin);
 }
 
-static bool getCommandResponse(uint8_t opcode, cecResponse_t *pResponse)
+static void readString(char *value, size_t size)
 {
+    value[0] = '\0';
+    if (fgets(value, size, stdin) != NULL)
+    {
+        value[strcspn(value, "\r\n")] = '\0';
+    }
+}
+
+/**
+ * @brief Compiles hdmicec/cec_responses into the opcode indexed response table.
+ *
+ * Done once at suite registration, so that the Rx callback only needs a table lookup.
+ * Opcodes without a response in the profile answer with Feature Abort (unsupported opcode).
+ * If an opcode is listed more than once, the first entry with a response wins.
+ */
+static void compileResponseTable(void)
+{
+    ut_kvp_instance_t *instance = ut_kvp_profile_getInstance();
     uint32_t numCommands = 0;
     char key_string[HDMI_CEC_KVP_SIZE] = {0};
+    char type[UT_KVP_MAX_ELEMENT_SIZE] = {0};
+
+    for (uint32_t opcode = 0; opcode < HDMI_CEC_MAX_OPCODES; opcode++)
+    {
+        cecResponse_t *pResponse = &gResponseTable[opcode];
 
-    memset(pResponse, 0, sizeof(cecResponse_t));
+        memset(pResponse, 0, sizeof(cecResponse_t));
+        pResponse->frame[1] = 0x00; //Feature abort
+        pResponse->frame[2] = (uint8_t)opcode;
+        pResponse->frame[3] = 0x01; //Unsupported opcode
+        pResponse->frameSize = 4;
+    }
 
-    numCommands = UT_KVP_PROFILE_GET_LIST_COUNT("hdmicec/cec_responses");
+    numCommands = ut_kvp_getListCount(instance, "hdmicec/cec_responses");
 
     for(uint32_t i = 0; i < numCommands; i++)
     {
+        cecResponse_t *pResponse;
+        uint32_t payloadSize;
         uint8_t command;
-        uint8_t found;
 
         snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/command" , i);
-        command = UT_KVP_PROFILE_GET_UINT8(key_string);
+        command = ut_kvp_getUInt8Field(instance, key_string);
+        pResponse = &gResponseTable[command];
 
-        if(command != opcode)
+        snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/response/command" , i);
+        if(pResponse->supported || !ut_kvp_fieldPresent(instance, key_string))
         {
             continue;
         }
-        snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/response/command" , i);
-        found = ut_kvp_fieldPresent(ut_kvp_profile_getInstance(), key_string);
+        pResponse->supported = true;
+        pResponse->frame[1] = ut_kvp_getUInt8Field(instance, key_string);
 
-        if(found)
-        {
-            pResponse->cecCommand = UT_KVP_PROFILE_GET_UINT8(key_string);
+        snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/response/type" , i);
+        ut_kvp_getStringField(instance, key_string, type, UT_KVP_MAX_ELEMENT_SIZE);
+        pResponse->broadcast = (strcmp(type, "Direct") != 0);
 
-            snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/response/type" , i);
-            UT_KVP_PROFILE_GET_STRING(key_string, pResponse->type);
-
-            snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/response/payload" , i);
-            pResponse->payloadSize = UT_KVP_PROFILE_GET_LIST_COUNT(key_string);
+        snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/response/payload" , i);
+        payloadSize = ut_kvp_getListCount(instance, key_string);
+        if (payloadSize > HDMI_CEC_MAX_PAYLOAD - 2)
+        {
+            UT_LOG_WARNING("Response payload for opcode 0x%02X truncated to %d bytes", command, HDMI_CEC_MAX_PAYLOAD - 2);
+            payloadSize = HDMI_CEC_MAX_PAYLOAD - 2;
+        }
+        pResponse->frameSize = payloadSize + 2;
 
-            for(uint8_t j = 0; j < pResponse->payloadSize; j++)
-            {
-                snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/response/payload/%d" , i, j);
-                pResponse->payload[j] = UT_KVP_PROFILE_GET_UINT8(key_string);
-            }
+        for(uint32_t j = 0; j < payloadSize; j++)
+        {
+            snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/response/payload/%d" , i, j);
+            pResponse->frame[j + 2] = ut_kvp_getUInt8Field(instance, key_string);
+        }
 
-            snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/response/update_payload" , i);
-            pResponse->updatePhysicalAddress = UT_KVP_PROFILE_GET_BOOL(key_string);
+        snprintf(key_string, HDMI_CEC_KVP_SIZE, "hdmicec/cec_responses/%d/response/update_payload" , i);
+        pResponse->updatePhysicalAddress = ut_kvp_getBoolField(instance, key_string);
+    }
+}
 
-            if (pResponse->updatePhysicalAddress)
-            {
-                pResponse->payload[0] = (((uint8_t)gPhysicalAddressBytes[3] << 4) & 0xF0) | (gPhysicalAddressBytes[2] & 0x0F);
-                pResponse->payload[1] = (((uint8_t)gPhysicalAddressBytes[1] << 4) & 0xF0) | (gPhysicalAddressBytes[0] & 0x0F);
-            }
+/**
+ * @brief Patches the device physical address into the responses that carry it.
+ *
+ * Called whenever the physical address is read from the HAL.
+ */
+static void updateResponsePhysicalAddress(void)
+{
+    for (uint32_t opcode = 0; opcode < HDMI_CEC_MAX_OPCODES; opcode++)
+    {
+        cecResponse_t *pResponse = &gResponseTable[opcode];
 
-            return true;
+        if (pResponse->updatePhysicalAddress && pResponse->frameSize >= 4)
+        {
+            pResponse->frame[2] = (((uint8_t)gPhysicalAddressBytes[3] << 4) & 0xF0) | (gPhysicalAddressBytes[2] & 0x0F);
+            pResponse->frame[3] = (((uint8_t)gPhysicalAddressBytes[1] << 4) & 0xF0) | (gPhysicalAddressBytes[0] & 0x0F);
         }
     }
-
-    /* If the received opcode is not found in the supported list send feature abort response */
-    pResponse->cecCommand = 0x00; //Feature abort
-    pResponse->payloadSize = 2;
-    pResponse->payload[0] = opcode;
-    pResponse->payload[1] = 0x01; //Unsupported opcode
-    strncpy(pResponse->type, "Direct", UT_KVP_MAX_ELEMENT_SIZE);
-
-    return false;
 }
 
 static void sendResponse(int32_t handle, uint8_t initiator, uint8_t destination,
-                         uint8_t *buf, int32_t len, cecResponse_t *pCecResponse)
+                         uint8_t *buf, int32_t len, const cecResponse_t *pCecResponse)
 {
-    uint8_t prBuffer[HDMI_CEC_MAX_PAYLOAD] = {0};
-    uint8_t response[HDMI_CEC_MAX_PAYLOAD] = {0};
+    uint8_t prBuffer[HDMI_CEC_MAX_PAYLOAD * 3] = {0};
+    uint8_t response[HDMI_CEC_MAX_PAYLOAD];
 
-    if (pCecResponse->payloadSize)
+    //Responses without payload are not sent
+    if (pCecResponse->frameSize > 2)
     {
         int32_t result;
         const char* commandName;
         int32_t expectedDataLength;
 
-        if (!strcmp(pCecResponse->type, "Direct"))
+        memcpy(response, pCecResponse->frame, pCecResponse->frameSize);
+        if (!pCecResponse->broadcast)
         {
             response[0] = (destination << 4) | initiator;
         }
@@ -330,17 +428,11 @@ static void sendResponse(int32_t handle, uint8_t initiator, uint8_t destination,
             //Send braodcast message
             response[0] = (gLogicalAddress << 4) | gBroadcastAddress;
         }
-        response[1] = pCecResponse->cecCommand;
-
-        for (int32_t index = 0; index < pCecResponse->payloadSize; index++)
-        {
-            response[index + 2] = pCecResponse->payload[index];
-        }
 
         {
             uint8_t *temp = prBuffer;
             // Log each byte received in the buffer
-            for (int32_t index = 0; index < pCecResponse->payloadSize + 2; index++)
+            for (int32_t index = 0; index < pCecResponse->frameSize; index++)
             {
                 int32_t len = 0;
                 len = snprintf(temp, HDMI_CEC_MAX_PAYLOAD, "%02X:", response[index]);
@@ -350,63 +442,204 @@ static void sendResponse(int32_t handle, uint8_t initiator, uint8_t destination,
 
         }
 
-        HdmiCecTx(handle, response, pCecResponse->payloadSize + 2, &result);
+        HdmiCecTx(handle, response, pCecResponse->frameSize, &result);
+        test_events_frame("tx_response", 0, response, pCecResponse->frameSize, UT_Control_GetMapString(cecError_mapTable, result));
 
-        getCecCommandInfo(pCecResponse->cecCommand, &commandName, &expectedDataLength);
+        getCecCommandInfo(response[1], &commandName, &expectedDataLength);
 
         UT_LOG_INFO("Sent Response Opcode: [0x%02X] [%s] Initiator: [%x], Destination: [%x] Data: [%s]\n",
-                                 pCecResponse->cecCommand, commandName, destination, initiator, prBuffer);
+                                 response[1], commandName, destination, initiator, prBuffer);
     }
 }
 
-static void onRxDataReceived(int32_t handle, void *callbackData, uint8_t *buf, int32_t len)
+static uint64_t getTimeNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * NSEC_PER_SEC) + (uint64_t)ts.tv_nsec;
+}
+
+static bool responderEnqueue(int32_t handle, uint8_t *buf, int32_t len)
+{
+    uint32_t head = atomic_load_explicit(&gResponder.head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&gResponder.tail, memory_order_acquire);
+    cecRxFrame_t *frame;
+
+    if ((head - tail) >= RESPONDER_QUEUE_SIZE)
+    {
+        atomic_fetch_add_explicit(&gResponder.dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    frame = &gResponder.frames[head & (RESPONDER_QUEUE_SIZE - 1)];
+    frame->rxTimeNs = getTimeNs();
+    frame->handle = handle;
+    frame->len = (len > HDMI_CEC_MAX_PAYLOAD) ? HDMI_CEC_MAX_PAYLOAD : len;
+    memcpy(frame->buf, buf, frame->len);
+
+    atomic_store_explicit(&gResponder.head, head + 1, memory_order_release);
+    sem_post(&gResponder.available);
+    return true;
+}
+
+static bool responderDequeue(cecRxFrame_t *out)
 {
-    UT_LOG_INFO("In %s(IN: handle: [%p], IN: callbackData: [%p], IN: buf: [%p], IN: len: [%d])\n", __FUNCTION__, handle, callbackData, buf, len);
+    uint32_t tail = atomic_load_explicit(&gResponder.tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&gResponder.head, memory_order_acquire);
 
+    if (head == tail)
+    {
+        return false;
+    }
+    *out = gResponder.frames[tail & (RESPONDER_QUEUE_SIZE - 1)];
+    atomic_store_explicit(&gResponder.tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Logs the received frame and transmits the response from the response table.
+ *
+ * Runs on the responder thread.
+ */
+static void processRxFrame(const cecRxFrame_t *frame)
+{
     const char* commandName;
     int32_t expectedDataLength;
+    uint8_t initiator = (frame->buf[0] >> 4) & 0xF;  // Extract initiator address
+    uint8_t destination = frame->buf[0] & 0xF;       // Extract destination address
+    uint8_t opcode;                                  // Command opcode
+    uint8_t prBuffer[HDMI_CEC_MAX_PAYLOAD * 3] = {0};
+    uint64_t txStart, txEnd;
 
-    if ((handle != 0) && (callbackData != NULL) && (len > 0))
+    test_events_frame("rx_frame", frame->rxTimeNs, frame->buf, frame->len, NULL);
+
+    if( frame->len == 1)
     {
-        // Parse the command
-        uint8_t initiator = (buf[0] >> 4) & 0xF;  // Extract initiator address
-        uint8_t destination = buf[0] & 0xF;       // Extract destination address
-        uint8_t opcode;                           // Command opcode
-        cecResponse_t cecResponse = {0};          // cec response
-        uint8_t prBuffer[HDMI_CEC_MAX_PAYLOAD] = {0};
-        bool result = false;
+        UT_LOG_INFO("Received Ping message Initiator: [%x], Destination: [%x]", initiator, destination);
+        return;
+    }
 
-        if( len == 1)
-        {
-            UT_LOG_INFO("Received Ping message Initiator: [%x], Destination: [%x]", initiator, destination);
-            goto exit;
-        }
+    opcode = frame->buf[1];
 
-        opcode = buf[1];
+    if(getCecCommandInfo(opcode, &commandName, &expectedDataLength) != 0)
+    {
+        UT_LOG_WARNING("CEC command 0x%02X is not recognized", opcode);
+        return;
+    }
 
-        if(getCecCommandInfo(opcode, &commandName, &expectedDataLength) != 0)
+    {
+        uint8_t *temp = prBuffer;
+        // Log each byte received in the buffer
+        for (int32_t index = 0; index < frame->len; index++)
         {
-            UT_LOG_WARNING("CEC command 0x%02X is not recognized", opcode);
-            goto exit;
+            int32_t len = 0;
+            len = snprintf(temp, HDMI_CEC_MAX_PAYLOAD, "%02X:", frame->buf[index]);
+            temp += len;
         }
+        prBuffer[strlen(prBuffer)-1] = '\0';
+    }
+
+    UT_LOG_INFO("Received Opcode: [0x%02X] [%s] Initiator: [%x], Destination: [%x] Data: [%s]\n", opcode, commandName, initiator, destination, prBuffer);
+
+    pthread_mutex_lock(&gRxOpcodeMutex);
+    gRxOpcodeCount[opcode]++;
+    pthread_cond_broadcast(&gRxOpcodeCond);
+    pthread_mutex_unlock(&gRxOpcodeMutex);
+
+    if (gResponseTable[opcode].frameSize <= 2)
+    {
+        return;
+    }
+
+    txStart = getTimeNs();
+    sendResponse(frame->handle, initiator, destination, (uint8_t *)frame->buf, frame->len, &gResponseTable[opcode]);
+    txEnd = getTimeNs();
+
+    gResponder.responses++;
+    gResponder.latencyTotalNs += txEnd - frame->rxTimeNs;
+    if (gResponder.latencyMinNs == 0 || (txEnd - frame->rxTimeNs) < gResponder.latencyMinNs)
+    {
+        gResponder.latencyMinNs = txEnd - frame->rxTimeNs;
+    }
+    if ((txEnd - frame->rxTimeNs) > gResponder.latencyMaxNs)
+    {
+        gResponder.latencyMaxNs = txEnd - frame->rxTimeNs;
+    }
+    gResponder.txTotalNs += txEnd - txStart;
+    if ((txEnd - txStart) > gResponder.txMaxNs)
+    {
+        gResponder.txMaxNs = txEnd - txStart;
+    }
+}
+
+static void *responderThread(void *arg)
+{
+    cecRxFrame_t frame;
+    (void)arg;
 
+    while (atomic_load(&gResponder.running))
+    {
+        while (sem_wait(&gResponder.available) == -1 && errno == EINTR);
+
+        while (responderDequeue(&frame))
         {
-            uint8_t *temp = prBuffer;
-            // Log each byte received in the buffer
-            for (int32_t index = 0; index < len; index++)
-            {
-                int32_t len = 0;
-                len = snprintf(temp, HDMI_CEC_MAX_PAYLOAD, "%02X:", buf[index]);
-                temp += len;
-            }
-            prBuffer[strlen(prBuffer)-1] = '\0';
+            processRxFrame(&frame);
         }
+    }
+    return NULL;
+}
 
-        UT_LOG_INFO("Received Opcode: [0x%02X] [%s] Initiator: [%x], Destination: [%x] Data: [%s]\n", opcode, commandName, initiator, destination, prBuffer);
+static int32_t startResponder(void)
+{
+    //Init may be selected twice, keep the worker that is already running
+    if (atomic_load(&gResponder.running))
+    {
+        return 0;
+    }
+    memset(&gResponder, 0, sizeof(gResponder));
+    sem_init(&gResponder.available, 0, 0);
+    atomic_store(&gResponder.running, true);
 
-        result = getCommandResponse(opcode, &cecResponse);
+    if (pthread_create(&gResponder.thread, NULL, responderThread, NULL) != 0)
+    {
+        UT_LOG_ERROR("Failed to create the responder thread");
+        atomic_store(&gResponder.running, false);
+        sem_destroy(&gResponder.available);
+        return -1;
+    }
+    return 0;
+}
+
+static void stopResponder(void)
+{
+    if (!atomic_load(&gResponder.running))
+    {
+        return;
+    }
+    atomic_store(&gResponder.running, false);
+    sem_post(&gResponder.available);
+    pthread_join(gResponder.thread, NULL);
+    sem_destroy(&gResponder.available);
 
-        sendResponse(handle, initiator, destination, buf, len, &cecResponse);
+    UT_LOG_INFO("Responder: responses:[%u] dropped:[%u]", gResponder.responses, atomic_load(&gResponder.dropped));
+    if (gResponder.responses > 0)
+    {
+        UT_LOG_INFO("Responder: rx to response sent min:[%.3f ms] avg:[%.3f ms] max:[%.3f ms] HdmiCecTx avg:[%.3f ms] max:[%.3f ms]",
+                    gResponder.latencyMinNs / 1e6, (gResponder.latencyTotalNs / gResponder.responses) / 1e6,
+                    gResponder.latencyMaxNs / 1e6, (gResponder.txTotalNs / gResponder.responses) / 1e6,
+                    gResponder.txMaxNs / 1e6);
+    }
+}
+
+static void onRxDataReceived(int32_t handle, void *callbackData, uint8_t *buf, int32_t len)
+{
+    if ((handle != 0) && (callbackData != NULL) && (len > 0))
+    {
+        //Never block the HAL receive thread, the responder thread does the rest
+        if (!responderEnqueue(handle, buf, len))
+        {
+            UT_LOG_WARNING("Responder queue full, frame dropped");
+        }
     }
     else
     {
@@ -424,8 +657,6 @@ static void onRxDataReceived(int32_t handle, void *callbackData, uint8_t *buf, i
             UT_LOG_ERROR("Error: Invalid length.\n");
         }
     }
-exit:
-    UT_LOG_INFO("Out %s\n", __FUNCTION__);
 }
 
 /**
@@ -447,13 +678,18 @@ void test_l3_hdmi_cec_hal_Init(void)
     gTestID = 1;
     HDMI_CEC_STATUS status = HDMI_CEC_IO_SUCCESS;
     int32_t getLogicalAddress = -1;
+    int32_t result;
 
     UT_LOG_INFO("In %s [%02d%03d]\n", __FUNCTION__, gTestGroup, gTestID);
 
+    result = startResponder();
+    assert(result == 0);
+
     // Step 1: Call HdmiCecOpen()
     UT_LOG_INFO("Calling HdmiCecOpen(OUT:handle:[])");
     status = HdmiCecOpen(&gHandle);
     UT_LOG_INFO("Result HdmiCecOpen(OUT:handle:[0x%0X]) HDMI_CEC_STATUS:[%s]",gHandle, UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecOpen", UT_Control_GetMapString(cecError_mapTable,status), NULL);
     assert(status == HDMI_CEC_IO_SUCCESS);
     assert(gHandle != 0);
 
@@ -461,6 +697,7 @@ void test_l3_hdmi_cec_hal_Init(void)
     UT_LOG_INFO("Calling HdmiCecSetRxCallback(IN:handle:[0x%0X], IN:cbfunc:[0x%0X])",gHandle, onRxDataReceived);
     status = HdmiCecSetRxCallback(gHandle, onRxDataReceived,(void*)0xABABABAB);
     UT_LOG_INFO("Result HdmiCecSetRxCallback(IN:handle:[0x%0X], IN:cbfunc:[0x%0X]) HDMI_CEC_STATUS:[%s]",gHandle,onRxDataReceived, UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecSetRxCallback", UT_Control_GetMapString(cecError_mapTable,status), NULL);
     assert(status == HDMI_CEC_IO_SUCCESS);
 
     gPhysicalAddressBytes = (uint8_t*)&gPhysicalAddress;
@@ -470,13 +707,18 @@ void test_l3_hdmi_cec_hal_Init(void)
     UT_LOG_INFO("Result HdmiCecGetPhysicalAddress(IN:handle:[0x%0X], OUT:physicalAddress:[%01x.%01x.%01x.%01x]) HDMI_CEC_STATUS:[%s]", gHandle,
                                                   gPhysicalAddressBytes[3], gPhysicalAddressBytes[2], gPhysicalAddressBytes[1], gPhysicalAddressBytes[0],
                                                   UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecGetPhysicalAddress", UT_Control_GetMapString(cecError_mapTable,status),
+                         "\"physical_address\":\"%01x.%01x.%01x.%01x\"",
+                         gPhysicalAddressBytes[3], gPhysicalAddressBytes[2], gPhysicalAddressBytes[1], gPhysicalAddressBytes[0]);
     assert(status == HDMI_CEC_IO_SUCCESS);
+    updateResponsePhysicalAddress();
 
     if (gDeviceType == SOURCE)
     {
         UT_LOG_INFO("Calling HdmiCecGetLogicalAddress(IN:handle:[0x%0X], OUT:logicalAddress:[])", gHandle);
         status = HdmiCecGetLogicalAddress(gHandle, &getLogicalAddress);
         UT_LOG_INFO("Result HdmiCecGetLogicalAddress(IN:handle:[0x%0X], OUT:logicalAddress:[%x]) HDMI_CEC_STATUS:[%s])", gHandle, getLogicalAddress, UT_Control_GetMapString(cecError_mapTable,status));
+        test_events_hal_call("HdmiCecGetLogicalAddress", UT_Control_GetMapString(cecError_mapTable,status), "\"logical_address\":%d", getLogicalAddress);
 
         gLogicalAddress = getLogicalAddress;
     }
@@ -528,11 +770,13 @@ void test_l3_hdmi_cec_hal_AddLogicalAddress(void)
     UT_LOG_INFO("Calling HdmiCecAddLogicalAddress(IN:handle:[0x%0X], IN:logicalAddress:[%x]", gHandle, logicalAddress);
     status = HdmiCecAddLogicalAddress(gHandle, logicalAddress);
     UT_LOG_INFO("Result HdmiCecAddLogicalAddress (IN:handle:[0x%0X], IN:logicalAddress:[%x]) HDMI_CEC_STATUS[%s]",gHandle,logicalAddress,UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecAddLogicalAddress", UT_Control_GetMapString(cecError_mapTable,status), "\"logical_address\":%d", logicalAddress);
     assert(status == HDMI_CEC_IO_SUCCESS);
 
     UT_LOG_INFO("Calling HdmiCecGetLogicalAddress(IN:handle:[0x%0X], OUT:logicalAddress:[])", gHandle);
     status = HdmiCecGetLogicalAddress(gHandle, &getLogicalAddress);
     UT_LOG_INFO("Result HdmiCecGetLogicalAddress(IN:handle:[0x%0X], OUT:logicalAddress:[%x]) HDMI_CEC_STATUS:[%s])", gHandle, getLogicalAddress, UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecGetLogicalAddress", UT_Control_GetMapString(cecError_mapTable,status), "\"logical_address\":%d", getLogicalAddress);
     assert(status == HDMI_CEC_IO_SUCCESS);
     assert(logicalAddress == getLogicalAddress);
 
@@ -567,6 +811,7 @@ void test_l3_hdmi_cec_hal_GetLogicalAddress(void)
     UT_LOG_INFO("Calling HdmiCecGetLogicalAddress(IN:handle:[0x%0X], OUT:logicalAddress:[])", gHandle);
     status = HdmiCecGetLogicalAddress(gHandle, &logicalAddress);
     UT_LOG_INFO("Result HdmiCecGetLogicalAddress(IN:handle:[0x%0X], OUT:logicalAddress:[%x]) HDMI_CEC_STATUS:[%s])", gHandle, logicalAddress, UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecGetLogicalAddress", UT_Control_GetMapString(cecError_mapTable,status), "\"logical_address\":%d", logicalAddress);
     assert(status == HDMI_CEC_IO_SUCCESS);
     assert(logicalAddress >= 0 && logicalAddress <= 15);
 
@@ -648,6 +893,8 @@ void test_l3_hdmi_cec_hal_TransmitHdmiCecCommand(void) {
     UT_LOG_INFO("Calling HdmiCecTx(IN:handle:[0x%0X], IN:buf:[%p], IN:len:[%d], OUT:result:[])", gHandle, buf, len);
     int32_t status = HdmiCecTx(gHandle, buf, len, &result);
     UT_LOG_INFO("Result HdmiCecTx(IN:handle:[0x%0X], IN:buf:[%p], IN:len:[%d], OUT:result:[%s]) HDMI_CEC_STATUS:[%s]", gHandle, buf, len, UT_Control_GetMapString(cecError_mapTable, result)? UT_Control_GetMapString(cecError_mapTable, result):"HDMI_CEC_IO_SENT_FAILED", UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecTx", UT_Control_GetMapString(cecError_mapTable,status),
+                         "\"result\":\"%s\"", UT_Control_GetMapString(cecError_mapTable, result) ? UT_Control_GetMapString(cecError_mapTable, result) : "HDMI_CEC_IO_SENT_FAILED");
     assert(status == HDMI_CEC_IO_SUCCESS || status == HDMI_CEC_IO_SENT_AND_ACKD || status == HDMI_CEC_IO_SENT_BUT_NOT_ACKD );
 
     UT_LOG_INFO("Out %s\n", __FUNCTION__);
@@ -680,7 +927,11 @@ void test_l3_hdmi_cec_hal_GetPhysicalAddress(void)
     UT_LOG_INFO("Result HdmiCecGetPhysicalAddress(IN:handle:[0x%0X], OUT:physicalAddress:[%01x.%01x.%01x.%01x]) HDMI_CEC_STATUS:[%s]", gHandle,
                                                   gPhysicalAddressBytes[3], gPhysicalAddressBytes[2], gPhysicalAddressBytes[1], gPhysicalAddressBytes[0],
                                                   UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecGetPhysicalAddress", UT_Control_GetMapString(cecError_mapTable,status),
+                         "\"physical_address\":\"%01x.%01x.%01x.%01x\"",
+                         gPhysicalAddressBytes[3], gPhysicalAddressBytes[2], gPhysicalAddressBytes[1], gPhysicalAddressBytes[0]);
     assert(status == HDMI_CEC_IO_SUCCESS);
+    updateResponsePhysicalAddress();
 
     UT_LOG_INFO("Out %s\n", __FUNCTION__);
 }
@@ -721,6 +972,7 @@ void test_l3_hdmi_cec_hal_RemoveLogicalAddress(void)
     UT_LOG_INFO("Calling HdmiCecRemoveLogicalAddress(IN:handle:[0x%0X], IN:logicalAddress:[%d])", gHandle, logicalAddress);
     status = HdmiCecRemoveLogicalAddress(gHandle, logicalAddress);
     UT_LOG_INFO("Result HdmiCecRemoveLogicalAddress(IN:handle:[0x%0X], IN:logicalAddress:[%d]) HDMI_CEC_STATUS:[%s])", gHandle, logicalAddress, UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecRemoveLogicalAddress", UT_Control_GetMapString(cecError_mapTable,status), "\"logical_address\":%d", logicalAddress);
     assert(status == HDMI_CEC_IO_SUCCESS);
 
     gLogicalAddress = -1;
@@ -748,15 +1000,354 @@ void test_l3_hdmi_cec_hal_Close(void)
 
     UT_LOG_INFO("In %s [%02d%03d]\n", __FUNCTION__, gTestGroup, gTestID);
 
+    //No frame may reach responderEnqueue once the responder semaphore is destroyed
+    UT_LOG_INFO("Calling HdmiCecSetRxCallback(IN:handle:[0x%0X], IN:cbfunc:[NULL])", gHandle);
+    status = HdmiCecSetRxCallback(gHandle, NULL, NULL);
+    UT_LOG_INFO("Result HdmiCecSetRxCallback(IN:handle:[0x%0X], IN:cbfunc:[NULL]) HDMI_CEC_STATUS:[%s]", gHandle, UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecSetRxCallback", UT_Control_GetMapString(cecError_mapTable,status), NULL);
+
+    //Frames already queued are answered before the responder exits
+    stopResponder();
+
     UT_LOG_INFO("Calling HdmiCecClose(IN:handle:[0x%0X])", gHandle);
     status = HdmiCecClose(gHandle);
     UT_LOG_INFO("Result HdmiCecClose(IN:handle:[0x%0X]) HDMI_CEC_STATUS:[%s]", gHandle, UT_Control_GetMapString(cecError_mapTable,status));
+    test_events_hal_call("HdmiCecClose", UT_Control_GetMapString(cecError_mapTable,status), NULL);
     assert(status == HDMI_CEC_IO_SUCCESS);
     gHandle = 0;
 
     UT_LOG_INFO("Out %s\n", __FUNCTION__);
 }
 
+/**
+ * @brief Waits until the count of received frames for opcode exceeds since, or the timeout expires.
+ *
+ * @return true if the opcode was received
+ */
+static bool scriptWaitForOpcode(uint8_t opcode, uint32_t since, uint32_t timeoutMs)
+{
+    struct timespec ts;
+    bool received;
+    int32_t rc = 0;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += timeoutMs / 1000;
+    ts.tv_nsec += (timeoutMs % 1000) * NSEC_PER_MSEC;
+    if (ts.tv_nsec >= (long)NSEC_PER_SEC)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= NSEC_PER_SEC;
+    }
+
+    pthread_mutex_lock(&gRxOpcodeMutex);
+    while (gRxOpcodeCount[opcode] <= since && rc != ETIMEDOUT)
+    {
+        rc = pthread_cond_timedwait(&gRxOpcodeCond, &gRxOpcodeMutex, &ts);
+    }
+    received = (gRxOpcodeCount[opcode] > since);
+    pthread_mutex_unlock(&gRxOpcodeMutex);
+
+    return received;
+}
+
+static uint32_t scriptRxCount(uint8_t opcode)
+{
+    uint32_t count;
+
+    pthread_mutex_lock(&gRxOpcodeMutex);
+    count = gRxOpcodeCount[opcode];
+    pthread_mutex_unlock(&gRxOpcodeMutex);
+    return count;
+}
+
+/**
+ * @brief Parses a script argument, the whole argument has to be a number no larger than max.
+ *
+ * @return true if the argument is valid
+ */
+static bool scriptParseNumber(const char *arg, int32_t base, unsigned long max, unsigned long *value)
+{
+    char *end = NULL;
+
+    if (arg == NULL || *arg == '\0' || *arg == '-' || *arg == '+')
+    {
+        return false;
+    }
+    errno = 0;
+    *value = strtoul(arg, &end, base);
+    return (errno == 0 && *end == '\0' && *value <= max);
+}
+
+/**
+ * @brief Runs one script command.
+ *
+ * @param[in] line - command line, modified by strtok
+ * @param[in,out] rxMark - per opcode receive counts at the start of the script or the last "tx", used by "wait"
+ * @param[out] detail - human readable result
+ * @return true if the command passed
+ */
+static bool scriptRunCommand(char *line, uint32_t *rxMark, char *detail, size_t detailSize)
+{
+    char *save = NULL;
+    char *cmd = strtok_r(line, " \t", &save);
+    char *arg;
+    unsigned long value;
+    HDMI_CEC_STATUS status;
+
+    if (!strcmp(cmd, "add_la") || !strcmp(cmd, "remove_la"))
+    {
+        int32_t logicalAddress;
+
+        arg = strtok_r(NULL, " \t", &save);
+        if (arg == NULL)
+        {
+            snprintf(detail, detailSize, "missing logical address");
+            return false;
+        }
+        if (!scriptParseNumber(arg, 16, 0x0F, &value))
+        {
+            snprintf(detail, detailSize, "invalid logical address:[%s]", arg);
+            return false;
+        }
+        logicalAddress = (int32_t)value;
+        if (!strcmp(cmd, "add_la"))
+        {
+            status = HdmiCecAddLogicalAddress(gHandle, logicalAddress);
+            test_events_hal_call("HdmiCecAddLogicalAddress", UT_Control_GetMapString(cecError_mapTable, status), "\"logical_address\":%d", logicalAddress);
+            if (status == HDMI_CEC_IO_SUCCESS)
+            {
+                gLogicalAddress = logicalAddress;
+            }
+        }
+        else
+        {
+            status = HdmiCecRemoveLogicalAddress(gHandle, logicalAddress);
+            test_events_hal_call("HdmiCecRemoveLogicalAddress", UT_Control_GetMapString(cecError_mapTable, status), "\"logical_address\":%d", logicalAddress);
+        }
+        snprintf(detail, detailSize, "HDMI_CEC_STATUS:[%s]", UT_Control_GetMapString(cecError_mapTable, status));
+        return (status == HDMI_CEC_IO_SUCCESS);
+    }
+    else if (!strcmp(cmd, "tx"))
+    {
+        uint8_t buf[16] = {0};
+        uint8_t destination;
+        int32_t len = 1;
+        int32_t result = HDMI_CEC_IO_SENT_FAILED;
+        const char *resultString;
+
+        //tx <destination> [opcode] [data bytes...], all in hex
+        arg = strtok_r(NULL, " \t", &save);
+        if (arg == NULL || gLogicalAddress == -1)
+        {
+            snprintf(detail, detailSize, (arg == NULL) ? "missing destination" : "no logical address");
+            return false;
+        }
+        if (!scriptParseNumber(arg, 16, 0x0F, &value))
+        {
+            snprintf(detail, detailSize, "invalid destination:[%s]", arg);
+            return false;
+        }
+        destination = (uint8_t)value;
+        buf[0] = (uint8_t)((gLogicalAddress << 4) | destination);
+        while ((arg = strtok_r(NULL, " \t", &save)) != NULL)
+        {
+            if (len == (int32_t)sizeof(buf))
+            {
+                snprintf(detail, detailSize, "more than [%u] bytes", (uint32_t)sizeof(buf));
+                return false;
+            }
+            if (!scriptParseNumber(arg, 16, 0xFF, &value))
+            {
+                snprintf(detail, detailSize, "invalid byte:[%s]", arg);
+                return false;
+            }
+            buf[len++] = (uint8_t)value;
+        }
+
+        for (int32_t i = 0; i < HDMI_CEC_MAX_OPCODES; i++)
+        {
+            rxMark[i] = scriptRxCount((uint8_t)i);
+        }
+
+        status = HdmiCecTx(gHandle, buf, len, &result);
+        resultString = UT_Control_GetMapString(cecError_mapTable, result);
+        test_events_hal_call("HdmiCecTx", UT_Control_GetMapString(cecError_mapTable, status), "\"result\":\"%s\"",
+                             resultString ? resultString : "HDMI_CEC_IO_SENT_FAILED");
+        snprintf(detail, detailSize, "HDMI_CEC_STATUS:[%s] result:[%s]",
+                 UT_Control_GetMapString(cecError_mapTable, status), resultString ? resultString : "HDMI_CEC_IO_SENT_FAILED");
+        if (status != HDMI_CEC_IO_SUCCESS && status != HDMI_CEC_IO_SENT_AND_ACKD && status != HDMI_CEC_IO_SENT_BUT_NOT_ACKD)
+        {
+            return false;
+        }
+        //A directed frame has to be acknowledged, nobody acknowledges a broadcast
+        if (destination != 0x0F)
+        {
+            return (result == HDMI_CEC_IO_SENT_AND_ACKD);
+        }
+        return (result != HDMI_CEC_IO_SENT_FAILED);
+    }
+    else if (!strcmp(cmd, "wait"))
+    {
+        uint8_t opcode;
+        uint32_t timeoutMs = SCRIPT_DEFAULT_WAIT_MS;
+
+        //wait <opcode> [timeout_ms], waits for the opcode to be received after the last tx
+        arg = strtok_r(NULL, " \t", &save);
+        if (arg == NULL)
+        {
+            snprintf(detail, detailSize, "missing opcode");
+            return false;
+        }
+        if (!scriptParseNumber(arg, 16, 0xFF, &value))
+        {
+            snprintf(detail, detailSize, "invalid opcode:[%s]", arg);
+            return false;
+        }
+        opcode = (uint8_t)value;
+        arg = strtok_r(NULL, " \t", &save);
+        if (arg != NULL)
+        {
+            if (!scriptParseNumber(arg, 10, UINT32_MAX, &value))
+            {
+                snprintf(detail, detailSize, "invalid timeout:[%s]", arg);
+                return false;
+            }
+            timeoutMs = (uint32_t)value;
+        }
+        if (scriptWaitForOpcode(opcode, rxMark[opcode], timeoutMs))
+        {
+            snprintf(detail, detailSize, "opcode:[0x%02X] received", opcode);
+            return true;
+        }
+        snprintf(detail, detailSize, "opcode:[0x%02X] not received within [%u ms]", opcode, timeoutMs);
+        return false;
+    }
+    else if (!strcmp(cmd, "sleep"))
+    {
+        arg = strtok_r(NULL, " \t", &save);
+        if (arg == NULL)
+        {
+            snprintf(detail, detailSize, "missing duration");
+            return false;
+        }
+        if (!scriptParseNumber(arg, 10, UINT32_MAX / 1000, &value))
+        {
+            snprintf(detail, detailSize, "invalid duration:[%s]", arg);
+            return false;
+        }
+        usleep((useconds_t)value * 1000);
+        snprintf(detail, detailSize, "slept:[%s ms]", arg);
+        return true;
+    }
+
+    snprintf(detail, detailSize, "unknown command");
+    return false;
+}
+
+/**
+* @brief Runs a script of CEC commands without interactive prompts
+*
+* Reads commands from a script file, or from stdin when the path is "-" (terminated by "end").
+* One command per line, arguments in hex unless stated otherwise:
+* - add_la <logical address>
+* - remove_la <logical address>
+* - tx <destination> [opcode] [data bytes...]
+* - wait <opcode> [timeout ms, decimal]  - waits for the opcode to be received after the last tx
+* - sleep <ms, decimal>
+* Empty lines and lines starting with '#' are ignored.
+* Each command prints a "SCRIPT" result line and the run ends with a "SCRIPT SUMMARY" line.
+*
+* **Test Group ID:** 03@n
+*
+* **Test Case ID:** 008@n
+*
+* **Pre-Conditions:** @n
+* HDMI-CEC Module should be intialized through Test 1 before calling this test.
+*
+* **Dependencies:** None@n
+*
+*/
+void test_l3_hdmi_cec_hal_RunScript(void)
+{
+    char path[SCRIPT_MAX_PATH];
+    char line[SCRIPT_MAX_LINE];
+    char command[SCRIPT_MAX_LINE];
+    char detail[SCRIPT_MAX_LINE];
+    uint32_t rxMark[HDMI_CEC_MAX_OPCODES] = {0};
+    uint32_t lineNumber = 0, passed = 0, failed = 0;
+    uint64_t runStart, start;
+    FILE *script;
+
+    gTestID = 8;
+    UT_LOG_INFO("In %s [%02d%03d]\n", __FUNCTION__, gTestGroup, gTestID);
+
+    UT_LOG_MENU_INFO("Enter script path (- for stdin, terminated by '%s'):", SCRIPT_END);
+    readString(path, sizeof(path));
+
+    if (!strcmp(path, "-"))
+    {
+        script = stdin;
+    }
+    else
+    {
+        script = fopen(path, "r");
+        if (script == NULL)
+        {
+            UT_LOG_ERROR("Failed to open script [%s]", path);
+            UT_LOG_INFO("Out %s\n", __FUNCTION__);
+            return;
+        }
+    }
+
+    //A wait before any tx only matches frames received once the script has started
+    for (int32_t i = 0; i < HDMI_CEC_MAX_OPCODES; i++)
+    {
+        rxMark[i] = scriptRxCount((uint8_t)i);
+    }
+
+    runStart = getTimeNs();
+    while (fgets(line, sizeof(line), script) != NULL)
+    {
+        bool pass;
+        char *text = line;
+
+        lineNumber++;
+        line[strcspn(line, "\r\n")] = '\0';
+        while (*text == ' ' || *text == '\t')
+        {
+            text++;
+        }
+        if (*text == '\0' || *text == '#')
+        {
+            continue;
+        }
+        if (!strcmp(text, SCRIPT_END))
+        {
+            break;
+        }
+
+        strncpy(command, text, sizeof(command) - 1);
+        command[sizeof(command) - 1] = '\0';
+        start = getTimeNs();
+        pass = scriptRunCommand(text, rxMark, detail, sizeof(detail));
+        pass ? passed++ : failed++;
+
+        UT_LOG_INFO("SCRIPT [%u] cmd:[%s] %s elapsed:[%.3f ms] verdict:[%s]", lineNumber, command, detail,
+                    (getTimeNs() - start) / 1e6, pass ? "PASS" : "FAIL");
+    }
+
+    if (script != stdin)
+    {
+        fclose(script);
+    }
+
+    UT_LOG_INFO("SCRIPT SUMMARY commands:[%u] passed:[%u] failed:[%u] duration:[%.3f ms]",
+                passed + failed, passed, failed, (getTimeNs() - runStart) / 1e6);
+    UT_ASSERT_EQUAL(failed, 0);
+
+    UT_LOG_INFO("Out %s\n", __FUNCTION__);
+}
+
 static UT_test_suite_t * pSuite = NULL;
 
 /**
@@ -799,6 +1390,8 @@ int32_t test_register_hdmicec_hal_l3_tests(void)
         return -1;
     }
 
+    compileResponseTable();
+
     // List of test function names and strings
     UT_add_test( pSuite, "Init HDMI CEC", test_l3_hdmi_cec_hal_Init);
     UT_add_test( pSuite, "Add Logical Address", test_l3_hdmi_cec_hal_AddLogicalAddress);
@@ -807,6 +1400,7 @@ int32_t test_register_hdmicec_hal_l3_tests(void)
     UT_add_test( pSuite, "Get Phyiscal Address", test_l3_hdmi_cec_hal_GetPhysicalAddress);
     UT_add_test( pSuite, "Remove Logical Address", test_l3_hdmi_cec_hal_RemoveLogicalAddress);
     UT_add_test( pSuite, "Close HDMI CEC", test_l3_hdmi_cec_hal_Close);
+    UT_add_test( pSuite, "Run CEC Script", test_l3_hdmi_cec_hal_RunScript);
 
     return 0;
 }
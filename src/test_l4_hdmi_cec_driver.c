@@ -0,0 +1,1042 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:*
+* Copyright 2024 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+/**
+ * @addtogroup HPK Hardware Porting Kit
+ * @{
+ *
+ */
+/**
+ * @addtogroup HDMI_CEC HDMI CEC Module
+ * @{
+ *
+ */
+/**
+ * @defgroup HDMI_CEC_HALTESTS HDMI CEC HAL Tests
+ * @{
+ *
+ */
+
+/**
+ * @defgroup HDMI_CEC_HALTESTS_L4 HDMI CEC HAL Tests L4 File
+ * @{
+ * @parblock
+ *
+ * ### L4 Benchmark Cases for HDMI CEC HAL :
+ *
+ *
+ * ## Module's Role
+ * This module includes Level 4 performance benchmarks.
+ * Each HAL API is called repeatedly and the min, p50, p99 and max latency is reported.
+ * Sustained HdmiCecTx throughput and Rx callback delivery latency are measured as well.
+ * The same suite runs against the vendor libRCECHal.so and the virtual component,
+ * so that the results of different HAL drops can be compared.
+ *
+ * The results can be recorded to a baseline file named after HALIF_TEST_TAG_VERSION,
+ * and later runs compared against it. A run fails when the p50 or p99 latency of any
+ * benchmark exceeds the baseline by more than the configured tolerance.
+ *
+ * **Pre-Conditions:**  None@n
+ * **Dependencies:** None@n
+ *
+ * Refer to API Definition specification documentation : [hdmi-cec_halSpec.md](../../docs/pages/hdmi-cec_halSpec.md)
+ *
+ * @endparblock
+ */
+
+/**
+ * @file test_l4_hdmi_cec_driver.c
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <semaphore.h>
+#include <ut.h>
+#include <ut_log.h>
+#include <ut_kvp.h>
+#include <ut_kvp_profile.h>
+#include "hdmi_cec_driver.h"
+#ifdef VCOMPONENT
+#include "vcHdmiCec.h"
+#endif
+
+#ifndef HALIF_TEST_TAG_VERSION
+#define HALIF_TEST_TAG_VERSION "Not Defined"
+#endif
+
+#define BENCH_DEFAULT_ITERATIONS       1000
+#define BENCH_DEFAULT_TX_ITERATIONS    100
+#define BENCH_DEFAULT_THROUGHPUT_SECS  5
+#define BENCH_DEFAULT_RX_SAMPLES       20
+#define BENCH_RX_TIMEOUT_MS            2000
+
+#define BENCH_MAX_NAME_SIZE            32
+#define BENCH_MAX_RESULTS              16
+#define BENCH_MAX_PATH_SIZE            256
+#define BENCH_MAX_VERSION_SIZE         64
+#define BENCH_MAX_MODE_SIZE            16
+
+#define BENCH_DEFAULT_BASELINE_DIR     "."
+#define BENCH_DEFAULT_P50_TOLERANCE    20
+#define BENCH_DEFAULT_P99_TOLERANCE    50
+#define BENCH_DEFAULT_MIN_DELTA_US     50
+#define HDMI_CEC_DEVICE_TYPE_SIZE      8
+
+#define CEC_GIVE_PHYSICAL_ADDRESS      0x83
+#define CEC_REPORT_PHYSICAL_ADDRESS    0x84
+#define CEC_SINK_LOGICAL_ADDRESS       0x00
+#define CEC_PLAYBACK_LOGICAL_ADDRESS   0x04
+
+#define NSEC_PER_SEC  1000000000ULL
+#define NSEC_PER_MSEC 1000000ULL
+
+typedef enum
+{
+    SINK   = 0,
+    SOURCE = 1
+} benchDeviceType_t;
+
+typedef struct
+{
+    char     name[BENCH_MAX_NAME_SIZE];
+    uint32_t count;
+    uint64_t min_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+} benchResult_t;
+
+typedef enum
+{
+    BASELINE_OFF = 0,
+    BASELINE_RECORD,
+    BASELINE_COMPARE
+} benchBaselineMode_t;
+
+typedef struct
+{
+    benchBaselineMode_t mode;
+    char     dir[BENCH_MAX_PATH_SIZE];
+    char     compareVersion[BENCH_MAX_VERSION_SIZE];
+    uint32_t p50TolerancePercent;
+    uint32_t p99TolerancePercent;
+    uint32_t minDeltaUs;
+} benchBaselineConfig_t;
+
+typedef struct
+{
+    uint32_t iterations;
+    uint32_t txIterations;
+    uint32_t throughputSecs;
+    uint32_t rxSamples;
+    int32_t  rxDestination;
+    benchBaselineConfig_t baseline;
+} benchConfig_t;
+
+static int32_t gTestGroup = 4;
+static int32_t gTestID = 1;
+static int32_t gHandle = 0;
+static int32_t gLogicalAddress = -1;
+static benchDeviceType_t gDeviceType = SINK;
+static benchConfig_t gConfig;
+
+static benchResult_t gResults[BENCH_MAX_RESULTS];
+static uint32_t gNumResults = 0;
+
+#ifdef VCOMPONENT
+extern vcHdmiCec_t* get_virtual_component_handle(void);
+#endif
+
+static sem_t gRxSem;
+static volatile int32_t gRxExpectedInitiator = -1;
+static volatile uint64_t gRxArrivalNs = 0;
+
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * NSEC_PER_SEC) + (uint64_t)ts.tv_nsec;
+}
+
+static int compareU64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t getProfileUInt32(const char *key, uint32_t defaultValue)
+{
+    if (!ut_kvp_fieldPresent(ut_kvp_profile_getInstance(), key))
+    {
+        return defaultValue;
+    }
+    return UT_KVP_PROFILE_GET_UINT32((char *)key);
+}
+
+static void getProfileString(const char *key, char *value, uint32_t size, const char *defaultValue)
+{
+    if (!ut_kvp_fieldPresent(ut_kvp_profile_getInstance(), key) ||
+        ut_kvp_getStringField(ut_kvp_profile_getInstance(), key, value, size) != UT_KVP_STATUS_SUCCESS)
+    {
+        strncpy(value, defaultValue, size - 1);
+        value[size - 1] = '\0';
+    }
+}
+
+/**
+ * @brief Builds the baseline file name for a version, e.g. ./hdmicec_benchmark_1.4.2.yaml
+ *
+ * Characters that are not safe in a file name are replaced by '_'.
+ */
+static void getBaselinePath(const char *version, char *path, uint32_t size)
+{
+    char name[BENCH_MAX_VERSION_SIZE];
+    uint32_t i;
+
+    for (i = 0; version[i] != '\0' && i < sizeof(name) - 1; i++)
+    {
+        name[i] = (version[i] == '/' || version[i] == ' ') ? '_' : version[i];
+    }
+    name[i] = '\0';
+    snprintf(path, size, "%s/hdmicec_benchmark_%s.yaml", gConfig.baseline.dir, name);
+}
+
+/**
+ * @brief Sorts the samples and records min, p50, p99 and max under the given name.
+ */
+static void recordResult(const char *name, uint64_t *samples, uint32_t count)
+{
+    benchResult_t *result;
+
+    if (count == 0 || gNumResults >= BENCH_MAX_RESULTS)
+    {
+        UT_LOG_WARNING("Benchmark [%s] no samples recorded", name);
+        return;
+    }
+
+    qsort(samples, count, sizeof(uint64_t), compareU64);
+
+    result = &gResults[gNumResults++];
+    strncpy(result->name, name, BENCH_MAX_NAME_SIZE - 1);
+    result->name[BENCH_MAX_NAME_SIZE - 1] = '\0';
+    result->count  = count;
+    result->min_ns = samples[0];
+    result->p50_ns = samples[((count - 1) * 50) / 100];
+    result->p99_ns = samples[((count - 1) * 99) / 100];
+    result->max_ns = samples[count - 1];
+
+    UT_LOG_INFO("Benchmark [%s] samples:[%u] min:[%.3f us] p50:[%.3f us] p99:[%.3f us] max:[%.3f us]",
+                result->name, result->count,
+                result->min_ns / 1000.0, result->p50_ns / 1000.0,
+                result->p99_ns / 1000.0, result->max_ns / 1000.0);
+}
+
+static void onRxDataReceived(int32_t handle, void *callbackData, uint8_t *buf, int32_t len)
+{
+    uint64_t arrival = nowNs();
+
+    if ((handle == 0) || (buf == NULL) || (len < 2))
+    {
+        return;
+    }
+
+    if ((buf[1] == CEC_REPORT_PHYSICAL_ADDRESS) && (((buf[0] >> 4) & 0x0F) == gRxExpectedInitiator))
+    {
+        gRxArrivalNs = arrival;
+        sem_post(&gRxSem);
+    }
+}
+
+static void onTxComplete(int32_t handle, void *callbackData, int32_t result)
+{
+    (void)handle;
+    (void)callbackData;
+    (void)result;
+}
+
+static int32_t waitForRx(uint32_t timeoutMs)
+{
+    struct timespec ts;
+    int32_t s;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += timeoutMs / 1000;
+    ts.tv_nsec += (timeoutMs % 1000) * NSEC_PER_MSEC;
+    if (ts.tv_nsec >= (long)NSEC_PER_SEC)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= NSEC_PER_SEC;
+    }
+
+    while ((s = sem_timedwait(&gRxSem, &ts)) == -1 && errno == EINTR)
+    {
+        continue;
+    }
+    return s;
+}
+
+/**
+ * @brief Opens the HAL and makes sure a logical address is available for transmit.
+ */
+static void openDevice(void)
+{
+    HDMI_CEC_STATUS status;
+
+    status = HdmiCecOpen(&gHandle);
+    UT_ASSERT_EQUAL_FATAL(status, HDMI_CEC_IO_SUCCESS);
+    UT_ASSERT_NOT_EQUAL_FATAL(gHandle, 0);
+
+    status = HdmiCecSetRxCallback(gHandle, onRxDataReceived, (void *)0xABABABAB);
+    UT_ASSERT_EQUAL(status, HDMI_CEC_IO_SUCCESS);
+
+    status = HdmiCecSetTxCallback(gHandle, onTxComplete, (void *)0xABABABAB);
+    UT_ASSERT_EQUAL(status, HDMI_CEC_IO_SUCCESS);
+
+    if (gDeviceType == SINK)
+    {
+        status = HdmiCecAddLogicalAddress(gHandle, CEC_SINK_LOGICAL_ADDRESS);
+        UT_ASSERT_EQUAL(status, HDMI_CEC_IO_SUCCESS);
+    }
+
+    status = HdmiCecGetLogicalAddress(gHandle, &gLogicalAddress);
+    UT_ASSERT_EQUAL(status, HDMI_CEC_IO_SUCCESS);
+}
+
+static void closeDevice(void)
+{
+    HDMI_CEC_STATUS status;
+
+    if (gDeviceType == SINK)
+    {
+        HdmiCecRemoveLogicalAddress(gHandle, CEC_SINK_LOGICAL_ADDRESS);
+    }
+
+    status = HdmiCecClose(gHandle);
+    UT_ASSERT_EQUAL(status, HDMI_CEC_IO_SUCCESS);
+    gHandle = 0;
+    gLogicalAddress = -1;
+}
+
+/**
+* @brief Latency of HdmiCecOpen() and HdmiCecClose()
+*
+* Opens and closes the HAL the configured number of iterations and records the
+* latency of each call separately.
+*
+* **Test Group ID:** 04@n
+*
+* **Test Case ID:** 001@n
+*
+* **Pre-Conditions:** HAL is not opened@n
+*
+* **Dependencies:** None@n
+*
+*/
+void test_l4_hdmi_cec_hal_OpenCloseLatency(void)
+{
+    uint64_t *openSamples;
+    uint64_t *closeSamples;
+    uint32_t count = 0;
+    HDMI_CEC_STATUS status;
+    int32_t handle = 0;
+
+    gTestID = 1;
+    UT_LOG_INFO("In %s [%02d%03d]\n", __FUNCTION__, gTestGroup, gTestID);
+
+    openSamples  = (uint64_t *)malloc(sizeof(uint64_t) * gConfig.iterations);
+    closeSamples = (uint64_t *)malloc(sizeof(uint64_t) * gConfig.iterations);
+    UT_ASSERT_NOT_EQUAL_FATAL(openSamples, NULL);
+    UT_ASSERT_NOT_EQUAL_FATAL(closeSamples, NULL);
+
+    for (uint32_t i = 0; i < gConfig.iterations; i++)
+    {
+        uint64_t start = nowNs();
+        status = HdmiCecOpen(&handle);
+        uint64_t opened = nowNs();
+        if (status != HDMI_CEC_IO_SUCCESS)
+        {
+            UT_FAIL("HdmiCecOpen failed");
+            break;
+        }
+        status = HdmiCecClose(handle);
+        uint64_t closed = nowNs();
+        if (status != HDMI_CEC_IO_SUCCESS)
+        {
+            UT_FAIL("HdmiCecClose failed");
+            break;
+        }
+        openSamples[count]  = opened - start;
+        closeSamples[count] = closed - opened;
+        count++;
+    }
+
+    recordResult("HdmiCecOpen", openSamples, count);
+    recordResult("HdmiCecClose", closeSamples, count);
+
+    free(openSamples);
+    free(closeSamples);
+
+    UT_LOG_INFO("Out %s\n", __FUNCTION__);
+}
+
+/**
+* @brief Latency of HdmiCecGetPhysicalAddress() and HdmiCecGetLogicalAddress()
+*
+* **Test Group ID:** 04@n
+*
+* **Test Case ID:** 002@n
+*
+* **Pre-Conditions:** HAL is not opened@n
+*
+* **Dependencies:** None@n
+*
+*/
+void test_l4_hdmi_cec_hal_GetAddressLatency(void)
+{
+    uint64_t *physicalSamples;
+    uint64_t *logicalSamples;
+    uint32_t count = 0;
+    uint32_t physicalAddress;
+    int32_t logicalAddress;
+    HDMI_CEC_STATUS status;
+
+    gTestID = 2;
+    UT_LOG_INFO("In %s [%02d%03d]\n", __FUNCTION__, gTestGroup, gTestID);
+
+    physicalSamples = (uint64_t *)malloc(sizeof(uint64_t) * gConfig.iterations);
+    logicalSamples  = (uint64_t *)malloc(sizeof(uint64_t) * gConfig.iterations);
+    UT_ASSERT_NOT_EQUAL_FATAL(physicalSamples, NULL);
+    UT_ASSERT_NOT_EQUAL_FATAL(logicalSamples, NULL);
+
+    openDevice();
+
+    for (uint32_t i = 0; i < gConfig.iterations; i++)
+    {
+        uint64_t start = nowNs();
+        status = HdmiCecGetPhysicalAddress(gHandle, &physicalAddress);
+        uint64_t physical = nowNs();
+        if (status != HDMI_CEC_IO_SUCCESS)
+        {
+            UT_FAIL("HdmiCecGetPhysicalAddress failed");
+            break;
+        }
+        status = HdmiCecGetLogicalAddress(gHandle, &logicalAddress);
+        uint64_t logical = nowNs();
+        if (status != HDMI_CEC_IO_SUCCESS)
+        {
+            UT_FAIL("HdmiCecGetLogicalAddress failed");
+            break;
+        }
+        physicalSamples[count] = physical - start;
+        logicalSamples[count]  = logical - physical;
+        count++;
+    }
+
+    closeDevice();
+
+    recordResult("HdmiCecGetPhysicalAddress", physicalSamples, count);
+    recordResult("HdmiCecGetLogicalAddress", logicalSamples, count);
+
+    free(physicalSamples);
+    free(logicalSamples);
+
+    UT_LOG_INFO("Out %s\n", __FUNCTION__);
+}
+
+/**
+* @brief Latency of HdmiCecTx() and HdmiCecTxAsync()
+*
+* A polling message (header block only) is sent to the configured destination,
+* so that the benchmark has no side effect on the devices in the network.
+* HdmiCecTxAsync() is deprecated, it is skipped if the HAL reports it as not supported.
+*
+* **Test Group ID:** 04@n
+*
+* **Test Case ID:** 003@n
+*
+* **Pre-Conditions:** HAL is not opened@n
+*
+* **Dependencies:** None@n
+*
+*/
+void test_l4_hdmi_cec_hal_TxLatency(void)
+{
+    uint64_t *samples;
+    uint32_t count = 0;
+    uint8_t buf[1];
+    int32_t result;
+    HDMI_CEC_STATUS status;
+
+    gTestID = 3;
+    UT_LOG_INFO("In %s [%02d%03d]\n", __FUNCTION__, gTestGroup, gTestID);
+
+    samples = (uint64_t *)malloc(sizeof(uint64_t) * gConfig.txIterations);
+    UT_ASSERT_NOT_EQUAL_FATAL(samples, NULL);
+
+    openDevice();
+    buf[0] = (uint8_t)(((gLogicalAddress & 0x0F) << 4) | (gConfig.rxDestination & 0x0F));
+
+    for (uint32_t i = 0; i < gConfig.txIterations; i++)
+    {
+        uint64_t start = nowNs();
+        status = HdmiCecTx(gHandle, buf, sizeof(buf), &result);
+        samples[count] = nowNs() - start;
+        if (status != HDMI_CEC_IO_SUCCESS && status != HDMI_CEC_IO_SENT_AND_ACKD && status != HDMI_CEC_IO_SENT_BUT_NOT_ACKD)
+        {
+            UT_FAIL("HdmiCecTx failed");
+            break;
+        }
+        count++;
+    }
+    recordResult("HdmiCecTx", samples, count);
+
+    count = 0;
+    for (uint32_t i = 0; i < gConfig.txIterations; i++)
+    {
+        uint64_t start = nowNs();
+        status = HdmiCecTxAsync(gHandle, buf, sizeof(buf));
+        samples[count] = nowNs() - start;
+        if (status == HDMI_CEC_IO_OPERATION_NOT_SUPPORTED)
+        {
+            UT_LOG_INFO("HdmiCecTxAsync not supported, skipped");
+            break;
+        }
+        if (status != HDMI_CEC_IO_SUCCESS)
+        {
+            UT_FAIL("HdmiCecTxAsync failed");
+            break;
+        }
+        count++;
+    }
+    if (count > 0)
+    {
+        recordResult("HdmiCecTxAsync", samples, count);
+    }
+
+    closeDevice();
+    free(samples);
+
+    UT_LOG_INFO("Out %s\n", __FUNCTION__);
+}
+
+/**
+* @brief Sustained HdmiCecTx() throughput
+*
+* Transmits polling messages back to back for the configured duration and
+* reports the number of frames per second.
+*
+* **Test Group ID:** 04@n
+*
+* **Test Case ID:** 004@n
+*
+* **Pre-Conditions:** HAL is not opened@n
+*
+* **Dependencies:** None@n
+*
+*/
+void test_l4_hdmi_cec_hal_TxThroughput(void)
+{
+    uint8_t buf[1];
+    int32_t result;
+    uint64_t frames = 0, failed = 0;
+    uint64_t start, end, elapsed;
+    HDMI_CEC_STATUS status;
+
+    gTestID = 4;
+    UT_LOG_INFO("In %s [%02d%03d]\n", __FUNCTION__, gTestGroup, gTestID);
+
+    openDevice();
+    buf[0] = (uint8_t)(((gLogicalAddress & 0x0F) << 4) | (gConfig.rxDestination & 0x0F));
+
+    start = nowNs();
+    end = start + ((uint64_t)gConfig.throughputSecs * NSEC_PER_SEC);
+    while (nowNs() < end)
+    {
+        status = HdmiCecTx(gHandle, buf, sizeof(buf), &result);
+        if (status == HDMI_CEC_IO_SUCCESS || status == HDMI_CEC_IO_SENT_AND_ACKD || status == HDMI_CEC_IO_SENT_BUT_NOT_ACKD)
+        {
+            frames++;
+        }
+        else
+        {
+            failed++;
+        }
+    }
+    elapsed = nowNs() - start;
+
+    closeDevice();
+
+    UT_LOG_INFO("Benchmark [HdmiCecTx throughput] frames:[%llu] failed:[%llu] duration:[%.3f s] rate:[%.1f frames/s]",
+                (unsigned long long)frames, (unsigned long long)failed,
+                elapsed / (double)NSEC_PER_SEC, (frames * (double)NSEC_PER_SEC) / elapsed);
+    UT_ASSERT_EQUAL(failed, 0);
+
+    //Record the mean time per frame, so the baseline check also catches a throughput drop
+    if (frames > 0 && gNumResults < BENCH_MAX_RESULTS)
+    {
+        benchResult_t *throughput = &gResults[gNumResults++];
+        strncpy(throughput->name, "HdmiCecTxThroughput", BENCH_MAX_NAME_SIZE - 1);
+        throughput->name[BENCH_MAX_NAME_SIZE - 1] = '\0';
+        throughput->count  = (uint32_t)frames;
+        throughput->min_ns = throughput->p50_ns = throughput->p99_ns = throughput->max_ns = elapsed / frames;
+    }
+
+    UT_LOG_INFO("Out %s\n", __FUNCTION__);
+}
+
+/**
+* @brief Rx callback delivery latency
+*
+* Sends \<Give Physical Address\> to the configured destination and measures the
+* time until \<Report Physical Address\> from that device reaches the Rx callback.
+* The destination is taken from hdmicec/benchmark/rx_destination, by default the TV
+* for a source device and Playback Device 1 for a sink device.
+* When no device answers the first request (e.g. no CEC network attached) the benchmark
+* is reported as skipped without sending the remaining requests.
+* Under the vComponent, which does not answer HdmiCecTx, the \<Report Physical Address\>
+* is injected with vcHdmiCec_InjectFrame and timed from the injection to the Rx callback.
+*
+* **Test Group ID:** 04@n
+*
+* **Test Case ID:** 005@n
+*
+* **Pre-Conditions:** HAL is not opened@n
+*
+* **Dependencies:** None@n
+*
+*/
+void test_l4_hdmi_cec_hal_RxCallbackLatency(void)
+{
+    uint64_t *samples;
+    uint32_t count = 0, timeouts = 0, requests = 0;
+    uint8_t buf[2];
+    int32_t result;
+    HDMI_CEC_STATUS status;
+
+    gTestID = 5;
+    UT_LOG_INFO("In %s [%02d%03d]\n", __FUNCTION__, gTestGroup, gTestID);
+
+    samples = (uint64_t *)malloc(sizeof(uint64_t) * gConfig.rxSamples);
+    UT_ASSERT_NOT_EQUAL_FATAL(samples, NULL);
+
+    openDevice();
+    buf[0] = (uint8_t)(((gLogicalAddress & 0x0F) << 4) | (gConfig.rxDestination & 0x0F));
+    buf[1] = CEC_GIVE_PHYSICAL_ADDRESS;
+    gRxExpectedInitiator = gConfig.rxDestination;
+
+#ifdef VCOMPONENT
+    vcHdmiCec_t* vc = get_virtual_component_handle();
+    //Broadcast <Report Physical Address> 1.0.0.0 as it would come back from the destination
+    uint8_t report[5] = { (uint8_t)(((gConfig.rxDestination & 0x0F) << 4) | 0x0F), CEC_REPORT_PHYSICAL_ADDRESS, 0x10, 0x00, 0x04 };
+#endif
+
+    for (uint32_t i = 0; i < gConfig.rxSamples; i++)
+    {
+        uint64_t start;
+
+        while (sem_trywait(&gRxSem) == 0); //Drop late responses of the previous request
+        start = nowNs();
+#ifdef VCOMPONENT
+        if (vc != NULL)
+        {
+            UT_ASSERT_EQUAL(vcHdmiCec_InjectFrame(vc, report, sizeof(report)), VC_HDMICEC_STATUS_SUCCESS);
+        }
+        else
+#endif
+        {
+            status = HdmiCecTx(gHandle, buf, sizeof(buf), &result);
+            if (status != HDMI_CEC_IO_SUCCESS && status != HDMI_CEC_IO_SENT_AND_ACKD && status != HDMI_CEC_IO_SENT_BUT_NOT_ACKD)
+            {
+                UT_FAIL("HdmiCecTx failed");
+                break;
+            }
+        }
+        requests++;
+        if (waitForRx(BENCH_RX_TIMEOUT_MS) != 0)
+        {
+            timeouts++;
+            if (count == 0)
+            {
+                //Nobody answers, the other requests would only wait for the timeout too
+                break;
+            }
+            continue;
+        }
+        samples[count++] = gRxArrivalNs - start;
+    }
+    gRxExpectedInitiator = -1;
+
+    closeDevice();
+
+    UT_LOG_INFO("Benchmark [Rx callback] requests:[%u] responses:[%u] timeouts:[%u]", requests, count, timeouts);
+    if (count == 0)
+    {
+        UT_LOG_WARNING("No response from logical address [%x], Rx callback latency not measured", gConfig.rxDestination);
+    }
+    else
+    {
+        recordResult("RxCallback", samples, count);
+    }
+    free(samples);
+
+    UT_LOG_INFO("Out %s\n", __FUNCTION__);
+}
+
+/**
+* @brief Prints the summary table of all benchmarks run so far.
+*
+* **Test Group ID:** 04@n
+*
+* **Test Case ID:** 006@n
+*
+* **Pre-Conditions:** None@n
+*
+* **Dependencies:** None@n
+*
+*/
+void test_l4_hdmi_cec_hal_Summary(void)
+{
+    gTestID = 6;
+    UT_LOG_INFO("In %s [%02d%03d]\n", __FUNCTION__, gTestGroup, gTestID);
+
+    UT_LOG_INFO("%-28s %8s %12s %12s %12s %12s", "Benchmark", "samples", "min(us)", "p50(us)", "p99(us)", "max(us)");
+    for (uint32_t i = 0; i < gNumResults; i++)
+    {
+        UT_LOG_INFO("%-28s %8u %12.3f %12.3f %12.3f %12.3f", gResults[i].name, gResults[i].count,
+                    gResults[i].min_ns / 1000.0, gResults[i].p50_ns / 1000.0,
+                    gResults[i].p99_ns / 1000.0, gResults[i].max_ns / 1000.0);
+    }
+
+    UT_LOG_INFO("Out %s\n", __FUNCTION__);
+}
+
+static int32_t writeBaseline(const char *path)
+{
+    FILE *file;
+
+    file = fopen(path, "w");
+    if (file == NULL)
+    {
+        UT_LOG_ERROR("Failed to open baseline file [%s] for writing", path);
+        return -1;
+    }
+
+    fprintf(file, "---\n");
+    fprintf(file, "hdmicec_benchmark:\n");
+    fprintf(file, "  version: \"%s\"\n", HALIF_TEST_TAG_VERSION);
+    fprintf(file, "  results:\n");
+    for (uint32_t i = 0; i < gNumResults; i++)
+    {
+        fprintf(file, "    - name: %s\n", gResults[i].name);
+        fprintf(file, "      samples: %u\n", gResults[i].count);
+        fprintf(file, "      min_ns: %llu\n", (unsigned long long)gResults[i].min_ns);
+        fprintf(file, "      p50_ns: %llu\n", (unsigned long long)gResults[i].p50_ns);
+        fprintf(file, "      p99_ns: %llu\n", (unsigned long long)gResults[i].p99_ns);
+        fprintf(file, "      max_ns: %llu\n", (unsigned long long)gResults[i].max_ns);
+    }
+    fclose(file);
+    return 0;
+}
+
+/**
+ * @brief Checks a single percentile against the baseline.
+ *
+ * A regression needs to exceed both the relative tolerance and the absolute minimum delta,
+ * so that jitter of a few microseconds on very fast calls does not fail the run.
+ *
+ * @return true if the current value is a regression
+ */
+static bool isRegression(uint64_t baseNs, uint64_t currentNs, uint32_t tolerancePercent)
+{
+    uint64_t minDeltaNs = (uint64_t)gConfig.baseline.minDeltaUs * 1000ULL;
+
+    if (currentNs <= baseNs)
+    {
+        return false;
+    }
+    if ((currentNs - baseNs) <= minDeltaNs)
+    {
+        return false;
+    }
+    return (currentNs * 100ULL) > (baseNs * (100ULL + tolerancePercent));
+}
+
+static double deltaPercent(uint64_t baseNs, uint64_t currentNs)
+{
+    if (baseNs == 0)
+    {
+        return 0.0;
+    }
+    return (((double)currentNs - (double)baseNs) * 100.0) / (double)baseNs;
+}
+
+/**
+ * @brief Compares the current results against a baseline file.
+ *
+ * @param regressions receives the number of benchmarks whose p50 or p99 regressed
+ * @param missing receives the number of baseline benchmarks with no current result
+ */
+static int32_t compareBaseline(const char *path, uint32_t *regressions, uint32_t *missing)
+{
+    ut_kvp_instance_t *instance;
+    char version[BENCH_MAX_VERSION_SIZE] = {0};
+    char key[UT_KVP_MAX_ELEMENT_SIZE];
+    char name[BENCH_MAX_NAME_SIZE];
+    uint32_t numBase;
+
+    *regressions = 0;
+    *missing = 0;
+
+    instance = ut_kvp_createInstance();
+    if (instance == NULL)
+    {
+        return -1;
+    }
+    if (ut_kvp_open(instance, (char *)path) != UT_KVP_STATUS_SUCCESS)
+    {
+        UT_LOG_ERROR("Failed to read baseline file [%s]", path);
+        ut_kvp_destroyInstance(instance);
+        return -1;
+    }
+
+    ut_kvp_getStringField(instance, "hdmicec_benchmark/version", version, sizeof(version));
+    numBase = ut_kvp_getListCount(instance, "hdmicec_benchmark/results");
+
+    UT_LOG_INFO("Baseline [%s] version:[%s] current version:[%s] tolerance p50:[%u%%] p99:[%u%%] min delta:[%u us]",
+                path, version, HALIF_TEST_TAG_VERSION, gConfig.baseline.p50TolerancePercent,
+                gConfig.baseline.p99TolerancePercent, gConfig.baseline.minDeltaUs);
+    UT_LOG_INFO("%-28s %12s %12s %9s %12s %12s %9s  %s", "Benchmark",
+                "base p50", "p50(us)", "delta", "base p99", "p99(us)", "delta", "verdict");
+
+    for (uint32_t i = 0; i < gNumResults; i++)
+    {
+        benchResult_t *current = &gResults[i];
+        uint64_t baseP50 = 0, baseP99 = 0;
+        bool found = false;
+        bool p50Regressed, p99Regressed;
+
+        for (uint32_t j = 0; j < numBase; j++)
+        {
+            snprintf(key, sizeof(key), "hdmicec_benchmark/results/%u/name", j);
+            if (ut_kvp_getStringField(instance, key, name, sizeof(name)) != UT_KVP_STATUS_SUCCESS ||
+                strncmp(name, current->name, BENCH_MAX_NAME_SIZE) != 0)
+            {
+                continue;
+            }
+            snprintf(key, sizeof(key), "hdmicec_benchmark/results/%u/p50_ns", j);
+            baseP50 = ut_kvp_getUInt64Field(instance, key);
+            snprintf(key, sizeof(key), "hdmicec_benchmark/results/%u/p99_ns", j);
+            baseP99 = ut_kvp_getUInt64Field(instance, key);
+            found = true;
+            break;
+        }
+
+        if (!found)
+        {
+            UT_LOG_INFO("%-28s %12s %12.3f %9s %12s %12.3f %9s  %s", current->name,
+                        "-", current->p50_ns / 1000.0, "-", "-", current->p99_ns / 1000.0, "-", "NEW");
+            continue;
+        }
+
+        p50Regressed = isRegression(baseP50, current->p50_ns, gConfig.baseline.p50TolerancePercent);
+        p99Regressed = isRegression(baseP99, current->p99_ns, gConfig.baseline.p99TolerancePercent);
+        if (p50Regressed || p99Regressed)
+        {
+            (*regressions)++;
+        }
+
+        UT_LOG_INFO("%-28s %12.3f %12.3f %+8.1f%% %12.3f %12.3f %+8.1f%%  %s", current->name,
+                    baseP50 / 1000.0, current->p50_ns / 1000.0, deltaPercent(baseP50, current->p50_ns),
+                    baseP99 / 1000.0, current->p99_ns / 1000.0, deltaPercent(baseP99, current->p99_ns),
+                    (p50Regressed && p99Regressed) ? "REGRESSED p50 p99" :
+                    p50Regressed ? "REGRESSED p50" :
+                    p99Regressed ? "REGRESSED p99" : "ok");
+    }
+
+    //A benchmark that failed or was not run must not pass the gate silently
+    for (uint32_t j = 0; j < numBase; j++)
+    {
+        bool found = false;
+
+        snprintf(key, sizeof(key), "hdmicec_benchmark/results/%u/name", j);
+        if (ut_kvp_getStringField(instance, key, name, sizeof(name)) != UT_KVP_STATUS_SUCCESS)
+        {
+            continue;
+        }
+        for (uint32_t i = 0; i < gNumResults && !found; i++)
+        {
+            found = (strncmp(name, gResults[i].name, BENCH_MAX_NAME_SIZE) == 0);
+        }
+        if (!found)
+        {
+            (*missing)++;
+            UT_LOG_INFO("%-28s %12s %12s %9s %12s %12s %9s  %s", name, "-", "-", "-", "-", "-", "-", "MISSING");
+        }
+    }
+
+    ut_kvp_destroyInstance(instance);
+    return 0;
+}
+
+/**
+* @brief Records the benchmark results as baseline, or compares them against a stored baseline.
+*
+* Controlled by hdmicec/benchmark/baseline in the profile:
+* - mode: "record" writes the results to <dir>/hdmicec_benchmark_<HALIF_TEST_TAG_VERSION>.yaml
+* - mode: "compare" reads the baseline of compare_version (default: the current version)
+*   and fails if the p50 or p99 of any benchmark regressed beyond the tolerance, or if a
+*   benchmark of the baseline has no result in this run.
+* Both modes fail when there are no results.
+* When no mode is configured the test does nothing.
+*
+* **Test Group ID:** 04@n
+*
+* **Test Case ID:** 007@n
+*
+* **Pre-Conditions:** Benchmarks 001 to 005 have been run@n
+*
+* **Dependencies:** None@n
+*
+*/
+void test_l4_hdmi_cec_hal_BaselineCheck(void)
+{
+    char path[BENCH_MAX_PATH_SIZE];
+    uint32_t regressions = 0;
+    uint32_t missing = 0;
+
+    gTestID = 7;
+    UT_LOG_INFO("In %s [%02d%03d]\n", __FUNCTION__, gTestGroup, gTestID);
+
+    if (gConfig.baseline.mode == BASELINE_OFF)
+    {
+        UT_LOG_INFO("No baseline mode configured, skipped");
+        UT_LOG_INFO("Out %s\n", __FUNCTION__);
+        return;
+    }
+
+    if (gNumResults == 0)
+    {
+        UT_LOG_ERROR("No benchmark results, run the benchmarks before the baseline check");
+        UT_FAIL("No benchmark results");
+        UT_LOG_INFO("Out %s\n", __FUNCTION__);
+        return;
+    }
+
+    if (gConfig.baseline.mode == BASELINE_RECORD)
+    {
+        getBaselinePath(HALIF_TEST_TAG_VERSION, path, sizeof(path));
+        UT_ASSERT_EQUAL(writeBaseline(path), 0);
+        UT_LOG_INFO("Baseline with [%u] results recorded to [%s]", gNumResults, path);
+    }
+    else
+    {
+        getBaselinePath(gConfig.baseline.compareVersion, path, sizeof(path));
+        if (compareBaseline(path, &regressions, &missing) != 0)
+        {
+            UT_FAIL("Baseline could not be read");
+        }
+        else if (missing > 0)
+        {
+            UT_LOG_ERROR("[%u] benchmarks of baseline [%s] have no result in this run", missing, path);
+            UT_FAIL("Benchmarks missing against baseline");
+        }
+        else if (regressions > 0)
+        {
+            UT_LOG_ERROR("[%u] benchmarks regressed against baseline [%s]", regressions, path);
+            UT_FAIL("Performance regression against baseline");
+        }
+    }
+
+    UT_LOG_INFO("Out %s\n", __FUNCTION__);
+}
+
+static UT_test_suite_t * pSuite = NULL;
+
+/**
+ * @brief Register the benchmark tests for this module
+ *
+ * @return int32_t - 0 on success, otherwise failure
+ */
+int32_t test_register_hdmicec_hal_l4_tests(void)
+{
+    ut_kvp_status_t status;
+    char deviceType[HDMI_CEC_DEVICE_TYPE_SIZE] = {0};
+    char mode[BENCH_MAX_MODE_SIZE];
+
+    pSuite = UT_add_suite("[L4 HDMICEC Benchmark] ", NULL, NULL);
+    if (pSuite == NULL)
+    {
+        return -1;
+    }
+
+    status = ut_kvp_getStringField(ut_kvp_profile_getInstance(), "hdmicec/type", deviceType, HDMI_CEC_DEVICE_TYPE_SIZE);
+    if (status != UT_KVP_STATUS_SUCCESS)
+    {
+        UT_LOG_ERROR("Failed to get the platform type");
+        return -1;
+    }
+    gDeviceType = (!strncmp(deviceType, "source", HDMI_CEC_DEVICE_TYPE_SIZE)) ? SOURCE : SINK;
+
+    gConfig.iterations     = getProfileUInt32("hdmicec/benchmark/iterations", BENCH_DEFAULT_ITERATIONS);
+    gConfig.txIterations   = getProfileUInt32("hdmicec/benchmark/tx_iterations", BENCH_DEFAULT_TX_ITERATIONS);
+    gConfig.throughputSecs = getProfileUInt32("hdmicec/benchmark/throughput_duration_secs", BENCH_DEFAULT_THROUGHPUT_SECS);
+    gConfig.rxSamples      = getProfileUInt32("hdmicec/benchmark/rx_samples", BENCH_DEFAULT_RX_SAMPLES);
+    gConfig.rxDestination  = (int32_t)getProfileUInt32("hdmicec/benchmark/rx_destination",
+                                        (gDeviceType == SOURCE) ? CEC_SINK_LOGICAL_ADDRESS : CEC_PLAYBACK_LOGICAL_ADDRESS);
+
+    getProfileString("hdmicec/benchmark/baseline/mode", mode, sizeof(mode), "off");
+    if (!strncmp(mode, "record", sizeof(mode)))
+    {
+        gConfig.baseline.mode = BASELINE_RECORD;
+    }
+    else if (!strncmp(mode, "compare", sizeof(mode)))
+    {
+        gConfig.baseline.mode = BASELINE_COMPARE;
+    }
+    else
+    {
+        gConfig.baseline.mode = BASELINE_OFF;
+    }
+    getProfileString("hdmicec/benchmark/baseline/dir", gConfig.baseline.dir, sizeof(gConfig.baseline.dir), BENCH_DEFAULT_BASELINE_DIR);
+    getProfileString("hdmicec/benchmark/baseline/compare_version", gConfig.baseline.compareVersion,
+                     sizeof(gConfig.baseline.compareVersion), HALIF_TEST_TAG_VERSION);
+    gConfig.baseline.p50TolerancePercent = getProfileUInt32("hdmicec/benchmark/baseline/p50_tolerance_percent", BENCH_DEFAULT_P50_TOLERANCE);
+    gConfig.baseline.p99TolerancePercent = getProfileUInt32("hdmicec/benchmark/baseline/p99_tolerance_percent", BENCH_DEFAULT_P99_TOLERANCE);
+    gConfig.baseline.minDeltaUs          = getProfileUInt32("hdmicec/benchmark/baseline/min_delta_us", BENCH_DEFAULT_MIN_DELTA_US);
+
+    sem_init(&gRxSem, 0, 0);
+
+    UT_add_test( pSuite, "Open Close Latency", test_l4_hdmi_cec_hal_OpenCloseLatency);
+    UT_add_test( pSuite, "Get Address Latency", test_l4_hdmi_cec_hal_GetAddressLatency);
+    UT_add_test( pSuite, "Tx Latency", test_l4_hdmi_cec_hal_TxLatency);
+    UT_add_test( pSuite, "Tx Throughput", test_l4_hdmi_cec_hal_TxThroughput);
+    UT_add_test( pSuite, "Rx Callback Latency", test_l4_hdmi_cec_hal_RxCallbackLatency);
+    UT_add_test( pSuite, "Benchmark Summary", test_l4_hdmi_cec_hal_Summary);
+    UT_add_test( pSuite, "Baseline Check", test_l4_hdmi_cec_hal_BaselineCheck);
+
+    return 0;
+}
+
+/** @} */ // End of HDMI CEC HAL Tests L4 File
+/** @} */ // End of HDMI CEC HAL Tests
+/** @} */ // End of HDMI CEC Module
+/** @} */ // End of HPK
@@ -70,6 +70,9 @@ extern int test_register_hdmicec_hal_sink_l2_tests( void );
 /* L3 Testing Functions */
 extern int test_register_hdmicec_hal_l3_tests(void);
 
+/* L4 Benchmark Functions */
+extern int test_register_hdmicec_hal_l4_tests(void);
+
 int register_hdmicec_hal_l1_tests( void )
 {
     int registerFailed=0;
@@ -105,6 +108,15 @@ int register_hdmicec_hal_l3_tests( void )
     return registerFailed;
 }
 
+int register_hdmicec_hal_l4_tests( void )
+{
+    int registerFailed=0;
+
+    registerFailed |= test_register_hdmicec_hal_l4_tests();
+
+    return registerFailed;
+}
+
 
 /** @} */ // End of HDMI CEC HAL Tests Register File
 /** @} */ // End of HDMI CEC HAL Tests
@@ -124,6 +124,14 @@ void stop_virtual_component(void)
 
 }
 
+/**
+ * @brief Returns the handle of the running virtual component, NULL if it is not started
+ */
+vcHdmiCec_t* get_virtual_component_handle(void)
+{
+    return gVCInfo.handle;
+}
+
 static UT_test_suite_t * pSuite = NULL;
 
 /**
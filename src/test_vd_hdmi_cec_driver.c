@@ -35,117 +35,70 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
-#include <semaphore.h>
 #include <time.h>
 #include <errno.h>
 
 #include <ut.h>
+#include <ut_cunit.h>
 #include <ut_log.h>
 #include <ut_kvp_profile.h>
 #include "hdmi_cec_driver.h"
+#include "test_waiters.h"
+#ifdef VCOMPONENT
+#include "vcHdmiCec.h"
+#endif
 
 #define DEFAULT_LOGICAL_ADDRESS_PANEL 0
 
-#define MAX_WAIT_TIME_SECS 30
+#define MAX_WAIT_TIME_MS 30000
 #define MAX_DATA_SIZE 64
+#define MAX_TEST_NAME_SIZE 64
 
-#define CEC_IMAGE_VIEW_ON 0x04
-#define CEC_TEXT_VIEW_ON 0x0D
-#define CEC_STANDBY 0x36
-#define CEC_SET_OSD_NAME 0x47
-#define CEC_ACTIVE_SOURCE 0x82
-#define CEC_REPORT_PHYSICAL_ADDRESS 0x84
-#define CEC_REQUEST_ACTIVE_SOURCE 0x85
-#define CEC_INACTIVE_SOURCE 0x9D
-#define CEC_COMMAND_UNKNOWN 0x00
-
-#define CMD_IMAGE_VIEW_ON "ImageViewOn"
-#define CMD_TEXT_VIEW_ON "TextViewOn"
-#define CMD_STANDBY "StandBy"
-#define CMD_ACTIVE_SOURCE "ActiveSource"
-#define CMD_REQUEST_ACTIVE_SOURCE "RequestActiveSource"
-#define CMD_INACTIVE_SOURCE "InactiveSource"
-#define CMD_SET_OSD_NAME "SetOsdName"
-#define CMD_REPORT_PHYSICAL_ADDRESS "ReportPhysicalAddress"
-
-#define VP_PREFIX "hdmicec/"
-#define CMD_DATA_OSD_NAME "/osd_name"
+#define VP_VALIDATION "hdmicec/validation"
+#define VP_COMMAND "/command"
 #define VP_RESULT_INITIATOR "/result/initiator"
 #define VP_RESULT_DESTINATION "/result/destination"
 #define VP_RESULT_OPCODE "/result/opcode"
 #define VP_RESULT_PARAMETER_SIZE "/result/parameters/size"
 #define VP_RESULT_PARAMETER_DATA "/result/parameters/data/"
+#define VP_INPUT "/input"
+#define VP_INPUT_FRAME "/input/frame"
+#define VP_INPUT_STATE "/input/state"
+#define VP_INPUT_PARAMETERS "/input/parameters/"
+#define MAX_STIMULUS_SIZE 1024
 
 #define COUNT(x) ((sizeof(x)/sizeof(0[x])) / ((size_t)(!(sizeof(x) % sizeof(0[x])))))
 
+/* One entry of the validation profile, compiled at registration so the check is a single memcmp */
 typedef struct
 {
-  char* str;
-  int val;
-} strVal_t;
-
-const static strVal_t gOpCode [] = {
-  { CMD_IMAGE_VIEW_ON, CEC_IMAGE_VIEW_ON },
-  { CMD_TEXT_VIEW_ON, CEC_TEXT_VIEW_ON },
-  { CMD_SET_OSD_NAME, CEC_SET_OSD_NAME },
-  { CMD_STANDBY , CEC_STANDBY },
-  { CMD_ACTIVE_SOURCE, CEC_ACTIVE_SOURCE },
-  { CMD_REQUEST_ACTIVE_SOURCE, CEC_REQUEST_ACTIVE_SOURCE },
-  { CMD_INACTIVE_SOURCE, CEC_INACTIVE_SOURCE },
-  { CMD_REPORT_PHYSICAL_ADDRESS, CEC_REPORT_PHYSICAL_ADDRESS}
-};
-
+  uint32_t index; //Position in the hdmicec/validation list, used to build the stimulus
+  char command[UT_KVP_MAX_ELEMENT_SIZE];
+  char testName[MAX_TEST_NAME_SIZE];
+  uint8_t expected[MAX_DATA_SIZE]; //Header block, opcode and operands
+  uint32_t expectedLength;
+} vdValidation_t;
 
 static UT_test_suite_t * pSuite = NULL;
 static int gTestGroup = 1;
 static int gTestID = 1;
 
-static uint8_t gExpectedCecCommand = CEC_COMMAND_UNKNOWN; //Set teach test before waiting for trigger
-static sem_t gSemCallbackReceived;
-static uint8_t gCommandValidated = CEC_COMMAND_UNKNOWN; //Set by receive callback after test validation is successful
+static vdValidation_t *gValidations = NULL; //One entry per test, sized from the validation profile
+static uint32_t gNumValidations = 0;
 
 static ut_kvp_instance_t *gValidationProfileInstance = NULL;
+static bool gSelfDriving = false; //Each test injects its own stimulus from the validation profile
+static bool gIsolated = false; //Each test opens and closes the HAL instead of sharing the suite fixture
+static int gSuiteHandle = 0; //HAL handle opened by the suite fixture
 
-int GetOpCode(const strVal_t *map, int length, char* str)
-{
-  int result = -1;
-
-  if(map == NULL || length <= 0 || str == NULL)
-  {
-    return result;
-  }
-
-  for (int i = 0;  i < length;  ++i)
-  {
-    if (!strcmp(str, map[i].str))
-    {
-        result = map[i].val;
-        break;
-    }
-  }
-  return result;
-}
-
-char* GetOpCodeString(const strVal_t *map, int length, int val)
-{
-  char* result = NULL;
-
-  if(map == NULL || length <= 0)
-  {
-    return NULL;
-  }
-
-  for (int i = 0;  i < length;  ++i)
-  {
-    if (val == (int)map[i].val)
-    {
-        result = map[i].str;
-        break;
-    }
-  }
-  return result;
-}
+#ifdef VCOMPONENT
+extern vcHdmiCec_t* get_virtual_component_handle(void);
 
+/* Fields copied from the validation profile into the injected control plane message */
+const static char* gStimulusFields [] = { "initiator", "destination", "osd_name" };
+const static char* gStimulusParameters [] = { "parent", "name", "type", "version", "active_source",
+                                              "vendor", "pwr_status", "port_id", "number_children" };
+#endif
 
 /**
  * @brief hdmicec receive message callback
@@ -157,223 +110,337 @@ char* GetOpCodeString(const strVal_t *map, int length, int val)
  */
 void ReceiveCallback(int handle, void *callbackData, unsigned char *buf, int len)
 {
-    uint8_t src, dest, opcode;
-    uint8_t expected_src, expected_dest, expected_opcode;
-    uint8_t physical_address[4];
-    char* expected_command = NULL;
-    ut_kvp_instance_t *vp_instance;
-    char szReturnedString[UT_KVP_MAX_ELEMENT_SIZE];
-    char field_name[UT_KVP_MAX_ELEMENT_SIZE];
-    uint8_t parameter_data[UT_KVP_MAX_ELEMENT_SIZE];
-    uint8_t parameter_size = 0;
-    int length = 0, field_len = 0;
-
-    UT_LOG ("\nBuffer generated: %x length: %d\n",buf, len);
-
     UT_ASSERT_MSG( handle != 0, "Error: Invalid handle.");
     UT_ASSERT_MSG( callbackData != NULL, "Error: Null callback data.");
     UT_ASSERT_MSG( len > 0, "Error: Invalid length.");
 
-    vp_instance = (ut_kvp_instance_t *)callbackData;
+    //Wakes the test waiting for this frame, validation happens on the test thread
+    test_waiter_notify(buf, len);
+}
+
+/**
+ * @brief callback to get the async send message status
+ *
+ * @param handle Hdmi device handle
+ * @param callbackData callback data passed
+ * @param result async send status
+ */
+void TransmitCallback(int handle, void *callbackData, int result)
+{
+   if((handle!=0) && (callbackData !=NULL)) {
+           //UT_ASSERT_TRUE_FATAL( (unsigned long long)callbackData== (unsigned long long)0xDEADBEEF);
+           UT_LOG ("\ncallbackData returned: %x result: %d\n",callbackData, result);
+   }
+}
+
+
+static void log_frame(const char *prefix, const uint8_t *buf, uint32_t len)
+{
+    char str[MAX_DATA_SIZE * 3 + 1] = {0};
 
-    UT_LOG("\nCall back data generated is \n");
-    for (int index=0; index < len; index++)
+    for (uint32_t i = 0; i < len; i++)
+    {
+        snprintf(str + (i * 3), sizeof(str) - (i * 3), "%02X:", buf[i]);
+    }
+    if (len > 0)
     {
-            UT_LOG("buf at index : %d is %x", index, buf[index]);
+        str[(len * 3) - 1] = '\0';
     }
+    UT_LOG("%s [%s]", prefix, str);
+}
 
-    src = (buf[0] & 0xF0) >> 4;
-    dest = buf[0] & 0x0F;
-    opcode = buf[1];
+/**
+ * @brief Compiles one entry of the validation profile into the expected frame
+ *
+ * @return 0 on success, -1 if the entry is invalid
+ */
+static int compile_validation(uint32_t index, vdValidation_t *validation)
+{
+    char prefix[UT_KVP_MAX_ELEMENT_SIZE];
+    char field_name[UT_KVP_MAX_ELEMENT_SIZE];
+    uint8_t initiator, destination, parameter_size;
 
-    expected_command = GetOpCodeString(gOpCode, COUNT(gOpCode), gExpectedCecCommand);
-    strcpy(field_name, VP_PREFIX);
-    strcpy(field_name + strlen(VP_PREFIX), expected_command);
-    length = strlen(field_name);
+    memset(validation, 0, sizeof(vdValidation_t));
+    validation->index = index;
+    snprintf(prefix, sizeof(prefix), VP_VALIDATION"/%u", index);
 
-    strcpy(field_name + length, VP_RESULT_INITIATOR);
-    expected_src = ut_kvp_getUInt8Field (vp_instance, field_name);
+    snprintf(field_name, sizeof(field_name), "%s"VP_COMMAND, prefix);
+    if(ut_kvp_getStringField(gValidationProfileInstance, field_name, validation->command, sizeof(validation->command)) != UT_KVP_STATUS_SUCCESS)
+    {
+        UT_LOG_ERROR("Validation entry [%u] has no command", index);
+        return -1;
+    }
 
-    strcpy(field_name + length, VP_RESULT_DESTINATION);
-    expected_dest = ut_kvp_getUInt8Field (vp_instance, field_name);
+    snprintf(field_name, sizeof(field_name), "%s"VP_RESULT_INITIATOR, prefix);
+    initiator = ut_kvp_getUInt8Field(gValidationProfileInstance, field_name);
+    snprintf(field_name, sizeof(field_name), "%s"VP_RESULT_DESTINATION, prefix);
+    destination = ut_kvp_getUInt8Field(gValidationProfileInstance, field_name);
+    snprintf(field_name, sizeof(field_name), "%s"VP_RESULT_OPCODE, prefix);
+    validation->expected[0] = ((initiator & 0x0F) << 4) | (destination & 0x0F);
+    validation->expected[1] = ut_kvp_getUInt8Field(gValidationProfileInstance, field_name);
+
+    snprintf(field_name, sizeof(field_name), "%s"VP_RESULT_PARAMETER_SIZE, prefix);
+    parameter_size = ut_kvp_getUInt8Field(gValidationProfileInstance, field_name);
+    if(parameter_size > MAX_DATA_SIZE - 2)
+    {
+        UT_LOG_ERROR("Validation entry [%s] has too many parameters [%u]", validation->command, parameter_size);
+        return -1;
+    }
+    for (uint32_t i = 0; i < parameter_size; ++i)
+    {
+        snprintf(field_name, sizeof(field_name), "%s"VP_RESULT_PARAMETER_DATA"%u", prefix, i);
+        validation->expected[i + 2] = ut_kvp_getUInt8Field(gValidationProfileInstance, field_name);
+    }
+    validation->expectedLength = parameter_size + 2;
 
-    strcpy(field_name + length, VP_RESULT_OPCODE);
-    expected_opcode = ut_kvp_getUInt8Field (vp_instance, field_name);
+    snprintf(validation->testName, sizeof(validation->testName), "test_vd_%s", validation->command);
+    return 0;
+}
 
-    strcpy(field_name + length, VP_RESULT_PARAMETER_SIZE);
-    parameter_size = ut_kvp_getUInt8Field (vp_instance, field_name);
-    field_len = strlen(field_name);
-    strcpy(field_name + length, VP_RESULT_PARAMETER_DATA);
+#ifdef VCOMPONENT
+/**
+ * @brief Injects the stimulus for a validation entry into the virtual component.
+ *
+ * The "input" section of the entry is sent as a control plane command message.
+ * If it has a "state" field it is sent as a state message with its "parameters",
+ * and if it has a "frame" list the bytes are injected as a raw CEC frame.
+ *
+ * @return 0 on success, -1 on failure
+ */
+static int inject_stimulus(const vdValidation_t *validation)
+{
+    char prefix[UT_KVP_MAX_ELEMENT_SIZE];
+    char field_name[UT_KVP_MAX_ELEMENT_SIZE];
+    char value[UT_KVP_MAX_ELEMENT_SIZE];
+    char message[MAX_STIMULUS_SIZE];
+    vcHdmiCec_t* vc = get_virtual_component_handle();
+    vcHdmiCec_Status_t status;
+    int length = 0;
 
-    for (int i = 0; i < parameter_size; ++i)
+    if(vc == NULL)
     {
-        int num_len = snprintf( NULL, 0, "%d", i );
-        snprintf( field_name + field_len + 1 , num_len + 1, "%d", i );
-        parameter_data[i] = ut_kvp_getUInt8Field (vp_instance, field_name);
-        UT_LOG("Expected Parameter data at [%d]: 0x%02x",i,parameter_data[i]);
+        UT_LOG_ERROR("Virtual component not started");
+        return -1;
     }
+    snprintf(prefix, sizeof(prefix), VP_VALIDATION"/%u", validation->index);
 
-    UT_LOG("\nExpected Command[%s] Src[%d] Dest[%d] \n", (GetOpCodeString(gOpCode, COUNT(gOpCode), gExpectedCecCommand)),expected_src, expected_dest);
-    UT_LOG("\nCommand[%s] triggered Src[%d] Dest[%d] \n", (GetOpCodeString(gOpCode, COUNT(gOpCode), opcode)),src, dest);
-
-    switch (opcode)
+    snprintf(field_name, sizeof(field_name), "%s"VP_INPUT_FRAME, prefix);
+    if(ut_kvp_fieldPresent(gValidationProfileInstance, field_name))
     {
-        case CEC_ACTIVE_SOURCE:
-        case CEC_INACTIVE_SOURCE:
+        unsigned char frame[MAX_DATA_SIZE];
+        uint32_t count = ut_kvp_getListCount(gValidationProfileInstance, field_name);
+
+        if(count == 0 || count > MAX_DATA_SIZE)
         {
-            UT_LOG("\nPhysicalAddress[%d.%d.%d.%d]\n",(buf[2] >> 4) & 0x0F, buf[2] & 0x0F, (buf[3] >> 4) & 0xF0, buf[3] & 0x0F);
+            UT_LOG_ERROR("Invalid stimulus frame for %s", validation->command);
+            return -1;
         }
-        break;
-        case CEC_SET_OSD_NAME:
+        for(uint32_t i = 0; i < count; i++)
+        {
+            snprintf(field_name, sizeof(field_name), "%s"VP_INPUT_FRAME"/%u", prefix, i);
+            frame[i] = ut_kvp_getUInt8Field(gValidationProfileInstance, field_name);
+        }
+        status = vcHdmiCec_InjectFrame(vc, frame, count);
+        return (status == VC_HDMICEC_STATUS_SUCCESS) ? 0 : -1;
+    }
+
+    snprintf(field_name, sizeof(field_name), "%s"VP_INPUT_STATE, prefix);
+    if(ut_kvp_getStringField(gValidationProfileInstance, field_name, value, sizeof(value)) == UT_KVP_STATUS_SUCCESS)
+    {
+        length = snprintf(message, sizeof(message), "hdmicec:\n  state: %s\n  parameters:\n", value);
+        for(int i = 0; i < COUNT(gStimulusParameters) && length < sizeof(message); i++)
         {
-            char str[len - 1];
-            memcpy(str, &buf[2], len-2);
-            str[len-2] = '\0';
-            UT_LOG("\nosd_name[%s]\n", str);
+            snprintf(field_name, sizeof(field_name), "%s"VP_INPUT_PARAMETERS"%s", prefix, gStimulusParameters[i]);
+            if(ut_kvp_getStringField(gValidationProfileInstance, field_name, value, sizeof(value)) == UT_KVP_STATUS_SUCCESS)
+            {
+                length += snprintf(message + length, sizeof(message) - length, "    %s: %s\n", gStimulusParameters[i], value);
+            }
         }
-        break;
     }
-    //Lets see if this the opcode that was expected. If it is not test will timeout
-    if(gExpectedCecCommand == opcode)
+    else
     {
-        //Lets validate the addresses and opcode
-        if(src == expected_src && dest == expected_dest && opcode == expected_opcode)
+        length = snprintf(message, sizeof(message), "hdmicec:\n  command: %s\n", validation->command);
+        for(int i = 0; i < COUNT(gStimulusFields) && length < sizeof(message); i++)
         {
-            UT_LOG("\nParameter size[%d] received size[%d]\n", parameter_size, len - 2);
-            //Expected parameter size should be equal to length of cec buffer received minus 2 (Address, opcode bytes)
-            gCommandValidated = gExpectedCecCommand;
-            if(parameter_size > 0)
+            snprintf(field_name, sizeof(field_name), "%s"VP_INPUT"/%s", prefix, gStimulusFields[i]);
+            if(ut_kvp_getStringField(gValidationProfileInstance, field_name, value, sizeof(value)) == UT_KVP_STATUS_SUCCESS)
             {
-                if((parameter_size != (len - 2)) || (memcmp(parameter_data, &buf[2], parameter_size) != 0))
-                {
-                    gCommandValidated = CEC_COMMAND_UNKNOWN;
-                }
+                length += snprintf(message + length, sizeof(message) - length, "  %s: %s\n", gStimulusFields[i], value);
             }
         }
-        //Even if the validation fails, signal the test as the opcode is same.
-        sem_post(&gSemCallbackReceived);
     }
+
+    if(length >= sizeof(message))
+    {
+        UT_LOG_ERROR("Stimulus for %s too long", validation->command);
+        return -1;
+    }
+    status = vcHdmiCec_InjectMessage(vc, message);
+    return (status == VC_HDMICEC_STATUS_SUCCESS) ? 0 : -1;
+}
+#endif
+
+static int open_hal(int *handle)
+{
+    int result;
+
+    result = HdmiCecOpen( handle );
+    if (HDMI_CEC_IO_SUCCESS != result)
+    {
+        UT_LOG_ERROR("HdmiCecOpen failed [%d]", result);
+        return -1;
+    }
+
+    result = HdmiCecSetRxCallback(*handle, ReceiveCallback, (void*)gValidations);
+    if (HDMI_CEC_IO_SUCCESS != result) { UT_LOG_ERROR("HdmiCecSetRxCallback failed [%d]", result); }
+
+    result = HdmiCecSetTxCallback( *handle, TransmitCallback, (void*)0xDEADBEEF );
+    if (HDMI_CEC_IO_SUCCESS != result) { UT_LOG_ERROR("HdmiCecSetTxCallback failed [%d]", result); }
+
+    return 0;
 }
 
 /**
- * @brief callback to get the async send message status
+ * @brief Suite setup, opens the HAL once for all the tests unless tests are isolated
  *
- * @param handle Hdmi device handle
- * @param callbackData callback data passed
- * @param result async send status
+ * @return int - 0 on success, otherwise failure
  */
-void TransmitCallback(int handle, void *callbackData, int result)
+static int suite_init(void)
 {
-   if((handle!=0) && (callbackData !=NULL)) {
-           //UT_ASSERT_TRUE_FATAL( (unsigned long long)callbackData== (unsigned long long)0xDEADBEEF);
-           UT_LOG ("\ncallbackData returned: %x result: %d\n",callbackData, result);
-   }
+    if (gIsolated)
+    {
+        return 0;
+    }
+    return open_hal(&gSuiteHandle);
 }
 
-
-int TimedWaitForCallback(uint32_t timeOutSeconds)
+/**
+ * @brief Suite teardown, closes the HAL opened by suite_init
+ *
+ * @return int - 0 on success, otherwise failure
+ */
+static int suite_cleanup(void)
 {
-    int s, result = -1;
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    ts.tv_sec += timeOutSeconds;
-    while ((s = sem_timedwait(&gSemCallbackReceived, &ts)) == -1 && errno == EINTR)
-    {
-        continue;       /* Restart if interrupted by handler */
-    }
+    int result;
 
-   /* Check what happened */
-    if (s == -1)
+    if (gIsolated || gSuiteHandle == 0)
     {
-        if (errno == ETIMEDOUT)
-        {
-            result = 1;
-        }
+        return 0;
     }
-    else
+    result = HdmiCecClose( gSuiteHandle );
+    gSuiteHandle = 0;
+    return (HDMI_CEC_IO_SUCCESS == result) ? 0 : -1;
+}
+
+/**
+ * @brief Returns the HAL to the state right after open, so tests sharing the fixture start clean
+ *
+ * @return int - 0 on success, otherwise failure
+ */
+static int reset_fixture(void)
+{
+#ifdef VCOMPONENT
+    if (vcHdmiCec_Reset(get_virtual_component_handle()) != VC_HDMICEC_STATUS_SUCCESS)
     {
-        result = 0;
+        return -1;
     }
-    return result;
+#endif
+    return 0;
 }
 
-static void validate_receive_callback_data(uint8_t expected_cmd, const char *cmd_str, const char *func, uint32_t timeOutSecs)
+static void validate_receive_callback_data(const vdValidation_t *validation, uint32_t timeOutMs)
 {
 	int result;
-    int handle = 0;
-    gTestID = 1;
-
-    UT_LOG("\n In %s [%02d%03d]\n", func, gTestGroup, gTestID);
-    result = HdmiCecOpen( &handle );
-    if (HDMI_CEC_IO_SUCCESS != result) { UT_FAIL_FATAL("open failed"); }
+    test_waiter_t waiter;
+    int handle = gSuiteHandle;
+    gTestID = validation->index + 1;
 
-    result = HdmiCecSetRxCallback(handle, ReceiveCallback, (void*)gValidationProfileInstance);
-    if (HDMI_CEC_IO_SUCCESS != result) { UT_FAIL("HdmiCecSetRxCallback failed"); }
-
-    result = HdmiCecSetTxCallback( handle, TransmitCallback, (void*)0xDEADBEEF );
-    if (HDMI_CEC_IO_SUCCESS != result) { UT_FAIL("HdmiCecSetTxCallback failed"); }
+    UT_LOG("\n In %s [%02d%03d]\n", validation->testName, gTestGroup, gTestID);
+    if (gIsolated)
+    {
+        if (open_hal(&handle) != 0) { UT_FAIL_FATAL("open failed"); }
+    }
+    else
+    {
+        if (handle == 0) { UT_FAIL_FATAL("HAL not opened by the suite setup"); }
+        if (reset_fixture() != 0) { UT_FAIL_FATAL("reset failed"); }
+    }
 
     result = HdmiCecAddLogicalAddress( handle, DEFAULT_LOGICAL_ADDRESS_PANEL );
     if (HDMI_CEC_IO_SUCCESS != result) { UT_FAIL("HdmiCecAddLogicalAddress failed"); }
 
-    gExpectedCecCommand = expected_cmd;
-    gCommandValidated = CEC_COMMAND_UNKNOWN;
+    //Armed before the trigger so the frame cannot be missed. Only the opcode is matched,
+    //so a frame with wrong addresses or operands fails validation instead of timing out.
+    test_waiter_arm(&waiter, TEST_WAITER_ANY, TEST_WAITER_ANY, validation->expected[1]);
 
-    UT_LOG ("\nTrigger %s\n", cmd_str);
-    result = TimedWaitForCallback(timeOutSecs);
-    if(result != 0)
+#ifdef VCOMPONENT
+    if(gSelfDriving)
+    {
+        UT_LOG ("\nInjecting %s\n", validation->command);
+        if(inject_stimulus(validation) != 0)
+        {
+            UT_FAIL("Failed to inject the stimulus");
+        }
+    }
+    else
+#endif
+    {
+        UT_LOG ("\nTrigger %s\n", validation->command);
+    }
+    if(!test_waiter_wait(&waiter, timeOutMs))
     {
         UT_FAIL("Failed to receive expected command in callback");
     }
-    if(gCommandValidated != gExpectedCecCommand)
+    else
+    {
+        UT_LOG("Received %s after %llu us", validation->command, (unsigned long long)(test_waiter_elapsed_ns(&waiter) / 1000));
+        if((waiter.len != validation->expectedLength) || (memcmp(waiter.frame, validation->expected, waiter.len) != 0))
+        {
+            log_frame("Expected", validation->expected, validation->expectedLength);
+            log_frame("Received", waiter.frame, waiter.len);
+            UT_FAIL("Test Validation failed");
+        }
+    }
+    if (gIsolated)
     {
-        UT_FAIL("Test Validation failed");
+        result = HdmiCecClose( handle );
+        if (HDMI_CEC_IO_SUCCESS != result) { UT_FAIL_FATAL("close failed"); }
     }
-    result = HdmiCecClose( handle );
-    if (HDMI_CEC_IO_SUCCESS != result) { UT_FAIL_FATAL("close failed"); }
 }
 
 
 /**
-*  Positive cases that receive callback data
+*  Positive cases that receive callback data, one per validation profile entry.
+*  CUnit tests take no arguments, so every test runs this function and finds its entry by test name.
 */
-void test_vd_sink_image_view_on (void)
-{
-    validate_receive_callback_data(CEC_IMAGE_VIEW_ON, CMD_IMAGE_VIEW_ON, __FUNCTION__, MAX_WAIT_TIME_SECS);
-}
-
-void test_vd_sink_text_view_on (void)
+static void test_vd_validation (void)
 {
-    validate_receive_callback_data(CEC_TEXT_VIEW_ON, CMD_TEXT_VIEW_ON, __FUNCTION__, MAX_WAIT_TIME_SECS);
-}
-
-void test_vd_sink_active_source (void)
-{
-    validate_receive_callback_data(CEC_ACTIVE_SOURCE, CMD_ACTIVE_SOURCE, __FUNCTION__, MAX_WAIT_TIME_SECS);
-}
+    CU_pTest pTest = CU_get_current_test();
 
-void test_vd_sink_inactive_source (void)
-{
-    validate_receive_callback_data(CEC_INACTIVE_SOURCE, CMD_INACTIVE_SOURCE, __FUNCTION__, MAX_WAIT_TIME_SECS);
-}
-
-void test_vd_sink_set_osd_name (void)
-{
-    validate_receive_callback_data(CEC_SET_OSD_NAME, CMD_SET_OSD_NAME, __FUNCTION__, MAX_WAIT_TIME_SECS);
+    for (uint32_t i = 0; pTest != NULL && i < gNumValidations; i++)
+    {
+        if (strcmp(gValidations[i].testName, pTest->pName) == 0)
+        {
+            validate_receive_callback_data(&gValidations[i], MAX_WAIT_TIME_MS);
+            return;
+        }
+    }
+    UT_FAIL("No validation profile entry for the current test");
 }
 
-void test_vd_sink_add_device (void)
-{
-    validate_receive_callback_data(CEC_REPORT_PHYSICAL_ADDRESS, CMD_REPORT_PHYSICAL_ADDRESS, __FUNCTION__, MAX_WAIT_TIME_SECS);
-}
 /**
  * @brief Register the main test(s) for this module
  *
+ * @param validation_profile - path of the validation profile
+ * @param self_driving - if true each test injects its stimulus in process instead of waiting for a control plane client
+ * @param isolated - if true each test opens and closes the HAL, otherwise the HAL is opened once for the suite
+ *
  * @return int - 0 on success, otherwise failure
  */
-int test_vd_hdmi_cec_driver_register ( char* validation_profile )
+int test_vd_hdmi_cec_driver_register ( char* validation_profile, bool self_driving, bool isolated )
 {
     ut_kvp_status_t status;
+    uint32_t count;
     if(validation_profile == NULL)
     {
         UT_FAIL("validation_profile NULL");
@@ -389,21 +456,39 @@ int test_vd_hdmi_cec_driver_register ( char* validation_profile )
         assert(status == UT_KVP_STATUS_SUCCESS);
         return -1;
     }
+    gSelfDriving = self_driving;
+    gIsolated = isolated;
 
 	/* add a suite to the registry */
-	pSuite = UT_add_suite( "[L3 hdmi_cec_driver]", NULL, NULL );
+	pSuite = UT_add_suite( "[L3 hdmi_cec_driver]", suite_init, suite_cleanup );
 	if ( NULL == pSuite )
 	{
 		return -1;
 	}
 
-	sem_init(&gSemCallbackReceived, 0, 0);
-	UT_add_test( pSuite, "test_vd_sink_image_view_on" ,test_vd_sink_image_view_on );
-    UT_add_test( pSuite, "test_vd_sink_text_view_on" ,test_vd_sink_text_view_on );
-    UT_add_test( pSuite, "test_vd_sink_active_source" ,test_vd_sink_active_source);
-    UT_add_test( pSuite, "test_vd_sink_inactive_source" ,test_vd_sink_inactive_source );
-    UT_add_test( pSuite, "test_vd_sink_set_osd_name" ,test_vd_sink_set_osd_name );
-    UT_add_test( pSuite, "test_vd_sink_add_device" ,test_vd_sink_add_device );
+    count = ut_kvp_getListCount(gValidationProfileInstance, VP_VALIDATION);
+    //The table is also the Rx callback data, keep it allocated when the profile has no entry
+    gValidations = (vdValidation_t *)calloc((count > 0) ? count : 1, sizeof(vdValidation_t));
+    assert(gValidations != NULL);
+    for(uint32_t i = 0; i < count; i++)
+    {
+        vdValidation_t *validation = &gValidations[gNumValidations];
+        if(compile_validation(i, validation) != 0)
+        {
+            continue;
+        }
+        //The test finds its entry by name, so a command listed twice gets its index appended
+        for(uint32_t j = 0; j < gNumValidations; j++)
+        {
+            if(strcmp(gValidations[j].testName, validation->testName) == 0)
+            {
+                snprintf(validation->testName, sizeof(validation->testName), "test_vd_%s_%u", validation->command, i);
+                break;
+            }
+        }
+        UT_add_test( pSuite, validation->testName, test_vd_validation );
+        gNumValidations++;
+    }
 
 	return 0;
 }
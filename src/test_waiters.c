@@ -0,0 +1,192 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @addtogroup HPK Hardware Porting Kit
+ * @{
+ *
+ */
+
+/**
+ * @addtogroup HDMI_CEC HDMI CEC Module
+ * @{
+ *
+ */
+
+/**
+ * @defgroup HDMI_CEC_HALTESTS HDMI CEC HAL Tests
+ * @{
+ *
+ */
+
+/**
+ * @defgroup HDMI_CEC_HALTESTS_Waiters HDMI CEC HAL Tests Frame Waiters
+ * @{
+ *
+ */
+
+/**
+* @file test_waiters.c
+*
+*/
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "test_waiters.h"
+
+#define NSEC_PER_SEC 1000000000ULL
+#define NSEC_PER_MSEC 1000000ULL
+
+static pthread_mutex_t gWaiterMutex = PTHREAD_MUTEX_INITIALIZER;
+static test_waiter_t *gWaiters = NULL; //Armed waiters, not yet matched
+
+static uint64_t getTimeNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * NSEC_PER_SEC) + (uint64_t)ts.tv_nsec;
+}
+
+/* Called with gWaiterMutex held */
+static void removeWaiter(test_waiter_t *pWaiter)
+{
+    test_waiter_t **pp;
+
+    for (pp = &gWaiters; *pp != NULL; pp = &(*pp)->pNext)
+    {
+        if (*pp == pWaiter)
+        {
+            *pp = pWaiter->pNext;
+            break;
+        }
+    }
+    pWaiter->pNext = NULL;
+}
+
+void test_waiter_arm(test_waiter_t *pWaiter, int32_t initiator, int32_t destination, int32_t opcode)
+{
+    pthread_condattr_t attr;
+
+    memset(pWaiter, 0, sizeof(test_waiter_t));
+    pWaiter->initiator = initiator;
+    pWaiter->destination = destination;
+    pWaiter->opcode = opcode;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&pWaiter->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    pthread_mutex_lock(&gWaiterMutex);
+    pWaiter->armedNs = getTimeNs();
+    pWaiter->pNext = gWaiters;
+    gWaiters = pWaiter;
+    pthread_mutex_unlock(&gWaiterMutex);
+}
+
+bool test_waiter_wait(test_waiter_t *pWaiter, uint32_t timeoutMs)
+{
+    struct timespec deadline;
+    uint64_t deadlineNs = getTimeNs() + ((uint64_t)timeoutMs * NSEC_PER_MSEC);
+    bool matched;
+    int32_t rc = 0;
+
+    deadline.tv_sec = deadlineNs / NSEC_PER_SEC;
+    deadline.tv_nsec = deadlineNs % NSEC_PER_SEC;
+
+    pthread_mutex_lock(&gWaiterMutex);
+    while (!pWaiter->matched && rc != ETIMEDOUT)
+    {
+        rc = pthread_cond_timedwait(&pWaiter->cond, &gWaiterMutex, &deadline);
+    }
+    matched = pWaiter->matched;
+    if (!matched)
+    {
+        removeWaiter(pWaiter);
+    }
+    pthread_mutex_unlock(&gWaiterMutex);
+
+    pthread_cond_destroy(&pWaiter->cond);
+    return matched;
+}
+
+void test_waiter_cancel(test_waiter_t *pWaiter)
+{
+    pthread_mutex_lock(&gWaiterMutex);
+    if (!pWaiter->matched)
+    {
+        removeWaiter(pWaiter);
+    }
+    pthread_mutex_unlock(&gWaiterMutex);
+
+    pthread_cond_destroy(&pWaiter->cond);
+}
+
+uint64_t test_waiter_elapsed_ns(const test_waiter_t *pWaiter)
+{
+    return pWaiter->matched ? (pWaiter->matchedNs - pWaiter->armedNs) : 0;
+}
+
+void test_waiter_notify(const uint8_t *pBuf, int32_t len)
+{
+    test_waiter_t **pp;
+    int32_t initiator, destination, opcode;
+    uint64_t now;
+
+    if (pBuf == NULL || len <= 0)
+    {
+        return;
+    }
+    initiator = (pBuf[0] >> 4) & 0x0F;
+    destination = pBuf[0] & 0x0F;
+    opcode = (len > 1) ? pBuf[1] : TEST_WAITER_ANY;
+
+    pthread_mutex_lock(&gWaiterMutex);
+    now = getTimeNs();
+    pp = &gWaiters;
+    while (*pp != NULL)
+    {
+        test_waiter_t *pWaiter = *pp;
+
+        if ((pWaiter->initiator == TEST_WAITER_ANY || pWaiter->initiator == initiator) &&
+            (pWaiter->destination == TEST_WAITER_ANY || pWaiter->destination == destination) &&
+            (pWaiter->opcode == TEST_WAITER_ANY || (len > 1 && pWaiter->opcode == opcode)))
+        {
+            pWaiter->len = (len > TEST_WAITER_MAX_FRAME) ? TEST_WAITER_MAX_FRAME : len;
+            memcpy(pWaiter->frame, pBuf, pWaiter->len);
+            pWaiter->matchedNs = now;
+            pWaiter->matched = true;
+            *pp = pWaiter->pNext; //Each waiter matches once
+            pWaiter->pNext = NULL;
+            pthread_cond_signal(&pWaiter->cond);
+        }
+        else
+        {
+            pp = &pWaiter->pNext;
+        }
+    }
+    pthread_mutex_unlock(&gWaiterMutex);
+}
+
+/** @} */ // End of HDMI CEC HAL Tests Frame Waiters
+/** @} */ // End of HDMI CEC HAL Tests
+/** @} */ // End of HDMI CEC Module
+/** @} */ // End of HPK
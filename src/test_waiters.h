@@ -0,0 +1,145 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @addtogroup HPK Hardware Porting Kit
+ * @{
+ *
+ */
+
+/**
+ * @addtogroup HDMI_CEC HDMI CEC Module
+ * @{
+ *
+ */
+
+/**
+ * @defgroup HDMI_CEC_HALTESTS HDMI CEC HAL Tests
+ * @{
+ *
+ */
+
+/**
+ * @defgroup HDMI_CEC_HALTESTS_Waiters HDMI CEC HAL Tests Frame Waiters
+ * @{
+ * @parblock
+ *
+ * ### Waiting for received frames in HDMI CEC HAL tests :
+ *
+ * A test arms a waiter with the initiator, destination and opcode it expects, triggers the stimulus,
+ * then waits. The receive callback passes every frame to test_waiter_notify(), which wakes the
+ * matching waiters directly, so the wait ends as soon as the frame arrives rather than at a fixed delay.
+ * Any number of waiters can be armed at the same time, each is matched by the first frame received
+ * after it was armed. Deadlines and timestamps use CLOCK_MONOTONIC.
+ *
+ * @code
+ * test_waiter_t waiter;
+ * test_waiter_arm(&waiter, 4, 0, 0x82);
+ * //Trigger the stimulus
+ * if (test_waiter_wait(&waiter, 2000))
+ * {
+ *     UT_LOG("Matched after %llu us", test_waiter_elapsed_ns(&waiter) / 1000);
+ * }
+ * @endcode
+ *
+ * @endparblock
+ *
+ */
+
+/**
+* @file test_waiters.h
+*
+*/
+
+#ifndef __TEST_WAITERS_H__
+#define __TEST_WAITERS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define TEST_WAITER_ANY (-1)          /*!< Matches any initiator, destination or opcode */
+#define TEST_WAITER_MAX_FRAME 64
+
+typedef struct test_waiter_t
+{
+    int32_t initiator;                /*!< Expected initiator or TEST_WAITER_ANY */
+    int32_t destination;              /*!< Expected destination or TEST_WAITER_ANY */
+    int32_t opcode;                   /*!< Expected opcode or TEST_WAITER_ANY, polling frames only match TEST_WAITER_ANY */
+    pthread_cond_t cond;
+    bool matched;
+    uint64_t armedNs;
+    uint64_t matchedNs;
+    uint8_t frame[TEST_WAITER_MAX_FRAME]; /*!< Matching frame, valid once matched */
+    int32_t len;
+    struct test_waiter_t *pNext;
+} test_waiter_t;
+
+/**
+ * @brief Arms a waiter for the next frame matching the given addresses and opcode.
+ *
+ * Arm before triggering the stimulus so the frame cannot be missed.
+ *
+ * @param[out] pWaiter - waiter, usually on the caller's stack, owned by the registry until waited or cancelled
+ * @param[in] initiator - expected initiator or TEST_WAITER_ANY
+ * @param[in] destination - expected destination or TEST_WAITER_ANY
+ * @param[in] opcode - expected opcode or TEST_WAITER_ANY
+ */
+void test_waiter_arm(test_waiter_t *pWaiter, int32_t initiator, int32_t destination, int32_t opcode);
+
+/**
+ * @brief Waits for the armed waiter to match, then removes it from the registry.
+ *
+ * @param[in] pWaiter - armed waiter
+ * @param[in] timeoutMs - maximum time to wait
+ *
+ * @return true if a matching frame was received
+ */
+bool test_waiter_wait(test_waiter_t *pWaiter, uint32_t timeoutMs);
+
+/**
+ * @brief Removes an armed waiter from the registry without waiting.
+ *
+ * @param[in] pWaiter - armed waiter
+ */
+void test_waiter_cancel(test_waiter_t *pWaiter);
+
+/**
+ * @brief Returns the time between arming and matching, 0 if the waiter did not match.
+ *
+ * @param[in] pWaiter - waiter
+ */
+uint64_t test_waiter_elapsed_ns(const test_waiter_t *pWaiter);
+
+/**
+ * @brief Passes a received frame to the registry, waking every armed waiter it matches.
+ *
+ * Called from the HAL receive callback.
+ *
+ * @param[in] pBuf - received frame
+ * @param[in] len - length of the frame
+ */
+void test_waiter_notify(const uint8_t *pBuf, int32_t len);
+
+#endif //__TEST_WAITERS_H__
+
+/** @} */ // End of HDMI CEC HAL Tests Frame Waiters
+/** @} */ // End of HDMI CEC HAL Tests
+/** @} */ // End of HDMI CEC Module
+/** @} */ // End of HPK
@@ -0,0 +1,651 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file vcBenchmark.c
+ *
+ * Standalone microbenchmark for the vComponent primitives in vcCommand.c, vcDevice.c and vcRxQueue.c.
+ *
+ * The device map benchmarks run on synthetic topologies, from a TV with a single child up
+ * to the full 15 logical address bus with a depth of 4 (every physical address nibble used).
+ * Each topology is generated as YAML and loaded through ut_kvp_openMemory(), exactly as the
+ * vComponent loads its profile.
+ *
+ * For every primitive the harness reports ns/op and allocations/op. Allocations are counted by
+ * interposing malloc/calloc/realloc in this executable, so allocations made inside ut-control
+ * while reading the profile are included.
+ *
+ * The Rx delivery benchmarks hand frames from a producer thread, standing in for the message
+ * handler, to a consumer running an epoll loop, in bursts. They compare posting every frame from
+ * the Rx callback to the event loop with the eventfd and batched reads of vcRxQueue, and report
+ * the wake ups of the consumer per frame.
+ *
+ * Usage: vcBenchmark [-n iterations] [-v]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "vcCommand.h"
+#include "vcDevice.h"
+#include "vcRxQueue.h"
+
+#define BENCH_DEFAULT_ITERATIONS    100000
+#define BENCH_MIN_DEVICES           2
+#define BENCH_MAX_DEVICES           15
+#define BENCH_MAX_DEPTH             4
+#define BENCH_YAML_SIZE             (16 * 1024)
+
+/* Iterations of the heavier map benchmarks are scaled down from the -n value */
+#define BENCH_MAP_DIVISOR           100
+
+/* Frames sent back to back before the producer waits for the consumer, and frames per read */
+#define BENCH_RX_BURST              16
+#define BENCH_RX_BATCH              32
+
+typedef struct
+{
+  const char* name;
+  uint64_t iterations;
+  uint64_t elapsed_ns;
+  uint64_t allocs;
+} benchResult_t;
+
+static bool gVerbose = false;
+static uint64_t gAllocCount = 0;
+
+/* The Rx benchmarks allocate from several threads, so the counter is updated atomically */
+static uint64_t AllocCount(void)
+{
+  return __atomic_load_n(&gAllocCount, __ATOMIC_RELAXED);
+}
+
+/* glibc entry points used by the interposed allocators below */
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+  __atomic_fetch_add(&gAllocCount, 1, __ATOMIC_RELAXED);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t nmemb, size_t size)
+{
+  __atomic_fetch_add(&gAllocCount, 1, __ATOMIC_RELAXED);
+  return __libc_calloc(nmemb, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+  __atomic_fetch_add(&gAllocCount, 1, __ATOMIC_RELAXED);
+  return __libc_realloc(ptr, size);
+}
+
+/* The vComponent logs through UT_logPrefix(). Keep the benchmark output clean unless -v is given */
+void UT_logPrefix(const char *file, int line, const char *prefix, const char *format, ...)
+{
+  va_list args;
+
+  if(!gVerbose)
+  {
+    return;
+  }
+  fprintf(stderr, "%s%s:%d ", prefix, file, line);
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fprintf(stderr, "\n");
+}
+
+static uint64_t NowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void ResultStart(benchResult_t* result, const char* name, uint64_t iterations)
+{
+  result->name = name;
+  result->iterations = iterations;
+  result->allocs = AllocCount();
+  result->elapsed_ns = NowNs();
+}
+
+static void ResultStop(benchResult_t* result)
+{
+  result->elapsed_ns = NowNs() - result->elapsed_ns;
+  result->allocs = AllocCount() - result->allocs;
+}
+
+static void ResultPrint(const benchResult_t* result, int devices)
+{
+  double nsPerOp = (double)result->elapsed_ns / (double)result->iterations;
+  double allocsPerOp = (double)result->allocs / (double)result->iterations;
+
+  if(devices > 0)
+  {
+    printf("%-44s %7d %12.1f %12.2f\n", result->name, devices, nsPerOp, allocsPerOp);
+  }
+  else
+  {
+    printf("%-44s %7s %12.1f %12.2f\n", result->name, "-", nsPerOp, allocsPerOp);
+  }
+}
+
+/* Keeps the compiler from discarding results of the benchmarked calls */
+static volatile uint64_t gSink;
+
+/*
+ * Topology generation.
+ *
+ * Device 0 is the TV (root). Devices 1..4 form a chain so the map reaches the maximum depth
+ * as soon as there are 5 devices. Further devices are spread round-robin over devices 0..3,
+ * so the depth never goes beyond BENCH_MAX_DEPTH.
+ * Device types are picked so the pool hands out every logical address it has before falling
+ * back to unregistered.
+ */
+static const char* gTypeOrder[] = {
+  "PlaybackDevice", "AudioSystem", "Tuner", "RecordingDevice",
+  "PlaybackDevice", "Tuner", "RecordingDevice",
+  "PlaybackDevice", "Tuner", "RecordingDevice",
+  "Tuner", "Reserved", "Reserved", "Reserved"
+};
+
+static int ParentOf(int index)
+{
+  if(index <= BENCH_MAX_DEPTH)
+  {
+    return index - 1;
+  }
+  return (index - BENCH_MAX_DEPTH - 1) % BENCH_MAX_DEPTH;
+}
+
+static int EmitDevice(char* buf, int pos, int size, int index, int numDevices, int indent, int portId)
+{
+  int children[BENCH_MAX_DEVICES];
+  int numChildren = 0;
+
+  for(int i = 1; i < numDevices; i++)
+  {
+    if(ParentOf(i) == index)
+    {
+      children[numChildren++] = i;
+    }
+  }
+
+  pos += snprintf(buf + pos, size - pos,
+                  "%*s- name: Device%d\n"
+                  "%*s  type: %s\n"
+                  "%*s  version: 4\n"
+                  "%*s  active_source: false\n"
+                  "%*s  vendor: SONY\n"
+                  "%*s  pwr_status: on\n"
+                  "%*s  port_id: %d\n"
+                  "%*s  number_children: %d\n",
+                  indent, "", index,
+                  indent, "", (index == 0) ? "TV" : gTypeOrder[(index - 1) % COUNT_OF(gTypeOrder)],
+                  indent, "",
+                  indent, "",
+                  indent, "",
+                  indent, "",
+                  indent, "", portId,
+                  indent, "", numChildren);
+
+  if(numChildren > 0)
+  {
+    pos += snprintf(buf + pos, size - pos, "%*s  children:\n", indent, "");
+    for(int i = 0; i < numChildren; i++)
+    {
+      pos = EmitDevice(buf, pos, size, children[i], numDevices, indent + 4, i + 1);
+    }
+  }
+  return pos;
+}
+
+static ut_kvp_instance_t* CreateTopology(int numDevices)
+{
+  ut_kvp_instance_t* instance;
+  char* yaml;
+  int pos;
+
+  //ut_kvp_openMemory() takes ownership of the buffer, so it has to be malloc'ed
+  yaml = (char*)malloc(BENCH_YAML_SIZE);
+  if(yaml == NULL)
+  {
+    return NULL;
+  }
+  pos = snprintf(yaml, BENCH_YAML_SIZE, "---\nhdmicec:\n  emulated_device: Device0\n  device_map:\n");
+  pos = EmitDevice(yaml, pos, BENCH_YAML_SIZE, 0, numDevices, 4, 0);
+
+  instance = ut_kvp_createInstance();
+  if(instance == NULL)
+  {
+    free(yaml);
+    return NULL;
+  }
+  if(ut_kvp_openMemory(instance, yaml, pos) != UT_KVP_STATUS_SUCCESS)
+  {
+    fprintf(stderr, "ut_kvp_openMemory() failed for %d devices\n", numDevices);
+    ut_kvp_destroyInstance(instance);
+    return NULL;
+  }
+  return instance;
+}
+
+static void ClearLogicalAddresses(struct vcDevice_info_t* map)
+{
+  if(map == NULL)
+  {
+    return;
+  }
+  map->logical_address = LOGICAL_ADDRESS_UNKNOWN;
+  ClearLogicalAddresses(map->first_child);
+  ClearLogicalAddresses(map->next_sibling);
+}
+
+static void BenchCommand(uint64_t iterations)
+{
+  benchResult_t result;
+  vcCommand_t cmd;
+  uint8_t osdName[] = { 'B', 'e', 'n', 'c', 'h', 'm', 'a', 'r', 'k', 'D', 'e', 'v', 'i', 'c', 'e' };
+  uint8_t raw[VCCOMMAND_MAX_DATA_SIZE + 2];
+  char* opcodeFirst = CMD_FEATURE_ABORT;
+  char* opcodeLast = CMD_TERMINATE_ARC;
+
+  ResultStart(&result, "vcCommand_Format", iterations);
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    vcCommand_Format(&cmd, LOGICAL_ADDRESS_PLAYBACKDEVICE1, LOGICAL_ADDRESS_TV, CEC_SET_OSD_NAME);
+    gSink += cmd.opcode;
+  }
+  ResultStop(&result);
+  ResultPrint(&result, 0);
+
+  ResultStart(&result, "vcCommand_PushBackArray (15 bytes)", iterations);
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    cmd.parameter_size = 0;
+    vcCommand_PushBackArray(&cmd, osdName, sizeof(osdName));
+    gSink += cmd.parameter_size;
+  }
+  ResultStop(&result);
+  ResultPrint(&result, 0);
+
+  ResultStart(&result, "vcCommand_GetRawBytes (17 bytes)", iterations);
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    gSink += vcCommand_GetRawBytes(&cmd, raw, sizeof(raw));
+  }
+  ResultStop(&result);
+  ResultPrint(&result, 0);
+
+  ResultStart(&result, "vcCommand_GetOpCode (first entry)", iterations);
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    gSink += vcCommand_GetOpCode(opcodeFirst);
+  }
+  ResultStop(&result);
+  ResultPrint(&result, 0);
+
+  ResultStart(&result, "vcCommand_GetOpCode (last entry)", iterations);
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    gSink += vcCommand_GetOpCode(opcodeLast);
+  }
+  ResultStop(&result);
+  ResultPrint(&result, 0);
+
+  ResultStart(&result, "vcCommand_GetOpCode (unknown)", iterations);
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    gSink += vcCommand_GetOpCode("NotAnOpCode");
+  }
+  ResultStop(&result);
+  ResultPrint(&result, 0);
+}
+
+static int BenchDeviceMap(int numDevices, uint64_t iterations)
+{
+  benchResult_t result;
+  ut_kvp_instance_t* instance;
+  struct vcDevice_info_t* map;
+  vcDevice_logical_address_pool_t pool;
+  uint64_t mapIterations = iterations / BENCH_MAP_DIVISOR;
+  char lastName[MAX_OSD_NAME_LENGTH];
+  uint64_t elapsed = 0;
+  uint64_t allocs = 0;
+  uint64_t start;
+
+  if(mapIterations == 0)
+  {
+    mapIterations = 1;
+  }
+
+  instance = CreateTopology(numDevices);
+  if(instance == NULL)
+  {
+    return -1;
+  }
+
+  ResultStart(&result, "vcDevice_CreateMapFromProfile+DestroyMap", mapIterations);
+  for(uint64_t i = 0; i < mapIterations; i++)
+  {
+    map = vcDevice_CreateMapFromProfile(instance, "hdmicec/device_map/0");
+    vcDevice_DestroyMap(map);
+  }
+  ResultStop(&result);
+  ResultPrint(&result, numDevices);
+
+  map = vcDevice_CreateMapFromProfile(instance, "hdmicec/device_map/0");
+  if(map == NULL)
+  {
+    ut_kvp_destroyInstance(instance);
+    return -1;
+  }
+
+  //Only the allocation itself is timed, resetting the map between runs is not
+  result.name = "vcDevice_AllocatePhysicalLogicalAddresses";
+  result.iterations = mapIterations;
+  for(uint64_t i = 0; i < mapIterations; i++)
+  {
+    ClearLogicalAddresses(map);
+    vcDevice_InitLogicalAddressPool(&pool);
+    allocs -= AllocCount();
+    start = NowNs();
+    vcDevice_AllocatePhysicalLogicalAddresses(map, map, &pool);
+    elapsed += NowNs() - start;
+    allocs += AllocCount();
+  }
+  result.elapsed_ns = elapsed;
+  result.allocs = allocs;
+  ResultPrint(&result, numDevices);
+
+  ResultStart(&result, "vcDevice_Get (root)", iterations);
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    gSink += (uintptr_t)vcDevice_Get(map, "Device0");
+  }
+  ResultStop(&result);
+  ResultPrint(&result, numDevices);
+
+  snprintf(lastName, sizeof(lastName), "Device%d", numDevices - 1);
+  ResultStart(&result, "vcDevice_Get (last added)", iterations);
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    gSink += (uintptr_t)vcDevice_Get(map, lastName);
+  }
+  ResultStop(&result);
+  ResultPrint(&result, numDevices);
+
+  ResultStart(&result, "vcDevice_Get (miss)", iterations);
+  for(uint64_t i = 0; i < iterations; i++)
+  {
+    gSink += (uintptr_t)vcDevice_Get(map, "NoSuchDevice");
+  }
+  ResultStop(&result);
+  ResultPrint(&result, numDevices);
+
+  if(gVerbose)
+  {
+    vcDevice_PrintMap(map, 0);
+  }
+
+  vcDevice_DestroyMap(map);
+  ut_kvp_destroyInstance(instance);
+  return 0;
+}
+
+typedef enum
+{
+  BENCH_RX_CALLBACK = 0,    //Consumer work done in the callback, on the producer thread
+  BENCH_RX_POSTED,          //Callback queues the frame and signals the event loop, one wake up per frame
+  BENCH_RX_EVENTFD          //vcRxQueue, one wake up per burst and batched reads
+} benchRxMode_t;
+
+/* What a middleware event loop needs to receive frames from the Rx callback */
+typedef struct
+{
+  pthread_mutex_t mutex;
+  vcHdmiCec_Frame_t frames[BENCH_RX_BURST];
+  uint32_t head;
+  uint32_t count;
+} benchRxPosted_t;
+
+typedef struct
+{
+  benchRxMode_t mode;
+  uint64_t frames;
+  int fd;
+  vcRxQueue_t *queue;
+  benchRxPosted_t posted;
+  uint64_t consumed;
+  uint64_t wakeups;
+} benchRx_t;
+
+static void BenchRxConsume(benchRx_t* rx, const uint8_t* frame, uint32_t len)
+{
+  gSink += frame[len - 1];
+  __atomic_store_n(&rx->consumed, rx->consumed + 1, __ATOMIC_RELEASE);
+}
+
+static void BenchRxCallback(benchRx_t* rx, const uint8_t* frame, uint32_t len)
+{
+  benchRxPosted_t* posted = &rx->posted;
+  uint64_t one = 1;
+
+  if(rx->mode == BENCH_RX_CALLBACK)
+  {
+    BenchRxConsume(rx, frame, len);
+    return;
+  }
+  pthread_mutex_lock(&posted->mutex);
+  memcpy(posted->frames[(posted->head + posted->count) % BENCH_RX_BURST].data, frame, len);
+  posted->frames[(posted->head + posted->count) % BENCH_RX_BURST].len = len;
+  posted->count++;
+  pthread_mutex_unlock(&posted->mutex);
+  (void)!write(rx->fd, &one, sizeof(one));
+}
+
+static void* BenchRxEventLoop(void* arg)
+{
+  benchRx_t* rx = (benchRx_t*)arg;
+  vcHdmiCec_Frame_t frames[BENCH_RX_BATCH];
+  struct epoll_event event = { .events = EPOLLIN };
+  int epfd = epoll_create1(0);
+
+  epoll_ctl(epfd, EPOLL_CTL_ADD, rx->fd, &event);
+  while(__atomic_load_n(&rx->consumed, __ATOMIC_ACQUIRE) < rx->frames)
+  {
+    if(epoll_wait(epfd, &event, 1, 100) <= 0)
+    {
+      continue;
+    }
+    rx->wakeups++;
+    if(rx->mode == BENCH_RX_EVENTFD)
+    {
+      uint32_t count;
+      do
+      {
+        count = vcRxQueue_Read(rx->queue, frames, BENCH_RX_BATCH);
+        for(uint32_t i = 0; i < count; i++)
+        {
+          BenchRxConsume(rx, frames[i].data, frames[i].len);
+        }
+      } while(count == BENCH_RX_BATCH);
+    }
+    else
+    {
+      uint64_t value;
+      (void)!read(rx->fd, &value, sizeof(value));
+      for(uint64_t i = 0; i < value; i++)
+      {
+        vcHdmiCec_Frame_t frame;
+        pthread_mutex_lock(&rx->posted.mutex);
+        frame = rx->posted.frames[rx->posted.head];
+        rx->posted.head = (rx->posted.head + 1) % BENCH_RX_BURST;
+        rx->posted.count--;
+        pthread_mutex_unlock(&rx->posted.mutex);
+        BenchRxConsume(rx, frame.data, frame.len);
+      }
+    }
+  }
+  close(epfd);
+  return NULL;
+}
+
+static int BenchRxDelivery(benchRxMode_t mode, const char* name, uint64_t frames)
+{
+  benchResult_t result;
+  benchRx_t rx;
+  pthread_t consumer;
+  uint8_t frame[] = { 0x40, 0x44, 0x41 };  //<User Control Pressed> "Volume Up", the bulk of a key press stream
+
+  memset(&rx, 0, sizeof(rx));
+  rx.mode = mode;
+  rx.frames = frames;
+  pthread_mutex_init(&rx.posted.mutex, NULL);
+  if(mode == BENCH_RX_EVENTFD)
+  {
+    rx.queue = vcRxQueue_Create(VCRXQUEUE_DEFAULT_CAPACITY);
+    if(rx.queue == NULL)
+    {
+      return -1;
+    }
+    vcRxQueue_Enable(rx.queue, true);
+    rx.fd = vcRxQueue_GetFd(rx.queue);
+  }
+  else
+  {
+    rx.fd = eventfd(0, EFD_NONBLOCK);
+  }
+
+  ResultStart(&result, name, frames);
+  if(mode != BENCH_RX_CALLBACK && pthread_create(&consumer, NULL, BenchRxEventLoop, &rx) != 0)
+  {
+    return -1;
+  }
+  for(uint64_t sent = 0; sent < frames;)
+  {
+    for(uint32_t i = 0; i < BENCH_RX_BURST && sent < frames; i++, sent++)
+    {
+      if(mode == BENCH_RX_EVENTFD)
+      {
+        vcRxQueue_Push(rx.queue, frame, sizeof(frame));
+      }
+      else
+      {
+        BenchRxCallback(&rx, frame, sizeof(frame));
+      }
+    }
+    //Keep the queues within a burst, nothing is dropped
+    while(__atomic_load_n(&rx.consumed, __ATOMIC_ACQUIRE) < sent)
+    {
+      sched_yield();
+    }
+  }
+  if(mode != BENCH_RX_CALLBACK)
+  {
+    pthread_join(consumer, NULL);
+  }
+  ResultStop(&result);
+  ResultPrint(&result, 0);
+  if(mode != BENCH_RX_CALLBACK)
+  {
+    printf("%-44s %7s %12.3f\n", "  wake ups/frame", "-", (double)rx.wakeups / (double)frames);
+  }
+
+  if(mode == BENCH_RX_EVENTFD)
+  {
+    vcRxQueue_Destroy(rx.queue);
+  }
+  else
+  {
+    close(rx.fd);
+  }
+  pthread_mutex_destroy(&rx.posted.mutex);
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  uint64_t iterations = BENCH_DEFAULT_ITERATIONS;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:vh")) != -1)
+  {
+    switch(opt)
+    {
+      case 'n':
+        iterations = strtoull(optarg, NULL, 0);
+        if(iterations == 0)
+        {
+          fprintf(stderr, "Invalid iteration count [%s]\n", optarg);
+          return -1;
+        }
+        break;
+      case 'v':
+        gVerbose = true;
+        break;
+      case 'h':
+      default:
+        printf("Usage: %s [-n iterations] [-v]\n", argv[0]);
+        return (opt == 'h') ? 0 : -1;
+    }
+  }
+
+  printf("vComponent microbenchmark, %llu iterations (map benchmarks %llu)\n\n",
+         (unsigned long long)iterations, (unsigned long long)((iterations / BENCH_MAP_DIVISOR) ? (iterations / BENCH_MAP_DIVISOR) : 1));
+  printf("%-44s %7s %12s %12s\n", "Benchmark", "Devices", "ns/op", "allocs/op");
+
+  BenchCommand(iterations);
+
+  if(BenchRxDelivery(BENCH_RX_CALLBACK, "Rx callback (on the handler thread)", iterations) != 0 ||
+     BenchRxDelivery(BENCH_RX_POSTED, "Rx callback posted to an event loop", iterations) != 0 ||
+     BenchRxDelivery(BENCH_RX_EVENTFD, "vcRxQueue eventfd, batched read", iterations) != 0)
+  {
+    fprintf(stderr, "Rx delivery benchmark failed\n");
+    return -1;
+  }
+
+  for(int devices = BENCH_MIN_DEVICES; devices <= BENCH_MAX_DEVICES; devices++)
+  {
+    if(BenchDeviceMap(devices, iterations) != 0)
+    {
+      fprintf(stderr, "Device map benchmark failed for %d devices\n", devices);
+      return -1;
+    }
+  }
+
+  return 0;
+}
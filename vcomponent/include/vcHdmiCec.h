@@ -35,11 +35,89 @@ typedef enum
     VC_HDMICEC_STATUS_INVALID_PARAM,       /**!< Invalid parameter. */
     VC_HDMICEC_STATUS_PROFILE_READ_ERROR,  /**!< Error reading the profile path from file */
     VC_HDMICEC_STATUS_OUT_OF_MEMORY,       /**!< Out f memory. */
+    VC_HDMICEC_STATUS_MESSAGE_REJECTED,    /**!< Control plane message could not be handled. */
+    VC_HDMICEC_STATUS_QUEUE_FULL,          /**!< Control plane message dropped, the message queue is full. */
+    VC_HDMICEC_STATUS_NO_RESOURCES,        /**!< No room left, e.g. for another Rx consumer. */
+    VC_HDMICEC_STATUS_WRONG_THREAD,        /**!< Called from a vComponent thread the call would have to wait for. */
+    VC_HDMICEC_STATUS_TIMEOUT,             /**!< The vComponent did not complete the request in time. */
     VC_HDMICEC_STATUS_MAX                  /**!< Out of range marker (not a valid status). */
 } vcHdmiCec_Status_t;
 
 typedef void vcHdmiCec_t;
 
+#define VC_HDMICEC_MAX_REQUEST_ID_LENGTH 64
+#define VC_HDMICEC_MAX_ERROR_LENGTH 128
+
+/**! Acknowledgement of a control plane message that carried a "hdmicec/request_id" field */
+typedef struct
+{
+    const char* pRequestId;           /**!< request_id copied from the message. */
+    vcHdmiCec_Status_t status;        /**!< VC_HDMICEC_STATUS_SUCCESS, VC_HDMICEC_STATUS_MESSAGE_REJECTED or VC_HDMICEC_STATUS_QUEUE_FULL. */
+    const char* pError;               /**!< Reason of the failure, empty on success. */
+    unsigned long long queuedUs;      /**!< Time from reception to the start of the handling. */
+    unsigned long long processedUs;   /**!< Time spent handling the message, including the Rx callback. */
+} vcHdmiCec_Ack_t;
+
+#define VC_HDMICEC_MAX_FRAME_LENGTH 64
+
+/**! Received CEC frame, returned by vcHdmiCec_ReadRxFrames */
+typedef struct
+{
+    unsigned char data[VC_HDMICEC_MAX_FRAME_LENGTH];  /**!< CEC frame, header block first. */
+    unsigned int len;                                 /**!< Frame length in bytes. */
+} vcHdmiCec_Frame_t;
+
+/**! Counters of the Rx queue, returned by vcHdmiCec_GetRxQueueStats */
+typedef struct
+{
+    unsigned long long queued;        /**!< Frames added to the queue. */
+    unsigned long long dropped;       /**!< Frames dropped because the queue was full or the frame too long. */
+    unsigned long long wakeups;       /**!< Times the eventfd was signalled. */
+    unsigned long long reads;         /**!< Calls to vcHdmiCec_ReadRxFrames that returned frames. */
+    unsigned long long framesRead;    /**!< Frames returned by vcHdmiCec_ReadRxFrames. */
+    unsigned int pending;             /**!< Frames waiting to be read. */
+    unsigned int maxDepth;            /**!< Largest number of frames waiting at once. */
+    unsigned int capacity;            /**!< Frames the queue holds, rx_queue_size in the profile. */
+} vcHdmiCec_RxQueueStats_t;
+
+#define VC_HDMICEC_MAX_RX_CONSUMERS 8
+#define VC_HDMICEC_MAX_RX_CONSUMER_NAME_LENGTH 32
+
+/**! Opcode subscription of an Rx consumer, bit n of the 256 bits selects opcode n */
+typedef struct
+{
+    unsigned long long bits[4];
+} vcHdmiCec_OpcodeMask_t;
+
+#define VC_HDMICEC_OPCODE_MASK_SET(pMask, opcode)     ((pMask)->bits[((opcode) & 0xFF) >> 6] |= (1ULL << ((opcode) & 63)))
+#define VC_HDMICEC_OPCODE_MASK_CLEAR(pMask, opcode)   ((pMask)->bits[((opcode) & 0xFF) >> 6] &= ~(1ULL << ((opcode) & 63)))
+#define VC_HDMICEC_OPCODE_MASK_ISSET(pMask, opcode)   (((pMask)->bits[((opcode) & 0xFF) >> 6] >> ((opcode) & 63)) & 1ULL)
+
+/**! Counters of an Rx consumer, returned by vcHdmiCec_GetRxConsumerStats. The HAL receive callback has id 0 */
+typedef struct
+{
+    int id;                                             /**!< Id returned by vcHdmiCec_AddRxConsumer, 0 for the HAL receive callback. */
+    char name[VC_HDMICEC_MAX_RX_CONSUMER_NAME_LENGTH];  /**!< Name given to vcHdmiCec_AddRxConsumer. */
+    vcHdmiCec_OpcodeMask_t mask;                        /**!< Opcodes delivered to the consumer, unused for id 0. */
+    unsigned long long delivered;                       /**!< Frames passed to the callback. */
+    unsigned long long filtered;                        /**!< Frames not in the opcode mask, including polling messages. */
+    unsigned long long totalNs;                         /**!< Time spent in the callback. */
+    unsigned long long maxNs;                           /**!< Longest callback. */
+    unsigned int depth;                                 /**!< Frames queued for the dispatcher workers right now. */
+    unsigned int maxDepth;                              /**!< Most frames queued for the dispatcher workers at once. */
+    unsigned long long dropped;                         /**!< Frames not queued because the consumer queue was full. */
+    unsigned long long waitTotalNs;                     /**!< Time frames spent queued before the callback ran. */
+    unsigned long long waitMaxNs;                       /**!< Longest time a frame spent queued. */
+} vcHdmiCec_RxConsumerStats_t;
+
+/**! Called with a received frame whose opcode is in the consumer mask, on the message handler thread,
+ *   or on one of the dispatcher worker threads when rx_dispatch_workers is set in the profile */
+typedef void (*vcHdmiCec_RxConsumerCallback_t)( int consumerId, void* pUserData, const unsigned char* pFrame, unsigned int len );
+
+/**! Called on the message handler thread once a message with a request_id has been handled,
+ *   or on the sending thread if the message was dropped because the queue was full */
+typedef void (*vcHdmiCec_AckCallback_t)( const vcHdmiCec_Ack_t* pAck, void* pUserData );
+
 /**
  * @brief Intitialize the HDMI CEC Virtual Component and the control plane
  * This will setup the initial state machine of the Virtual Component
@@ -91,6 +169,225 @@ vcHdmiCec_Status_t vcHdmiCec_Close( vcHdmiCec_t* pVCHdmiCec );
  */
 vcHdmiCec_Status_t vcHdmiCec_Deinitialize( vcHdmiCec_t *pvComponent );
 
+/**
+ * @brief Resets the emulated network to the state loaded from the profile by HdmiCecOpen,
+ * without closing the HAL. Devices added or removed since HdmiCecOpen are discarded and the
+ * emulated device logical address is released. Callbacks stay registered.
+ * Messages queued before the reset are handled first; the call returns once the reset is done,
+ * or after 5 seconds. The reset runs on the message handler thread, so it cannot be called from
+ * an Rx callback or an Rx consumer running on that thread.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ *
+ * @return Status of the reset (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Network reset.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ * @retval VC_HDMICEC_STATUS_PROFILE_READ_ERROR - The network could not be reloaded from the profile
+ * @retval VC_HDMICEC_STATUS_QUEUE_FULL - The HAL is being closed, the reset was not queued
+ * @retval VC_HDMICEC_STATUS_WRONG_THREAD - Called from the message handler thread, the reset was not queued
+ * @retval VC_HDMICEC_STATUS_TIMEOUT - The reset was queued but not done within 5 seconds
+ */
+vcHdmiCec_Status_t vcHdmiCec_Reset( vcHdmiCec_t* pVCHdmiCec );
+
+/**
+ * @brief Injects a control plane message in process, without a websocket client.
+ * The message takes the same path as one received by the control plane, so it is
+ * handled in order with them on the message handler thread. The frames it produces reach
+ * the HAL receive callback and the Rx consumers like any received frame, see vcHdmiCec_AddRxConsumer.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ * @param[in] pMessage - control plane message YAML, with a "hdmicec/command", "hdmicec/state", "hdmicec/batch",
+ *                       "hdmicec/traffic" or "hdmicec/keypress" field.
+ *
+ * @return Status of the injection (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Message queued.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_INVALID_PARAM - pMessage is NULL or not one of these messages
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ * @retval VC_HDMICEC_STATUS_OUT_OF_MEMORY - Memory allocation error
+ * @retval VC_HDMICEC_STATUS_QUEUE_FULL - The message queue is full, the message was dropped
+ */
+vcHdmiCec_Status_t vcHdmiCec_InjectMessage( vcHdmiCec_t* pVCHdmiCec, const char* pMessage );
+
+/**
+ * @brief Injects a raw CEC frame, delivered as is to the HAL receive callback.
+ * The callback runs on the message handler thread, or on a dispatcher worker thread when
+ * rx_dispatch_workers is set in the profile.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ * @param[in] pFrame - CEC frame, header block first
+ * @param[in] len - frame length in bytes
+ *
+ * @return Status of the injection (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Frame queued.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_INVALID_PARAM - pFrame is NULL, len is 0 or larger than the vComponent frame buffer
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ * @retval VC_HDMICEC_STATUS_OUT_OF_MEMORY - Memory allocation error
+ * @retval VC_HDMICEC_STATUS_QUEUE_FULL - The message queue is full, the message was dropped
+ */
+vcHdmiCec_Status_t vcHdmiCec_InjectFrame( vcHdmiCec_t* pVCHdmiCec, const unsigned char* pFrame, unsigned int len );
+
+/**
+ * @brief Registers the callback that acknowledges control plane messages.
+ * A control plane message that carries a "hdmicec/request_id" field is acknowledged once it has been
+ * handled and the resulting Rx callbacks, if any, have returned. The acknowledgement is also logged as
+ * "Ack: request_id[<id>] ...", whether or not a callback is registered.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ * @param[in] cbFunc - callback, NULL to unregister.
+ * @param[in] pUserData - passed back to cbFunc.
+ *
+ * @return Status of the registration (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Callback registered.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ */
+vcHdmiCec_Status_t vcHdmiCec_SetAckCallback( vcHdmiCec_t* pVCHdmiCec, vcHdmiCec_AckCallback_t cbFunc, void* pUserData );
+
+/**
+ * @brief Delivers received frames through an eventfd instead of the HAL receive callback.
+ * Received frames are queued and the descriptor is readable while frames are waiting, so it can be
+ * added to the epoll set of the middleware event loop. Frames are then fetched in batches with
+ * vcHdmiCec_ReadRxFrames on the middleware thread, and the receive callback is no longer invoked.
+ * The size of the queue is read from "hdmicec/rx_queue_size" in the profile (256 frames by default),
+ * frames received while it is full are dropped.
+ * The descriptor belongs to the vComponent. It stays open until HdmiCecClose, remove it from the
+ * epoll set before closing the HAL.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ * @param[out] pFd - receives the eventfd.
+ *
+ * @return Status of the switch (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Received frames are queued.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_INVALID_PARAM - pFd is NULL
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ */
+vcHdmiCec_Status_t vcHdmiCec_OpenRxEventFd( vcHdmiCec_t* pVCHdmiCec, int* pFd );
+
+/**
+ * @brief Reads a batch of received frames queued since vcHdmiCec_OpenRxEventFd, oldest first.
+ * The eventfd is cleared once the queue is empty. Call it until fewer than maxFrames frames are
+ * returned after each wake up.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ * @param[out] pFrames - buffer receiving the frames.
+ * @param[in] maxFrames - number of frames pFrames holds.
+ * @param[out] pNumFrames - receives the number of frames returned, 0 when none is waiting.
+ *
+ * @return Status of the read (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Frames returned, possibly none.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_INVALID_PARAM - pFrames or pNumFrames is NULL
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ */
+vcHdmiCec_Status_t vcHdmiCec_ReadRxFrames( vcHdmiCec_t* pVCHdmiCec, vcHdmiCec_Frame_t* pFrames, unsigned int maxFrames, unsigned int* pNumFrames );
+
+/**
+ * @brief Goes back to delivering received frames through the HAL receive callback.
+ * Frames still queued are discarded. The eventfd stays open until HdmiCecClose.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ *
+ * @return Status of the switch (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Received frames go to the receive callback.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ */
+vcHdmiCec_Status_t vcHdmiCec_CloseRxEventFd( vcHdmiCec_t* pVCHdmiCec );
+
+/**
+ * @brief Returns the counters of the Rx queue read through vcHdmiCec_ReadRxFrames.
+ * The counters keep running across vcHdmiCec_CloseRxEventFd and vcHdmiCec_OpenRxEventFd.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ * @param[out] pStats - receives the counters.
+ *
+ * @return Status of the request (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Counters returned.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_INVALID_PARAM - pStats is NULL
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ */
+vcHdmiCec_Status_t vcHdmiCec_GetRxQueueStats( vcHdmiCec_t* pVCHdmiCec, vcHdmiCec_RxQueueStats_t* pStats );
+
+/**
+ * @brief Registers an Rx consumer, modelling one client of a multi-client CEC daemon.
+ * Every received frame is checked against the opcode mask of each consumer with a single bit test,
+ * and only the consumers that subscribed to its opcode are called.
+ * Without rx_dispatch_workers in the profile, the consumers are called on the message handler
+ * thread, in the order they were added. With it, each consumer has its own queue and its callback
+ * runs on one of the worker threads. Each consumer still gets its frames in order, one at a time,
+ * but consumers run concurrently and in no set order with each other and the HAL receive callback.
+ * Polling messages carry no opcode and are not delivered. Consumers are called after the HAL
+ * receive callback, or after the frame is queued for vcHdmiCec_ReadRxFrames, which both still
+ * receive every frame. Consumers are removed when the HAL is closed.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ * @param[in] pName - name shown with the consumer counters, may be NULL.
+ * @param[in] pMask - opcodes delivered to the consumer.
+ * @param[in] cbFunc - called with each frame delivered.
+ * @param[in] pUserData - passed back to cbFunc.
+ * @param[out] pConsumerId - receives the id of the consumer.
+ *
+ * @return Status of the registration (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Consumer registered.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_INVALID_PARAM - pMask, cbFunc or pConsumerId is NULL
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ * @retval VC_HDMICEC_STATUS_NO_RESOURCES - VC_HDMICEC_MAX_RX_CONSUMERS consumers are already registered
+ */
+vcHdmiCec_Status_t vcHdmiCec_AddRxConsumer( vcHdmiCec_t* pVCHdmiCec, const char* pName, const vcHdmiCec_OpcodeMask_t* pMask,
+                                            vcHdmiCec_RxConsumerCallback_t cbFunc, void* pUserData, int* pConsumerId );
+
+/**
+ * @brief Replaces the opcode mask of an Rx consumer, from the next frame received.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ * @param[in] consumerId - id returned by vcHdmiCec_AddRxConsumer.
+ * @param[in] pMask - opcodes delivered to the consumer.
+ *
+ * @return Status of the update (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Mask replaced.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_INVALID_PARAM - pMask is NULL or consumerId is unknown
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ */
+vcHdmiCec_Status_t vcHdmiCec_SetRxConsumerMask( vcHdmiCec_t* pVCHdmiCec, int consumerId, const vcHdmiCec_OpcodeMask_t* pMask );
+
+/**
+ * @brief Removes an Rx consumer. Once it returns the consumer callback is not running and is not
+ * called again, so pUserData may be released. It may be called from the consumer callback.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ * @param[in] consumerId - id returned by vcHdmiCec_AddRxConsumer.
+ *
+ * @return Status of the removal (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Consumer removed.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_INVALID_PARAM - consumerId is unknown
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ */
+vcHdmiCec_Status_t vcHdmiCec_RemoveRxConsumer( vcHdmiCec_t* pVCHdmiCec, int consumerId );
+
+/**
+ * @brief Returns the counters of the Rx consumers, including the HAL receive callback with id 0.
+ * The queue depths, drops and wait times are only counted when rx_dispatch_workers is set in the profile.
+ *
+ * @param[in] pVCHdmiCec - pointer to VC instance.
+ * @param[out] pStats - receives up to maxStats entries, VC_HDMICEC_MAX_RX_CONSUMERS + 1 hold them all.
+ * @param[in] maxStats - number of entries pStats holds.
+ * @param[out] pNumConsumers - receives the number of consumers, which may be more than maxStats.
+ *
+ * @return Status of the request (vcHdmiCec_Status_t)
+ * @retval VC_HDMICEC_STATUS_SUCCESS - Counters returned.
+ * @retval VC_HDMICEC_STATUS_INVALID_HANDLE - Invalid vcHdmiCec_t* handle
+ * @retval VC_HDMICEC_STATUS_INVALID_PARAM - pStats or pNumConsumers is NULL
+ * @retval VC_HDMICEC_STATUS_NOT_OPENED - HdmiCecOpen has not been called
+ */
+vcHdmiCec_Status_t vcHdmiCec_GetRxConsumerStats( vcHdmiCec_t* pVCHdmiCec, vcHdmiCec_RxConsumerStats_t* pStats, unsigned int maxStats, unsigned int* pNumConsumers );
+
 
 
 
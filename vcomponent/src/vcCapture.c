@@ -0,0 +1,532 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "vcHdmiCec.h"
+#include "vcCapture.h"
+#include "vcStats.h"
+
+/* Longest LEB128 encoding of a 64 bit value */
+#define MAX_VARINT_LENGTH     10
+/* The file is flushed at most this long after a record, so a crash loses little of the incident */
+#define FLUSH_INTERVAL_NS     100000000ULL
+/* Retry interval when the RX path cannot take a replayed frame */
+#define REPLAY_RETRY_NS       1000000ULL
+
+struct vcCapture_writer_s
+{
+  FILE *file;
+  pthread_mutex_t mutex;
+  uint64_t last_ns;
+  uint64_t flushed_ns;
+  char names[VCCAPTURE_NUM_ADDRESSES][VCCAPTURE_MAX_NAME_LENGTH];
+};
+
+struct vcCapture_reader_s
+{
+  const uint8_t *data;
+  size_t size;
+  size_t pos;
+  uint64_t start_realtime_ns;
+  uint64_t timestamp_ns;
+  char names[VCCAPTURE_NUM_ADDRESSES][VCCAPTURE_MAX_NAME_LENGTH];
+};
+
+struct vcCapture_replay_s
+{
+  vcCapture_reader_t *reader;
+  double speed;
+  vcCapture_emit_t emit;
+  void *ctx;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t condition;
+  bool stop;
+};
+
+static void PutLE(uint8_t *buf, uint64_t value, uint32_t bytes)
+{
+  for(uint32_t i = 0; i < bytes; i++)
+  {
+    buf[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static uint64_t GetLE(const uint8_t *buf, uint32_t bytes)
+{
+  uint64_t value = 0;
+
+  for(uint32_t i = 0; i < bytes; i++)
+  {
+    value |= (uint64_t)buf[i] << (8 * i);
+  }
+  return value;
+}
+
+static uint32_t PutVarint(uint8_t *buf, uint64_t value)
+{
+  uint32_t len = 0;
+
+  do
+  {
+    buf[len] = value & 0x7F;
+    value >>= 7;
+    if(value != 0)
+    {
+      buf[len] |= 0x80;
+    }
+    len++;
+  } while(value != 0);
+  return len;
+}
+
+static bool GetVarint(const uint8_t *buf, size_t size, size_t *pos, uint64_t *value)
+{
+  *value = 0;
+  for(uint32_t i = 0; i < MAX_VARINT_LENGTH && *pos < size; i++)
+  {
+    uint8_t byte = buf[(*pos)++];
+    *value |= (uint64_t)(byte & 0x7F) << (7 * i);
+    if((byte & 0x80) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint64_t RealtimeNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void DeadlineToTimespec(uint64_t deadline_ns, struct timespec *ts)
+{
+  ts->tv_sec = (time_t)(deadline_ns / 1000000000ULL);
+  ts->tv_nsec = (long)(deadline_ns % 1000000000ULL);
+}
+
+vcCapture_writer_t* vcCapture_Open(const char *path)
+{
+  vcCapture_writer_t *writer;
+  uint8_t header[VCCAPTURE_HEADER_SIZE];
+
+  assert(path != NULL);
+  writer = (vcCapture_writer_t *)calloc(1, sizeof(vcCapture_writer_t));
+  if(writer == NULL)
+  {
+    VC_LOG_ERROR("vcCapture_Open: Out of memory");
+    return NULL;
+  }
+  writer->file = fopen(path, "wb");
+  if(writer->file == NULL)
+  {
+    VC_LOG_ERROR("vcCapture_Open: Failed to create [%s]", path);
+    free(writer);
+    return NULL;
+  }
+  memcpy(header, VCCAPTURE_MAGIC, 4);
+  PutLE(&header[4], VCCAPTURE_VERSION, 2);
+  PutLE(&header[6], VCCAPTURE_HEADER_SIZE, 2);
+  PutLE(&header[8], RealtimeNs(), 8);
+  if(fwrite(header, sizeof(header), 1, writer->file) != 1)
+  {
+    VC_LOG_ERROR("vcCapture_Open: Failed to write the header of [%s]", path);
+    fclose(writer->file);
+    free(writer);
+    return NULL;
+  }
+  pthread_mutex_init(&writer->mutex, NULL);
+  writer->last_ns = vcStats_NowNs();
+  writer->flushed_ns = writer->last_ns;
+  VC_LOG("vcCapture_Open: Capturing to [%s]", path);
+  return writer;
+}
+
+void vcCapture_Close(vcCapture_writer_t *writer)
+{
+  if(writer == NULL)
+  {
+    return;
+  }
+  fclose(writer->file);
+  pthread_mutex_destroy(&writer->mutex);
+  free(writer);
+}
+
+bool vcCapture_Write(vcCapture_writer_t *writer, vcCapture_record_kind_t kind, uint64_t timestamp_ns,
+                     const uint8_t *frame, uint32_t len, uint8_t result, const char *source_name)
+{
+  uint8_t record[3 + MAX_VARINT_LENGTH + VCCAPTURE_MAX_FRAME_LENGTH];
+  uint8_t la;
+  uint32_t pos = 0;
+  bool written = true;
+
+  assert(writer != NULL);
+  assert(kind == VCCAPTURE_RECORD_RX || kind == VCCAPTURE_RECORD_TX);
+  if(frame == NULL || len == 0)
+  {
+    return false;
+  }
+  if(len > VCCAPTURE_MAX_FRAME_LENGTH)
+  {
+    len = VCCAPTURE_MAX_FRAME_LENGTH;
+  }
+  if(source_name == NULL)
+  {
+    source_name = "";
+  }
+  la = frame[0] >> 4;
+
+  pthread_mutex_lock(&writer->mutex);
+  if(strncmp(writer->names[la], source_name, VCCAPTURE_MAX_NAME_LENGTH - 1) != 0)
+  {
+    uint8_t name[3 + VCCAPTURE_MAX_NAME_LENGTH];
+    uint32_t name_len;
+
+    strncpy(writer->names[la], source_name, VCCAPTURE_MAX_NAME_LENGTH - 1);
+    name_len = strlen(writer->names[la]);
+    name[0] = VCCAPTURE_RECORD_NAME;
+    name[1] = la;
+    name[2] = (uint8_t)name_len;
+    memcpy(&name[3], writer->names[la], name_len);
+    written = (fwrite(name, 3 + name_len, 1, writer->file) == 1);
+  }
+
+  //Rx and Tx are timestamped on different threads, so a frame can reach the lock after a later one
+  if(timestamp_ns < writer->last_ns)
+  {
+    timestamp_ns = writer->last_ns;
+  }
+  record[pos++] = (uint8_t)kind;
+  pos += PutVarint(&record[pos], timestamp_ns - writer->last_ns);
+  record[pos++] = result;
+  record[pos++] = (uint8_t)len;
+  memcpy(&record[pos], frame, len);
+  pos += len;
+  written = written && (fwrite(record, pos, 1, writer->file) == 1);
+  writer->last_ns = timestamp_ns;
+
+  if(timestamp_ns - writer->flushed_ns >= FLUSH_INTERVAL_NS)
+  {
+    fflush(writer->file);
+    writer->flushed_ns = timestamp_ns;
+  }
+  pthread_mutex_unlock(&writer->mutex);
+
+  if(!written)
+  {
+    VC_LOG_ERROR("vcCapture_Write: Failed to write the record");
+  }
+  return written;
+}
+
+vcCapture_reader_t* vcCapture_OpenReader(const char *path)
+{
+  vcCapture_reader_t *reader;
+  struct stat st;
+  void *data;
+  int fd;
+
+  assert(path != NULL);
+  fd = open(path, O_RDONLY);
+  if(fd < 0)
+  {
+    VC_LOG_ERROR("vcCapture_OpenReader: Failed to open [%s]", path);
+    return NULL;
+  }
+  if(fstat(fd, &st) != 0 || st.st_size < VCCAPTURE_HEADER_SIZE)
+  {
+    VC_LOG_ERROR("vcCapture_OpenReader: [%s] is too short for a capture", path);
+    close(fd);
+    return NULL;
+  }
+  data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED)
+  {
+    VC_LOG_ERROR("vcCapture_OpenReader: Failed to map [%s]", path);
+    return NULL;
+  }
+  if(memcmp(data, VCCAPTURE_MAGIC, 4) != 0 || GetLE((uint8_t *)data + 4, 2) != VCCAPTURE_VERSION)
+  {
+    VC_LOG_ERROR("vcCapture_OpenReader: [%s] is not a version %d capture", path, VCCAPTURE_VERSION);
+    munmap(data, st.st_size);
+    return NULL;
+  }
+  reader = (vcCapture_reader_t *)calloc(1, sizeof(vcCapture_reader_t));
+  if(reader == NULL)
+  {
+    VC_LOG_ERROR("vcCapture_OpenReader: Out of memory");
+    munmap(data, st.st_size);
+    return NULL;
+  }
+  reader->data = (const uint8_t *)data;
+  reader->size = st.st_size;
+  reader->start_realtime_ns = GetLE(reader->data + 8, 8);
+  vcCapture_Rewind(reader);
+  return reader;
+}
+
+void vcCapture_CloseReader(vcCapture_reader_t *reader)
+{
+  if(reader == NULL)
+  {
+    return;
+  }
+  munmap((void *)reader->data, reader->size);
+  free(reader);
+}
+
+void vcCapture_Rewind(vcCapture_reader_t *reader)
+{
+  assert(reader != NULL);
+  //The header size is in the file so that later versions can extend the header
+  reader->pos = GetLE(reader->data + 6, 2);
+  reader->timestamp_ns = 0;
+  memset(reader->names, 0, sizeof(reader->names));
+}
+
+/* Decodes the frame record starting at offset. timestamp_ns is set to the delta from the previous frame */
+static bool DecodeFrame(const uint8_t *data, size_t size, size_t offset, vcCapture_record_t *record, size_t *next)
+{
+  size_t pos = offset;
+  uint8_t kind = data[pos++];
+
+  if(kind != VCCAPTURE_RECORD_RX && kind != VCCAPTURE_RECORD_TX)
+  {
+    return false;
+  }
+  if(!GetVarint(data, size, &pos, &record->timestamp_ns) || pos + 2 > size || pos + 2 + data[pos + 1] > size
+     || data[pos + 1] == 0)
+  {
+    return false;
+  }
+  record->kind = (vcCapture_record_kind_t)kind;
+  record->offset = offset;
+  record->result = data[pos];
+  record->len = data[pos + 1];
+  pos += 2;
+  memcpy(record->frame, &data[pos], record->len);
+  record->source_name[0] = '\0';
+  *next = pos + record->len;
+  return true;
+}
+
+bool vcCapture_Next(vcCapture_reader_t *reader, vcCapture_record_t *record)
+{
+  const uint8_t *data;
+  size_t pos;
+
+  assert(reader != NULL);
+  assert(record != NULL);
+  data = reader->data;
+  pos = reader->pos;
+
+  while(pos < reader->size)
+  {
+    if(data[pos] == VCCAPTURE_RECORD_NAME)
+    {
+      uint8_t la, len;
+      if(pos + 3 > reader->size || pos + 3 + data[pos + 2] > reader->size)
+      {
+        break;
+      }
+      la = data[pos + 1] & 0x0F;
+      len = data[pos + 2];
+      memset(reader->names[la], 0, VCCAPTURE_MAX_NAME_LENGTH);
+      memcpy(reader->names[la], &data[pos + 3], (len < VCCAPTURE_MAX_NAME_LENGTH) ? len : VCCAPTURE_MAX_NAME_LENGTH - 1);
+      pos += 3 + len;
+      reader->pos = pos;
+      continue;
+    }
+    if(!DecodeFrame(data, reader->size, pos, record, &pos))
+    {
+      break;
+    }
+    record->timestamp_ns += reader->timestamp_ns;
+    strcpy(record->source_name, reader->names[record->frame[0] >> 4]);
+
+    reader->timestamp_ns = record->timestamp_ns;
+    reader->pos = pos;
+    return true;
+  }
+  if(pos < reader->size)
+  {
+    VC_LOG_ERROR("vcCapture_Next: Capture truncated or corrupted at offset %zu of %zu", reader->pos, reader->size);
+    reader->pos = reader->size;
+  }
+  return false;
+}
+
+bool vcCapture_ReadAt(vcCapture_reader_t *reader, size_t offset, vcCapture_record_t *record)
+{
+  size_t next;
+
+  assert(reader != NULL);
+  assert(record != NULL);
+  if(offset >= reader->size)
+  {
+    return false;
+  }
+  return DecodeFrame(reader->data, reader->size, offset, record, &next);
+}
+
+uint64_t vcCapture_GetStartTime(vcCapture_reader_t *reader)
+{
+  assert(reader != NULL);
+  return reader->start_realtime_ns;
+}
+
+/* Sleeps until deadline_ns. Returns false if the replay was stopped meanwhile */
+static bool ReplayWait(vcCapture_replay_t *replay, uint64_t deadline_ns)
+{
+  struct timespec ts;
+  bool stop;
+
+  DeadlineToTimespec(deadline_ns, &ts);
+  pthread_mutex_lock(&replay->mutex);
+  while(!replay->stop && vcStats_NowNs() < deadline_ns)
+  {
+    pthread_cond_timedwait(&replay->condition, &replay->mutex, &ts);
+  }
+  stop = replay->stop;
+  pthread_mutex_unlock(&replay->mutex);
+  return !stop;
+}
+
+static void* ReplayThread(void *arg)
+{
+  vcCapture_replay_t *replay = (vcCapture_replay_t *)arg;
+  vcCapture_record_t record;
+  uint64_t start_ns = vcStats_NowNs();
+  uint64_t delivered = 0, skipped = 0, retries = 0;
+  bool running = true;
+
+  while(running && vcCapture_Next(replay->reader, &record))
+  {
+    if(record.kind != VCCAPTURE_RECORD_RX)
+    {
+      skipped++;
+      continue;
+    }
+    if(replay->speed > 0)
+    {
+      running = ReplayWait(replay, start_ns + (uint64_t)((double)record.timestamp_ns / replay->speed));
+    }
+    //The frame is offered again until the RX path takes it, replays never drop frames
+    while(running && !replay->emit(replay->ctx, &record))
+    {
+      retries++;
+      running = ReplayWait(replay, vcStats_NowNs() + REPLAY_RETRY_NS);
+    }
+    if(running)
+    {
+      delivered++;
+    }
+  }
+  VC_LOG("Replay %s: %llu Rx frames delivered, %llu Tx frames skipped, %llu retries in %llu ms",
+         running ? "complete" : "stopped", (unsigned long long)delivered, (unsigned long long)skipped,
+         (unsigned long long)retries, (unsigned long long)((vcStats_NowNs() - start_ns) / 1000000));
+  return NULL;
+}
+
+vcCapture_replay_t* vcCapture_StartReplay(const char *path, double speed, vcCapture_emit_t emit, void *ctx)
+{
+  vcCapture_replay_t *replay;
+  pthread_condattr_t attr;
+
+  assert(emit != NULL);
+  if(speed < 0)
+  {
+    VC_LOG_ERROR("vcCapture_StartReplay: Invalid speed %f", speed);
+    return NULL;
+  }
+  replay = (vcCapture_replay_t *)calloc(1, sizeof(vcCapture_replay_t));
+  if(replay == NULL)
+  {
+    VC_LOG_ERROR("vcCapture_StartReplay: Out of memory");
+    return NULL;
+  }
+  replay->reader = vcCapture_OpenReader(path);
+  if(replay->reader == NULL)
+  {
+    free(replay);
+    return NULL;
+  }
+  replay->speed = speed;
+  replay->emit = emit;
+  replay->ctx = ctx;
+  pthread_mutex_init(&replay->mutex, NULL);
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&replay->condition, &attr);
+  pthread_condattr_destroy(&attr);
+
+  if(pthread_create(&replay->thread, NULL, ReplayThread, replay) != 0)
+  {
+    VC_LOG_ERROR("vcCapture_StartReplay: Failed to create the replay thread");
+    pthread_cond_destroy(&replay->condition);
+    pthread_mutex_destroy(&replay->mutex);
+    vcCapture_CloseReader(replay->reader);
+    free(replay);
+    return NULL;
+  }
+  if(speed > 0)
+  {
+    VC_LOG("vcCapture_StartReplay: Replaying [%s] at %.2fx", path, speed);
+  }
+  else
+  {
+    VC_LOG("vcCapture_StartReplay: Replaying [%s] at maximum speed", path);
+  }
+  return replay;
+}
+
+void vcCapture_StopReplay(vcCapture_replay_t *replay)
+{
+  if(replay == NULL)
+  {
+    return;
+  }
+  pthread_mutex_lock(&replay->mutex);
+  replay->stop = true;
+  pthread_cond_signal(&replay->condition);
+  pthread_mutex_unlock(&replay->mutex);
+  pthread_join(replay->thread, NULL);
+
+  pthread_cond_destroy(&replay->condition);
+  pthread_mutex_destroy(&replay->mutex);
+  vcCapture_CloseReader(replay->reader);
+  free(replay);
+}
@@ -0,0 +1,179 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __VCCAPTURE_H
+#define __VCCAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Capture file layout, all integers little endian:
+ *
+ *  Header   : "VCAP" | u16 version | u16 header size | u64 CLOCK_REALTIME ns at the start of the capture
+ *  Frame    : u8 kind (RX or TX) | varint ns since the previous frame | u8 result | u8 length | frame bytes
+ *  Name     : u8 kind (NAME) | u8 logical address | u8 length | name bytes
+ *
+ * The varint is LEB128, 7 bits per byte with the top bit set on every byte but the last.
+ * The first frame is timed from the start of the capture. A name record gives the osd_name of the
+ * initiator of the frames that follow it, and is only written when the name of that address changes.
+ */
+#define VCCAPTURE_MAGIC               "VCAP"
+#define VCCAPTURE_VERSION             1
+#define VCCAPTURE_HEADER_SIZE         16
+#define VCCAPTURE_MAX_FRAME_LENGTH    255
+#define VCCAPTURE_MAX_NAME_LENGTH     16
+#define VCCAPTURE_NUM_ADDRESSES       16
+
+typedef enum
+{
+  VCCAPTURE_RECORD_RX = 0,
+  VCCAPTURE_RECORD_TX,
+  VCCAPTURE_RECORD_NAME
+} vcCapture_record_kind_t;
+
+/* One decoded frame */
+typedef struct
+{
+  vcCapture_record_kind_t kind;       /* VCCAPTURE_RECORD_RX or VCCAPTURE_RECORD_TX */
+  uint64_t timestamp_ns;              /* Since the start of the capture */
+  uint8_t result;                     /* HDMI_CEC_STATUS of a TX, HDMI_CEC_IO_SUCCESS for an RX */
+  uint32_t len;
+  uint8_t frame[VCCAPTURE_MAX_FRAME_LENGTH];
+  char source_name[VCCAPTURE_MAX_NAME_LENGTH]; /* Empty if the initiator was not known */
+  size_t offset;                      /* Of the record in the file */
+} vcCapture_record_t;
+
+typedef struct vcCapture_writer_s vcCapture_writer_t;
+typedef struct vcCapture_reader_s vcCapture_reader_t;
+typedef struct vcCapture_replay_s vcCapture_replay_t;
+
+/**
+ * @brief Delivers a replayed RX frame.
+ *
+ * Called on the replay thread. It may block until the frame can be delivered.
+ *
+ * @return false to stop the replay.
+ */
+typedef bool (*vcCapture_emit_t)(void *ctx, const vcCapture_record_t *record);
+
+/**
+ * @brief Creates a capture file, replacing any existing file.
+ *
+ * @param path Path of the file.
+ * @return Pointer to the writer, NULL if the file could not be created.
+ */
+vcCapture_writer_t* vcCapture_Open(const char *path);
+
+/**
+ * @brief Flushes and closes the capture file.
+ *
+ * @param writer Pointer to the writer.
+ */
+void vcCapture_Close(vcCapture_writer_t *writer);
+
+/**
+ * @brief Appends a frame to the capture. Thread safe.
+ *
+ * @param writer Pointer to the writer.
+ * @param kind VCCAPTURE_RECORD_RX or VCCAPTURE_RECORD_TX.
+ * @param timestamp_ns CLOCK_MONOTONIC time of the frame, see vcStats_NowNs().
+ * @param frame Frame bytes, the first one being the header block.
+ * @param len Length of the frame, truncated to VCCAPTURE_MAX_FRAME_LENGTH.
+ * @param result Result of the transmission.
+ * @param source_name osd_name of the initiator, NULL if it is not known.
+ * @return false if the record could not be written.
+ */
+bool vcCapture_Write(vcCapture_writer_t *writer, vcCapture_record_kind_t kind, uint64_t timestamp_ns,
+                     const uint8_t *frame, uint32_t len, uint8_t result, const char *source_name);
+
+/**
+ * @brief Maps a capture file for reading.
+ *
+ * @param path Path of the file.
+ * @return Pointer to the reader, NULL if the file could not be mapped or is not a capture.
+ */
+vcCapture_reader_t* vcCapture_OpenReader(const char *path);
+
+/**
+ * @brief Unmaps the capture file.
+ *
+ * @param reader Pointer to the reader.
+ */
+void vcCapture_CloseReader(vcCapture_reader_t *reader);
+
+/**
+ * @brief Decodes the next frame, applying the name records found on the way.
+ *
+ * A truncated record at the end of the file, as left by a box that lost power, ends the capture.
+ *
+ * @param reader Pointer to the reader.
+ * @param record Filled with the frame.
+ * @return false at the end of the capture.
+ */
+bool vcCapture_Next(vcCapture_reader_t *reader, vcCapture_record_t *record);
+
+/**
+ * @brief Decodes the frame record at offset, without reading the records before it.
+ *
+ * The timestamp and the source name depend on the records before it, so timestamp_ns
+ * is set to the delta from the previous frame and source_name is left empty.
+ *
+ * @param reader Pointer to the reader.
+ * @param offset Offset of a frame record, as returned in vcCapture_record_t.
+ * @param record Filled with the frame.
+ * @return false if there is no valid frame record at offset.
+ */
+bool vcCapture_ReadAt(vcCapture_reader_t *reader, size_t offset, vcCapture_record_t *record);
+
+/**
+ * @brief Goes back to the first record.
+ *
+ * @param reader Pointer to the reader.
+ */
+void vcCapture_Rewind(vcCapture_reader_t *reader);
+
+/**
+ * @brief Returns the CLOCK_REALTIME ns at which the capture started.
+ *
+ * @param reader Pointer to the reader.
+ */
+uint64_t vcCapture_GetStartTime(vcCapture_reader_t *reader);
+
+/**
+ * @brief Starts feeding the RX frames of a capture to emit, on a thread of its own.
+ *
+ * TX frames are skipped, they are what the HAL under test is expected to answer.
+ *
+ * @param path Path of the capture file.
+ * @param speed 1.0 for the original timing, 2.0 for twice as fast, etc. 0 delivers the frames back to back.
+ * @param emit Function called for every RX frame.
+ * @param ctx Passed to emit.
+ * @return Pointer to the replay, NULL if the capture could not be read.
+ */
+vcCapture_replay_t* vcCapture_StartReplay(const char *path, double speed, vcCapture_emit_t emit, void *ctx);
+
+/**
+ * @brief Stops the replay if it is still running and releases it.
+ *
+ * @param replay Pointer to the replay.
+ */
+void vcCapture_StopReplay(vcCapture_replay_t *replay);
+
+#endif //__VCCAPTURE_H
@@ -24,6 +24,50 @@
 #include "vcCommand.h"
 #include "vcDevice.h"
 
+const static vcCommand_strVal_t gUiCommandStrVal [] = {
+  { "Select", (int) CEC_UI_COMMAND_SELECT },
+  { "Up", (int) CEC_UI_COMMAND_UP },
+  { "Down", (int) CEC_UI_COMMAND_DOWN },
+  { "Left", (int) CEC_UI_COMMAND_LEFT },
+  { "Right", (int) CEC_UI_COMMAND_RIGHT },
+  { "RootMenu", (int) CEC_UI_COMMAND_ROOT_MENU },
+  { "SetupMenu", (int) CEC_UI_COMMAND_SETUP_MENU },
+  { "ContentsMenu", (int) CEC_UI_COMMAND_CONTENTS_MENU },
+  { "Exit", (int) CEC_UI_COMMAND_EXIT },
+  { "Number0", (int) CEC_UI_COMMAND_NUMBER_0 },
+  { "Number1", (int) CEC_UI_COMMAND_NUMBER_1 },
+  { "Number2", (int) CEC_UI_COMMAND_NUMBER_2 },
+  { "Number3", (int) CEC_UI_COMMAND_NUMBER_3 },
+  { "Number4", (int) CEC_UI_COMMAND_NUMBER_4 },
+  { "Number5", (int) CEC_UI_COMMAND_NUMBER_5 },
+  { "Number6", (int) CEC_UI_COMMAND_NUMBER_6 },
+  { "Number7", (int) CEC_UI_COMMAND_NUMBER_7 },
+  { "Number8", (int) CEC_UI_COMMAND_NUMBER_8 },
+  { "Number9", (int) CEC_UI_COMMAND_NUMBER_9 },
+  { "Enter", (int) CEC_UI_COMMAND_ENTER },
+  { "ChannelUp", (int) CEC_UI_COMMAND_CHANNEL_UP },
+  { "ChannelDown", (int) CEC_UI_COMMAND_CHANNEL_DOWN },
+  { "DisplayInformation", (int) CEC_UI_COMMAND_DISPLAY_INFORMATION },
+  { "Power", (int) CEC_UI_COMMAND_POWER },
+  { "VolumeUp", (int) CEC_UI_COMMAND_VOLUME_UP },
+  { "VolumeDown", (int) CEC_UI_COMMAND_VOLUME_DOWN },
+  { "Mute", (int) CEC_UI_COMMAND_MUTE },
+  { "Play", (int) CEC_UI_COMMAND_PLAY },
+  { "Stop", (int) CEC_UI_COMMAND_STOP },
+  { "Pause", (int) CEC_UI_COMMAND_PAUSE },
+  { "Record", (int) CEC_UI_COMMAND_RECORD },
+  { "Rewind", (int) CEC_UI_COMMAND_REWIND },
+  { "FastForward", (int) CEC_UI_COMMAND_FAST_FORWARD },
+  { "Eject", (int) CEC_UI_COMMAND_EJECT },
+  { "Forward", (int) CEC_UI_COMMAND_FORWARD },
+  { "Backward", (int) CEC_UI_COMMAND_BACKWARD },
+  { "EPG", (int) CEC_UI_COMMAND_EPG },
+  { "Blue", (int) CEC_UI_COMMAND_F1_BLUE },
+  { "Red", (int) CEC_UI_COMMAND_F2_RED },
+  { "Green", (int) CEC_UI_COMMAND_F3_GREEN },
+  { "Yellow", (int) CEC_UI_COMMAND_F4_YELLOW }
+};
+
 const static vcCommand_strVal_t gOpCodeStrVal [] = {
   { CMD_FEATURE_ABORT, (int) CEC_FEATURE_ABORT },
   { CMD_IMAGE_VIEW_ON, (int) CEC_IMAGE_VIEW_ON },
@@ -240,3 +284,39 @@ vcCommand_opcode_t vcCommand_GetOpCode(char* codeStr)
   return ((vcCommand_opcode_t) vcCommand_GetValue(gOpCodeStrVal, COUNT_OF(gOpCodeStrVal), codeStr, CEC_OPCODE_UNKNOWN));
 }
 
+const char* vcCommand_GetOpCodeString(int opcode)
+{
+  //A few opcodes appear twice in the table, the later entry is the one seen on a real bus
+  for (int i = COUNT_OF(gOpCodeStrVal) - 1;  i >= 0;  --i)
+  {
+    if (opcode == gOpCodeStrVal[i].val)
+    {
+      return gOpCodeStrVal[i].str;
+    }
+  }
+  return NULL;
+}
+
+vcCommand_ui_command_t vcCommand_GetUiCommand(char* codeStr)
+{
+  char *end;
+  long code;
+
+  if (codeStr == NULL || codeStr[0] == '\0')
+  {
+    return CEC_UI_COMMAND_UNKNOWN;
+  }
+  code = vcCommand_GetValue(gUiCommandStrVal, COUNT_OF(gUiCommandStrVal), codeStr, CEC_UI_COMMAND_UNKNOWN);
+  if(code != CEC_UI_COMMAND_UNKNOWN)
+  {
+    return (vcCommand_ui_command_t) code;
+  }
+  //Codes without a name are given as numbers
+  code = strtol(codeStr, &end, 0);
+  if(*end != '\0' || code < 0 || code > 0xFF)
+  {
+    return CEC_UI_COMMAND_UNKNOWN;
+  }
+  return (vcCommand_ui_command_t) code;
+}
+
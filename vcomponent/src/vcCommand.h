@@ -30,14 +30,22 @@
 #define CEC_MSG_COMMAND "command"
 #define CEC_MSG_CONFIG "config"
 #define CEC_MSG_STATE "state"
+#define CEC_MSG_REQUEST_ID "request_id"
+#define CEC_MSG_BATCH "batch"
+#define CEC_MSG_TRAFFIC "traffic"
+#define CEC_MSG_KEYPRESS "keypress"
 
 #define CEC_MSG_STATE_ADD_DEVICE "AddDevice"
 #define CEC_MSG_STATE_REMOVE_DEVICE "RemoveDevice"
 #define CEC_MSG_STATE_PRINT_STATUS "PrintStatus"
+#define CEC_MSG_STATE_START_CAPTURE "StartCapture"
+#define CEC_MSG_STATE_STOP_CAPTURE "StopCapture"
+#define CEC_MSG_STATE_REPLAY "Replay"
 
 #define CEC_CMD_INITIATOR "initiator"
 #define CEC_CMD_DESTINATION "destination"
 #define CEC_CMD_PARAMETERS "parameters"
+#define CEC_CMD_DELAY_MS "delay_ms"
 
 #define CEC_BROADCAST "broadcast"
 
@@ -103,6 +111,7 @@
 
 //Parameter Names
 #define CMD_DATA_OSD_NAME "osd_name"
+#define CMD_DATA_UI_COMMAND "ui_command"
 
 #define COUNT_OF(x) ((sizeof(x)/sizeof(0[x])) / ((size_t)(!(sizeof(x) % sizeof(0[x])))))
 
@@ -168,6 +177,53 @@ typedef enum
 } vcCommand_opcode_t;
 
 
+/* UI command codes carried by UserControlPressed */
+typedef enum
+{
+  CEC_UI_COMMAND_UNKNOWN             = -1,
+  CEC_UI_COMMAND_SELECT              = 0x00,
+  CEC_UI_COMMAND_UP                  = 0x01,
+  CEC_UI_COMMAND_DOWN                = 0x02,
+  CEC_UI_COMMAND_LEFT                = 0x03,
+  CEC_UI_COMMAND_RIGHT               = 0x04,
+  CEC_UI_COMMAND_ROOT_MENU           = 0x09,
+  CEC_UI_COMMAND_SETUP_MENU          = 0x0A,
+  CEC_UI_COMMAND_CONTENTS_MENU       = 0x0B,
+  CEC_UI_COMMAND_EXIT                = 0x0D,
+  CEC_UI_COMMAND_NUMBER_0            = 0x20,
+  CEC_UI_COMMAND_NUMBER_1            = 0x21,
+  CEC_UI_COMMAND_NUMBER_2            = 0x22,
+  CEC_UI_COMMAND_NUMBER_3            = 0x23,
+  CEC_UI_COMMAND_NUMBER_4            = 0x24,
+  CEC_UI_COMMAND_NUMBER_5            = 0x25,
+  CEC_UI_COMMAND_NUMBER_6            = 0x26,
+  CEC_UI_COMMAND_NUMBER_7            = 0x27,
+  CEC_UI_COMMAND_NUMBER_8            = 0x28,
+  CEC_UI_COMMAND_NUMBER_9            = 0x29,
+  CEC_UI_COMMAND_ENTER               = 0x2B,
+  CEC_UI_COMMAND_CHANNEL_UP          = 0x30,
+  CEC_UI_COMMAND_CHANNEL_DOWN        = 0x31,
+  CEC_UI_COMMAND_DISPLAY_INFORMATION = 0x35,
+  CEC_UI_COMMAND_POWER               = 0x40,
+  CEC_UI_COMMAND_VOLUME_UP           = 0x41,
+  CEC_UI_COMMAND_VOLUME_DOWN         = 0x42,
+  CEC_UI_COMMAND_MUTE                = 0x43,
+  CEC_UI_COMMAND_PLAY                = 0x44,
+  CEC_UI_COMMAND_STOP                = 0x45,
+  CEC_UI_COMMAND_PAUSE               = 0x46,
+  CEC_UI_COMMAND_RECORD              = 0x47,
+  CEC_UI_COMMAND_REWIND              = 0x48,
+  CEC_UI_COMMAND_FAST_FORWARD        = 0x49,
+  CEC_UI_COMMAND_EJECT               = 0x4A,
+  CEC_UI_COMMAND_FORWARD             = 0x4B,
+  CEC_UI_COMMAND_BACKWARD            = 0x4C,
+  CEC_UI_COMMAND_EPG                 = 0x53,
+  CEC_UI_COMMAND_F1_BLUE             = 0x71,
+  CEC_UI_COMMAND_F2_RED              = 0x72,
+  CEC_UI_COMMAND_F3_GREEN            = 0x73,
+  CEC_UI_COMMAND_F4_YELLOW           = 0x74
+} vcCommand_ui_command_t;
+
 typedef enum
 {
   CEC_POWER_STATUS_ON                          = 0x00,
@@ -335,6 +391,22 @@ uint32_t vcCommand_GetRawBytes(vcCommand_t* cmd, uint8_t* data, uint32_t len);
  */
 vcCommand_opcode_t vcCommand_GetOpCode(char* codeStr);
 
+/**
+ * @brief Converts an opcode to its name.
+ *
+ * @param opcode The opcode.
+ * @return The name of the opcode, or NULL if it is not known.
+ */
+const char* vcCommand_GetOpCodeString(int opcode);
+
+/**
+ * @brief Converts a UI command name, e.g. "Select" or "VolumeUp", or a number, e.g. "0x41", to its code.
+ *
+ * @param codeStr The UI command name or number.
+ * @return The UI command code, or CEC_UI_COMMAND_UNKNOWN.
+ */
+vcCommand_ui_command_t vcCommand_GetUiCommand(char* codeStr);
+
 /**
  * @brief Gets the value (int - enum) associated with the string from the provided array of strVal_t.
  *
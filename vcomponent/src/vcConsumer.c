@@ -0,0 +1,593 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "vcHdmiCec.h"
+#include "vcConsumer.h"
+#include "vcStats.h"
+
+/* The public consumers, plus one slot for the HAL client */
+#define VCCONSUMER_MAX_SLOTS   (VC_HDMICEC_MAX_RX_CONSUMERS + 1)
+#define VCCONSUMER_CLIENT_SLOT VC_HDMICEC_MAX_RX_CONSUMERS
+
+/* Frame waiting for a worker */
+typedef struct
+{
+  uint64_t enqueue_ns;
+  uint32_t len;
+  uint8_t data[VC_HDMICEC_MAX_FRAME_LENGTH];
+} vcConsumer_entry_t;
+
+typedef struct
+{
+  bool active;
+  uint32_t busy;            //Callbacks of the consumer running right now
+  bool scheduled;           //In the ready list or served by a worker
+  int id;
+  vcHdmiCec_OpcodeMask_t mask;
+  vcHdmiCec_RxConsumerCallback_t callback;
+  void *data;
+  vcConsumer_entry_t *queue;
+  uint32_t head;
+  uint32_t count;
+  vcConsumer_stats_t stats;
+} vcConsumer_slot_t;
+
+/* Consumer picked for a frame, copied out of the table so the callback runs without the mutex */
+typedef struct
+{
+  vcConsumer_slot_t *slot;
+  int id;
+  vcHdmiCec_RxConsumerCallback_t callback;
+  void *data;
+} vcConsumer_match_t;
+
+struct vcConsumer_table_s
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t idle;
+  pthread_cond_t work;
+  pthread_t dispatcher;
+  int next_id;
+  vcConsumer_slot_t slots[VCCONSUMER_MAX_SLOTS];
+
+  //Dispatcher pool, unused when num_workers is 0
+  uint32_t num_workers;
+  uint32_t queue_size;
+  pthread_t *workers;
+  bool stop;
+  vcConsumer_slot_t *ready[VCCONSUMER_MAX_SLOTS];
+  uint32_t ready_head;
+  uint32_t ready_count;
+};
+
+static vcConsumer_slot_t* FindSlot(vcConsumer_table_t *table, int id)
+{
+  for(int i = 0; i < VC_HDMICEC_MAX_RX_CONSUMERS; i++)
+  {
+    if(table->slots[i].active && table->slots[i].id == id)
+    {
+      return &table->slots[i];
+    }
+  }
+  return NULL;
+}
+
+/* True on the threads that run callbacks, where waiting for a callback would dead lock */
+static bool IsCallbackThread(vcConsumer_table_t *table)
+{
+  if(pthread_equal(pthread_self(), table->dispatcher))
+  {
+    return true;
+  }
+  for(uint32_t i = 0; i < table->num_workers; i++)
+  {
+    if(pthread_equal(pthread_self(), table->workers[i]))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Fills a free slot, called with the mutex held */
+static void InitSlot(vcConsumer_slot_t *slot, int id, const char *name, vcHdmiCec_RxConsumerCallback_t callback, void *data)
+{
+  vcConsumer_entry_t *queue = slot->queue;
+
+  memset(slot, 0, sizeof(vcConsumer_slot_t));
+  slot->queue = queue;
+  slot->id = id;
+  slot->callback = callback;
+  slot->data = data;
+  slot->stats.id = id;
+  if(name != NULL)
+  {
+    strncpy(slot->stats.name, name, VCCONSUMER_MAX_NAME_LENGTH - 1);
+  }
+}
+
+/* Queues a frame for the workers, called with the mutex held */
+static void Enqueue(vcConsumer_table_t *table, vcConsumer_slot_t *slot, const uint8_t *frame, uint32_t len, uint64_t now)
+{
+  vcConsumer_entry_t *entry;
+
+  if(slot->count == table->queue_size)
+  {
+    slot->stats.dropped++;
+    return;
+  }
+  entry = &slot->queue[(slot->head + slot->count) % table->queue_size];
+  entry->enqueue_ns = now;
+  entry->len = (len > VC_HDMICEC_MAX_FRAME_LENGTH) ? VC_HDMICEC_MAX_FRAME_LENGTH : len;
+  memcpy(entry->data, frame, entry->len);
+  slot->count++;
+  if(slot->count > slot->stats.maxDepth)
+  {
+    slot->stats.maxDepth = slot->count;
+  }
+
+  //A slot is handed to one worker at a time, which keeps the frames of a consumer in order
+  if(!slot->scheduled)
+  {
+    slot->scheduled = true;
+    table->ready[(table->ready_head + table->ready_count) % VCCONSUMER_MAX_SLOTS] = slot;
+    table->ready_count++;
+    pthread_cond_signal(&table->work);
+  }
+}
+
+/* Runs the callback of a match without the mutex. slot->busy is taken by the caller and released here.
+ * enqueue_ns is 0 when the frame was not queued. */
+static void RunCallback(vcConsumer_table_t *table, vcConsumer_match_t *match, const uint8_t *frame, uint32_t len, uint64_t enqueue_ns)
+{
+  uint64_t start = 0, duration = 0;
+  bool ran = false;
+
+  //An earlier callback may have removed the consumer
+  if(__atomic_load_n(&match->slot->active, __ATOMIC_ACQUIRE))
+  {
+    start = vcStats_NowNs();
+    match->callback(match->id, match->data, frame, len);
+    duration = vcStats_NowNs() - start;
+    ran = true;
+  }
+
+  pthread_mutex_lock(&table->mutex);
+  if(ran)
+  {
+    match->slot->stats.delivered++;
+    match->slot->stats.totalNs += duration;
+    if(duration > match->slot->stats.maxNs)
+    {
+      match->slot->stats.maxNs = duration;
+    }
+    if(enqueue_ns != 0)
+    {
+      match->slot->stats.waitTotalNs += start - enqueue_ns;
+      if(start - enqueue_ns > match->slot->stats.waitMaxNs)
+      {
+        match->slot->stats.waitMaxNs = start - enqueue_ns;
+      }
+    }
+  }
+  match->slot->busy--;
+  if(match->slot->busy == 0 && !match->slot->active)
+  {
+    pthread_cond_broadcast(&table->idle);
+  }
+  pthread_mutex_unlock(&table->mutex);
+}
+
+/* Serves one frame of the oldest ready consumer at a time, so one slow consumer keeps at most one worker */
+static void* Worker(void *arg)
+{
+  vcConsumer_table_t *table = (vcConsumer_table_t *)arg;
+  vcConsumer_slot_t *slot;
+  vcConsumer_entry_t entry;
+  vcConsumer_match_t match;
+
+  pthread_mutex_lock(&table->mutex);
+  while(true)
+  {
+    while(table->ready_count == 0 && !table->stop)
+    {
+      pthread_cond_wait(&table->work, &table->mutex);
+    }
+    if(table->stop)
+    {
+      break;
+    }
+    slot = table->ready[table->ready_head];
+    table->ready_head = (table->ready_head + 1) % VCCONSUMER_MAX_SLOTS;
+    table->ready_count--;
+    if(!slot->active || slot->count == 0)
+    {
+      slot->scheduled = false;
+      continue;
+    }
+
+    entry = slot->queue[slot->head];
+    slot->head = (slot->head + 1) % table->queue_size;
+    slot->count--;
+    slot->busy++;
+    match.slot = slot;
+    match.id = slot->id;
+    match.callback = slot->callback;
+    match.data = slot->data;
+    pthread_mutex_unlock(&table->mutex);
+
+    RunCallback(table, &match, entry.data, entry.len, entry.enqueue_ns);
+
+    pthread_mutex_lock(&table->mutex);
+    if(slot->active && slot->count > 0)
+    {
+      //Back to the end of the ready list, behind the other consumers
+      table->ready[(table->ready_head + table->ready_count) % VCCONSUMER_MAX_SLOTS] = slot;
+      table->ready_count++;
+    }
+    else
+    {
+      slot->scheduled = false;
+    }
+  }
+  pthread_mutex_unlock(&table->mutex);
+  return NULL;
+}
+
+vcConsumer_table_t* vcConsumer_Create(uint32_t workers, uint32_t queueSize)
+{
+  vcConsumer_table_t *table = (vcConsumer_table_t *)calloc(1, sizeof(vcConsumer_table_t));
+
+  if(table == NULL)
+  {
+    return NULL;
+  }
+  pthread_mutex_init(&table->mutex, NULL);
+  pthread_cond_init(&table->idle, NULL);
+  pthread_cond_init(&table->work, NULL);
+  table->next_id = 1;
+  if(workers == 0)
+  {
+    return table;
+  }
+
+  table->queue_size = queueSize ? queueSize : VCCONSUMER_DEFAULT_QUEUE_SIZE;
+  table->workers = (pthread_t *)calloc(VCCONSUMER_MAX_SLOTS, sizeof(pthread_t));
+  if(table->workers == NULL)
+  {
+    vcConsumer_Destroy(table);
+    return NULL;
+  }
+  for(int i = 0; i < VCCONSUMER_MAX_SLOTS; i++)
+  {
+    table->slots[i].queue = (vcConsumer_entry_t *)malloc(table->queue_size * sizeof(vcConsumer_entry_t));
+    if(table->slots[i].queue == NULL)
+    {
+      vcConsumer_Destroy(table);
+      return NULL;
+    }
+  }
+  //More workers than consumers would never run
+  while(table->num_workers < workers && table->num_workers < VCCONSUMER_MAX_SLOTS)
+  {
+    if(pthread_create(&table->workers[table->num_workers], NULL, Worker, table) != 0)
+    {
+      VC_LOG_ERROR("vcConsumer_Create: Failed to start dispatcher worker %u", table->num_workers);
+      vcConsumer_Destroy(table);
+      return NULL;
+    }
+    table->num_workers++;
+  }
+  return table;
+}
+
+void vcConsumer_Destroy(vcConsumer_table_t *table)
+{
+  uint32_t discarded = 0;
+
+  if(table == NULL)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&table->mutex);
+  table->stop = true;
+  pthread_cond_broadcast(&table->work);
+  pthread_mutex_unlock(&table->mutex);
+  for(uint32_t i = 0; i < table->num_workers; i++)
+  {
+    pthread_join(table->workers[i], NULL);
+  }
+
+  for(int i = 0; i < VCCONSUMER_MAX_SLOTS; i++)
+  {
+    if(table->slots[i].active)
+    {
+      discarded += table->slots[i].count;
+    }
+    free(table->slots[i].queue);
+  }
+  if(discarded > 0)
+  {
+    VC_LOG("Rx dispatcher discarded %u queued frames", discarded);
+  }
+  free(table->workers);
+  pthread_cond_destroy(&table->work);
+  pthread_cond_destroy(&table->idle);
+  pthread_mutex_destroy(&table->mutex);
+  free(table);
+}
+
+bool vcConsumer_Add(vcConsumer_table_t *table, const char *name, const vcHdmiCec_OpcodeMask_t *mask,
+                    vcHdmiCec_RxConsumerCallback_t callback, void *data, int *id)
+{
+  vcConsumer_slot_t *slot = NULL;
+
+  assert(table != NULL);
+  assert(mask != NULL);
+  assert(callback != NULL);
+  assert(id != NULL);
+
+  pthread_mutex_lock(&table->mutex);
+  //A removed slot is free once its callback has returned and no worker holds it
+  for(int i = 0; i < VC_HDMICEC_MAX_RX_CONSUMERS && slot == NULL; i++)
+  {
+    if(!table->slots[i].active && table->slots[i].busy == 0 && !table->slots[i].scheduled)
+    {
+      slot = &table->slots[i];
+    }
+  }
+  if(slot == NULL)
+  {
+    pthread_mutex_unlock(&table->mutex);
+    return false;
+  }
+
+  InitSlot(slot, table->next_id++, name, callback, data);
+  slot->mask = *mask;
+  __atomic_store_n(&slot->active, true, __ATOMIC_RELEASE);
+  *id = slot->id;
+  pthread_mutex_unlock(&table->mutex);
+  return true;
+}
+
+void vcConsumer_SetClient(vcConsumer_table_t *table, const char *name, vcHdmiCec_RxConsumerCallback_t callback, void *data)
+{
+  vcConsumer_slot_t *slot;
+
+  assert(table != NULL);
+  assert(callback != NULL);
+
+  pthread_mutex_lock(&table->mutex);
+  slot = &table->slots[VCCONSUMER_CLIENT_SLOT];
+  assert(!slot->active);
+  InitSlot(slot, 0, name, callback, data);
+  __atomic_store_n(&slot->active, true, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&table->mutex);
+}
+
+bool vcConsumer_SetMask(vcConsumer_table_t *table, int id, const vcHdmiCec_OpcodeMask_t *mask)
+{
+  vcConsumer_slot_t *slot;
+
+  assert(table != NULL);
+  assert(mask != NULL);
+
+  pthread_mutex_lock(&table->mutex);
+  slot = FindSlot(table, id);
+  if(slot != NULL)
+  {
+    slot->mask = *mask;
+  }
+  pthread_mutex_unlock(&table->mutex);
+  return (slot != NULL);
+}
+
+bool vcConsumer_Remove(vcConsumer_table_t *table, int id)
+{
+  vcConsumer_slot_t *slot;
+
+  assert(table != NULL);
+
+  pthread_mutex_lock(&table->mutex);
+  slot = FindSlot(table, id);
+  if(slot != NULL)
+  {
+    __atomic_store_n(&slot->active, false, __ATOMIC_RELEASE);
+    //Frames still queued for the consumer are dropped
+    slot->count = 0;
+    //The caller may free the callback data once this returns
+    while(slot->busy > 0 && !IsCallbackThread(table))
+    {
+      pthread_cond_wait(&table->idle, &table->mutex);
+    }
+  }
+  pthread_mutex_unlock(&table->mutex);
+  return (slot != NULL);
+}
+
+uint32_t vcConsumer_Dispatch(vcConsumer_table_t *table, const uint8_t *frame, uint32_t len)
+{
+  vcConsumer_match_t matches[VC_HDMICEC_MAX_RX_CONSUMERS];
+  uint32_t numMatches = 0;
+  uint64_t word = 0, bit = 0;
+  uint64_t now = 0;
+
+  assert(table != NULL);
+  assert(frame != NULL);
+
+  //Polling messages match no mask
+  if(len > 1)
+  {
+    word = frame[1] >> 6;
+    bit = 1ULL << (frame[1] & 63);
+  }
+  if(table->num_workers > 0)
+  {
+    now = vcStats_NowNs();
+  }
+
+  pthread_mutex_lock(&table->mutex);
+  table->dispatcher = pthread_self();
+  for(int i = 0; i < VC_HDMICEC_MAX_RX_CONSUMERS; i++)
+  {
+    vcConsumer_slot_t *slot = &table->slots[i];
+    if(!slot->active)
+    {
+      continue;
+    }
+    if((slot->mask.bits[word] & bit) == 0)
+    {
+      slot->stats.filtered++;
+      continue;
+    }
+    if(table->num_workers > 0)
+    {
+      Enqueue(table, slot, frame, len, now);
+      numMatches++;
+      continue;
+    }
+    slot->busy++;
+    matches[numMatches].slot = slot;
+    matches[numMatches].id = slot->id;
+    matches[numMatches].callback = slot->callback;
+    matches[numMatches].data = slot->data;
+    numMatches++;
+  }
+  pthread_mutex_unlock(&table->mutex);
+
+  if(table->num_workers > 0)
+  {
+    return numMatches;
+  }
+  for(uint32_t i = 0; i < numMatches; i++)
+  {
+    RunCallback(table, &matches[i], frame, len, 0);
+  }
+  return numMatches;
+}
+
+void vcConsumer_PostClient(vcConsumer_table_t *table, const uint8_t *frame, uint32_t len)
+{
+  vcConsumer_slot_t *slot;
+  vcConsumer_match_t match;
+
+  assert(table != NULL);
+  assert(frame != NULL);
+
+  slot = &table->slots[VCCONSUMER_CLIENT_SLOT];
+  pthread_mutex_lock(&table->mutex);
+  table->dispatcher = pthread_self();
+  if(!slot->active)
+  {
+    pthread_mutex_unlock(&table->mutex);
+    return;
+  }
+  if(table->num_workers > 0)
+  {
+    Enqueue(table, slot, frame, len, vcStats_NowNs());
+    pthread_mutex_unlock(&table->mutex);
+    return;
+  }
+  slot->busy++;
+  match.slot = slot;
+  match.id = slot->id;
+  match.callback = slot->callback;
+  match.data = slot->data;
+  pthread_mutex_unlock(&table->mutex);
+
+  RunCallback(table, &match, frame, len, 0);
+}
+
+uint32_t vcConsumer_GetStats(vcConsumer_table_t *table, vcConsumer_stats_t *stats, uint32_t maxStats)
+{
+  uint32_t count = 0;
+
+  assert(table != NULL);
+  assert(stats != NULL || maxStats == 0);
+
+  pthread_mutex_lock(&table->mutex);
+  for(int i = 0; i < VCCONSUMER_MAX_SLOTS; i++)
+  {
+    if(!table->slots[i].active)
+    {
+      continue;
+    }
+    if(count < maxStats)
+    {
+      stats[count] = table->slots[i].stats;
+      stats[count].mask = table->slots[i].mask;
+      stats[count].depth = table->slots[i].count;
+    }
+    count++;
+  }
+  pthread_mutex_unlock(&table->mutex);
+  return count;
+}
+
+void vcConsumer_Print(vcConsumer_table_t *table)
+{
+  vcConsumer_stats_t stats[VCCONSUMER_MAX_SLOTS];
+  uint32_t count;
+
+  assert(table != NULL);
+  count = vcConsumer_GetStats(table, stats, VCCONSUMER_MAX_SLOTS);
+
+  VC_LOG(">>>>>>> >>>>> >>>> >> >> >");
+  VC_LOG("Rx Consumers   : %u", count);
+  if(table->num_workers > 0)
+  {
+    VC_LOG("Dispatcher     : %u workers, %u frames per consumer", table->num_workers, table->queue_size);
+  }
+  else
+  {
+    VC_LOG("Dispatcher     : none, callbacks run on the message handler");
+  }
+  for(uint32_t i = 0; i < count; i++)
+  {
+    VC_LOG("  [%d] %s", stats[i].id, stats[i].name);
+    if(stats[i].id != 0)
+    {
+      VC_LOG("    Mask       : %016llX%016llX%016llX%016llX",
+             stats[i].mask.bits[3], stats[i].mask.bits[2], stats[i].mask.bits[1], stats[i].mask.bits[0]);
+    }
+    VC_LOG("    Delivered  : %llu, filtered %llu", (unsigned long long)stats[i].delivered, (unsigned long long)stats[i].filtered);
+    if(stats[i].delivered > 0)
+    {
+      VC_LOG("    Callback   : mean %llu us, max %llu us",
+             (unsigned long long)(stats[i].totalNs / stats[i].delivered / 1000), (unsigned long long)(stats[i].maxNs / 1000));
+    }
+    if(table->num_workers > 0)
+    {
+      VC_LOG("    Queue      : depth %u, max %u, dropped %llu", stats[i].depth, stats[i].maxDepth, (unsigned long long)stats[i].dropped);
+      if(stats[i].delivered > 0)
+      {
+        VC_LOG("    Queue wait : mean %llu us, max %llu us",
+               (unsigned long long)(stats[i].waitTotalNs / stats[i].delivered / 1000), (unsigned long long)(stats[i].waitMaxNs / 1000));
+      }
+    }
+  }
+  VC_LOG("=================================");
+}
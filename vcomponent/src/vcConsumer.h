@@ -0,0 +1,143 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __VCCONSUMER_H
+#define __VCCONSUMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "vcHdmiCec.h"
+
+#define VCCONSUMER_MAX_NAME_LENGTH    VC_HDMICEC_MAX_RX_CONSUMER_NAME_LENGTH
+#define VCCONSUMER_DEFAULT_QUEUE_SIZE 64
+
+typedef struct vcConsumer_table_s vcConsumer_table_t;
+
+typedef vcHdmiCec_RxConsumerStats_t vcConsumer_stats_t;
+
+/**
+ * @brief Creates an empty table of Rx consumers.
+ *
+ * With no workers, the callbacks run on the thread that dispatches the frame. Otherwise each
+ * consumer gets a queue and the callbacks run on a pool of worker threads. A consumer is served
+ * by one worker at a time, so it gets its frames in order, and a slow consumer holds one worker
+ * while the others keep serving the rest.
+ *
+ * @param workers Number of worker threads, 0 to run the callbacks on the dispatching thread.
+ * @param queueSize Frames queued per consumer before frames are dropped, 0 for VCCONSUMER_DEFAULT_QUEUE_SIZE.
+ * @return Pointer to the table, NULL on failure.
+ */
+vcConsumer_table_t* vcConsumer_Create(uint32_t workers, uint32_t queueSize);
+
+/**
+ * @brief Releases the table. No frame may be dispatched anymore.
+ *
+ * @param table Pointer to the table.
+ */
+void vcConsumer_Destroy(vcConsumer_table_t *table);
+
+/**
+ * @brief Adds a consumer.
+ *
+ * @param table Pointer to the table.
+ * @param name Name used when printing, may be NULL.
+ * @param mask Opcodes delivered to the consumer.
+ * @param callback Called with the frames whose opcode is in the mask.
+ * @param data Passed back to callback.
+ * @param id Receives the id of the consumer. Ids are not reused.
+ * @return false if the table is full.
+ */
+bool vcConsumer_Add(vcConsumer_table_t *table, const char *name, const vcHdmiCec_OpcodeMask_t *mask,
+                    vcHdmiCec_RxConsumerCallback_t callback, void *data, int *id);
+
+/**
+ * @brief Sets the consumer of the HAL client, which gets every frame posted with vcConsumer_PostClient().
+ *
+ * The client has id 0 and no opcode mask. It is served by the workers like the other consumers.
+ *
+ * @param table Pointer to the table.
+ * @param name Name used when printing.
+ * @param callback Called with every frame posted.
+ * @param data Passed back to callback.
+ */
+void vcConsumer_SetClient(vcConsumer_table_t *table, const char *name, vcHdmiCec_RxConsumerCallback_t callback, void *data);
+
+/**
+ * @brief Replaces the opcode mask of a consumer. Takes effect from the next frame dispatched.
+ *
+ * @param table Pointer to the table.
+ * @param id Id returned by vcConsumer_Add().
+ * @param mask Opcodes delivered to the consumer.
+ * @return false if there is no such consumer.
+ */
+bool vcConsumer_SetMask(vcConsumer_table_t *table, int id, const vcHdmiCec_OpcodeMask_t *mask);
+
+/**
+ * @brief Removes a consumer.
+ *
+ * Frames still queued for the consumer are dropped. Returns once the callback of the consumer
+ * is no longer running, unless it is called from a consumer callback.
+ *
+ * @param table Pointer to the table.
+ * @param id Id returned by vcConsumer_Add().
+ * @return false if there is no such consumer.
+ */
+bool vcConsumer_Remove(vcConsumer_table_t *table, int id);
+
+/**
+ * @brief Passes a frame to every consumer whose mask has its opcode, in the order they were added.
+ *
+ * Polling messages carry no opcode and are not delivered. With workers, the frame is copied
+ * to the queue of each consumer and the function returns without waiting for the callbacks.
+ *
+ * @param table Pointer to the table.
+ * @param frame CEC frame, header block first.
+ * @param len Frame length in bytes.
+ * @return Number of consumers the frame was delivered or queued to.
+ */
+uint32_t vcConsumer_Dispatch(vcConsumer_table_t *table, const uint8_t *frame, uint32_t len);
+
+/**
+ * @brief Passes a frame to the HAL client set with vcConsumer_SetClient().
+ *
+ * @param table Pointer to the table.
+ * @param frame CEC frame, header block first.
+ * @param len Frame length in bytes.
+ */
+void vcConsumer_PostClient(vcConsumer_table_t *table, const uint8_t *frame, uint32_t len);
+
+/**
+ * @brief Copies the counters, queue depths and masks of the consumers.
+ *
+ * @param table Pointer to the table.
+ * @param stats Receives up to maxStats entries, one per consumer including the HAL client.
+ * @param maxStats Number of entries stats holds.
+ * @return Number of consumers.
+ */
+uint32_t vcConsumer_GetStats(vcConsumer_table_t *table, vcConsumer_stats_t *stats, uint32_t maxStats);
+
+/**
+ * @brief Prints the consumers, their masks, their counters and their queue depths.
+ *
+ * @param table Pointer to the table.
+ */
+void vcConsumer_Print(vcConsumer_table_t *table);
+
+#endif //__VCCONSUMER_H
@@ -310,6 +310,25 @@ struct vcDevice_info_t* vcDevice_Get(struct vcDevice_info_t* map, char* name)
   return vcDevice_Get(map->next_sibling, name);
 }
 
+struct vcDevice_info_t* vcDevice_GetByLogicalAddress(struct vcDevice_info_t* map, int logical_address)
+{
+  struct vcDevice_info_t* device;
+  if(map == NULL)
+  {
+    return NULL;
+  }
+  if(map->logical_address == logical_address)
+  {
+    return map;
+  }
+  device = vcDevice_GetByLogicalAddress(map->first_child, logical_address);
+  if(device != NULL)
+  {
+    return device;
+  }
+  return vcDevice_GetByLogicalAddress(map->next_sibling, logical_address);
+}
+
 void vcDevice_InitLogicalAddressPool(vcDevice_logical_address_pool_t *pool)
 {
   if(pool == NULL)
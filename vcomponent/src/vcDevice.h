@@ -34,7 +34,7 @@ typedef enum
 } vcDevice_port_type_t;
 
 typedef struct {
-    bool allocated[LOGICAL_ADDRESS_BROADCAST];
+    bool allocated[LOGICAL_ADDRESS_BROADCAST + 1];
 } vcDevice_logical_address_pool_t;
 
 extern struct vcDevice_info_t
@@ -122,6 +122,15 @@ void vcDevice_RemoveChild(struct vcDevice_info_t* map, char* name);
  */
 struct vcDevice_info_t* vcDevice_Get(struct vcDevice_info_t* map, char* name);
 
+/**
+ * @brief Finds a device by its logical address.
+ *
+ * @param map Pointer to the root of the device map.
+ * @param logical_address Logical address of the device to be found.
+ * @return Pointer to the first device found with that address, NULL otherwise.
+ */
+struct vcDevice_info_t* vcDevice_GetByLogicalAddress(struct vcDevice_info_t* map, int logical_address);
+
 /**
  * @brief Initializes the logical address pool.
  *
@@ -21,17 +21,31 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <errno.h>
+#include <time.h>
 #include <pthread.h>
 
 #include "hdmi_cec_driver.h"
 #include "vcHdmiCec.h"
 #include "vcDevice.h"
 #include "vcCommand.h"
+#include "vcTrace.h"
+#include "vcStats.h"
+#include "vcScheduler.h"
+#include "vcTraffic.h"
+#include "vcCapture.h"
+#include "vcRxQueue.h"
+#include "vcConsumer.h"
 #include "ut_kvp_profile.h"
 #include "ut_control_plane.h"
 
 #define MAX_QUEUE_SIZE 32
+#define CONTROL_QUEUE_SLOTS 8
+#define MAX_BATCH_SIZE 32
+#define MAX_KEYPRESS_FRAMES 1000
 #define CONTROL_PLANE_PORT 8080
+#define DEFAULT_CALLBACK_BUDGET_US 10000
+#define RESET_TIMEOUT_MS 5000
 
 typedef enum
 {
@@ -40,6 +54,13 @@ typedef enum
   CEC_MSG_TYPE_EVENT,
   CEC_MSG_TYPE_CONFIG,
   CEC_MSG_TYPE_STATE,
+  CEC_MSG_TYPE_FRAME,
+  CEC_MSG_TYPE_RESET,
+  CEC_MSG_TYPE_BATCH,
+  CEC_MSG_TYPE_TRAFFIC,
+  CEC_MSG_TYPE_TRAFFIC_FRAME,
+  CEC_MSG_TYPE_KEYPRESS,
+  CEC_MSG_TYPE_TX_COMPLETE,
   CEC_MSG_TYPE_EXIT_REQUESTED
 } vcHdmiCec_msg_type_t;
 
@@ -48,8 +69,27 @@ typedef struct
   vcHdmiCec_msg_type_t type;
   char* message;
   uint32_t size;
+  char request_id[VC_HDMICEC_MAX_REQUEST_ID_LENGTH]; //Empty if the message is not acknowledged
+  uint64_t received_ns;
 } vcHdmiCec_message_t;
 
+/* One item of a batch, decoded into its CEC frame before any item is delivered */
+typedef struct
+{
+  uint8_t data[VCCOMMAND_MAX_DATA_SIZE];
+  uint32_t len;
+  uint64_t deadline_ns;
+} vcHdmiCec_batch_item_t;
+
+/* Result of HdmiCecTxAsync, reported to the Tx callback from the message handler */
+typedef struct
+{
+  int handle;
+  int result;
+  int len;
+  unsigned char data[VCCOMMAND_MAX_DATA_SIZE];
+} vcHdmiCec_tx_complete_t;
+
 /**HDMI CEC HAL Data structures */
 typedef struct
 {
@@ -84,13 +124,26 @@ typedef struct
   int num_devices;
   struct vcDevice_info_t* devices_map;
   vcHdmiCec_callbacks_t callbacks;
+  vcStats_callback_t rx_cb_stats;
+  vcStats_callback_t tx_cb_stats;
   vcDevice_logical_address_pool_t address_pool;
 
+  vcScheduler_t *scheduler;
+  vcTraffic_t *traffic;
+  bool profile_traffic_started;
+  vcCapture_writer_t *capture;
+  pthread_mutex_t capture_mutex;    //Also guards devices_map and emulated_device against a reset
+  vcCapture_replay_t *replay;
+  vcRxQueue_t *rx_queue;
+  vcConsumer_table_t *consumers;
   pthread_t msg_handler_thread;
   uint32_t msg_count;
-  vcHdmiCec_message_t msg_queue[MAX_QUEUE_SIZE];
+  vcHdmiCec_message_t msg_queue[MAX_QUEUE_SIZE + CONTROL_QUEUE_SLOTS];
   pthread_mutex_t msg_queue_mutex;
   pthread_cond_t msg_queue_condition;
+  pthread_cond_t msg_space_condition;
+  pthread_cond_t reset_condition;
+  uint32_t reset_count;
   volatile bool exit_request;
 } vcHdmiCec_hal_t;
 
@@ -100,9 +153,18 @@ typedef struct
   vcHdmiCec_hal_t * cec_hal;
   ut_kvp_instance_t *profile_instance;
   ut_controlPlane_instance_t *cp_instance;
+  vcHdmiCec_AckCallback_t ack_cb_func;
+  void* ack_cb_data;
   bool bOpened;
 } vcHdmiCec_internal_t;
 
+/* Frame waiting in the scheduler to be queued to the message handler */
+typedef struct
+{
+  vcHdmiCec_hal_t *hal;
+  vcHdmiCec_message_t msg;
+} vcHdmiCec_scheduled_t;
+
 
 /*Global variables*/
 
@@ -125,21 +187,50 @@ const static vcCommand_strVal_t gMsgStrVal [] = {
   { CEC_MSG_PREFIX"/"CEC_MSG_COMMAND, (int)CEC_MSG_TYPE_COMMAND },
   { CEC_MSG_PREFIX"/"CEC_MSG_CONFIG, (int)CEC_MSG_TYPE_CONFIG },
   { CEC_MSG_PREFIX"/"CEC_MSG_EVENT, (int)CEC_MSG_TYPE_EVENT },
-  { CEC_MSG_PREFIX"/"CEC_MSG_STATE, (int)CEC_MSG_TYPE_STATE }
+  { CEC_MSG_PREFIX"/"CEC_MSG_STATE, (int)CEC_MSG_TYPE_STATE },
+  { CEC_MSG_PREFIX"/"CEC_MSG_BATCH, (int)CEC_MSG_TYPE_BATCH },
+  { CEC_MSG_PREFIX"/"CEC_MSG_TRAFFIC, (int)CEC_MSG_TYPE_TRAFFIC },
+  { CEC_MSG_PREFIX"/"CEC_MSG_KEYPRESS, (int)CEC_MSG_TYPE_KEYPRESS }
+};
+
+const static vcCommand_strVal_t gAckStatusStrVal [] = {
+  { "SUCCESS", (int)VC_HDMICEC_STATUS_SUCCESS },
+  { "REJECTED", (int)VC_HDMICEC_STATUS_MESSAGE_REJECTED },
+  { "QUEUE_FULL", (int)VC_HDMICEC_STATUS_QUEUE_FULL }
 };
 
 static void TeardownHal (vcHdmiCec_hal_t* hal);
-static void EnqueueMessage(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg);
+static bool EnqueueMessage(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg);
+static bool TryEnqueueMessage(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg);
 static void DequeueMessage(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t* out_msg);
 static void ProcessMsg( char *key, ut_kvp_instance_t *instance, void* user_data);
 static void* MessageHandler(void *data);
 static ut_kvp_instance_t* KVPInstanceOpen(char* msg, int size);
-static void ParseCommand(vcHdmiCec_hal_t *hal, char* cmd, int size, vcCommand_t *cec_cmd);
+static bool ParseCommand(vcHdmiCec_hal_t *hal, char* cmd, int size, vcCommand_t *cec_cmd, char *error);
+static bool BuildCommand(vcHdmiCec_hal_t *hal, ut_kvp_instance_t *kvpInstance, const char *prefix, vcCommand_t *cec_cmd, char *error);
+static bool ResolveAddresses(vcHdmiCec_hal_t *hal, ut_kvp_instance_t *kvpInstance, const char *prefix, struct vcDevice_info_t **src, vcCommand_logical_address_t *la, char *error);
+static bool HandleKeyPress(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg, uint64_t started_ns, bool *deferred, char *error);
+static bool HandleBatch(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg, uint64_t started_ns, bool *deferred, char *error);
+static bool HandleTraffic(vcHdmiCec_hal_t *hal, ut_kvp_instance_t *kvpInstance, char *error);
+static bool EmitTrafficFrame(void *ctx, const uint8_t *frame, uint32_t len, uint64_t generated_ns);
+static bool HandleStateMessages(vcHdmiCec_hal_t *hal, char* cmd, int size, char *error);
+static bool StartCapture(vcHdmiCec_hal_t *hal, const char *path, char *error);
+static void StopCapture(vcHdmiCec_hal_t *hal);
+static void CaptureFrame(vcHdmiCec_hal_t *hal, vcCapture_record_kind_t kind, const uint8_t *buf, uint32_t len, uint8_t result);
+static bool StartReplay(vcHdmiCec_hal_t *hal, const char *path, const char *speed, char *error);
+static bool EmitReplayFrame(void *ctx, const vcCapture_record_t *record);
+static void ReadRequestId(ut_kvp_instance_t *instance, vcHdmiCec_message_t *msg);
+static void SendAck(vcHdmiCec_message_t *msg, vcHdmiCec_Status_t status, const char *error, uint64_t started_ns);
 static void LoadPortsInfo (ut_kvp_instance_t* instance, vcHdmiCec_port_info_t* ports, unsigned int nPorts);
 static void ResetMessage(vcHdmiCec_message_t *msg);
 static void PrintStatus(vcHdmiCec_hal_t *cec);
 static void PrintDevicesInfo(vcHdmiCec_hal_t *cec);
 static void PrintPortsInfo(vcHdmiCec_hal_t *cec);
+static void PrintCallbackStats(vcHdmiCec_hal_t *cec);
+static void InvokeRxCallback(vcHdmiCec_hal_t *hal, uint8_t *buf, uint32_t len);
+static void InvokeTxCallback(vcHdmiCec_hal_t *hal, int handle, const unsigned char *buf, int len, int result);
+static bool LoadNetwork(vcHdmiCec_hal_t *cec, ut_kvp_instance_t *profile_instance);
+static void ResetNetwork(vcHdmiCec_hal_t *hal);
 
 static ut_kvp_instance_t* KVPInstanceOpen(char* msg, int size)
 {
@@ -165,42 +256,45 @@ static ut_kvp_instance_t* KVPInstanceOpen(char* msg, int size)
   return kvpInstance;
 }
 
-static void ParseCommand(vcHdmiCec_hal_t *hal, char* cmd, int size, vcCommand_t *cec_cmd)
+static bool ParseCommand(vcHdmiCec_hal_t *hal, char* cmd, int size, vcCommand_t *cec_cmd, char *error)
 {
-  char str[UT_KVP_MAX_ELEMENT_SIZE];
-  vcCommand_opcode_t opcode = CEC_OPCODE_UNKNOWN;
-  struct vcDevice_info_t *src, *dest;
-  vcCommand_logical_address_t la;
+  bool result;
   assert(cmd != NULL);
 
-  vcCommand_Clear(cec_cmd);
   ut_kvp_instance_t *kvpInstance = KVPInstanceOpen(cmd, size);
   assert(kvpInstance != NULL);
-  ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_COMMAND, str, UT_KVP_MAX_ELEMENT_SIZE);
-  opcode = vcCommand_GetOpCode(str);
-  if(opcode == CEC_OPCODE_UNKNOWN)
-  {
-    VC_LOG_ERROR("ParseCommand: Opcode[%s] Unknown", str);
-    return;
-  }
-  VC_LOG("ParseCommand: Opcode[%s]", str);
+  result = BuildCommand(hal, kvpInstance, CEC_MSG_PREFIX, cec_cmd, error);
+  ut_kvp_destroyInstance(kvpInstance);
+  return result;
+}
 
-  ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CEC_CMD_INITIATOR, str, UT_KVP_MAX_ELEMENT_SIZE);
-  src = vcDevice_Get(hal->devices_map, str);
-  if(src == NULL)
+/* Looks up the initiator and destination named under prefix */
+static bool ResolveAddresses(vcHdmiCec_hal_t *hal, ut_kvp_instance_t *kvpInstance, const char *prefix, struct vcDevice_info_t **src, vcCommand_logical_address_t *la, char *error)
+{
+  char str[UT_KVP_MAX_ELEMENT_SIZE];
+  char key[UT_KVP_MAX_ELEMENT_SIZE];
+  struct vcDevice_info_t *dest = NULL;
+
+  snprintf(key, sizeof(key), "%s/"CEC_CMD_INITIATOR, prefix);
+  ut_kvp_getStringField(kvpInstance, key, str, UT_KVP_MAX_ELEMENT_SIZE);
+  *src = vcDevice_Get(hal->devices_map, str);
+  if(*src == NULL)
   {
-    VC_LOG_ERROR("ParseCommand: Initiator[%s] Unknown", str);
-    return;
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Initiator[%s] Unknown", str);
+    VC_LOG_ERROR("ParseCommand: %s", error);
+    return false;
   }
   VC_LOG("ParseCommand: Initiator[%s] ", str);
-  ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CEC_CMD_DESTINATION, str, UT_KVP_MAX_ELEMENT_SIZE);
+  snprintf(key, sizeof(key), "%s/"CEC_CMD_DESTINATION, prefix);
+  ut_kvp_getStringField(kvpInstance, key, str, UT_KVP_MAX_ELEMENT_SIZE);
   if(strcmp(str, CEC_BROADCAST) != 0)
   {
     dest = vcDevice_Get(hal->devices_map, str);
     if(dest == NULL)
     {
-      VC_LOG_ERROR("ParseCommand: Destination[%s] Unknown", str);
-      return;
+      snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Destination[%s] Unknown", str);
+      VC_LOG_ERROR("ParseCommand: %s", error);
+      return false;
     }
   }
 
@@ -208,11 +302,39 @@ static void ParseCommand(vcHdmiCec_hal_t *hal, char* cmd, int size, vcCommand_t
 
   if(dest == NULL)
   {
-    la = LOGICAL_ADDRESS_BROADCAST;
+    *la = LOGICAL_ADDRESS_BROADCAST;
   }
   else 
   {
-    la = dest->logical_address;
+    *la = dest->logical_address;
+  }
+  return true;
+}
+
+/* Builds the CEC frame of the command described by the fields under prefix, e.g. "hdmicec" or "hdmicec/batch/0" */
+static bool BuildCommand(vcHdmiCec_hal_t *hal, ut_kvp_instance_t *kvpInstance, const char *prefix, vcCommand_t *cec_cmd, char *error)
+{
+  char str[UT_KVP_MAX_ELEMENT_SIZE];
+  char key[UT_KVP_MAX_ELEMENT_SIZE];
+  vcCommand_opcode_t opcode = CEC_OPCODE_UNKNOWN;
+  struct vcDevice_info_t *src;
+  vcCommand_logical_address_t la;
+
+  vcCommand_Clear(cec_cmd);
+  snprintf(key, sizeof(key), "%s/"CEC_MSG_COMMAND, prefix);
+  ut_kvp_getStringField(kvpInstance, key, str, UT_KVP_MAX_ELEMENT_SIZE);
+  opcode = vcCommand_GetOpCode(str);
+  if(opcode == CEC_OPCODE_UNKNOWN)
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Opcode[%s] Unknown", str);
+    VC_LOG_ERROR("ParseCommand: %s", error);
+    return false;
+  }
+  VC_LOG("ParseCommand: Opcode[%s]", str);
+
+  if(!ResolveAddresses(hal, kvpInstance, prefix, &src, &la, error))
+  {
+    return false;
   }
   vcCommand_Format(cec_cmd, src->logical_address, la, opcode);
 
@@ -230,25 +352,379 @@ static void ParseCommand(vcHdmiCec_hal_t *hal, char* cmd, int size, vcCommand_t
 
     case CEC_SET_OSD_NAME:
     {
-      ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CMD_DATA_OSD_NAME, str, UT_KVP_MAX_ELEMENT_SIZE);
+      snprintf(key, sizeof(key), "%s/"CMD_DATA_OSD_NAME, prefix);
+      ut_kvp_getStringField(kvpInstance, key, str, UT_KVP_MAX_ELEMENT_SIZE);
       vcCommand_PushBackArray(cec_cmd, (uint8_t *)str, strlen(str));
     }
     break;
 
+    case CEC_USER_CONTROL_PRESSED:
+    {
+      vcCommand_ui_command_t ui;
+      snprintf(key, sizeof(key), "%s/"CEC_CMD_PARAMETERS"/"CMD_DATA_UI_COMMAND, prefix);
+      str[0] = '\0';
+      ut_kvp_getStringField(kvpInstance, key, str, UT_KVP_MAX_ELEMENT_SIZE);
+      ui = vcCommand_GetUiCommand(str);
+      if(ui == CEC_UI_COMMAND_UNKNOWN)
+      {
+        snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "UI command[%s] Unknown", str);
+        VC_LOG_ERROR("ParseCommand: %s", error);
+        return false;
+      }
+      vcCommand_PushBackByte(cec_cmd, (uint8_t)ui);
+    }
+    break;
+
     default:
     {
     }
     break;
   }
+  return true;
+}
+
+/* Scheduled frames are never dropped: while the message queue is full the scheduler offers the frame again */
+static bool ScheduledEnqueue(void *data)
+{
+  vcHdmiCec_scheduled_t *scheduled = (vcHdmiCec_scheduled_t *)data;
+
+  if(!TryEnqueueMessage(scheduled->hal, &scheduled->msg))
+  {
+    return false;
+  }
+  free(scheduled);
+  return true;
+}
+
+static void ScheduledFree(vcHdmiCec_scheduled_t *scheduled)
+{
+  free(scheduled->msg.message);
+  free(scheduled);
+}
+
+/* Called for the frames discarded by a reset or by HdmiCecClose */
+static void ScheduledRelease(void *data)
+{
+  vcHdmiCec_scheduled_t *scheduled = (vcHdmiCec_scheduled_t *)data;
+
+  SendAck(&scheduled->msg, VC_HDMICEC_STATUS_MESSAGE_REJECTED, "Discarded before delivery", scheduled->msg.received_ns);
+  ScheduledFree(scheduled);
+}
+
+/* Hands count frames to the scheduler, all of them or none. The last frame carries the request_id of ack_msg,
+ * if set, and the message is acknowledged once it is delivered */
+static bool ScheduleFrames(vcHdmiCec_hal_t *hal, uint32_t count, const uint8_t **frames, const uint32_t *lens,
+                           const uint64_t *deadlines_ns, vcHdmiCec_message_t *ack_msg, uint64_t started_ns)
+{
+  vcHdmiCec_scheduled_t **scheduled;
+  uint32_t i;
+
+  scheduled = (vcHdmiCec_scheduled_t **)malloc(sizeof(vcHdmiCec_scheduled_t *) * count);
+  assert(scheduled != NULL);
+  for(i = 0; i < count; i++)
+  {
+    scheduled[i] = (vcHdmiCec_scheduled_t *)calloc(1, sizeof(vcHdmiCec_scheduled_t));
+    assert(scheduled[i] != NULL);
+    scheduled[i]->hal = hal;
+    scheduled[i]->msg.type = CEC_MSG_TYPE_FRAME;
+    scheduled[i]->msg.size = lens[i];
+    scheduled[i]->msg.message = malloc(lens[i]);
+    assert(scheduled[i]->msg.message != NULL);
+    memcpy(scheduled[i]->msg.message, frames[i], lens[i]);
+  }
+  if(ack_msg != NULL)
+  {
+    memcpy(scheduled[count - 1]->msg.request_id, ack_msg->request_id, sizeof(scheduled[count - 1]->msg.request_id));
+    scheduled[count - 1]->msg.received_ns = started_ns;
+  }
+  if(!vcScheduler_AddGroup(hal->scheduler, count, deadlines_ns, ScheduledEnqueue, ScheduledRelease, (void **)scheduled))
+  {
+    //The caller rejects the message, so nothing is acknowledged here
+    for(i = 0; i < count; i++)
+    {
+      ScheduledFree(scheduled[i]);
+    }
+    free(scheduled);
+    return false;
+  }
+  free(scheduled);
+  return true;
+}
+
+/* Schedules a remote control key press: UserControlPressed at the start and then every repeat_ms while
+ * the key is held, and UserControlReleased after hold_ms. The press is acknowledged once the release is delivered. */
+static bool HandleKeyPress(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg, uint64_t started_ns, bool *deferred, char *error)
+{
+  char str[UT_KVP_MAX_ELEMENT_SIZE];
+  struct vcDevice_info_t *src;
+  vcCommand_logical_address_t la;
+  vcCommand_ui_command_t ui;
+  uint32_t hold_ms, repeat_ms, presses, i;
+  uint8_t pressed[3], released[2];
+  const uint8_t **frames;
+  uint32_t *lens;
+  uint64_t *deadlines_ns;
+  bool scheduled;
+
+  *deferred = false;
+  ut_kvp_instance_t *kvpInstance = KVPInstanceOpen(msg->message, msg->size);
+  assert(kvpInstance != NULL);
+  if(!ResolveAddresses(hal, kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_KEYPRESS, &src, &la, error))
+  {
+    ut_kvp_destroyInstance(kvpInstance);
+    return false;
+  }
+  str[0] = '\0';
+  ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_KEYPRESS"/"CMD_DATA_UI_COMMAND, str, UT_KVP_MAX_ELEMENT_SIZE);
+  ui = vcCommand_GetUiCommand(str);
+  hold_ms = ut_kvp_getUInt32Field(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_KEYPRESS"/hold_ms");
+  repeat_ms = ut_kvp_getUInt32Field(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_KEYPRESS"/repeat_ms");
+  ut_kvp_destroyInstance(kvpInstance);
+  if(ui == CEC_UI_COMMAND_UNKNOWN)
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "UI command[%s] Unknown", str);
+    VC_LOG_ERROR("HandleKeyPress: %s", error);
+    return false;
+  }
+
+  //The first press plus one repeat for every full repeat_ms strictly inside the hold
+  presses = 1;
+  if(repeat_ms != 0 && hold_ms != 0)
+  {
+    presses += (hold_ms - 1) / repeat_ms;
+  }
+  if(presses + 1 > MAX_KEYPRESS_FRAMES)
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "%u frames for hold_ms %u and repeat_ms %u, at most %u", presses + 1, hold_ms, repeat_ms, MAX_KEYPRESS_FRAMES);
+    VC_LOG_ERROR("HandleKeyPress: %s", error);
+    return false;
+  }
+
+  pressed[0] = (uint8_t)((src->logical_address << 4) | (la & 0x0F));
+  pressed[1] = CEC_USER_CONTROL_PRESSED;
+  pressed[2] = (uint8_t)ui;
+  released[0] = pressed[0];
+  released[1] = CEC_USER_CONTROL_RELEASED;
+
+  //The presses and the release are scheduled together, so a key is never left pressed
+  frames = (const uint8_t **)malloc(sizeof(uint8_t *) * (presses + 1));
+  lens = (uint32_t *)malloc(sizeof(uint32_t) * (presses + 1));
+  deadlines_ns = (uint64_t *)malloc(sizeof(uint64_t) * (presses + 1));
+  assert(frames != NULL && lens != NULL && deadlines_ns != NULL);
+  for(i = 0; i < presses; i++)
+  {
+    frames[i] = pressed;
+    lens[i] = sizeof(pressed);
+    deadlines_ns[i] = started_ns + (uint64_t)i * repeat_ms * 1000000ULL;
+  }
+  frames[presses] = released;
+  lens[presses] = sizeof(released);
+  deadlines_ns[presses] = started_ns + (uint64_t)hold_ms * 1000000ULL;
+  scheduled = ScheduleFrames(hal, presses + 1, frames, lens, deadlines_ns, msg, started_ns);
+  free(frames);
+  free(lens);
+  free(deadlines_ns);
+  if(!scheduled)
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Failed to schedule, no frame delivered");
+    VC_LOG_ERROR("HandleKeyPress: %s", error);
+    return false;
+  }
+  *deferred = true;
+  VC_LOG("HandleKeyPress: UI command[0x%02X] hold[%u ms] repeat[%u ms] presses[%u]", ui, hold_ms, repeat_ms, presses);
+  return true;
+}
+
+/* Decodes every item of a batch before delivering any, so a batch with a bad item is rejected as a whole.
+ * Items due now are delivered straight away, later ones are handed to the scheduler as raw frames. They are
+ * all scheduled before the first item is delivered, so a batch that cannot be scheduled delivers nothing.
+ * If the last item is scheduled it carries the request_id, and the batch is acknowledged once it is delivered. */
+static bool HandleBatch(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg, uint64_t started_ns, bool *deferred, char *error)
+{
+  vcHdmiCec_batch_item_t *items;
+  char prefix[UT_KVP_MAX_ELEMENT_SIZE];
+  char key[UT_KVP_MAX_ELEMENT_SIZE];
+  char itemError[VC_HDMICEC_MAX_ERROR_LENGTH];
+  uint64_t deadline_ns = started_ns;
+  uint32_t count, due, i;
+  const uint8_t *frames[MAX_BATCH_SIZE];
+  uint32_t lens[MAX_BATCH_SIZE];
+  uint64_t deadlines_ns[MAX_BATCH_SIZE];
+  uint64_t now;
+  vcCommand_t cmd;
+
+  *deferred = false;
+  ut_kvp_instance_t *kvpInstance = KVPInstanceOpen(msg->message, msg->size);
+  assert(kvpInstance != NULL);
+  count = ut_kvp_getListCount(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_BATCH);
+  if(count == 0 || count > MAX_BATCH_SIZE)
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Batch of %u items, expected 1 to %u", count, MAX_BATCH_SIZE);
+    VC_LOG_ERROR("HandleBatch: %s", error);
+    ut_kvp_destroyInstance(kvpInstance);
+    return false;
+  }
+  items = (vcHdmiCec_batch_item_t *)malloc(sizeof(vcHdmiCec_batch_item_t) * count);
+  assert(items != NULL);
+
+  for(i = 0; i < count; i++)
+  {
+    snprintf(prefix, sizeof(prefix), CEC_MSG_PREFIX"/"CEC_MSG_BATCH"/%u", i);
+    if(!BuildCommand(hal, kvpInstance, prefix, &cmd, itemError))
+    {
+      snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Item[%u]: %s", i, itemError);
+      free(items);
+      ut_kvp_destroyInstance(kvpInstance);
+      return false;
+    }
+    //Delays are relative to the previous item, the first one to the start of the batch
+    snprintf(key, sizeof(key), "%s/"CEC_CMD_DELAY_MS, prefix);
+    if(ut_kvp_fieldPresent(kvpInstance, key))
+    {
+      deadline_ns += (uint64_t)ut_kvp_getUInt32Field(kvpInstance, key) * 1000000ULL;
+    }
+    items[i].len = vcCommand_GetRawBytes(&cmd, items[i].data, VCCOMMAND_MAX_DATA_SIZE);
+    items[i].deadline_ns = deadline_ns;
+  }
   ut_kvp_destroyInstance(kvpInstance);
+
+  //Once an item is scheduled the ones after it must follow it through the scheduler to keep the order
+  now = vcStats_NowNs();
+  for(due = 0; due < count && items[due].deadline_ns <= now; due++);
+  for(i = due; i < count; i++)
+  {
+    frames[i - due] = items[i].data;
+    lens[i - due] = items[i].len;
+    deadlines_ns[i - due] = items[i].deadline_ns;
+  }
+  if(due < count && !ScheduleFrames(hal, count - due, frames, lens, deadlines_ns, msg, started_ns))
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Failed to schedule, no item delivered");
+    VC_LOG_ERROR("HandleBatch: %s", error);
+    free(items);
+    return false;
+  }
+  *deferred = (due < count);
+  for(i = 0; i < due; i++)
+  {
+    InvokeRxCallback(hal, items[i].data, items[i].len);
+  }
+  VC_LOG("HandleBatch: %u items", count);
+  free(items);
+  return true;
+}
+
+
+/* Starts or stops the traffic generator from the "hdmicec/traffic" section of a control plane message or of the profile */
+static bool HandleTraffic(vcHdmiCec_hal_t *hal, ut_kvp_instance_t *kvpInstance, char *error)
+{
+  vcTraffic_config_t *config;
+  char prefix[UT_KVP_MAX_ELEMENT_SIZE];
+  char key[UT_KVP_MAX_ELEMENT_SIZE];
+  char str[UT_KVP_MAX_ELEMENT_SIZE];
+  char streamError[VC_HDMICEC_MAX_ERROR_LENGTH];
+  vcCommand_t cmd;
+  bool result;
+
+  if(ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_TRAFFIC"/action", str, UT_KVP_MAX_ELEMENT_SIZE) == UT_KVP_STATUS_SUCCESS &&
+     !strcmp(str, "stop"))
+  {
+    vcTraffic_Stop(hal->traffic);
+    return true;
+  }
+
+  config = (vcTraffic_config_t *)calloc(1, sizeof(vcTraffic_config_t));
+  assert(config != NULL);
+  config->num_streams = ut_kvp_getListCount(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_TRAFFIC"/streams");
+  if(config->num_streams == 0 || config->num_streams > VCTRAFFIC_MAX_STREAMS)
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "%u traffic streams, expected 1 to %u", config->num_streams, VCTRAFFIC_MAX_STREAMS);
+    VC_LOG_ERROR("HandleTraffic: %s", error);
+    free(config);
+    return false;
+  }
+
+  for(uint32_t i = 0; i < config->num_streams; i++)
+  {
+    vcTraffic_stream_t *stream = &config->streams[i];
+
+    snprintf(prefix, sizeof(prefix), CEC_MSG_PREFIX"/"CEC_MSG_TRAFFIC"/streams/%u", i);
+    if(!BuildCommand(hal, kvpInstance, prefix, &cmd, streamError))
+    {
+      snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Stream[%u]: %s", i, streamError);
+      free(config);
+      return false;
+    }
+    stream->len = vcCommand_GetRawBytes(&cmd, stream->frame, VCCOMMAND_MAX_DATA_SIZE);
+
+    snprintf(key, sizeof(key), "%s/rate", prefix);
+    stream->rate = ut_kvp_getUInt32Field(kvpInstance, key);
+    snprintf(key, sizeof(key), "%s/burst", prefix);
+    stream->burst = ut_kvp_fieldPresent(kvpInstance, key) ? ut_kvp_getUInt32Field(kvpInstance, key) : 1;
+    snprintf(key, sizeof(key), "%s/arrival", prefix);
+    stream->arrival = VCTRAFFIC_ARRIVAL_CONSTANT;
+    if(ut_kvp_getStringField(kvpInstance, key, str, UT_KVP_MAX_ELEMENT_SIZE) == UT_KVP_STATUS_SUCCESS && !strcmp(str, "poisson"))
+    {
+      stream->arrival = VCTRAFFIC_ARRIVAL_POISSON;
+    }
+    if(stream->rate == 0 || stream->burst == 0)
+    {
+      snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Stream[%u]: rate and burst must be at least 1", i);
+      VC_LOG_ERROR("HandleTraffic: %s", error);
+      free(config);
+      return false;
+    }
+    if(stream->rate > VCTRAFFIC_MAX_RATE)
+    {
+      snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Stream[%u]: rate %u above %u frames/s, use burst for more", i, stream->rate, VCTRAFFIC_MAX_RATE);
+      VC_LOG_ERROR("HandleTraffic: %s", error);
+      free(config);
+      return false;
+    }
+  }
+  config->duration_ns = (uint64_t)ut_kvp_getUInt32Field(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_TRAFFIC"/duration_ms") * 1000000ULL;
+  config->count = ut_kvp_getUInt32Field(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_TRAFFIC"/count");
+  config->seed = ut_kvp_getUInt32Field(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_TRAFFIC"/seed");
+  if(config->duration_ns == 0 && config->count == 0)
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Traffic needs a duration_ms or a count");
+    VC_LOG_ERROR("HandleTraffic: %s", error);
+    free(config);
+    return false;
+  }
+
+  result = vcTraffic_Start(hal->traffic, config);
+  if(!result)
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Traffic generator failed to start");
+  }
+  free(config);
+  return result;
 }
 
+/* Runs on the scheduler thread. Generated frames take the same queue as the control plane messages */
+static bool EmitTrafficFrame(void *ctx, const uint8_t *frame, uint32_t len, uint64_t generated_ns)
+{
+  vcHdmiCec_message_t msg = {0};
+
+  msg.type = CEC_MSG_TYPE_TRAFFIC_FRAME;
+  msg.message = malloc(len);
+  if(msg.message == NULL)
+  {
+    return false;
+  }
+  memcpy(msg.message, frame, len);
+  msg.size = len;
+  msg.received_ns = generated_ns;
+  return EnqueueMessage((vcHdmiCec_hal_t *)ctx, &msg);
+}
 
-static void HandleStateMessages( vcHdmiCec_hal_t *hal, char* cmd, int size)
+static bool HandleStateMessages( vcHdmiCec_hal_t *hal, char* cmd, int size, char *error)
 {
   char str[UT_KVP_MAX_ELEMENT_SIZE];
   ut_kvp_instance_t *kvpInstance = KVPInstanceOpen(cmd, size);
   struct vcDevice_info_t *device = NULL, *parent = NULL;
+  bool result = true;
   assert(kvpInstance != NULL);
   ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_STATE, str, UT_KVP_MAX_ELEMENT_SIZE);
 
@@ -257,28 +733,31 @@ static void HandleStateMessages( vcHdmiCec_hal_t *hal, char* cmd, int size)
      device = vcDevice_CreateMapFromProfile(kvpInstance, "hdmicec/parameters");
      if(device == NULL)
      {
-        VC_LOG_ERROR("HandleStateMessages: AddDevice failed to create device");
+        snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "AddDevice failed to create device");
+        VC_LOG_ERROR("HandleStateMessages: %s", error);
         ut_kvp_destroyInstance(kvpInstance);
-        return;
+        return false;
      }
      ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CEC_CMD_PARAMETERS"/parent", str, UT_KVP_MAX_ELEMENT_SIZE);
      parent = vcDevice_Get(hal->devices_map, str);
      if(parent == NULL)
      {
-        VC_LOG_ERROR("HandleStateMessages: AddDevice failed to get parent");
+        snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "AddDevice failed to get parent[%s]", str);
+        VC_LOG_ERROR("HandleStateMessages: %s", error);
         vcDevice_DestroyMap(device);
         ut_kvp_destroyInstance(kvpInstance);
-        return;
+        return false;
      }
      //Check if the new device can be added to a free port
      if(parent == hal->emulated_device && parent->type == DEVICE_TYPE_TV)
      {
         if(parent->number_children >= hal->num_ports)
         {
-          VC_LOG_ERROR("HandleStateMessages: AddDevice: No free port to Add Device");
+          snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "AddDevice: No free port to Add Device");
+          VC_LOG_ERROR("HandleStateMessages: %s", error);
           vcDevice_DestroyMap(device);
           ut_kvp_destroyInstance(kvpInstance);
-          return;
+          return false;
         }
      }
      vcDevice_InsertChild(parent, device);
@@ -296,10 +775,7 @@ static void HandleStateMessages( vcHdmiCec_hal_t *hal, char* cmd, int size)
         vcCommand_PushBackArray(&cmd, buf, sizeof(buf));
         vcCommand_PushBackByte(&cmd, (uint8_t)device->type);
         len = vcCommand_GetRawBytes(&cmd, cec_data, VCCOMMAND_MAX_DATA_SIZE);
-        if(hal->callbacks.rx_cb_func != NULL)
-        {
-          hal->callbacks.rx_cb_func((intptr_t)hal, hal->callbacks.rx_cb_data, cec_data, len);
-        }
+        InvokeRxCallback(hal, cec_data, len);
       }
   }
   else if(!strcmp(str, CEC_MSG_STATE_REMOVE_DEVICE))
@@ -308,9 +784,10 @@ static void HandleStateMessages( vcHdmiCec_hal_t *hal, char* cmd, int size)
      device = vcDevice_Get(hal->devices_map, str);
      if(device == NULL)
      {
-        VC_LOG_ERROR("HandleStateMessages: RemoveDevice failed to get device");
+        snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "RemoveDevice failed to get device[%s]", str);
+        VC_LOG_ERROR("HandleStateMessages: %s", error);
         ut_kvp_destroyInstance(kvpInstance);
-        return;
+        return false;
      }
      vcDevice_RemoveChild(hal->devices_map, str);
   }
@@ -325,20 +802,188 @@ static void HandleStateMessages( vcHdmiCec_hal_t *hal, char* cmd, int size)
     {
       PrintPortsInfo(hal);
     }
+    else if(!strcmp(str, "Callbacks"))
+    {
+      PrintCallbackStats(hal);
+    }
+    else if(!strcmp(str, "Traffic"))
+    {
+      vcTraffic_Print(hal->traffic);
+    }
     else
     {
       PrintStatus(hal);
     }
   }
+  else if(!strcmp(str, CEC_MSG_STATE_START_CAPTURE))
+  {
+    ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CEC_CMD_PARAMETERS"/path", str, UT_KVP_MAX_ELEMENT_SIZE);
+    result = StartCapture(hal, str, error);
+  }
+  else if(!strcmp(str, CEC_MSG_STATE_STOP_CAPTURE))
+  {
+    StopCapture(hal);
+  }
+  else if(!strcmp(str, CEC_MSG_STATE_REPLAY))
+  {
+    char speed[UT_KVP_MAX_ELEMENT_SIZE];
+    if(ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CEC_CMD_PARAMETERS"/speed", speed, UT_KVP_MAX_ELEMENT_SIZE) != UT_KVP_STATUS_SUCCESS)
+    {
+      strcpy(speed, "original");
+    }
+    ut_kvp_getStringField(kvpInstance, CEC_MSG_PREFIX"/"CEC_CMD_PARAMETERS"/path", str, UT_KVP_MAX_ELEMENT_SIZE);
+    result = StartReplay(hal, str, speed, error);
+  }
+  else
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Unknown State Message[%s]", str);
+    VC_LOG_ERROR("%s", error);
+    result = false;
+  }
+  ut_kvp_destroyInstance(kvpInstance);
+  return result;
+}
+
+/* Replaces the current capture, if any, with a new file */
+static bool StartCapture(vcHdmiCec_hal_t *hal, const char *path, char *error)
+{
+  vcCapture_writer_t *capture;
+
+  if(path[0] == '\0')
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "StartCapture: No path");
+    VC_LOG_ERROR("%s", error);
+    return false;
+  }
+  capture = vcCapture_Open(path);
+  if(capture == NULL)
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "StartCapture: Failed to create [%s]", path);
+    return false;
+  }
+  StopCapture(hal);
+  pthread_mutex_lock(&hal->capture_mutex);
+  hal->capture = capture;
+  pthread_mutex_unlock(&hal->capture_mutex);
+  return true;
+}
+
+static void StopCapture(vcHdmiCec_hal_t *hal)
+{
+  vcCapture_writer_t *capture;
+
+  pthread_mutex_lock(&hal->capture_mutex);
+  capture = hal->capture;
+  hal->capture = NULL;
+  pthread_mutex_unlock(&hal->capture_mutex);
+  vcCapture_Close(capture);
+}
+
+/* Called for every frame on the emulated bus, from the message handler for Rx and from the caller of the HAL for Tx */
+static void CaptureFrame(vcHdmiCec_hal_t *hal, vcCapture_record_kind_t kind, const uint8_t *buf, uint32_t len, uint8_t result)
+{
+  struct vcDevice_info_t *source;
+  uint64_t timestamp_ns = vcStats_NowNs();
+
+  pthread_mutex_lock(&hal->capture_mutex);
+  if(hal->capture != NULL)
+  {
+    source = vcDevice_GetByLogicalAddress(hal->devices_map, buf[0] >> 4);
+    vcCapture_Write(hal->capture, kind, timestamp_ns, buf, len, result, (source != NULL) ? source->osd_name : NULL);
+  }
+  pthread_mutex_unlock(&hal->capture_mutex);
+}
+
+/* speed is "original", "max" or a factor such as "0.5" or "10" */
+static bool StartReplay(vcHdmiCec_hal_t *hal, const char *path, const char *speed, char *error)
+{
+  double factor;
+  char *end;
+
+  if(!strcmp(speed, "original"))
+  {
+    factor = 1.0;
+  }
+  else if(!strcmp(speed, "max"))
+  {
+    factor = 0;
+  }
   else
   {
-    VC_LOG_ERROR("Unknown State Message: %s", str);
+    factor = strtod(speed, &end);
+    if(end == speed || *end != '\0' || factor <= 0)
+    {
+      snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Replay: Invalid speed[%s]", speed);
+      VC_LOG_ERROR("%s", error);
+      return false;
+    }
+  }
+  vcCapture_StopReplay(hal->replay);
+  hal->replay = vcCapture_StartReplay(path, factor, EmitReplayFrame, hal);
+  if(hal->replay == NULL)
+  {
+    snprintf(error, VC_HDMICEC_MAX_ERROR_LENGTH, "Replay: Failed to read capture [%s]", path);
+    return false;
+  }
+  return true;
+}
+
+/* Runs on the replay thread. Returning false makes the replay offer the frame again once the queue drains */
+static bool EmitReplayFrame(void *ctx, const vcCapture_record_t *record)
+{
+  vcHdmiCec_hal_t *hal = (vcHdmiCec_hal_t *)ctx;
+  vcHdmiCec_message_t msg = {0};
+
+  msg.message = (char *)malloc(record->len);
+  if(msg.message == NULL)
+  {
+    return false;
+  }
+  memcpy(msg.message, record->frame, record->len);
+  msg.size = record->len;
+  msg.type = CEC_MSG_TYPE_FRAME;
+  msg.received_ns = vcStats_NowNs();
+  return EnqueueMessage(hal, &msg);
+}
+
+static void ReadRequestId(ut_kvp_instance_t *instance, vcHdmiCec_message_t *msg)
+{
+  msg->received_ns = vcStats_NowNs();
+  if(ut_kvp_getStringField(instance, CEC_MSG_PREFIX"/"CEC_MSG_REQUEST_ID, msg->request_id, VC_HDMICEC_MAX_REQUEST_ID_LENGTH) != UT_KVP_STATUS_SUCCESS)
+  {
+    msg->request_id[0] = '\0';
+  }
+}
+
+/* Acknowledges a message that carried a request_id. started_ns is when the message handler picked it up */
+static void SendAck(vcHdmiCec_message_t *msg, vcHdmiCec_Status_t status, const char *error, uint64_t started_ns)
+{
+  vcHdmiCec_Ack_t ack;
+  uint64_t completed_ns;
+  vcHdmiCec_internal_t *vc = gvcHdmiCec;
+
+  if(msg->request_id[0] == '\0')
+  {
+    return;
+  }
+  completed_ns = vcStats_NowNs();
+  ack.pRequestId = msg->request_id;
+  ack.status = status;
+  ack.pError = (error != NULL) ? error : "";
+  ack.queuedUs = (started_ns - msg->received_ns) / 1000;
+  ack.processedUs = (completed_ns - started_ns) / 1000;
+  VC_TRACE2(ack, status, completed_ns - started_ns);
+  VC_LOG("Ack: request_id[%s] status[%s] queued[%llu us] processed[%llu us] error[%s]", ack.pRequestId,
+         vcCommand_GetString(gAckStatusStrVal, COUNT_OF(gAckStatusStrVal), status), ack.queuedUs, ack.processedUs, ack.pError);
+  if(vc != NULL && vc->ack_cb_func != NULL)
+  {
+    vc->ack_cb_func(&ack, vc->ack_cb_data);
   }
 }
 
 static void ProcessMsg( char *key, ut_kvp_instance_t *instance, void* user_data)
 {
-  vcHdmiCec_message_t msg;
+  vcHdmiCec_message_t msg = {0};
   char *message;
   vcHdmiCec_internal_t *vc = (vcHdmiCec_internal_t*) user_data;
   assert(vc != NULL);
@@ -354,6 +999,7 @@ static void ProcessMsg( char *key, ut_kvp_instance_t *instance, void* user_data)
     VC_LOG_ERROR("ProcessMsg: Unknown Message Type [%s]", key);
     return;
   }
+  VC_TRACE1(process_msg, msg.type);
   if(msg.type != CEC_MSG_TYPE_EXIT_REQUESTED)
   {
     message = ut_kvp_getData(instance);
@@ -361,22 +1007,91 @@ static void ProcessMsg( char *key, ut_kvp_instance_t *instance, void* user_data)
     //ut_kvp_openMemory expects msg to be malloc'ed.
     //The ownership of the string is transferred to ut_kvp_openMemory. Do not free the string
     msg.size = strlen(msg.message);
+    ReadRequestId(instance, &msg);
   }
   EnqueueMessage(vc->cec_hal, &msg);
 }
 
-static void EnqueueMessage(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg)
+/* Frames fill MAX_QUEUE_SIZE slots at most, the CONTROL_QUEUE_SLOTS after them are kept for
+ * control messages so that a saturating traffic run cannot lock the control plane out */
+static uint32_t QueueLimit(vcHdmiCec_msg_type_t type)
+{
+  switch(type)
+  {
+    case CEC_MSG_TYPE_FRAME:
+    case CEC_MSG_TYPE_TRAFFIC_FRAME:
+    case CEC_MSG_TYPE_TX_COMPLETE:
+      return MAX_QUEUE_SIZE;
+    default:
+      return MAX_QUEUE_SIZE + CONTROL_QUEUE_SLOTS;
+  }
+}
+
+/* Queues a message if there is room. The caller keeps the message if it was not queued */
+static bool TryEnqueueMessage(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg)
+{
+    bool queued = false;
+
+    pthread_mutex_lock(&hal->msg_queue_mutex);
+    if (hal->msg_count < QueueLimit(msg->type))
+    {
+      hal->msg_queue[hal->msg_count] = *msg;
+      hal->msg_count++;
+      queued = true;
+      VC_TRACE2(enqueue, msg->type, hal->msg_count);
+      pthread_cond_signal(&hal->msg_queue_condition);
+    }
+    else
+    {
+      VC_TRACE2(enqueue_drop, msg->type, hal->msg_count);
+    }
+    pthread_mutex_unlock(&hal->msg_queue_mutex);
+    return queued;
+}
+
+/* Exit and reset requests are never dropped, the sender waits for the message handler to make room.
+ * Returns false only when the message handler has already exited. */
+static bool WaitEnqueueMessage(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg)
 {
+    bool queued = false;
+
     pthread_mutex_lock(&hal->msg_queue_mutex);
-    if (hal->msg_count < MAX_QUEUE_SIZE)
+    while (hal->msg_count >= QueueLimit(msg->type) && !hal->exit_request)
+    {
+      pthread_cond_wait(&hal->msg_space_condition, &hal->msg_queue_mutex);
+    }
+    if (!hal->exit_request)
     {
-      hal->msg_queue[hal->msg_count].size = msg->size;
-      hal->msg_queue[hal->msg_count].type = msg->type;
-      hal->msg_queue[hal->msg_count].message = msg->message;
+      hal->msg_queue[hal->msg_count] = *msg;
       hal->msg_count++;
+      queued = true;
+      VC_TRACE2(enqueue, msg->type, hal->msg_count);
       pthread_cond_signal(&hal->msg_queue_condition);
     }
     pthread_mutex_unlock(&hal->msg_queue_mutex);
+    return queued;
+}
+
+static bool EnqueueMessage(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t *msg)
+{
+    bool queued;
+
+    if(msg->type == CEC_MSG_TYPE_EXIT_REQUESTED || msg->type == CEC_MSG_TYPE_RESET)
+    {
+      queued = WaitEnqueueMessage(hal, msg);
+    }
+    else
+    {
+      queued = TryEnqueueMessage(hal, msg);
+    }
+    if(!queued)
+    {
+      //Tell the sender now, the message handler will never see this one
+      SendAck(msg, VC_HDMICEC_STATUS_QUEUE_FULL, "Message queue full", msg->received_ns);
+      free(msg->message);
+      msg->message = NULL;
+    }
+    return queued;
 }
 
 static void DequeueMessage(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t* out_msg)
@@ -396,6 +1111,8 @@ static void DequeueMessage(vcHdmiCec_hal_t *hal, vcHdmiCec_message_t* out_msg)
         hal->msg_queue[i] = hal->msg_queue[i + 1];
     }
     hal->msg_count--;
+    VC_TRACE2(dequeue, out_msg->type, hal->msg_count);
+    pthread_cond_broadcast(&hal->msg_space_condition);
     pthread_mutex_unlock(&hal->msg_queue_mutex);
 }
 
@@ -407,6 +1124,7 @@ static void ResetMessage(vcHdmiCec_message_t *msg)
   msg->message = NULL;
   msg->size = 0;
   msg->type = CEC_MSG_TYPE_NONE;
+  msg->request_id[0] = '\0';
 }
 
 static void* MessageHandler(void *data)
@@ -427,7 +1145,11 @@ static void* MessageHandler(void *data)
       case CEC_MSG_TYPE_EXIT_REQUESTED:
       {
         VC_LOG("EXIT REQUESTED in MessageHandler\n");
+        pthread_mutex_lock(&hal->msg_queue_mutex);
         hal->exit_request = true;
+        //Nothing is handled after this, release the senders still waiting for room
+        pthread_cond_broadcast(&hal->msg_space_condition);
+        pthread_mutex_unlock(&hal->msg_queue_mutex);
       }
       break;
 
@@ -436,12 +1158,91 @@ static void* MessageHandler(void *data)
         vcCommand_t cmd;
         uint32_t len;
         uint8_t cec_data[VCCOMMAND_MAX_DATA_SIZE];
-        ParseCommand(hal, msg.message, msg.size, &cmd);
-        len = vcCommand_GetRawBytes(&cmd, cec_data, VCCOMMAND_MAX_DATA_SIZE);
-        if(hal->callbacks.rx_cb_func != NULL)
+        char error[VC_HDMICEC_MAX_ERROR_LENGTH] = "";
+        uint64_t started_ns = vcStats_NowNs();
+        bool parsed = ParseCommand(hal, msg.message, msg.size, &cmd, error);
+        if(parsed)
         {
-          hal->callbacks.rx_cb_func((intptr_t)hal, hal->callbacks.rx_cb_data, cec_data, len);
+          len = vcCommand_GetRawBytes(&cmd, cec_data, VCCOMMAND_MAX_DATA_SIZE);
+          InvokeRxCallback(hal, cec_data, len);
         }
+        SendAck(&msg, parsed ? VC_HDMICEC_STATUS_SUCCESS : VC_HDMICEC_STATUS_MESSAGE_REJECTED, error, started_ns);
+      }
+      break;
+
+      case CEC_MSG_TYPE_FRAME:
+      {
+        //Raw frames are not handed to ut_kvp, so the message handler owns them
+        uint64_t started_ns = vcStats_NowNs();
+        InvokeRxCallback(hal, (uint8_t *)msg.message, msg.size);
+        free(msg.message);
+        //Only the last frame of a scheduled batch carries a request_id
+        SendAck(&msg, VC_HDMICEC_STATUS_SUCCESS, NULL, started_ns);
+      }
+      break;
+
+      case CEC_MSG_TYPE_TRAFFIC_FRAME:
+      {
+        InvokeRxCallback(hal, (uint8_t *)msg.message, msg.size);
+        vcTraffic_RecordDelivery(hal->traffic, (uint8_t *)msg.message, msg.size, msg.received_ns, vcStats_NowNs());
+        free(msg.message);
+      }
+      break;
+
+      case CEC_MSG_TYPE_TRAFFIC:
+      {
+        char error[VC_HDMICEC_MAX_ERROR_LENGTH] = "";
+        uint64_t started_ns = vcStats_NowNs();
+        //A message without a body starts the traffic described in the profile
+        ut_kvp_instance_t *kvpInstance = (msg.message != NULL) ? KVPInstanceOpen(msg.message, msg.size) : gvcHdmiCec->profile_instance;
+        bool handled;
+        assert(kvpInstance != NULL);
+        handled = HandleTraffic(hal, kvpInstance, error);
+        if(msg.message != NULL)
+        {
+          ut_kvp_destroyInstance(kvpInstance);
+        }
+        SendAck(&msg, handled ? VC_HDMICEC_STATUS_SUCCESS : VC_HDMICEC_STATUS_MESSAGE_REJECTED, error, started_ns);
+      }
+      break;
+
+      case CEC_MSG_TYPE_KEYPRESS:
+      {
+        char error[VC_HDMICEC_MAX_ERROR_LENGTH] = "";
+        uint64_t started_ns = vcStats_NowNs();
+        bool deferred;
+        bool handled = HandleKeyPress(hal, &msg, started_ns, &deferred, error);
+        if(!deferred)
+        {
+          SendAck(&msg, handled ? VC_HDMICEC_STATUS_SUCCESS : VC_HDMICEC_STATUS_MESSAGE_REJECTED, error, started_ns);
+        }
+      }
+      break;
+
+      case CEC_MSG_TYPE_BATCH:
+      {
+        char error[VC_HDMICEC_MAX_ERROR_LENGTH] = "";
+        uint64_t started_ns = vcStats_NowNs();
+        bool deferred;
+        bool handled = HandleBatch(hal, &msg, started_ns, &deferred, error);
+        if(!deferred)
+        {
+          SendAck(&msg, handled ? VC_HDMICEC_STATUS_SUCCESS : VC_HDMICEC_STATUS_MESSAGE_REJECTED, error, started_ns);
+        }
+      }
+      break;
+
+      case CEC_MSG_TYPE_TX_COMPLETE:
+      {
+        vcHdmiCec_tx_complete_t *tx = (vcHdmiCec_tx_complete_t *)msg.message;
+        InvokeTxCallback(hal, tx->handle, tx->data, tx->len, tx->result);
+        free(msg.message);
+      }
+      break;
+
+      case CEC_MSG_TYPE_RESET:
+      {
+        ResetNetwork(hal);
       }
       break;
 
@@ -459,7 +1260,10 @@ static void* MessageHandler(void *data)
 
       case CEC_MSG_TYPE_STATE:
       {
-        HandleStateMessages(hal, msg.message, msg.size);
+        char error[VC_HDMICEC_MAX_ERROR_LENGTH] = "";
+        uint64_t started_ns = vcStats_NowNs();
+        bool handled = HandleStateMessages(hal, msg.message, msg.size, error);
+        SendAck(&msg, handled ? VC_HDMICEC_STATUS_SUCCESS : VC_HDMICEC_STATUS_MESSAGE_REJECTED, error, started_ns);
       }
       break;
 
@@ -474,6 +1278,76 @@ static void* MessageHandler(void *data)
   return NULL;
 }
 
+/* Client callbacks run on the vComponent threads, so a slow callback delays every
+ * message queued behind it, unless rx_dispatch_workers moves the Rx callback to the
+ * dispatcher pool. Each invocation is timed and checked against the budget. */
+static void InvokeHalRxCallback(vcHdmiCec_hal_t *hal, uint8_t *buf, uint32_t len)
+{
+  int opcode = (len > 1) ? buf[1] : -1; //Polling messages carry no opcode
+  uint64_t start, duration;
+
+  if(hal->callbacks.rx_cb_func == NULL)
+  {
+    return;
+  }
+  VC_TRACE3(rx_cb_entry, buf[0], opcode, len);
+  start = vcStats_NowNs();
+  hal->callbacks.rx_cb_func((intptr_t)hal, hal->callbacks.rx_cb_data, buf, len);
+  duration = vcStats_NowNs() - start;
+  VC_TRACE3(rx_cb_return, buf[0], opcode, len);
+
+  if(vcStats_Record(&hal->rx_cb_stats, buf[0], (opcode < 0) ? VCSTATS_OPCODE_POLLING : opcode, duration))
+  {
+    VC_TRACE3(rx_cb_overrun, buf[0], opcode, duration);
+    VC_LOG_ERROR("Rx callback took %llu us for opcode 0x%02X (budget %llu us)", (unsigned long long)(duration / 1000),
+                 opcode & 0xFF, (unsigned long long)(hal->rx_cb_stats.budget_ns / 1000));
+  }
+}
+
+/* The HAL client is the consumer with id 0 of the Rx dispatcher */
+static void ClientRxConsumer(int consumerId, void *pUserData, const unsigned char *pFrame, unsigned int len)
+{
+  (void)consumerId;
+  InvokeHalRxCallback((vcHdmiCec_hal_t *)pUserData, (uint8_t *)pFrame, len);
+}
+
+/* Delivers a received frame to the HAL client and to the Rx consumers */
+static void InvokeRxCallback(vcHdmiCec_hal_t *hal, uint8_t *buf, uint32_t len)
+{
+  //The frame is on the bus whether or not anyone listens to it
+  CaptureFrame(hal, VCCAPTURE_RECORD_RX, buf, len, HDMI_CEC_IO_SUCCESS);
+  //The middleware reads the frame from its own thread, see vcHdmiCec_OpenRxEventFd()
+  if(!vcRxQueue_Push(hal->rx_queue, buf, len))
+  {
+    vcConsumer_PostClient(hal->consumers, buf, len);
+  }
+  //Consumers only get the opcodes they subscribed to
+  vcConsumer_Dispatch(hal->consumers, buf, len);
+}
+
+static void InvokeTxCallback(vcHdmiCec_hal_t *hal, int handle, const unsigned char *buf, int len, int result)
+{
+  int opcode = (len > 1) ? buf[1] : -1;
+  uint64_t start, duration;
+
+  if(hal->callbacks.tx_cb_func == NULL)
+  {
+    return;
+  }
+  VC_TRACE3(tx_cb_entry, buf[0], opcode, result);
+  start = vcStats_NowNs();
+  hal->callbacks.tx_cb_func(handle, hal->callbacks.tx_cb_data, result);
+  duration = vcStats_NowNs() - start;
+  VC_TRACE3(tx_cb_return, buf[0], opcode, result);
+
+  if(vcStats_Record(&hal->tx_cb_stats, buf[0], (opcode < 0) ? VCSTATS_OPCODE_POLLING : opcode, duration))
+  {
+    VC_TRACE3(tx_cb_overrun, buf[0], opcode, duration);
+    VC_LOG_ERROR("Tx callback took %llu us for opcode 0x%02X (budget %llu us)", (unsigned long long)(duration / 1000),
+                 opcode & 0xFF, (unsigned long long)(hal->tx_cb_stats.budget_ns / 1000));
+  }
+}
+
 static void LoadPortsInfo (ut_kvp_instance_t* instance, vcHdmiCec_port_info_t* ports, unsigned int nPorts)
 {
   char *prefix = "hdmicec/ports/";
@@ -509,7 +1383,7 @@ static void PrintStatus(vcHdmiCec_hal_t *cec)
 {
   assert(cec != NULL);
   VC_LOG(">>>>>>> >>>>> >>>> >> >> >");
-  VC_LOG("Emulated Device               : %s", cec->emulated_device->osd_name);
+  VC_LOG("Emulated Device               : %s", (cec->emulated_device != NULL) ? cec->emulated_device->osd_name : "(none)");
   VC_LOG("Number of Ports               : %d", cec->num_ports);
   VC_LOG("Number of devices in Network  : %d", cec->num_devices);
   VC_LOG("===========================");
@@ -544,6 +1418,15 @@ static void PrintPortsInfo(vcHdmiCec_hal_t *cec)
   VC_LOG("=================================");
 }
 
+static void PrintCallbackStats(vcHdmiCec_hal_t *cec)
+{
+  assert(cec != NULL);
+  vcStats_Print(&cec->rx_cb_stats);
+  vcStats_Print(&cec->tx_cb_stats);
+  vcRxQueue_Print(cec->rx_queue);
+  vcConsumer_Print(cec->consumers);
+}
+
 static void TeardownHal (vcHdmiCec_hal_t* hal)
 {
   vcHdmiCec_message_t msg = {0};
@@ -552,6 +1435,12 @@ static void TeardownHal (vcHdmiCec_hal_t* hal)
     return;
   }
 
+  //Stop the replay and the scheduler first so that nothing is queued behind the exit request
+  vcCapture_StopReplay(hal->replay);
+  hal->replay = NULL;
+  vcScheduler_Destroy(hal->scheduler);
+  hal->scheduler = NULL;
+
   if ( hal->msg_handler_thread )
   {
     memset(&msg, 0, sizeof(msg));
@@ -563,6 +1452,22 @@ static void TeardownHal (vcHdmiCec_hal_t* hal)
     }
   }
   hal->msg_handler_thread = 0;
+  //Generated frames still queued were delivered and counted by the message handler before it exited
+  vcTraffic_Destroy(hal->traffic);
+  hal->traffic = NULL;
+  StopCapture(hal);
+  pthread_mutex_destroy(&hal->capture_mutex);
+  vcRxQueue_Destroy(hal->rx_queue);
+  hal->rx_queue = NULL;
+  vcConsumer_Destroy(hal->consumers);
+  hal->consumers = NULL;
+  if(hal->rx_cb_stats.overruns > 0 || hal->tx_cb_stats.overruns > 0)
+  {
+    //Leave the evidence in the log before the statistics are gone
+    PrintCallbackStats(hal);
+  }
+  vcStats_Deinit(&hal->rx_cb_stats);
+  vcStats_Deinit(&hal->tx_cb_stats);
   vcDevice_DestroyMap(hal->devices_map);
 
   if(hal->ports)
@@ -589,6 +1494,8 @@ vcHdmiCec_t* vcHdmiCec_Initialize( void )
   result->cec_hal = NULL;
   result->bOpened = false;
   result->cp_instance = NULL;
+  result->ack_cb_func = NULL;
+  result->ack_cb_data = NULL;
 
   gvcHdmiCec = result;
   return (vcHdmiCec_t *)result;
@@ -633,6 +1540,9 @@ if(pProfilePath == NULL)
     assert(vcHdmiCec->cp_instance != NULL);
     UT_ControlPlane_RegisterCallbackOnMessage(gvcHdmiCec->cp_instance, "hdmicec/command", &ProcessMsg, (void*) vcHdmiCec);
     UT_ControlPlane_RegisterCallbackOnMessage(gvcHdmiCec->cp_instance, "hdmicec/state", &ProcessMsg, (void*) vcHdmiCec);
+    UT_ControlPlane_RegisterCallbackOnMessage(gvcHdmiCec->cp_instance, "hdmicec/batch", &ProcessMsg, (void*) vcHdmiCec);
+    UT_ControlPlane_RegisterCallbackOnMessage(gvcHdmiCec->cp_instance, "hdmicec/traffic", &ProcessMsg, (void*) vcHdmiCec);
+    UT_ControlPlane_RegisterCallbackOnMessage(gvcHdmiCec->cp_instance, "hdmicec/keypress", &ProcessMsg, (void*) vcHdmiCec);
     UT_ControlPlane_Start(vcHdmiCec->cp_instance);
   }
   vcHdmiCec->bOpened = true;
@@ -690,57 +1600,317 @@ vcHdmiCec_Status_t vcHdmiCec_Deinitialize(vcHdmiCec_t *pvcHdmiCec)
   return VC_HDMICEC_STATUS_SUCCESS;
 }
 
-HDMI_CEC_STATUS HdmiCecOpen(int* handle)
+static vcHdmiCec_Status_t InjectCheck(vcHdmiCec_internal_t* vcHdmiCec, const char* func)
 {
-  char emulated_device[MAX_OSD_NAME_LENGTH];
-  vcHdmiCec_hal_t* cec;
-  ut_kvp_instance_t *profile_instance;
-  vcHdmiCec_port_info_t* ports;
+  if(vcHdmiCec == NULL || vcHdmiCec != gvcHdmiCec)
+  {
+    VC_LOG_ERROR("%s: Invalid handle", func);
+    return VC_HDMICEC_STATUS_INVALID_HANDLE;
+  }
 
-  if(handle == NULL)
+  if(vcHdmiCec->cec_hal == NULL || vcHdmiCec->cec_hal->state != HAL_STATE_READY)
   {
-    return HDMI_CEC_IO_INVALID_HANDLE;
+    VC_LOG_ERROR("%s: HAL not ready", func);
+    return VC_HDMICEC_STATUS_NOT_OPENED;
   }
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
 
-  if(gvcHdmiCec == NULL)
+vcHdmiCec_Status_t vcHdmiCec_InjectMessage( vcHdmiCec_t* pvcHdmiCec, const char* pMessage )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+  ut_kvp_instance_t *kvpInstance;
+  vcHdmiCec_message_t msg = {0};
+  char *copy;
+
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
   {
-    return HDMI_CEC_IO_NOT_OPENED;
+    return status;
   }
 
-  if(gvcHdmiCec->cec_hal != NULL)
+  if(pMessage == NULL)
   {
-    return HDMI_CEC_IO_ALREADY_OPEN;
+    VC_LOG_ERROR("vcHdmiCec_InjectMessage: Invalid message");
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
   }
 
-  cec = (vcHdmiCec_hal_t*)malloc(sizeof(vcHdmiCec_hal_t));
-  if(cec == NULL) 
+  //Classify the message the same way the control plane does by its key
+  copy = strdup(pMessage);
+  if(copy == NULL)
   {
-    VC_LOG_ERROR( "HdmiCecOpen: Out of Memory" );
-    return HDMI_CEC_IO_GENERAL_ERROR;
+    return VC_HDMICEC_STATUS_OUT_OF_MEMORY;
   }
-  memset(cec, 0, sizeof(vcHdmiCec_hal_t));
+  kvpInstance = KVPInstanceOpen(copy, strlen(copy));
+  if(kvpInstance == NULL)
+  {
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
+  }
+  if(ut_kvp_fieldPresent(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_COMMAND))
+  {
+    msg.type = CEC_MSG_TYPE_COMMAND;
+  }
+  else if(ut_kvp_fieldPresent(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_STATE))
+  {
+    msg.type = CEC_MSG_TYPE_STATE;
+  }
+  else if(ut_kvp_fieldPresent(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_BATCH))
+  {
+    msg.type = CEC_MSG_TYPE_BATCH;
+  }
+  else if(ut_kvp_fieldPresent(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_TRAFFIC))
+  {
+    msg.type = CEC_MSG_TYPE_TRAFFIC;
+  }
+  else if(ut_kvp_fieldPresent(kvpInstance, CEC_MSG_PREFIX"/"CEC_MSG_KEYPRESS))
+  {
+    msg.type = CEC_MSG_TYPE_KEYPRESS;
+  }
+  else
+  {
+    msg.type = CEC_MSG_TYPE_NONE;
+  }
+  ReadRequestId(kvpInstance, &msg);
+  ut_kvp_destroyInstance(kvpInstance);
 
-  profile_instance = gvcHdmiCec->profile_instance;
-  assert(profile_instance != NULL);
-  
-  ut_kvp_getStringField(profile_instance, "hdmicec/emulated_device", emulated_device, MAX_OSD_NAME_LENGTH);
+  if(msg.type == CEC_MSG_TYPE_NONE)
+  {
+    VC_LOG_ERROR("vcHdmiCec_InjectMessage: Not a command, state, batch, traffic or keypress message");
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
+  }
 
-  cec->num_ports = ut_kvp_getUInt32Field(profile_instance, "hdmicec/number_ports");
-  ports = (vcHdmiCec_port_info_t*) malloc(sizeof(vcHdmiCec_port_info_t) * cec->num_ports);
-  assert(ports != NULL);
+  //ut_kvp_openMemory in the message handler takes ownership of the string
+  msg.message = strdup(pMessage);
+  if(msg.message == NULL)
+  {
+    return VC_HDMICEC_STATUS_OUT_OF_MEMORY;
+  }
+  msg.size = strlen(msg.message);
+  VC_TRACE1(process_msg, msg.type);
+  if(!EnqueueMessage(vcHdmiCec->cec_hal, &msg))
+  {
+    return VC_HDMICEC_STATUS_QUEUE_FULL;
+  }
 
-  LoadPortsInfo(profile_instance, ports, cec->num_ports);
-  cec->ports = ports;
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
 
-  //Setup Eventing and callback
-  cec->exit_request = false;
-  pthread_mutex_init( &cec->msg_queue_mutex, NULL );
-  pthread_cond_init( &cec->msg_queue_condition, NULL );
-  pthread_create(&cec->msg_handler_thread, NULL, MessageHandler, (void*) cec );
-  memset(&cec->msg_queue, 0, sizeof(vcHdmiCec_message_t) * MAX_QUEUE_SIZE);
+vcHdmiCec_Status_t vcHdmiCec_InjectFrame( vcHdmiCec_t* pvcHdmiCec, const unsigned char* pFrame, unsigned int len )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+  vcHdmiCec_message_t msg = {0};
 
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
+  {
+    return status;
+  }
 
-  //Device Discovery and Network Topology
+  if(pFrame == NULL || len == 0 || len > VCCOMMAND_MAX_DATA_SIZE)
+  {
+    VC_LOG_ERROR("vcHdmiCec_InjectFrame: Invalid frame");
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
+  }
+
+  msg.type = CEC_MSG_TYPE_FRAME;
+  msg.message = malloc(len);
+  if(msg.message == NULL)
+  {
+    return VC_HDMICEC_STATUS_OUT_OF_MEMORY;
+  }
+  memcpy(msg.message, pFrame, len);
+  msg.size = len;
+  VC_TRACE1(process_msg, msg.type);
+  if(!EnqueueMessage(vcHdmiCec->cec_hal, &msg))
+  {
+    return VC_HDMICEC_STATUS_QUEUE_FULL;
+  }
+
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
+
+vcHdmiCec_Status_t vcHdmiCec_SetAckCallback( vcHdmiCec_t* pvcHdmiCec, vcHdmiCec_AckCallback_t cbFunc, void* pUserData )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+
+  if(vcHdmiCec == NULL || vcHdmiCec != gvcHdmiCec)
+  {
+    VC_LOG_ERROR("vcHdmiCec_SetAckCallback: Invalid handle");
+    return VC_HDMICEC_STATUS_INVALID_HANDLE;
+  }
+  vcHdmiCec->ack_cb_data = pUserData;
+  vcHdmiCec->ack_cb_func = cbFunc;
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
+
+vcHdmiCec_Status_t vcHdmiCec_OpenRxEventFd( vcHdmiCec_t* pvcHdmiCec, int* pFd )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
+  {
+    return status;
+  }
+  if(pFd == NULL)
+  {
+    VC_LOG_ERROR("vcHdmiCec_OpenRxEventFd: Invalid parameter");
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
+  }
+
+  vcRxQueue_Enable(vcHdmiCec->cec_hal->rx_queue, true);
+  *pFd = vcRxQueue_GetFd(vcHdmiCec->cec_hal->rx_queue);
+  VC_LOG("Rx frames delivered through eventfd %d", *pFd);
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
+
+vcHdmiCec_Status_t vcHdmiCec_ReadRxFrames( vcHdmiCec_t* pvcHdmiCec, vcHdmiCec_Frame_t* pFrames, unsigned int maxFrames, unsigned int* pNumFrames )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
+  {
+    return status;
+  }
+  if(pFrames == NULL || pNumFrames == NULL)
+  {
+    VC_LOG_ERROR("vcHdmiCec_ReadRxFrames: Invalid parameter");
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
+  }
+
+  *pNumFrames = vcRxQueue_Read(vcHdmiCec->cec_hal->rx_queue, pFrames, maxFrames);
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
+
+vcHdmiCec_Status_t vcHdmiCec_CloseRxEventFd( vcHdmiCec_t* pvcHdmiCec )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
+  {
+    return status;
+  }
+
+  vcRxQueue_Enable(vcHdmiCec->cec_hal->rx_queue, false);
+  VC_LOG("Rx frames delivered through the Rx callback");
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
+
+vcHdmiCec_Status_t vcHdmiCec_GetRxQueueStats( vcHdmiCec_t* pvcHdmiCec, vcHdmiCec_RxQueueStats_t* pStats )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
+  {
+    return status;
+  }
+  if(pStats == NULL)
+  {
+    VC_LOG_ERROR("vcHdmiCec_GetRxQueueStats: Invalid parameter");
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
+  }
+
+  vcRxQueue_GetStats(vcHdmiCec->cec_hal->rx_queue, pStats);
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
+
+vcHdmiCec_Status_t vcHdmiCec_AddRxConsumer( vcHdmiCec_t* pvcHdmiCec, const char* pName, const vcHdmiCec_OpcodeMask_t* pMask,
+                                            vcHdmiCec_RxConsumerCallback_t cbFunc, void* pUserData, int* pConsumerId )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
+  {
+    return status;
+  }
+  if(pMask == NULL || cbFunc == NULL || pConsumerId == NULL)
+  {
+    VC_LOG_ERROR("vcHdmiCec_AddRxConsumer: Invalid parameter");
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
+  }
+
+  if(!vcConsumer_Add(vcHdmiCec->cec_hal->consumers, pName, pMask, cbFunc, pUserData, pConsumerId))
+  {
+    VC_LOG_ERROR("vcHdmiCec_AddRxConsumer: %d consumers already registered", VC_HDMICEC_MAX_RX_CONSUMERS);
+    return VC_HDMICEC_STATUS_NO_RESOURCES;
+  }
+  VC_LOG("Rx consumer [%d] %s added", *pConsumerId, (pName != NULL) ? pName : "");
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
+
+vcHdmiCec_Status_t vcHdmiCec_SetRxConsumerMask( vcHdmiCec_t* pvcHdmiCec, int consumerId, const vcHdmiCec_OpcodeMask_t* pMask )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
+  {
+    return status;
+  }
+  if(pMask == NULL || !vcConsumer_SetMask(vcHdmiCec->cec_hal->consumers, consumerId, pMask))
+  {
+    VC_LOG_ERROR("vcHdmiCec_SetRxConsumerMask: Invalid parameter");
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
+  }
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
+
+vcHdmiCec_Status_t vcHdmiCec_RemoveRxConsumer( vcHdmiCec_t* pvcHdmiCec, int consumerId )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
+  {
+    return status;
+  }
+  if(!vcConsumer_Remove(vcHdmiCec->cec_hal->consumers, consumerId))
+  {
+    VC_LOG_ERROR("vcHdmiCec_RemoveRxConsumer: Unknown consumer [%d]", consumerId);
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
+  }
+  VC_LOG("Rx consumer [%d] removed", consumerId);
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
+
+vcHdmiCec_Status_t vcHdmiCec_GetRxConsumerStats( vcHdmiCec_t* pvcHdmiCec, vcHdmiCec_RxConsumerStats_t* pStats, unsigned int maxStats, unsigned int* pNumConsumers )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
+  {
+    return status;
+  }
+  if(pStats == NULL || pNumConsumers == NULL)
+  {
+    VC_LOG_ERROR("vcHdmiCec_GetRxConsumerStats: Invalid parameter");
+    return VC_HDMICEC_STATUS_INVALID_PARAM;
+  }
+
+  *pNumConsumers = vcConsumer_GetStats(vcHdmiCec->cec_hal->consumers, pStats, maxStats);
+  return VC_HDMICEC_STATUS_SUCCESS;
+}
+
+static bool LoadNetwork(vcHdmiCec_hal_t *cec, ut_kvp_instance_t *profile_instance)
+{
+  char emulated_device[MAX_OSD_NAME_LENGTH];
+
+  ut_kvp_getStringField(profile_instance, "hdmicec/emulated_device", emulated_device, MAX_OSD_NAME_LENGTH);
   cec->num_devices = ut_kvp_getUInt32Field(profile_instance, "hdmicec/number_devices");
 
   cec->devices_map = vcDevice_CreateMapFromProfile(profile_instance, "hdmicec/device_map/0");
@@ -761,8 +1931,7 @@ HDMI_CEC_STATUS HdmiCecOpen(int* handle)
   {
     VC_LOG_ERROR("HdmiCecOpen: Couldnt load emulated device info");
     assert(cec->emulated_device != NULL);
-    TeardownHal(cec);
-    return HDMI_CEC_IO_GENERAL_ERROR;
+    return false;
   }
   vcDevice_InitLogicalAddressPool(&cec->address_pool);
   vcDevice_AllocatePhysicalLogicalAddresses(cec->devices_map, cec->emulated_device, &cec->address_pool);
@@ -778,6 +1947,223 @@ HDMI_CEC_STATUS HdmiCecOpen(int* handle)
     VC_LOG("HdmiCecOpen: Emulating a Source device");
     //TODO Auto Allocate Logical addresses
   }
+  return true;
+}
+
+/* Runs on the message handler thread, so no message is being processed while the network is rebuilt */
+static void ResetNetwork(vcHdmiCec_hal_t *hal)
+{
+  uint32_t discarded;
+
+  vcTraffic_Stop(hal->traffic);
+  vcCapture_StopReplay(hal->replay);
+  hal->replay = NULL;
+  //Batch items still waiting would otherwise be delivered into the fresh network
+  discarded = vcScheduler_Clear(hal->scheduler);
+  if(discarded > 0)
+  {
+    VC_LOG("vcHdmiCec_Reset: Discarded %u scheduled frames", discarded);
+  }
+  //Tx frames are captured on the caller thread, which looks up their source in the map
+  pthread_mutex_lock(&hal->capture_mutex);
+  vcDevice_DestroyMap(hal->devices_map);
+  hal->devices_map = NULL;
+  hal->emulated_device = NULL;
+  if(!LoadNetwork(hal, gvcHdmiCec->profile_instance))
+  {
+    VC_LOG_ERROR("vcHdmiCec_Reset: Failed to reload the network from the profile");
+  }
+  pthread_mutex_unlock(&hal->capture_mutex);
+
+  pthread_mutex_lock(&hal->msg_queue_mutex);
+  hal->reset_count++;
+  pthread_cond_broadcast(&hal->reset_condition);
+  pthread_mutex_unlock(&hal->msg_queue_mutex);
+}
+
+vcHdmiCec_Status_t vcHdmiCec_Reset( vcHdmiCec_t* pvcHdmiCec )
+{
+  vcHdmiCec_internal_t* vcHdmiCec = (vcHdmiCec_internal_t*)pvcHdmiCec;
+  vcHdmiCec_Status_t status;
+  vcHdmiCec_message_t msg = {0};
+  vcHdmiCec_hal_t *hal;
+  uint32_t reset_count;
+  struct timespec deadline;
+  int rc = 0;
+  bool done;
+
+  status = InjectCheck(vcHdmiCec, __FUNCTION__);
+  if(status != VC_HDMICEC_STATUS_SUCCESS)
+  {
+    return status;
+  }
+  hal = vcHdmiCec->cec_hal;
+
+  //The message handler would wait for itself, e.g. when called from the Rx callback
+  if(pthread_equal(pthread_self(), hal->msg_handler_thread))
+  {
+    VC_LOG_ERROR("vcHdmiCec_Reset: Cannot be called from the message handler thread");
+    return VC_HDMICEC_STATUS_WRONG_THREAD;
+  }
+
+  pthread_mutex_lock(&hal->msg_queue_mutex);
+  reset_count = hal->reset_count;
+  pthread_mutex_unlock(&hal->msg_queue_mutex);
+
+  msg.type = CEC_MSG_TYPE_RESET;
+  if(!EnqueueMessage(hal, &msg))
+  {
+    return VC_HDMICEC_STATUS_QUEUE_FULL;
+  }
+
+  //Wait for the messages queued before the reset and the reset itself to be handled
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += RESET_TIMEOUT_MS / 1000;
+  deadline.tv_nsec += (RESET_TIMEOUT_MS % 1000) * 1000000L;
+  if(deadline.tv_nsec >= 1000000000L)
+  {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  pthread_mutex_lock(&hal->msg_queue_mutex);
+  while (hal->reset_count == reset_count && rc != ETIMEDOUT)
+  {
+    rc = pthread_cond_timedwait(&hal->reset_condition, &hal->msg_queue_mutex, &deadline);
+  }
+  done = (hal->reset_count != reset_count);
+  pthread_mutex_unlock(&hal->msg_queue_mutex);
+  if(!done)
+  {
+    //The reset stays queued and is done once the message handler gets to it
+    VC_LOG_ERROR("vcHdmiCec_Reset: Not done after %u ms", RESET_TIMEOUT_MS);
+    return VC_HDMICEC_STATUS_TIMEOUT;
+  }
+
+  pthread_mutex_lock(&hal->capture_mutex);
+  status = (hal->emulated_device != NULL) ? VC_HDMICEC_STATUS_SUCCESS : VC_HDMICEC_STATUS_PROFILE_READ_ERROR;
+  pthread_mutex_unlock(&hal->capture_mutex);
+  return status;
+}
+
+/* The HAL APIs run on the caller thread while a reset may rebuild the network on the message handler.
+ * Returns the emulated device with the network locked, or NULL and unlocked if the last reset failed. */
+static struct vcDevice_info_t* LockEmulatedDevice(vcHdmiCec_hal_t *hal, const char *api)
+{
+  pthread_mutex_lock(&hal->capture_mutex);
+  if(hal->emulated_device == NULL)
+  {
+    pthread_mutex_unlock(&hal->capture_mutex);
+    VC_LOG_ERROR("%s: No emulated device, the network could not be reloaded", api);
+    return NULL;
+  }
+  return hal->emulated_device;
+}
+
+static void UnlockEmulatedDevice(vcHdmiCec_hal_t *hal)
+{
+  pthread_mutex_unlock(&hal->capture_mutex);
+}
+
+static HDMI_CEC_STATUS HalOpen(int* handle)
+{
+  vcHdmiCec_hal_t* cec;
+  ut_kvp_instance_t *profile_instance;
+  vcHdmiCec_port_info_t* ports;
+  uint64_t budget_us = DEFAULT_CALLBACK_BUDGET_US;
+  uint32_t rx_queue_size = VCRXQUEUE_DEFAULT_CAPACITY;
+  uint32_t dispatch_workers = 0;
+  uint32_t dispatch_queue_size = VCCONSUMER_DEFAULT_QUEUE_SIZE;
+
+  if(handle == NULL)
+  {
+    return HDMI_CEC_IO_INVALID_HANDLE;
+  }
+
+  if(gvcHdmiCec == NULL)
+  {
+    return HDMI_CEC_IO_NOT_OPENED;
+  }
+
+  if(gvcHdmiCec->cec_hal != NULL)
+  {
+    return HDMI_CEC_IO_ALREADY_OPEN;
+  }
+
+  cec = (vcHdmiCec_hal_t*)malloc(sizeof(vcHdmiCec_hal_t));
+  if(cec == NULL) 
+  {
+    VC_LOG_ERROR( "HdmiCecOpen: Out of Memory" );
+    return HDMI_CEC_IO_GENERAL_ERROR;
+  }
+  memset(cec, 0, sizeof(vcHdmiCec_hal_t));
+
+  profile_instance = gvcHdmiCec->profile_instance;
+  assert(profile_instance != NULL);
+
+  cec->num_ports = ut_kvp_getUInt32Field(profile_instance, "hdmicec/number_ports");
+  ports = (vcHdmiCec_port_info_t*) malloc(sizeof(vcHdmiCec_port_info_t) * cec->num_ports);
+  assert(ports != NULL);
+
+  LoadPortsInfo(profile_instance, ports, cec->num_ports);
+  cec->ports = ports;
+
+  if(ut_kvp_fieldPresent(profile_instance, "hdmicec/callback_budget_us"))
+  {
+    budget_us = ut_kvp_getUInt32Field(profile_instance, "hdmicec/callback_budget_us");
+  }
+  vcStats_Init(&cec->rx_cb_stats, "Rx", budget_us * 1000);
+  vcStats_Init(&cec->tx_cb_stats, "Tx", budget_us * 1000);
+
+  //Unused until the middleware asks for the eventfd
+  if(ut_kvp_fieldPresent(profile_instance, "hdmicec/rx_queue_size"))
+  {
+    rx_queue_size = ut_kvp_getUInt32Field(profile_instance, "hdmicec/rx_queue_size");
+  }
+  cec->rx_queue = vcRxQueue_Create(rx_queue_size ? rx_queue_size : VCRXQUEUE_DEFAULT_CAPACITY);
+  assert(cec->rx_queue != NULL);
+
+  //Without workers the Rx callbacks run on the message handler thread
+  if(ut_kvp_fieldPresent(profile_instance, "hdmicec/rx_dispatch_workers"))
+  {
+    dispatch_workers = ut_kvp_getUInt32Field(profile_instance, "hdmicec/rx_dispatch_workers");
+  }
+  if(ut_kvp_fieldPresent(profile_instance, "hdmicec/rx_dispatch_queue_size"))
+  {
+    dispatch_queue_size = ut_kvp_getUInt32Field(profile_instance, "hdmicec/rx_dispatch_queue_size");
+  }
+  cec->consumers = vcConsumer_Create(dispatch_workers, dispatch_queue_size);
+  assert(cec->consumers != NULL);
+  vcConsumer_SetClient(cec->consumers, "Rx callback", ClientRxConsumer, cec);
+
+  //Setup Eventing and callback
+  cec->exit_request = false;
+  pthread_mutex_init( &cec->msg_queue_mutex, NULL );
+  pthread_cond_init( &cec->msg_queue_condition, NULL );
+  pthread_cond_init( &cec->msg_space_condition, NULL );
+  pthread_cond_init( &cec->reset_condition, NULL );
+  pthread_mutex_init( &cec->capture_mutex, NULL );
+  pthread_create(&cec->msg_handler_thread, NULL, MessageHandler, (void*) cec );
+  cec->scheduler = vcScheduler_Create();
+  assert(cec->scheduler != NULL);
+  cec->traffic = vcTraffic_Create(cec->scheduler, EmitTrafficFrame, cec);
+  assert(cec->traffic != NULL);
+  memset(&cec->msg_queue, 0, sizeof(cec->msg_queue));
+
+
+  if(ut_kvp_fieldPresent(profile_instance, "hdmicec/capture_path"))
+  {
+    char path[UT_KVP_MAX_ELEMENT_SIZE];
+    char error[VC_HDMICEC_MAX_ERROR_LENGTH];
+    ut_kvp_getStringField(profile_instance, "hdmicec/capture_path", path, UT_KVP_MAX_ELEMENT_SIZE);
+    StartCapture(cec, path, error);
+  }
+
+  //Device Discovery and Network Topology
+  if(!LoadNetwork(cec, profile_instance))
+  {
+    TeardownHal(cec);
+    return HDMI_CEC_IO_GENERAL_ERROR;
+  }
   PrintStatus(cec);
 
   *handle = (intptr_t) cec;
@@ -787,7 +2173,7 @@ HDMI_CEC_STATUS HdmiCecOpen(int* handle)
   return HDMI_CEC_IO_SUCCESS;
 }
 
-HDMI_CEC_STATUS HdmiCecClose(int handle)
+static HDMI_CEC_STATUS HalClose(int handle)
 {
   if(gvcHdmiCec == NULL || gvcHdmiCec->cec_hal == NULL)
   {
@@ -808,8 +2194,10 @@ HDMI_CEC_STATUS HdmiCecClose(int handle)
 }
 
 
-HDMI_CEC_STATUS HdmiCecGetPhysicalAddress(int handle, unsigned int* physicalAddress)
+static HDMI_CEC_STATUS HalGetPhysicalAddress(int handle, unsigned int* physicalAddress)
 {
+  struct vcDevice_info_t *device;
+
   if(gvcHdmiCec == NULL || gvcHdmiCec->cec_hal == NULL)
   {
     VC_LOG_ERROR("HdmiCecGetPhysicalAddress: Not Opened");
@@ -826,12 +2214,20 @@ HDMI_CEC_STATUS HdmiCecGetPhysicalAddress(int handle, unsigned int* physicalAddr
     return HDMI_CEC_IO_INVALID_ARGUMENT;
   }
 
-  *physicalAddress = gvcHdmiCec->cec_hal->emulated_device->physical_address;
+  device = LockEmulatedDevice(gvcHdmiCec->cec_hal, "HdmiCecGetPhysicalAddress");
+  if(device == NULL)
+  {
+    return HDMI_CEC_IO_NOT_OPENED;
+  }
+  *physicalAddress = device->physical_address;
+  UnlockEmulatedDevice(gvcHdmiCec->cec_hal);
   return HDMI_CEC_IO_SUCCESS;
 }
 
-HDMI_CEC_STATUS HdmiCecAddLogicalAddress(int handle, int logicalAddresses)
+static HDMI_CEC_STATUS HalAddLogicalAddress(int handle, int logicalAddresses)
 {
+  struct vcDevice_info_t *device;
+
   if(gvcHdmiCec == NULL || gvcHdmiCec->cec_hal == NULL)
   {
     VC_LOG_ERROR("HdmiCecAddLogicalAddress: Not Opened");
@@ -842,19 +2238,28 @@ HDMI_CEC_STATUS HdmiCecAddLogicalAddress(int handle, int logicalAddresses)
     VC_LOG_ERROR("HdmiCecAddLogicalAddress: Invalid handle");
     return HDMI_CEC_IO_INVALID_HANDLE;
   }
-  if(gvcHdmiCec->cec_hal->emulated_device->type != DEVICE_TYPE_TV || logicalAddresses != 0)
+  device = LockEmulatedDevice(gvcHdmiCec->cec_hal, "HdmiCecAddLogicalAddress");
+  if(device == NULL)
   {
+    return HDMI_CEC_IO_NOT_OPENED;
+  }
+  if(device->type != DEVICE_TYPE_TV || logicalAddresses != 0)
+  {
+    UnlockEmulatedDevice(gvcHdmiCec->cec_hal);
     VC_LOG_ERROR("HdmiCecAddLogicalAddress: Invalid Argument");
     return HDMI_CEC_IO_INVALID_ARGUMENT;
   }
   //ADD Logical Address only for Sink device
-  gvcHdmiCec->cec_hal->emulated_device->logical_address = logicalAddresses;
+  device->logical_address = logicalAddresses;
+  UnlockEmulatedDevice(gvcHdmiCec->cec_hal);
 
   return HDMI_CEC_IO_SUCCESS;
 }
 
-HDMI_CEC_STATUS HdmiCecRemoveLogicalAddress(int handle, int logicalAddresses)
+static HDMI_CEC_STATUS HalRemoveLogicalAddress(int handle, int logicalAddresses)
 {
+  struct vcDevice_info_t *device;
+
   if(gvcHdmiCec == NULL || gvcHdmiCec->cec_hal == NULL)
   {
     VC_LOG_ERROR("HdmiCecRemoveLogicalAddress: Not Opened");
@@ -865,25 +2270,35 @@ HDMI_CEC_STATUS HdmiCecRemoveLogicalAddress(int handle, int logicalAddresses)
     VC_LOG_ERROR("HdmiCecRemoveLogicalAddress: Invalid handle");
     return HDMI_CEC_IO_INVALID_HANDLE;
   }
+  device = LockEmulatedDevice(gvcHdmiCec->cec_hal, "HdmiCecRemoveLogicalAddress");
+  if(device == NULL)
+  {
+    return HDMI_CEC_IO_NOT_OPENED;
+  }
   //Remove Logical Address only for Sink device
-  if(gvcHdmiCec->cec_hal->emulated_device->type != DEVICE_TYPE_TV || logicalAddresses != 0)
+  if(device->type != DEVICE_TYPE_TV || logicalAddresses != 0)
   {
+    UnlockEmulatedDevice(gvcHdmiCec->cec_hal);
     VC_LOG_ERROR("HdmiCecRemoveLogicalAddress: Invalid Argument");
     return HDMI_CEC_IO_INVALID_ARGUMENT;
   }
-  if(gvcHdmiCec->cec_hal->emulated_device->logical_address == 0x0F)
+  if(device->logical_address == 0x0F)
   {
+    UnlockEmulatedDevice(gvcHdmiCec->cec_hal);
     //Looks like logical address is already removed. 
     return HDMI_CEC_IO_ALREADY_REMOVED;
   }
   //Reset back to 0x0F
-  gvcHdmiCec->cec_hal->emulated_device->logical_address = 0x0F;
+  device->logical_address = 0x0F;
+  UnlockEmulatedDevice(gvcHdmiCec->cec_hal);
 
   return HDMI_CEC_IO_SUCCESS;
 }
 
-HDMI_CEC_STATUS HdmiCecGetLogicalAddress(int handle, int* logicalAddress)
+static HDMI_CEC_STATUS HalGetLogicalAddress(int handle, int* logicalAddress)
 {
+  struct vcDevice_info_t *device;
+
   if(gvcHdmiCec == NULL || gvcHdmiCec->cec_hal == NULL)
   {
     VC_LOG_ERROR("HdmiCecGetLogicalAddress: Not Opened");
@@ -899,12 +2314,18 @@ HDMI_CEC_STATUS HdmiCecGetLogicalAddress(int handle, int* logicalAddress)
     VC_LOG_ERROR("HdmiCecGetLogicalAddress: Invalid Argument");
     return HDMI_CEC_IO_INVALID_ARGUMENT;
   }
-  *logicalAddress = gvcHdmiCec->cec_hal->emulated_device->logical_address;
+  device = LockEmulatedDevice(gvcHdmiCec->cec_hal, "HdmiCecGetLogicalAddress");
+  if(device == NULL)
+  {
+    return HDMI_CEC_IO_NOT_OPENED;
+  }
+  *logicalAddress = device->logical_address;
+  UnlockEmulatedDevice(gvcHdmiCec->cec_hal);
 
   return HDMI_CEC_IO_SUCCESS;
 }
 
-HDMI_CEC_STATUS HdmiCecSetRxCallback(int handle, HdmiCecRxCallback_t cbfunc, void* data)
+static HDMI_CEC_STATUS HalSetRxCallback(int handle, HdmiCecRxCallback_t cbfunc, void* data)
 {
   if(gvcHdmiCec == NULL || gvcHdmiCec->cec_hal == NULL)
   {
@@ -919,10 +2340,20 @@ HDMI_CEC_STATUS HdmiCecSetRxCallback(int handle, HdmiCecRxCallback_t cbfunc, voi
   gvcHdmiCec->cec_hal->callbacks.rx_cb_func = cbfunc;
   gvcHdmiCec->cec_hal->callbacks.rx_cb_data = data;
 
+  //Traffic described in the profile starts once there is a callback to deliver it to
+  if(cbfunc != NULL && !gvcHdmiCec->cec_hal->profile_traffic_started &&
+     ut_kvp_fieldPresent(gvcHdmiCec->profile_instance, CEC_MSG_PREFIX"/"CEC_MSG_TRAFFIC))
+  {
+    vcHdmiCec_message_t msg = {0};
+    msg.type = CEC_MSG_TYPE_TRAFFIC;
+    gvcHdmiCec->cec_hal->profile_traffic_started = true;
+    EnqueueMessage(gvcHdmiCec->cec_hal, &msg);
+  }
+
   return HDMI_CEC_IO_SUCCESS;
 }
 
-HDMI_CEC_STATUS HdmiCecSetTxCallback(int handle, HdmiCecTxCallback_t cbfunc, void* data)
+static HDMI_CEC_STATUS HalSetTxCallback(int handle, HdmiCecTxCallback_t cbfunc, void* data)
 {
   if(gvcHdmiCec == NULL || gvcHdmiCec->cec_hal == NULL)
   {
@@ -939,8 +2370,11 @@ HDMI_CEC_STATUS HdmiCecSetTxCallback(int handle, HdmiCecTxCallback_t cbfunc, voi
   return HDMI_CEC_IO_SUCCESS;
 }
 
-HDMI_CEC_STATUS HdmiCecTx(int handle, const unsigned char* buf, int len, int* result)
+static HDMI_CEC_STATUS HalTx(int handle, const unsigned char* buf, int len, int* result)
 {
+  struct vcDevice_info_t *device;
+  bool unaddressed;
+
   if(gvcHdmiCec == NULL || gvcHdmiCec->cec_hal == NULL)
   {
     VC_LOG_ERROR("HdmiCecTx: Not Opened");
@@ -956,10 +2390,18 @@ HDMI_CEC_STATUS HdmiCecTx(int handle, const unsigned char* buf, int len, int* re
     VC_LOG_ERROR("HdmiCecTx: Invalid Argument");
     return HDMI_CEC_IO_INVALID_ARGUMENT;
   }
-  if(gvcHdmiCec->cec_hal->emulated_device->type == DEVICE_TYPE_TV && gvcHdmiCec->cec_hal->emulated_device->logical_address == 0x0F)
+  device = LockEmulatedDevice(gvcHdmiCec->cec_hal, "HdmiCecTx");
+  if(device == NULL)
+  {
+    return HDMI_CEC_IO_NOT_OPENED;
+  }
+  unaddressed = (device->type == DEVICE_TYPE_TV && device->logical_address == 0x0F);
+  UnlockEmulatedDevice(gvcHdmiCec->cec_hal);
+  if(unaddressed)
   {
     //If Logical Address is not set for a sink device, we cannot transmit
     VC_LOG_ERROR("HdmiCecTx: Send failed");
+    CaptureFrame(gvcHdmiCec->cec_hal, VCCAPTURE_RECORD_TX, buf, len, HDMI_CEC_IO_SENT_FAILED);
     return HDMI_CEC_IO_SENT_FAILED;
   }
 
@@ -970,12 +2412,18 @@ HDMI_CEC_STATUS HdmiCecTx(int handle, const unsigned char* buf, int len, int* re
   }
   VC_LOG("==========================");
   *result = HDMI_CEC_IO_SENT_BUT_NOT_ACKD;
+  CaptureFrame(gvcHdmiCec->cec_hal, VCCAPTURE_RECORD_TX, buf, len, *result);
 
   return HDMI_CEC_IO_SUCCESS;
 }
 
-HDMI_CEC_STATUS HdmiCecTxAsync(int handle, const unsigned char* buf, int len)
+static HDMI_CEC_STATUS HalTxAsync(int handle, const unsigned char* buf, int len)
 {
+  vcHdmiCec_message_t msg = {0};
+  vcHdmiCec_tx_complete_t *tx;
+  struct vcDevice_info_t *device;
+  bool unaddressed;
+
   if(gvcHdmiCec == NULL || gvcHdmiCec->cec_hal == NULL)
   {
     VC_LOG_ERROR("HdmiCecTxAsync: Not Opened");
@@ -992,11 +2440,18 @@ HDMI_CEC_STATUS HdmiCecTxAsync(int handle, const unsigned char* buf, int len)
     return HDMI_CEC_IO_INVALID_ARGUMENT;
   }
 
-  if((gvcHdmiCec->cec_hal->emulated_device->type == DEVICE_TYPE_TV && gvcHdmiCec->cec_hal->emulated_device->logical_address == 0x0F)
-            || gvcHdmiCec->cec_hal->callbacks.tx_cb_func == NULL)
+  device = LockEmulatedDevice(gvcHdmiCec->cec_hal, "HdmiCecTxAsync");
+  if(device == NULL)
+  {
+    return HDMI_CEC_IO_NOT_OPENED;
+  }
+  unaddressed = (device->type == DEVICE_TYPE_TV && device->logical_address == 0x0F);
+  UnlockEmulatedDevice(gvcHdmiCec->cec_hal);
+  if(unaddressed || gvcHdmiCec->cec_hal->callbacks.tx_cb_func == NULL)
   {
     //If Logical Address is not set for a sink device, we cannot transmit
     VC_LOG_ERROR("HdmiCecTxAsync: Send failed");
+    CaptureFrame(gvcHdmiCec->cec_hal, VCCAPTURE_RECORD_TX, buf, len, HDMI_CEC_IO_SENT_FAILED);
     return HDMI_CEC_IO_SENT_FAILED;
   }
 
@@ -1007,6 +2462,124 @@ HDMI_CEC_STATUS HdmiCecTxAsync(int handle, const unsigned char* buf, int len)
   }
   VC_LOG("==========================");
 
+  //The callback runs on the message handler thread, as it would on the HAL thread of a real driver
+  tx = (vcHdmiCec_tx_complete_t *)malloc(sizeof(vcHdmiCec_tx_complete_t));
+  if(tx == NULL)
+  {
+    VC_LOG_ERROR("HdmiCecTxAsync: Out of Memory");
+    return HDMI_CEC_IO_GENERAL_ERROR;
+  }
+  tx->handle = handle;
+  //There is no bus to acknowledge the frame, report the same result as HdmiCecTx
+  tx->result = HDMI_CEC_IO_SENT_BUT_NOT_ACKD;
+  tx->len = (len > VCCOMMAND_MAX_DATA_SIZE) ? VCCOMMAND_MAX_DATA_SIZE : len;
+  memcpy(tx->data, buf, tx->len);
+  msg.type = CEC_MSG_TYPE_TX_COMPLETE;
+  msg.message = (char *)tx;
+  msg.size = sizeof(vcHdmiCec_tx_complete_t);
+  msg.received_ns = vcStats_NowNs();
+  if(!EnqueueMessage(gvcHdmiCec->cec_hal, &msg))
+  {
+    VC_LOG_ERROR("HdmiCecTxAsync: Message queue full");
+    CaptureFrame(gvcHdmiCec->cec_hal, VCCAPTURE_RECORD_TX, buf, len, HDMI_CEC_IO_SENT_FAILED);
+    return HDMI_CEC_IO_SENT_FAILED;
+  }
+  CaptureFrame(gvcHdmiCec->cec_hal, VCCAPTURE_RECORD_TX, buf, len, HDMI_CEC_IO_SENT_BUT_NOT_ACKD);
+
   return HDMI_CEC_IO_SUCCESS;
 }
 
+
+/* HAL entry points.
+ * Each API is wrapped with an entry/return probe pair so the call latency
+ * can be measured with bpftrace or perf without rebuilding (see vcTrace.h).
+ */
+HDMI_CEC_STATUS HdmiCecOpen(int* handle)
+{
+  HDMI_CEC_STATUS status;
+  VC_TRACE0(open_entry);
+  status = HalOpen(handle);
+  VC_TRACE1(open_return, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecClose(int handle)
+{
+  HDMI_CEC_STATUS status;
+  VC_TRACE1(close_entry, handle);
+  status = HalClose(handle);
+  VC_TRACE1(close_return, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecGetPhysicalAddress(int handle, unsigned int* physicalAddress)
+{
+  HDMI_CEC_STATUS status;
+  VC_TRACE1(get_physical_address_entry, handle);
+  status = HalGetPhysicalAddress(handle, physicalAddress);
+  VC_TRACE1(get_physical_address_return, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecAddLogicalAddress(int handle, int logicalAddresses)
+{
+  HDMI_CEC_STATUS status;
+  VC_TRACE2(add_logical_address_entry, handle, logicalAddresses);
+  status = HalAddLogicalAddress(handle, logicalAddresses);
+  VC_TRACE1(add_logical_address_return, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecRemoveLogicalAddress(int handle, int logicalAddresses)
+{
+  HDMI_CEC_STATUS status;
+  VC_TRACE2(remove_logical_address_entry, handle, logicalAddresses);
+  status = HalRemoveLogicalAddress(handle, logicalAddresses);
+  VC_TRACE1(remove_logical_address_return, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecGetLogicalAddress(int handle, int* logicalAddress)
+{
+  HDMI_CEC_STATUS status;
+  VC_TRACE1(get_logical_address_entry, handle);
+  status = HalGetLogicalAddress(handle, logicalAddress);
+  VC_TRACE1(get_logical_address_return, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecSetRxCallback(int handle, HdmiCecRxCallback_t cbfunc, void* data)
+{
+  HDMI_CEC_STATUS status;
+  VC_TRACE1(set_rx_callback_entry, handle);
+  status = HalSetRxCallback(handle, cbfunc, data);
+  VC_TRACE1(set_rx_callback_return, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecSetTxCallback(int handle, HdmiCecTxCallback_t cbfunc, void* data)
+{
+  HDMI_CEC_STATUS status;
+  VC_TRACE1(set_tx_callback_entry, handle);
+  status = HalSetTxCallback(handle, cbfunc, data);
+  VC_TRACE1(set_tx_callback_return, status);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecTx(int handle, const unsigned char* buf, int len, int* result)
+{
+  HDMI_CEC_STATUS status;
+  VC_TRACE3(tx_entry, handle, (buf != NULL && len > 1) ? buf[1] : -1, len);
+  status = HalTx(handle, buf, len, result);
+  VC_TRACE2(tx_return, status, (result != NULL) ? *result : -1);
+  return status;
+}
+
+HDMI_CEC_STATUS HdmiCecTxAsync(int handle, const unsigned char* buf, int len)
+{
+  HDMI_CEC_STATUS status;
+  VC_TRACE3(tx_async_entry, handle, (buf != NULL && len > 1) ? buf[1] : -1, len);
+  status = HalTxAsync(handle, buf, len);
+  VC_TRACE1(tx_async_return, status);
+  return status;
+}
@@ -0,0 +1,256 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#include "vcHdmiCec.h"
+#include "vcRxQueue.h"
+#include "vcStats.h"
+
+struct vcRxQueue_s
+{
+  pthread_mutex_t mutex;
+  int fd;
+  bool enabled;
+  vcHdmiCec_Frame_t *frames;
+  uint32_t capacity;
+  uint32_t head;
+  uint32_t count;
+  vcRxQueue_stats_t stats;
+  uint64_t drop_log_ns;     //Time of the last drop logged
+  uint64_t drops_unlogged;  //Drops since then, reported with the next log
+};
+
+vcRxQueue_t* vcRxQueue_Create(uint32_t capacity)
+{
+  vcRxQueue_t *queue;
+
+  assert(capacity > 0);
+  queue = (vcRxQueue_t *)calloc(1, sizeof(vcRxQueue_t));
+  if(queue == NULL)
+  {
+    return NULL;
+  }
+  queue->frames = (vcHdmiCec_Frame_t *)calloc(capacity, sizeof(vcHdmiCec_Frame_t));
+  queue->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(queue->frames == NULL || queue->fd < 0)
+  {
+    VC_LOG_ERROR("vcRxQueue_Create: cannot create a queue of %u frames", capacity);
+    if(queue->fd >= 0)
+    {
+      close(queue->fd);
+    }
+    free(queue->frames);
+    free(queue);
+    return NULL;
+  }
+  queue->capacity = capacity;
+  pthread_mutex_init(&queue->mutex, NULL);
+  return queue;
+}
+
+void vcRxQueue_Destroy(vcRxQueue_t *queue)
+{
+  if(queue == NULL)
+  {
+    return;
+  }
+  close(queue->fd);
+  pthread_mutex_destroy(&queue->mutex);
+  free(queue->frames);
+  free(queue);
+}
+
+int vcRxQueue_GetFd(vcRxQueue_t *queue)
+{
+  assert(queue != NULL);
+  return queue->fd;
+}
+
+/* Called with the mutex held once the queue is empty */
+static void ClearFd(vcRxQueue_t *queue)
+{
+  uint64_t value;
+
+  //The descriptor is non blocking, this fails harmlessly when it was not signalled
+  (void)!read(queue->fd, &value, sizeof(value));
+}
+
+void vcRxQueue_Enable(vcRxQueue_t *queue, bool enable)
+{
+  assert(queue != NULL);
+  pthread_mutex_lock(&queue->mutex);
+  queue->enabled = enable;
+  if(!enable)
+  {
+    queue->head = 0;
+    queue->count = 0;
+    ClearFd(queue);
+  }
+  pthread_mutex_unlock(&queue->mutex);
+}
+
+bool vcRxQueue_Push(vcRxQueue_t *queue, const uint8_t *frame, uint32_t len)
+{
+  vcHdmiCec_Frame_t *slot;
+  bool wake;
+
+  assert(queue != NULL);
+  assert(frame != NULL);
+
+  pthread_mutex_lock(&queue->mutex);
+  if(!queue->enabled)
+  {
+    pthread_mutex_unlock(&queue->mutex);
+    return false;
+  }
+  if(queue->count == queue->capacity || len > VC_HDMICEC_MAX_FRAME_LENGTH)
+  {
+    uint64_t now = vcStats_NowNs();
+    uint64_t drops = 0;
+
+    //Drops come in bursts when the reader falls behind, log at most one line per interval
+    queue->stats.dropped++;
+    queue->drops_unlogged++;
+    if(queue->drop_log_ns == 0 || now - queue->drop_log_ns >= VCRXQUEUE_DROP_LOG_INTERVAL_NS)
+    {
+      drops = queue->drops_unlogged;
+      queue->drops_unlogged = 0;
+      queue->drop_log_ns = now;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    if(drops == 0)
+    {
+      return true;
+    }
+    if(len > VC_HDMICEC_MAX_FRAME_LENGTH)
+    {
+      VC_LOG_ERROR("Rx queue: %llu frames dropped, last one %u bytes, larger than vcHdmiCec_Frame_t",
+                   (unsigned long long)drops, len);
+    }
+    else
+    {
+      VC_LOG_ERROR("Rx queue: %llu frames dropped, %u frames are waiting to be read",
+                   (unsigned long long)drops, queue->capacity);
+    }
+    return true;
+  }
+
+  slot = &queue->frames[(queue->head + queue->count) % queue->capacity];
+  memcpy(slot->data, frame, len);
+  slot->len = len;
+  wake = (queue->count == 0);
+  queue->count++;
+  queue->stats.queued++;
+  if(queue->count > queue->stats.maxDepth)
+  {
+    queue->stats.maxDepth = queue->count;
+  }
+  //Only the first frame wakes the reader up, the ones behind it are read in the same batch
+  if(wake)
+  {
+    uint64_t one = 1;
+    queue->stats.wakeups++;
+    (void)!write(queue->fd, &one, sizeof(one));
+  }
+  pthread_mutex_unlock(&queue->mutex);
+  return true;
+}
+
+uint32_t vcRxQueue_Read(vcRxQueue_t *queue, vcHdmiCec_Frame_t *frames, uint32_t maxFrames)
+{
+  uint32_t numFrames = 0;
+
+  assert(queue != NULL);
+  assert(frames != NULL || maxFrames == 0);
+
+  pthread_mutex_lock(&queue->mutex);
+  while(numFrames < maxFrames && queue->count > 0)
+  {
+    uint32_t chunk = queue->capacity - queue->head;
+
+    //Copy up to the end of the ring, then wrap around
+    if(chunk > queue->count)
+    {
+      chunk = queue->count;
+    }
+    if(chunk > maxFrames - numFrames)
+    {
+      chunk = maxFrames - numFrames;
+    }
+    memcpy(&frames[numFrames], &queue->frames[queue->head], chunk * sizeof(vcHdmiCec_Frame_t));
+    numFrames += chunk;
+    queue->head = (queue->head + chunk) % queue->capacity;
+    queue->count -= chunk;
+  }
+  if(numFrames > 0)
+  {
+    queue->stats.reads++;
+    queue->stats.framesRead += numFrames;
+    if(queue->count == 0)
+    {
+      ClearFd(queue);
+    }
+  }
+  pthread_mutex_unlock(&queue->mutex);
+  return numFrames;
+}
+
+void vcRxQueue_GetStats(vcRxQueue_t *queue, vcRxQueue_stats_t *stats)
+{
+  assert(queue != NULL);
+  assert(stats != NULL);
+  pthread_mutex_lock(&queue->mutex);
+  *stats = queue->stats;
+  stats->pending = queue->count;
+  stats->capacity = queue->capacity;
+  pthread_mutex_unlock(&queue->mutex);
+}
+
+void vcRxQueue_Print(vcRxQueue_t *queue)
+{
+  vcRxQueue_stats_t stats;
+  bool enabled;
+
+  assert(queue != NULL);
+  vcRxQueue_GetStats(queue, &stats);
+  pthread_mutex_lock(&queue->mutex);
+  enabled = queue->enabled;
+  pthread_mutex_unlock(&queue->mutex);
+
+  VC_LOG(">>>>>>> >>>>> >>>> >> >> >");
+  VC_LOG("Rx Queue Statistics (%s)", enabled ? "enabled" : "disabled");
+  VC_LOG("Queued         : %llu", (unsigned long long)stats.queued);
+  VC_LOG("Dropped        : %llu", (unsigned long long)stats.dropped);
+  VC_LOG("Pending        : %u of %u", stats.pending, stats.capacity);
+  VC_LOG("Max depth      : %u", stats.maxDepth);
+  VC_LOG("Wake ups       : %llu", (unsigned long long)stats.wakeups);
+  VC_LOG("Reads          : %llu", (unsigned long long)stats.reads);
+  if(stats.reads > 0)
+  {
+    VC_LOG("Frames / read  : %.1f", (double)stats.framesRead / (double)stats.reads);
+  }
+  VC_LOG("=================================");
+}
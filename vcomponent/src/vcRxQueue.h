@@ -0,0 +1,107 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __VCRXQUEUE_H
+#define __VCRXQUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "vcHdmiCec.h"
+
+#define VCRXQUEUE_DEFAULT_CAPACITY 256
+
+typedef struct vcRxQueue_s vcRxQueue_t;
+
+#define VCRXQUEUE_DROP_LOG_INTERVAL_NS 1000000000ULL
+
+typedef vcHdmiCec_RxQueueStats_t vcRxQueue_stats_t;
+
+/**
+ * @brief Creates a queue of received frames, signalled through an eventfd.
+ *
+ * The queue starts disabled, frames are only queued once it is enabled.
+ *
+ * @param capacity Number of frames the queue holds, frames are dropped beyond it.
+ * @return Pointer to the queue, NULL if it or its eventfd could not be created.
+ */
+vcRxQueue_t* vcRxQueue_Create(uint32_t capacity);
+
+/**
+ * @brief Closes the eventfd and releases the queue.
+ *
+ * @param queue Pointer to the queue.
+ */
+void vcRxQueue_Destroy(vcRxQueue_t *queue);
+
+/**
+ * @brief Returns the eventfd of the queue. It is readable while frames are queued.
+ *
+ * @param queue Pointer to the queue.
+ */
+int vcRxQueue_GetFd(vcRxQueue_t *queue);
+
+/**
+ * @brief Enables or disables the queue. Disabling discards the frames still queued.
+ *
+ * @param queue Pointer to the queue.
+ * @param enable true to queue the received frames.
+ */
+void vcRxQueue_Enable(vcRxQueue_t *queue, bool enable);
+
+/**
+ * @brief Adds a received frame. The eventfd is signalled when the queue was empty.
+ *
+ * @param queue Pointer to the queue.
+ * @param frame CEC frame, header block first.
+ * @param len Frame length in bytes.
+ * @return false if the queue is disabled and the frame goes to the Rx callback instead.
+ *         true if the queue took the frame, including when it is dropped because the queue is full.
+ */
+bool vcRxQueue_Push(vcRxQueue_t *queue, const uint8_t *frame, uint32_t len);
+
+/**
+ * @brief Moves up to maxFrames frames out of the queue, oldest first.
+ *
+ * The eventfd is cleared when the queue becomes empty, so a caller that reads until fewer than
+ * maxFrames frames are returned never misses a wake up.
+ *
+ * @param queue Pointer to the queue.
+ * @param frames Buffer receiving the frames.
+ * @param maxFrames Number of frames the buffer holds.
+ * @return Number of frames returned.
+ */
+uint32_t vcRxQueue_Read(vcRxQueue_t *queue, vcHdmiCec_Frame_t *frames, uint32_t maxFrames);
+
+/**
+ * @brief Copies the queue counters, with the frames pending and the capacity.
+ *
+ * @param queue Pointer to the queue.
+ * @param stats Receives the counters.
+ */
+void vcRxQueue_GetStats(vcRxQueue_t *queue, vcRxQueue_stats_t *stats);
+
+/**
+ * @brief Prints the queue counters.
+ *
+ * @param queue Pointer to the queue.
+ */
+void vcRxQueue_Print(vcRxQueue_t *queue);
+
+#endif //__VCRXQUEUE_H
@@ -0,0 +1,296 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "vcHdmiCec.h"
+#include "vcScheduler.h"
+#include "vcStats.h"
+
+typedef struct vcScheduler_event_s
+{
+  uint64_t deadline_ns;
+  vcScheduler_func_t func;
+  vcScheduler_release_t release;
+  void *data;
+  struct vcScheduler_event_s *next;
+} vcScheduler_event_t;
+
+struct vcScheduler_s
+{
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t condition;
+  vcScheduler_event_t *head; //Sorted by deadline, FIFO for equal deadlines
+  vcScheduler_event_t *tail;
+  uint32_t pending;
+  uint64_t retry_ns;         //The head is an event that asked to be retried, not before this time
+  uint32_t generation;       //Incremented by vcScheduler_Clear
+  bool exit_request;
+};
+
+static void DeadlineToTimespec(uint64_t deadline_ns, struct timespec *ts)
+{
+  ts->tv_sec = (time_t)(deadline_ns / 1000000000ULL);
+  ts->tv_nsec = (long)(deadline_ns % 1000000000ULL);
+}
+
+static void* SchedulerThread(void *arg)
+{
+  vcScheduler_t *scheduler = (vcScheduler_t *)arg;
+  vcScheduler_event_t *event;
+  struct timespec ts;
+  uint64_t now;
+  uint32_t generation;
+  bool done;
+
+  pthread_mutex_lock(&scheduler->mutex);
+  while(!scheduler->exit_request)
+  {
+    if(scheduler->head == NULL)
+    {
+      pthread_cond_wait(&scheduler->condition, &scheduler->mutex);
+      continue;
+    }
+    now = vcStats_NowNs();
+    if(scheduler->head->deadline_ns > now || scheduler->retry_ns > now)
+    {
+      //Woken up early when an earlier event is added or on exit
+      DeadlineToTimespec((scheduler->retry_ns > now) ? scheduler->retry_ns : scheduler->head->deadline_ns, &ts);
+      pthread_cond_timedwait(&scheduler->condition, &scheduler->mutex, &ts);
+      continue;
+    }
+    scheduler->retry_ns = 0;
+    event = scheduler->head;
+    scheduler->head = event->next;
+    if(scheduler->head == NULL)
+    {
+      scheduler->tail = NULL;
+    }
+    scheduler->pending--;
+
+    //The event may add further events, so it runs without the lock
+    generation = scheduler->generation;
+    pthread_mutex_unlock(&scheduler->mutex);
+    done = event->func(event->data);
+    pthread_mutex_lock(&scheduler->mutex);
+    if(done)
+    {
+      free(event);
+      continue;
+    }
+    if(generation != scheduler->generation)
+    {
+      //Cleared while it ran
+      pthread_mutex_unlock(&scheduler->mutex);
+      if(event->release != NULL)
+      {
+        event->release(event->data);
+      }
+      free(event);
+      pthread_mutex_lock(&scheduler->mutex);
+      continue;
+    }
+    //Back to the head, the events after it wait for it so that the order is kept
+    event->next = scheduler->head;
+    scheduler->head = event;
+    if(scheduler->tail == NULL)
+    {
+      scheduler->tail = event;
+    }
+    scheduler->pending++;
+    scheduler->retry_ns = vcStats_NowNs() + VCSCHEDULER_RETRY_NS;
+  }
+  pthread_mutex_unlock(&scheduler->mutex);
+  return NULL;
+}
+
+vcScheduler_t* vcScheduler_Create(void)
+{
+  vcScheduler_t *scheduler;
+  pthread_condattr_t attr;
+
+  scheduler = (vcScheduler_t *)calloc(1, sizeof(vcScheduler_t));
+  if(scheduler == NULL)
+  {
+    VC_LOG_ERROR("vcScheduler_Create: Out of memory");
+    return NULL;
+  }
+  pthread_mutex_init(&scheduler->mutex, NULL);
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&scheduler->condition, &attr);
+  pthread_condattr_destroy(&attr);
+
+  if(pthread_create(&scheduler->thread, NULL, SchedulerThread, scheduler) != 0)
+  {
+    VC_LOG_ERROR("vcScheduler_Create: Failed to create the scheduler thread");
+    pthread_cond_destroy(&scheduler->condition);
+    pthread_mutex_destroy(&scheduler->mutex);
+    free(scheduler);
+    return NULL;
+  }
+  return scheduler;
+}
+
+void vcScheduler_Destroy(vcScheduler_t *scheduler)
+{
+  if(scheduler == NULL)
+  {
+    return;
+  }
+  pthread_mutex_lock(&scheduler->mutex);
+  scheduler->exit_request = true;
+  pthread_cond_signal(&scheduler->condition);
+  pthread_mutex_unlock(&scheduler->mutex);
+  pthread_join(scheduler->thread, NULL);
+
+  vcScheduler_Clear(scheduler);
+  pthread_cond_destroy(&scheduler->condition);
+  pthread_mutex_destroy(&scheduler->mutex);
+  free(scheduler);
+}
+
+/* Inserts an event in deadline order, called with the mutex held */
+static void InsertEvent(vcScheduler_t *scheduler, vcScheduler_event_t *event)
+{
+  vcScheduler_event_t **pos;
+
+  if(scheduler->tail == NULL || scheduler->tail->deadline_ns <= event->deadline_ns)
+  {
+    //Deadlines are mostly added in order, so appending is the common case
+    if(scheduler->tail != NULL)
+    {
+      scheduler->tail->next = event;
+    }
+    else
+    {
+      scheduler->head = event;
+    }
+    scheduler->tail = event;
+  }
+  else
+  {
+    for(pos = &scheduler->head; (*pos)->deadline_ns <= event->deadline_ns; pos = &(*pos)->next);
+    event->next = *pos;
+    *pos = event;
+  }
+  scheduler->pending++;
+  if(scheduler->head == event)
+  {
+    pthread_cond_signal(&scheduler->condition);
+  }
+}
+
+bool vcScheduler_Add(vcScheduler_t *scheduler, uint64_t deadline_ns, vcScheduler_func_t func, vcScheduler_release_t release, void *data)
+{
+  return vcScheduler_AddGroup(scheduler, 1, &deadline_ns, func, release, &data);
+}
+
+bool vcScheduler_AddGroup(vcScheduler_t *scheduler, uint32_t count, const uint64_t *deadlines_ns, vcScheduler_func_t func,
+                          vcScheduler_release_t release, void **data)
+{
+  vcScheduler_event_t *events;
+  uint32_t i;
+
+  assert(scheduler != NULL);
+  assert(func != NULL);
+  assert(deadlines_ns != NULL || count == 0);
+  assert(data != NULL || count == 0);
+
+  //Every event is allocated before any is inserted, so a failure leaves nothing behind
+  events = NULL;
+  for(i = 0; i < count; i++)
+  {
+    vcScheduler_event_t *event = (vcScheduler_event_t *)malloc(sizeof(vcScheduler_event_t));
+    if(event == NULL)
+    {
+      VC_LOG_ERROR("vcScheduler_AddGroup: Out of memory");
+      while(events != NULL)
+      {
+        event = events->next;
+        free(events);
+        events = event;
+      }
+      return false;
+    }
+    event->deadline_ns = deadlines_ns[count - 1 - i];
+    event->func = func;
+    event->release = release;
+    event->data = data[count - 1 - i];
+    event->next = events;
+    events = event;
+  }
+
+  pthread_mutex_lock(&scheduler->mutex);
+  while(events != NULL)
+  {
+    vcScheduler_event_t *event = events;
+    events = event->next;
+    event->next = NULL;
+    InsertEvent(scheduler, event);
+  }
+  pthread_mutex_unlock(&scheduler->mutex);
+  return true;
+}
+
+uint32_t vcScheduler_Clear(vcScheduler_t *scheduler)
+{
+  vcScheduler_event_t *event, *next;
+  uint32_t count;
+
+  assert(scheduler != NULL);
+
+  pthread_mutex_lock(&scheduler->mutex);
+  event = scheduler->head;
+  count = scheduler->pending;
+  scheduler->head = NULL;
+  scheduler->tail = NULL;
+  scheduler->pending = 0;
+  scheduler->retry_ns = 0;
+  scheduler->generation++;
+  pthread_mutex_unlock(&scheduler->mutex);
+
+  while(event != NULL)
+  {
+    next = event->next;
+    if(event->release != NULL)
+    {
+      event->release(event->data);
+    }
+    free(event);
+    event = next;
+  }
+  return count;
+}
+
+uint32_t vcScheduler_Pending(vcScheduler_t *scheduler)
+{
+  uint32_t pending;
+
+  assert(scheduler != NULL);
+  pthread_mutex_lock(&scheduler->mutex);
+  pending = scheduler->pending;
+  pthread_mutex_unlock(&scheduler->mutex);
+  return pending;
+}
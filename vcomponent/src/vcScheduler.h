@@ -0,0 +1,97 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __VCSCHEDULER_H
+#define __VCSCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define VCSCHEDULER_RETRY_NS 1000000ULL
+
+typedef struct vcScheduler_s vcScheduler_t;
+
+/* Called on the scheduler thread when the deadline of an event is reached. Returning false
+ * runs the event again after VCSCHEDULER_RETRY_NS, before any later event */
+typedef bool (*vcScheduler_func_t)(void *data);
+
+/* Called instead of the event function when a pending event is discarded */
+typedef void (*vcScheduler_release_t)(void *data);
+
+/**
+ * @brief Creates a scheduler and starts its thread.
+ *
+ * @return Pointer to the scheduler, NULL on allocation failure.
+ */
+vcScheduler_t* vcScheduler_Create(void);
+
+/**
+ * @brief Stops the scheduler thread and releases the events that are still pending.
+ *
+ * @param scheduler Pointer to the scheduler.
+ */
+void vcScheduler_Destroy(vcScheduler_t *scheduler);
+
+/**
+ * @brief Schedules an event.
+ *
+ * Events run in deadline order. Events with the same deadline run in the order they were added.
+ * A deadline in the past runs as soon as possible.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param deadline_ns CLOCK_MONOTONIC time at which func is called, see vcStats_NowNs().
+ * @param func Function called with data on the scheduler thread.
+ * @param release Function called with data if the event is discarded before it runs. May be NULL.
+ * @param data Passed to func or release.
+ * @return false if the event could not be allocated.
+ */
+bool vcScheduler_Add(vcScheduler_t *scheduler, uint64_t deadline_ns, vcScheduler_func_t func, vcScheduler_release_t release, void *data);
+
+/**
+ * @brief Schedules a group of events, either all of them or none.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @param count Number of events.
+ * @param deadlines_ns Deadline of each event, see vcScheduler_Add().
+ * @param func Function called with the data of each event on the scheduler thread.
+ * @param release Function called with the data of an event discarded before it runs. May be NULL.
+ * @param data Data of each event.
+ * @return false if the events could not be allocated, none of them is scheduled then.
+ */
+bool vcScheduler_AddGroup(vcScheduler_t *scheduler, uint32_t count, const uint64_t *deadlines_ns, vcScheduler_func_t func,
+                          vcScheduler_release_t release, void **data);
+
+/**
+ * @brief Discards every pending event, calling its release function.
+ *
+ * An event running while this is called and asking to be retried is discarded as well.
+ *
+ * @param scheduler Pointer to the scheduler.
+ * @return Number of events discarded.
+ */
+uint32_t vcScheduler_Clear(vcScheduler_t *scheduler);
+
+/**
+ * @brief Returns the number of pending events.
+ *
+ * @param scheduler Pointer to the scheduler.
+ */
+uint32_t vcScheduler_Pending(vcScheduler_t *scheduler);
+
+#endif //__VCSCHEDULER_H
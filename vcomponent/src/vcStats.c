@@ -0,0 +1,213 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <time.h>
+
+#include "vcHdmiCec.h"
+#include "vcStats.h"
+
+static uint32_t HistogramBucket(uint64_t duration_ns)
+{
+  uint64_t us = duration_ns / 1000;
+  uint32_t bucket = 0;
+
+  while(us != 0 && bucket < VCSTATS_HISTOGRAM_BUCKETS - 1)
+  {
+    us >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+uint64_t vcStats_NowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+void vcStats_Init(vcStats_callback_t *stats, const char *name, uint64_t budget_ns)
+{
+  assert(stats != NULL);
+  assert(name != NULL);
+
+  memset(stats, 0, sizeof(vcStats_callback_t));
+  strncpy(stats->name, name, VCSTATS_MAX_NAME_LENGTH - 1);
+  stats->budget_ns = budget_ns;
+  pthread_mutex_init(&stats->mutex, NULL);
+}
+
+void vcStats_Deinit(vcStats_callback_t *stats)
+{
+  assert(stats != NULL);
+  pthread_mutex_destroy(&stats->mutex);
+}
+
+bool vcStats_Record(vcStats_callback_t *stats, uint8_t header, uint16_t opcode, uint64_t duration_ns)
+{
+  vcStats_opcode_t *op;
+  bool overrun;
+
+  assert(stats != NULL);
+  if(opcode >= VCSTATS_OPCODE_SLOTS)
+  {
+    opcode = VCSTATS_OPCODE_POLLING;
+  }
+  overrun = (stats->budget_ns != 0 && duration_ns > stats->budget_ns);
+
+  pthread_mutex_lock(&stats->mutex);
+  stats->count++;
+  stats->total_ns += duration_ns;
+  if(duration_ns > stats->max_ns)
+  {
+    stats->max_ns = duration_ns;
+  }
+  stats->histogram[HistogramBucket(duration_ns)]++;
+
+  op = &stats->opcodes[opcode];
+  op->count++;
+  op->total_ns += duration_ns;
+  if(duration_ns > op->max_ns)
+  {
+    op->max_ns = duration_ns;
+  }
+
+  if(overrun)
+  {
+    vcStats_event_t *event = &stats->events[stats->event_head];
+    stats->overruns++;
+    op->overruns++;
+    event->timestamp_ns = vcStats_NowNs();
+    event->duration_ns = duration_ns;
+    event->opcode = opcode;
+    event->header = header;
+    stats->event_head = (stats->event_head + 1) % VCSTATS_MAX_EVENTS;
+    if(stats->event_count < VCSTATS_MAX_EVENTS)
+    {
+      stats->event_count++;
+    }
+  }
+  pthread_mutex_unlock(&stats->mutex);
+
+  return overrun;
+}
+
+void vcStats_Print(vcStats_callback_t *stats)
+{
+  uint16_t worst[VCSTATS_MAX_WORST];
+  uint32_t numWorst = 0;
+
+  assert(stats != NULL);
+  pthread_mutex_lock(&stats->mutex);
+
+  VC_LOG(">>>>>>> >>>>> >>>> >> >> >");
+  VC_LOG("%s Callback Statistics", stats->name);
+  VC_LOG("Invocations    : %llu", (unsigned long long)stats->count);
+  VC_LOG("Budget         : %llu us", (unsigned long long)(stats->budget_ns / 1000));
+  VC_LOG("Overruns       : %llu", (unsigned long long)stats->overruns);
+  if(stats->count == 0)
+  {
+    VC_LOG("=================================");
+    pthread_mutex_unlock(&stats->mutex);
+    return;
+  }
+  VC_LOG("Mean           : %llu us", (unsigned long long)(stats->total_ns / stats->count / 1000));
+  VC_LOG("Max            : %llu us", (unsigned long long)(stats->max_ns / 1000));
+
+  VC_LOG("Histogram:");
+  for(int i = 0; i < VCSTATS_HISTOGRAM_BUCKETS; i++)
+  {
+    if(stats->histogram[i] == 0)
+    {
+      continue;
+    }
+    if(i == 0)
+    {
+      VC_LOG("  %10s < %8u us : %u", "", 1, stats->histogram[i]);
+    }
+    else
+    {
+      VC_LOG("  %8u us - %8u us : %u", 1U << (i - 1), 1U << i, stats->histogram[i]);
+    }
+  }
+
+  //Pick the opcodes with the highest max duration
+  for(uint16_t opcode = 0; opcode < VCSTATS_OPCODE_SLOTS; opcode++)
+  {
+    uint32_t pos;
+    if(stats->opcodes[opcode].count == 0)
+    {
+      continue;
+    }
+    for(pos = numWorst; pos > 0 && stats->opcodes[worst[pos - 1]].max_ns < stats->opcodes[opcode].max_ns; pos--)
+    {
+      if(pos < VCSTATS_MAX_WORST)
+      {
+        worst[pos] = worst[pos - 1];
+      }
+    }
+    if(pos < VCSTATS_MAX_WORST)
+    {
+      worst[pos] = opcode;
+      if(numWorst < VCSTATS_MAX_WORST)
+      {
+        numWorst++;
+      }
+    }
+  }
+  VC_LOG("Worst offenders by opcode:");
+  for(uint32_t i = 0; i < numWorst; i++)
+  {
+    vcStats_opcode_t *op = &stats->opcodes[worst[i]];
+    if(worst[i] == VCSTATS_OPCODE_POLLING)
+    {
+      VC_LOG("  Polling : count %u, max %llu us, mean %llu us, overruns %u", op->count,
+             (unsigned long long)(op->max_ns / 1000), (unsigned long long)(op->total_ns / op->count / 1000), op->overruns);
+    }
+    else
+    {
+      VC_LOG("  0x%02X    : count %u, max %llu us, mean %llu us, overruns %u", worst[i], op->count,
+             (unsigned long long)(op->max_ns / 1000), (unsigned long long)(op->total_ns / op->count / 1000), op->overruns);
+    }
+  }
+
+  if(stats->event_count > 0)
+  {
+    VC_LOG("Flight recorder (last %u overruns, oldest first):", stats->event_count);
+    for(uint32_t i = 0; i < stats->event_count; i++)
+    {
+      uint32_t index = (stats->event_head + VCSTATS_MAX_EVENTS - stats->event_count + i) % VCSTATS_MAX_EVENTS;
+      vcStats_event_t *event = &stats->events[index];
+      VC_LOG("  t=%llu.%06llu s header 0x%02X opcode %s0x%02X took %llu us",
+             (unsigned long long)(event->timestamp_ns / 1000000000ULL),
+             (unsigned long long)((event->timestamp_ns % 1000000000ULL) / 1000),
+             event->header,
+             (event->opcode == VCSTATS_OPCODE_POLLING) ? "(polling) " : "",
+             event->opcode & 0xFF,
+             (unsigned long long)(event->duration_ns / 1000));
+    }
+  }
+  VC_LOG("=================================");
+  pthread_mutex_unlock(&stats->mutex);
+}
@@ -0,0 +1,115 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __VCSTATS_H
+#define __VCSTATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/* Histogram bucket i counts durations in [2^(i-1), 2^i) microseconds, bucket 0 is < 1us */
+#define VCSTATS_HISTOGRAM_BUCKETS 24
+
+/* Opcodes 0x00..0xFF plus one slot for polling messages, which carry no opcode */
+#define VCSTATS_OPCODE_SLOTS      257
+#define VCSTATS_OPCODE_POLLING    256
+
+#define VCSTATS_MAX_EVENTS        32
+#define VCSTATS_MAX_WORST         5
+#define VCSTATS_MAX_NAME_LENGTH   16
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t overruns;
+  uint64_t total_ns;
+  uint64_t max_ns;
+} vcStats_opcode_t;
+
+/* Flight recorder entry, written every time a callback exceeds the budget */
+typedef struct
+{
+  uint64_t timestamp_ns;
+  uint64_t duration_ns;
+  uint16_t opcode;
+  uint8_t header;
+} vcStats_event_t;
+
+typedef struct
+{
+  char name[VCSTATS_MAX_NAME_LENGTH];
+  uint64_t budget_ns;
+
+  pthread_mutex_t mutex;
+  uint64_t count;
+  uint64_t overruns;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint32_t histogram[VCSTATS_HISTOGRAM_BUCKETS];
+  vcStats_opcode_t opcodes[VCSTATS_OPCODE_SLOTS];
+
+  vcStats_event_t events[VCSTATS_MAX_EVENTS];
+  uint32_t event_head;
+  uint32_t event_count;
+} vcStats_callback_t;
+
+/**
+ * @brief Returns the CLOCK_MONOTONIC time in nanoseconds.
+ */
+uint64_t vcStats_NowNs(void);
+
+/**
+ * @brief Initializes the callback statistics.
+ *
+ * @param stats Pointer to the statistics to be initialized.
+ * @param name Name used when printing, e.g. "Rx" or "Tx".
+ * @param budget_ns Callback duration above which an overrun is recorded. 0 disables the budget check.
+ */
+void vcStats_Init(vcStats_callback_t *stats, const char *name, uint64_t budget_ns);
+
+/**
+ * @brief Releases the resources held by the callback statistics.
+ *
+ * @param stats Pointer to the statistics.
+ */
+void vcStats_Deinit(vcStats_callback_t *stats);
+
+/**
+ * @brief Records the duration of one callback invocation.
+ *
+ * Updates the histogram and the per opcode counters. If the duration exceeds the budget,
+ * an event is added to the flight recorder.
+ *
+ * @param stats Pointer to the statistics.
+ * @param header CEC header block of the message passed to the callback.
+ * @param opcode Opcode of the message, or VCSTATS_OPCODE_POLLING.
+ * @param duration_ns Time spent in the callback.
+ * @return true if the callback exceeded the budget.
+ */
+bool vcStats_Record(vcStats_callback_t *stats, uint8_t header, uint16_t opcode, uint64_t duration_ns);
+
+/**
+ * @brief Prints the histogram, the worst offending opcodes and the flight recorder.
+ *
+ * @param stats Pointer to the statistics.
+ */
+void vcStats_Print(vcStats_callback_t *stats);
+
+#endif //__VCSTATS_H
@@ -0,0 +1,56 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __VCTRACE_H
+#define __VCTRACE_H
+
+/**
+ * USDT (User-level Statically Defined Tracing) probes for the vComponent.
+ *
+ * Probes are compiled in whenever <sys/sdt.h> (systemtap-sdt-dev) is available,
+ * unless the library is built with VCOMPONENT_NO_USDT=1. An inactive probe is a
+ * single nop, so they are safe to leave in the hot path. Without the header the
+ * probes compile to nothing.
+ *
+ * All probes are published under the provider "vchdmicec", e.g.
+ *   bpftrace -l 'usdt:./libRCECHal.so:vchdmicec:*'
+ */
+#if !defined(VCOMPONENT_NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define VCOMPONENT_USDT
+#endif
+#endif
+
+#ifdef VCOMPONENT_USDT
+#include <sys/sdt.h>
+
+#define VC_TRACE0(name)                 DTRACE_PROBE(vchdmicec, name)
+#define VC_TRACE1(name, a)              DTRACE_PROBE1(vchdmicec, name, a)
+#define VC_TRACE2(name, a, b)           DTRACE_PROBE2(vchdmicec, name, a, b)
+#define VC_TRACE3(name, a, b, c)        DTRACE_PROBE3(vchdmicec, name, a, b, c)
+#define VC_TRACE4(name, a, b, c, d)     DTRACE_PROBE4(vchdmicec, name, a, b, c, d)
+#else
+#define VC_TRACE0(name)                 do { } while (0)
+#define VC_TRACE1(name, a)              do { (void)(a); } while (0)
+#define VC_TRACE2(name, a, b)           do { (void)(a); (void)(b); } while (0)
+#define VC_TRACE3(name, a, b, c)        do { (void)(a); (void)(b); (void)(c); } while (0)
+#define VC_TRACE4(name, a, b, c, d)     do { (void)(a); (void)(b); (void)(c); (void)(d); } while (0)
+#endif
+
+#endif //__VCTRACE_H
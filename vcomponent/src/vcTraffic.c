@@ -0,0 +1,349 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "vcHdmiCec.h"
+#include "vcTraffic.h"
+#include "vcStats.h"
+
+/* Next arrival of one stream, rescheduled until the run ends */
+typedef struct
+{
+  vcTraffic_t *traffic;
+  uint32_t stream;
+  uint32_t run_id;
+  uint64_t deadline_ns;
+  unsigned int seed;
+} vcTraffic_arrival_event_t;
+
+struct vcTraffic_s
+{
+  vcScheduler_t *scheduler;
+  vcTraffic_emit_t emit;
+  void *ctx;
+
+  pthread_mutex_t mutex;
+  vcTraffic_config_t config;
+  uint32_t run_id;
+  bool running;
+  bool reported;
+  uint64_t start_ns;
+  uint64_t end_ns;
+  uint64_t generated;
+  uint64_t dropped;
+  uint64_t delivered;
+  uint64_t last_delivery_ns;
+  vcStats_callback_t latency;
+};
+
+static uint64_t NextInterval(vcTraffic_stream_t *stream, unsigned int *seed)
+{
+  double mean_ns = 1000000000.0 / stream->rate;
+  double u;
+
+  if(stream->arrival == VCTRAFFIC_ARRIVAL_CONSTANT)
+  {
+    return (uint64_t)mean_ns;
+  }
+  //Inverse transform sampling of the exponential distribution, u in [0, 1)
+  u = (double)rand_r(seed) / ((double)RAND_MAX + 1.0);
+  return (uint64_t)(-log(1.0 - u) * mean_ns);
+}
+
+/* Called with the mutex held. Returns true if the report is complete and should be printed */
+static bool Finish(vcTraffic_t *traffic, uint64_t end_ns)
+{
+  traffic->running = false;
+  traffic->end_ns = end_ns;
+  VC_LOG("Traffic: generation finished, %llu frames generated, %llu dropped",
+         (unsigned long long)traffic->generated, (unsigned long long)traffic->dropped);
+  if(!traffic->reported && traffic->delivered + traffic->dropped >= traffic->generated)
+  {
+    traffic->reported = true;
+    return true;
+  }
+  return false;
+}
+
+static void ArrivalRelease(void *data)
+{
+  free(data);
+}
+
+/* Always done, frames the message queue cannot take are dropped and counted */
+static bool Arrival(void *data)
+{
+  vcTraffic_arrival_event_t *event = (vcTraffic_arrival_event_t *)data;
+  vcTraffic_t *traffic = event->traffic;
+  vcTraffic_stream_t *stream;
+  bool report = false;
+
+  pthread_mutex_lock(&traffic->mutex);
+  if(!traffic->running || event->run_id != traffic->run_id)
+  {
+    pthread_mutex_unlock(&traffic->mutex);
+    free(event);
+    return true;
+  }
+  if(traffic->config.duration_ns != 0 && event->deadline_ns - traffic->start_ns >= traffic->config.duration_ns)
+  {
+    report = Finish(traffic, traffic->start_ns + traffic->config.duration_ns);
+    pthread_mutex_unlock(&traffic->mutex);
+    free(event);
+    if(report)
+    {
+      vcTraffic_Print(traffic);
+    }
+    return true;
+  }
+
+  stream = &traffic->config.streams[event->stream];
+  for(uint32_t i = 0; i < stream->burst && traffic->running; i++)
+  {
+    if(traffic->config.count != 0 && traffic->generated >= traffic->config.count)
+    {
+      report = Finish(traffic, vcStats_NowNs());
+      break;
+    }
+    traffic->generated++;
+    stream->generated++;
+    if(!traffic->emit(traffic->ctx, stream->frame, stream->len, vcStats_NowNs()))
+    {
+      traffic->dropped++;
+      stream->dropped++;
+    }
+  }
+  if(traffic->running && traffic->config.count != 0 && traffic->generated >= traffic->config.count)
+  {
+    report = Finish(traffic, vcStats_NowNs());
+  }
+
+  if(traffic->running)
+  {
+    //Open loop: the next arrival does not depend on how long this one took to be delivered
+    event->deadline_ns += NextInterval(stream, &event->seed);
+    if(vcScheduler_Add(traffic->scheduler, event->deadline_ns, Arrival, ArrivalRelease, event))
+    {
+      event = NULL;
+    }
+    else
+    {
+      report = Finish(traffic, vcStats_NowNs());
+    }
+  }
+  pthread_mutex_unlock(&traffic->mutex);
+  free(event);
+  if(report)
+  {
+    vcTraffic_Print(traffic);
+  }
+  return true;
+}
+
+vcTraffic_t* vcTraffic_Create(vcScheduler_t *scheduler, vcTraffic_emit_t emit, void *ctx)
+{
+  vcTraffic_t *traffic;
+
+  assert(scheduler != NULL);
+  assert(emit != NULL);
+
+  traffic = (vcTraffic_t *)calloc(1, sizeof(vcTraffic_t));
+  if(traffic == NULL)
+  {
+    VC_LOG_ERROR("vcTraffic_Create: Out of memory");
+    return NULL;
+  }
+  traffic->scheduler = scheduler;
+  traffic->emit = emit;
+  traffic->ctx = ctx;
+  pthread_mutex_init(&traffic->mutex, NULL);
+  vcStats_Init(&traffic->latency, "Delivery", 0);
+  return traffic;
+}
+
+void vcTraffic_Destroy(vcTraffic_t *traffic)
+{
+  if(traffic == NULL)
+  {
+    return;
+  }
+  vcStats_Deinit(&traffic->latency);
+  pthread_mutex_destroy(&traffic->mutex);
+  free(traffic);
+}
+
+bool vcTraffic_Start(vcTraffic_t *traffic, const vcTraffic_config_t *config)
+{
+  vcTraffic_arrival_event_t *event;
+
+  assert(traffic != NULL);
+  assert(config != NULL);
+
+  if(config->num_streams == 0 || config->num_streams > VCTRAFFIC_MAX_STREAMS)
+  {
+    VC_LOG_ERROR("vcTraffic_Start: %u streams, expected 1 to %u", config->num_streams, VCTRAFFIC_MAX_STREAMS);
+    return false;
+  }
+  for(uint32_t i = 0; i < config->num_streams; i++)
+  {
+    if(config->streams[i].rate == 0 || config->streams[i].burst == 0 || config->streams[i].len == 0)
+    {
+      VC_LOG_ERROR("vcTraffic_Start: stream %u has no rate, burst or frame", i);
+      return false;
+    }
+    //A higher rate rounds the interval down to 0 and the scheduler would spin on the arrivals
+    if(config->streams[i].rate > VCTRAFFIC_MAX_RATE)
+    {
+      VC_LOG_ERROR("vcTraffic_Start: stream %u rate %u above %u frames/s", i, config->streams[i].rate, VCTRAFFIC_MAX_RATE);
+      return false;
+    }
+  }
+
+  pthread_mutex_lock(&traffic->mutex);
+  //Arrivals of the previous run see the new run_id and stop
+  traffic->run_id++;
+  traffic->config = *config;
+  for(uint32_t i = 0; i < traffic->config.num_streams; i++)
+  {
+    traffic->config.streams[i].generated = 0;
+    traffic->config.streams[i].dropped = 0;
+  }
+  traffic->generated = 0;
+  traffic->dropped = 0;
+  traffic->delivered = 0;
+  traffic->reported = false;
+  traffic->start_ns = vcStats_NowNs();
+  traffic->end_ns = 0;
+  traffic->last_delivery_ns = traffic->start_ns;
+  vcStats_Deinit(&traffic->latency);
+  vcStats_Init(&traffic->latency, "Delivery", 0);
+  traffic->running = true;
+
+  for(uint32_t i = 0; i < traffic->config.num_streams; i++)
+  {
+    event = (vcTraffic_arrival_event_t *)malloc(sizeof(vcTraffic_arrival_event_t));
+    if(event == NULL)
+    {
+      Finish(traffic, traffic->start_ns);
+      pthread_mutex_unlock(&traffic->mutex);
+      return false;
+    }
+    event->traffic = traffic;
+    event->stream = i;
+    event->run_id = traffic->run_id;
+    event->seed = traffic->config.seed + i;
+    event->deadline_ns = traffic->start_ns + NextInterval(&traffic->config.streams[i], &event->seed);
+    if(!vcScheduler_Add(traffic->scheduler, event->deadline_ns, Arrival, ArrivalRelease, event))
+    {
+      free(event);
+      Finish(traffic, traffic->start_ns);
+      pthread_mutex_unlock(&traffic->mutex);
+      return false;
+    }
+  }
+  VC_LOG("Traffic: started %u streams, duration %llu ms, count %llu", traffic->config.num_streams,
+         (unsigned long long)(traffic->config.duration_ns / 1000000), (unsigned long long)traffic->config.count);
+  pthread_mutex_unlock(&traffic->mutex);
+  return true;
+}
+
+void vcTraffic_Stop(vcTraffic_t *traffic)
+{
+  bool report = false;
+
+  assert(traffic != NULL);
+  pthread_mutex_lock(&traffic->mutex);
+  if(traffic->running)
+  {
+    report = Finish(traffic, vcStats_NowNs());
+  }
+  traffic->run_id++;
+  pthread_mutex_unlock(&traffic->mutex);
+  if(report)
+  {
+    vcTraffic_Print(traffic);
+  }
+}
+
+void vcTraffic_RecordDelivery(vcTraffic_t *traffic, const uint8_t *frame, uint32_t len, uint64_t generated_ns, uint64_t delivered_ns)
+{
+  bool report = false;
+
+  assert(traffic != NULL);
+  assert(frame != NULL);
+
+  pthread_mutex_lock(&traffic->mutex);
+  vcStats_Record(&traffic->latency, frame[0], (len > 1) ? frame[1] : VCSTATS_OPCODE_POLLING, delivered_ns - generated_ns);
+  traffic->delivered++;
+  traffic->last_delivery_ns = delivered_ns;
+  if(!traffic->running && !traffic->reported && traffic->delivered + traffic->dropped >= traffic->generated)
+  {
+    traffic->reported = true;
+    report = true;
+  }
+  pthread_mutex_unlock(&traffic->mutex);
+  if(report)
+  {
+    vcTraffic_Print(traffic);
+  }
+}
+
+static unsigned long long Rate(uint64_t count, uint64_t elapsed_ns)
+{
+  if(elapsed_ns == 0)
+  {
+    return 0;
+  }
+  return (unsigned long long)((count * 1000000000ULL) / elapsed_ns);
+}
+
+void vcTraffic_Print(vcTraffic_t *traffic)
+{
+  uint64_t elapsed_ns;
+
+  assert(traffic != NULL);
+  pthread_mutex_lock(&traffic->mutex);
+  elapsed_ns = (traffic->running ? vcStats_NowNs() : traffic->end_ns) - traffic->start_ns;
+
+  VC_LOG(">>>>>>> >>>>> >>>> >> >> >");
+  VC_LOG("Traffic Generator");
+  VC_LOG("State          : %s", traffic->running ? "Running" : "Stopped");
+  VC_LOG("Generation     : %llu ms", (unsigned long long)(elapsed_ns / 1000000));
+  VC_LOG("Generated      : %llu (%llu frames/s)", (unsigned long long)traffic->generated, Rate(traffic->generated, elapsed_ns));
+  VC_LOG("Dropped        : %llu", (unsigned long long)traffic->dropped);
+  VC_LOG("Delivered      : %llu (%llu frames/s)", (unsigned long long)traffic->delivered,
+         Rate(traffic->delivered, traffic->last_delivery_ns - traffic->start_ns));
+  for(uint32_t i = 0; i < traffic->config.num_streams; i++)
+  {
+    vcTraffic_stream_t *stream = &traffic->config.streams[i];
+    VC_LOG("  Stream %u: header 0x%02X opcode 0x%02X, %u/s %s x%u, generated %llu, dropped %llu", i,
+           stream->frame[0], (stream->len > 1) ? stream->frame[1] : 0,
+           stream->rate, (stream->arrival == VCTRAFFIC_ARRIVAL_POISSON) ? "poisson" : "constant", stream->burst,
+           (unsigned long long)stream->generated, (unsigned long long)stream->dropped);
+  }
+  //Time from generation to the return of the Rx callback, queueing included
+  vcStats_Print(&traffic->latency);
+  pthread_mutex_unlock(&traffic->mutex);
+}
@@ -0,0 +1,123 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef __VCTRAFFIC_H
+#define __VCTRAFFIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "vcCommand.h"
+#include "vcScheduler.h"
+
+#define VCTRAFFIC_MAX_STREAMS 16
+#define VCTRAFFIC_MAX_RATE    1000000   /* Arrivals per second of a stream, 1 us apart */
+
+typedef enum
+{
+  VCTRAFFIC_ARRIVAL_CONSTANT = 0,   /* Fixed interval of 1/rate */
+  VCTRAFFIC_ARRIVAL_POISSON         /* Exponentially distributed intervals with a mean of 1/rate */
+} vcTraffic_arrival_t;
+
+/* One source of frames, e.g. one opcode sent by one device */
+typedef struct
+{
+  uint8_t frame[VCCOMMAND_MAX_DATA_SIZE];
+  uint32_t len;
+  uint32_t rate;                    /* Arrivals per second */
+  vcTraffic_arrival_t arrival;
+  uint32_t burst;                   /* Frames queued back to back at each arrival */
+  uint64_t generated;
+  uint64_t dropped;
+} vcTraffic_stream_t;
+
+typedef struct
+{
+  vcTraffic_stream_t streams[VCTRAFFIC_MAX_STREAMS];
+  uint32_t num_streams;
+  uint64_t duration_ns;             /* 0 for no time limit */
+  uint64_t count;                   /* Total number of frames over all the streams, 0 for no limit */
+  uint32_t seed;                    /* Seed of the Poisson arrivals, so that a run can be repeated */
+} vcTraffic_config_t;
+
+typedef struct vcTraffic_s vcTraffic_t;
+
+/**
+ * @brief Queues a generated frame for delivery to the Rx callback.
+ *
+ * @return false if the frame was dropped.
+ */
+typedef bool (*vcTraffic_emit_t)(void *ctx, const uint8_t *frame, uint32_t len, uint64_t generated_ns);
+
+/**
+ * @brief Creates a traffic generator.
+ *
+ * @param scheduler Scheduler on which the arrivals run. It must be destroyed before the generator.
+ * @param emit Function called on the scheduler thread for every generated frame.
+ * @param ctx Passed to emit.
+ * @return Pointer to the generator, NULL on allocation failure.
+ */
+vcTraffic_t* vcTraffic_Create(vcScheduler_t *scheduler, vcTraffic_emit_t emit, void *ctx);
+
+/**
+ * @brief Releases the traffic generator.
+ *
+ * @param traffic Pointer to the generator.
+ */
+void vcTraffic_Destroy(vcTraffic_t *traffic);
+
+/**
+ * @brief Starts a run, stopping the current one if any. The metrics of the previous run are cleared.
+ *
+ * @param traffic Pointer to the generator.
+ * @param config Streams and limits of the run. Copied.
+ * @return false if the config has no stream, a stream with a rate of 0 or above VCTRAFFIC_MAX_RATE,
+ *         or the first arrivals could not be scheduled.
+ */
+bool vcTraffic_Start(vcTraffic_t *traffic, const vcTraffic_config_t *config);
+
+/**
+ * @brief Stops generating frames. Frames already queued are still delivered and counted.
+ *
+ * @param traffic Pointer to the generator.
+ */
+void vcTraffic_Stop(vcTraffic_t *traffic);
+
+/**
+ * @brief Records the delivery of a generated frame, once the Rx callback has returned.
+ *
+ * With the Rx eventfd queue or the Rx dispatcher pool, the frame has only been queued for the
+ * middleware at that point.
+ *
+ * @param traffic Pointer to the generator.
+ * @param frame Frame passed to the Rx callback.
+ * @param len Length of the frame.
+ * @param generated_ns Time at which the frame was generated.
+ * @param delivered_ns Time at which the Rx callback returned, or the frame was queued for the middleware.
+ */
+void vcTraffic_RecordDelivery(vcTraffic_t *traffic, const uint8_t *frame, uint32_t len, uint64_t generated_ns, uint64_t delivered_ns);
+
+/**
+ * @brief Prints the generated, dropped and delivered counts and rates, and the delivery latency.
+ *
+ * @param traffic Pointer to the generator.
+ */
+void vcTraffic_Print(vcTraffic_t *traffic);
+
+#endif //__VCTRAFFIC_H
@@ -0,0 +1,595 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file vcCaptureDiff.c
+ *
+ * Compares a capture against a golden capture (see vcCapture.h), e.g. the capture of a replay
+ * against a new HAL or middleware build with the capture of the same replay on a known good build.
+ *
+ * Frames are aligned by content and by time from the first frame of each capture. Two frames match
+ * when they have the same bytes and direction, within the match window of each other. The captures
+ * are aligned on their longest common subsequence of matching frames (Myers' diff), so a dropped
+ * frame does not shift the frames that follow it, even when the bus repeats the same frames.
+ * Frames left out of the alignment on both sides, with a match in the window, were reordered.
+ * The tool then reports:
+ *
+ *  - missing frames, in the golden capture only
+ *  - extra frames, in the test capture only
+ *  - reordered frames, matched but out of order with the frames around them
+ *  - the timing drift of the matched frames per opcode, and the frames outside the tolerance
+ *
+ * The exit code is 0 when the captures agree within the tolerances, 1 when they differ and -1 on error.
+ *
+ * Usage: vcCaptureDiff [options] <golden> <test>
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "vcCapture.h"
+#include "vcCommand.h"
+
+#define DEFAULT_WINDOW_MS           1000
+#define DEFAULT_TOLERANCE_MS        50
+#define DEFAULT_MAX_REPORTED        20
+/* Opcodes 0x00..0xFF plus one slot for polling messages, which carry no opcode */
+#define OPCODE_SLOTS                257
+#define OPCODE_POLLING              256
+#define UNMATCHED                   UINT32_MAX
+
+typedef struct
+{
+  uint64_t timestamp_ns;            /* From the first frame of the capture */
+  uint64_t offset;
+  uint64_t hash;
+  uint32_t match;                   /* Index of the matched frame in the other capture, or UNMATCHED */
+  uint16_t opcode;
+  bool reordered;
+} diff_frame_t;
+
+typedef struct
+{
+  const char *path;
+  vcCapture_reader_t *reader;
+  diff_frame_t *frames;
+  uint32_t count;
+} diff_capture_t;
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t over;
+  int64_t total_ns;
+  int64_t max_ns;                   /* Largest drift in absolute value, with its sign */
+} diff_drift_t;
+
+typedef struct
+{
+  diff_capture_t *golden;
+  diff_capture_t *test;
+  uint64_t window_ns;
+  int64_t *forward;                 /* Furthest reaching paths of Myers' algorithm, indexed by diagonal */
+  int64_t *backward;
+  int64_t center;
+} diff_context_t;
+
+typedef struct
+{
+  int kind;
+  uint64_t window_ns;
+  uint64_t tolerance_ns;
+  uint32_t max_reported;
+} diff_options_t;
+
+static bool gVerbose = false;
+
+/* vcCapture logs through UT_logPrefix(). Errors are always shown, the rest with -v */
+void UT_logPrefix(const char *file, int line, const char *prefix, const char *format, ...)
+{
+  va_list args;
+
+  if(!gVerbose && strstr(prefix, "ERROR") == NULL)
+  {
+    return;
+  }
+  fprintf(stderr, "%s", prefix);
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fprintf(stderr, "\n");
+}
+
+/* FNV-1a over the direction and the frame bytes */
+static uint64_t FrameHash(const vcCapture_record_t *record)
+{
+  uint64_t hash = 0xCBF29CE484222325ULL;
+
+  hash = (hash ^ (uint8_t)record->kind) * 0x100000001B3ULL;
+  for(uint32_t i = 0; i < record->len; i++)
+  {
+    hash = (hash ^ record->frame[i]) * 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+static bool SameFrame(diff_capture_t *a, uint32_t i, diff_capture_t *b, uint32_t j)
+{
+  vcCapture_record_t x, y;
+
+  if(a->frames[i].hash != b->frames[j].hash)
+  {
+    return false;
+  }
+  //Hashes can collide, the bytes decide
+  vcCapture_ReadAt(a->reader, a->frames[i].offset, &x);
+  vcCapture_ReadAt(b->reader, b->frames[j].offset, &y);
+  return x.kind == y.kind && x.len == y.len && memcmp(x.frame, y.frame, x.len) == 0;
+}
+
+static bool LoadCapture(diff_capture_t *capture, const char *path, int kind)
+{
+  vcCapture_record_t record;
+  uint32_t size = 1024;
+  uint64_t first_ns = 0;
+
+  memset(capture, 0, sizeof(diff_capture_t));
+  capture->path = path;
+  capture->reader = vcCapture_OpenReader(path);
+  if(capture->reader == NULL)
+  {
+    return false;
+  }
+  capture->frames = (diff_frame_t *)malloc(sizeof(diff_frame_t) * size);
+  while(capture->frames != NULL && vcCapture_Next(capture->reader, &record))
+  {
+    diff_frame_t *frame;
+    if(kind != -1 && (int)record.kind != kind)
+    {
+      continue;
+    }
+    if(capture->count == size)
+    {
+      diff_frame_t *frames = (diff_frame_t *)realloc(capture->frames, sizeof(diff_frame_t) * size * 2);
+      if(frames == NULL)
+      {
+        free(capture->frames);
+        capture->frames = NULL;
+        break;
+      }
+      capture->frames = frames;
+      size *= 2;
+    }
+    if(capture->count == 0)
+    {
+      first_ns = record.timestamp_ns;
+    }
+    frame = &capture->frames[capture->count++];
+    frame->timestamp_ns = record.timestamp_ns - first_ns;
+    frame->offset = record.offset;
+    frame->hash = FrameHash(&record);
+    frame->match = UNMATCHED;
+    frame->opcode = (record.len > 1) ? record.frame[1] : OPCODE_POLLING;
+    frame->reordered = false;
+  }
+  if(capture->frames == NULL)
+  {
+    fprintf(stderr, "Out of memory reading [%s]\n", path);
+    vcCapture_CloseReader(capture->reader);
+    return false;
+  }
+  return true;
+}
+
+static void FreeCapture(diff_capture_t *capture)
+{
+  free(capture->frames);
+  vcCapture_CloseReader(capture->reader);
+}
+
+/* Frames match when they have the same bytes and direction, within the window of each other */
+static bool Match(diff_context_t *ctx, uint32_t i, uint32_t j)
+{
+  uint64_t a = ctx->golden->frames[i].timestamp_ns, b = ctx->test->frames[j].timestamp_ns;
+
+  if(ctx->golden->frames[i].hash != ctx->test->frames[j].hash || ((a > b) ? a - b : b - a) > ctx->window_ns)
+  {
+    return false;
+  }
+  return SameFrame(ctx->golden, i, ctx->test, j);
+}
+
+static void Pair(diff_context_t *ctx, uint32_t i, uint32_t j)
+{
+  ctx->golden->frames[i].match = j;
+  ctx->test->frames[j].match = i;
+}
+
+#define VF(k) ctx->forward[ctx->center + (k)]
+#define VB(k) ctx->backward[ctx->center + (k)]
+
+/* Myers' middle snake: a stretch of matching frames on a shortest edit path between
+ * golden[a0, a1) and test[b0, b1). The snake runs from (x, y) to (u, v), relative to a0 and b0. */
+static void MiddleSnake(diff_context_t *ctx, uint32_t a0, uint32_t a1, uint32_t b0, uint32_t b1,
+                        int64_t *x_out, int64_t *y_out, int64_t *u_out, int64_t *v_out)
+{
+  int64_t n = a1 - a0, m = b1 - b0, delta = n - m;
+  bool odd = (delta & 1) != 0;
+
+  VF(1) = 0;
+  VB(1) = 0;
+  for(int64_t d = 0; d <= (n + m + 1) / 2; d++)
+  {
+    for(int64_t k = -d; k <= d; k += 2)
+    {
+      int64_t x = (k == -d || (k != d && VF(k - 1) < VF(k + 1))) ? VF(k + 1) : VF(k - 1) + 1;
+      int64_t y = x - k, sx = x, sy = y;
+      while(x < n && y < m && Match(ctx, a0 + x, b0 + y))
+      {
+        x++;
+        y++;
+      }
+      VF(k) = x;
+      if(odd && delta - k >= -(d - 1) && delta - k <= d - 1 && VF(k) + VB(delta - k) >= n)
+      {
+        *x_out = sx;
+        *y_out = sy;
+        *u_out = x;
+        *v_out = y;
+        return;
+      }
+    }
+    for(int64_t k = -d; k <= d; k += 2)
+    {
+      int64_t x = (k == -d || (k != d && VB(k - 1) < VB(k + 1))) ? VB(k + 1) : VB(k - 1) + 1;
+      int64_t y = x - k, sx = x, sy = y;
+      while(x < n && y < m && Match(ctx, a1 - 1 - x, b1 - 1 - y))
+      {
+        x++;
+        y++;
+      }
+      VB(k) = x;
+      if(!odd && delta - k >= -d && delta - k <= d && VB(k) + VF(delta - k) >= n)
+      {
+        *x_out = n - x;
+        *y_out = m - y;
+        *u_out = n - sx;
+        *v_out = m - sy;
+        return;
+      }
+    }
+  }
+  //Not reached, the paths always meet
+  *x_out = *u_out = n;
+  *y_out = *v_out = m;
+}
+
+/* Pairs the frames of the longest common subsequence of golden[a0, a1) and test[b0, b1) */
+static void Align(diff_context_t *ctx, uint32_t a0, uint32_t a1, uint32_t b0, uint32_t b1)
+{
+  int64_t x, y, u, v;
+
+  while(a0 < a1 && b0 < b1 && Match(ctx, a0, b0))
+  {
+    Pair(ctx, a0++, b0++);
+  }
+  while(a0 < a1 && b0 < b1 && Match(ctx, a1 - 1, b1 - 1))
+  {
+    Pair(ctx, --a1, --b1);
+  }
+  if(a0 == a1 || b0 == b1)
+  {
+    return;
+  }
+  MiddleSnake(ctx, a0, a1, b0, b1, &x, &y, &u, &v);
+  Align(ctx, a0, a0 + x, b0, b0 + y);
+  for(int64_t i = x, j = y; i < u; i++, j++)
+  {
+    Pair(ctx, a0 + i, b0 + j);
+  }
+  Align(ctx, a0 + u, a1, b0 + v, b1);
+}
+
+#undef VF
+#undef VB
+
+static int CompareByHash(const void *a, const void *b, void *arg)
+{
+  const diff_frame_t *frames = (const diff_frame_t *)arg;
+  const diff_frame_t *x = &frames[*(const uint32_t *)a], *y = &frames[*(const uint32_t *)b];
+
+  if(x->hash != y->hash)
+  {
+    return (x->hash > y->hash) ? 1 : -1;
+  }
+  //Same content, keep the time order
+  return (*(const uint32_t *)a > *(const uint32_t *)b) - (*(const uint32_t *)a < *(const uint32_t *)b);
+}
+
+/* A frame left out of the alignment on both sides, with the same content within the window, was
+ * reordered rather than missing and extra. Pairs them, earliest first. */
+static bool FindReordered(diff_context_t *ctx)
+{
+  diff_capture_t *golden = ctx->golden, *test = ctx->test;
+  uint32_t *extra, num_extra = 0;
+
+  extra = (uint32_t *)malloc(sizeof(uint32_t) * (test->count + 1));
+  if(extra == NULL)
+  {
+    fprintf(stderr, "Out of memory\n");
+    return false;
+  }
+  for(uint32_t j = 0; j < test->count; j++)
+  {
+    if(test->frames[j].match == UNMATCHED)
+    {
+      extra[num_extra++] = j;
+    }
+  }
+  qsort_r(extra, num_extra, sizeof(uint32_t), CompareByHash, test->frames);
+
+  for(uint32_t i = 0; i < golden->count && num_extra > 0; i++)
+  {
+    uint32_t lo = 0, hi = num_extra;
+    if(golden->frames[i].match != UNMATCHED)
+    {
+      continue;
+    }
+    while(lo < hi)
+    {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if(test->frames[extra[mid]].hash < golden->frames[i].hash)
+      {
+        lo = mid + 1;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+    for(; lo < num_extra && test->frames[extra[lo]].hash == golden->frames[i].hash; lo++)
+    {
+      if(test->frames[extra[lo]].match == UNMATCHED && Match(ctx, i, extra[lo]))
+      {
+        Pair(ctx, i, extra[lo]);
+        golden->frames[i].reordered = true;
+        break;
+      }
+    }
+  }
+  free(extra);
+  return true;
+}
+
+static bool Compare(diff_capture_t *golden, diff_capture_t *test, uint64_t window_ns)
+{
+  diff_context_t ctx;
+  size_t size = (size_t)golden->count + test->count + 3;
+  bool result;
+
+  ctx.golden = golden;
+  ctx.test = test;
+  ctx.window_ns = window_ns;
+  ctx.center = golden->count + test->count + 1;
+  ctx.forward = (int64_t *)malloc(sizeof(int64_t) * 2 * size);
+  ctx.backward = (int64_t *)malloc(sizeof(int64_t) * 2 * size);
+  if(ctx.forward == NULL || ctx.backward == NULL)
+  {
+    free(ctx.forward);
+    free(ctx.backward);
+    fprintf(stderr, "Out of memory\n");
+    return false;
+  }
+  Align(&ctx, 0, golden->count, 0, test->count);
+  result = FindReordered(&ctx);
+  free(ctx.forward);
+  free(ctx.backward);
+  return result;
+}
+
+static void PrintFrame(diff_capture_t *capture, uint32_t index, const char *prefix)
+{
+  vcCapture_record_t record;
+  const char *name;
+
+  vcCapture_ReadAt(capture->reader, capture->frames[index].offset, &record);
+  name = (capture->frames[index].opcode == OPCODE_POLLING) ? "Polling" : vcCommand_GetOpCodeString(capture->frames[index].opcode);
+  printf("  %s%12.6f %s %2u -> %2u %-26s", prefix, (double)capture->frames[index].timestamp_ns / 1e9,
+         (record.kind == VCCAPTURE_RECORD_RX) ? "RX" : "TX", record.frame[0] >> 4, record.frame[0] & 0x0F,
+         (name != NULL) ? name : "Unknown");
+  for(uint32_t i = 0; i < record.len; i++)
+  {
+    printf(" %02X", record.frame[i]);
+  }
+  printf("\n");
+}
+
+static int64_t Drift(diff_capture_t *golden, diff_capture_t *test, uint32_t i)
+{
+  return (int64_t)test->frames[golden->frames[i].match].timestamp_ns - (int64_t)golden->frames[i].timestamp_ns;
+}
+
+static int Report(diff_capture_t *golden, diff_capture_t *test, const diff_options_t *options)
+{
+  static diff_drift_t drifts[OPCODE_SLOTS];
+  uint32_t matched = 0, missing = 0, extra = 0, reordered = 0, late = 0, shown;
+
+  for(uint32_t i = 0; i < golden->count; i++)
+  {
+    diff_frame_t *frame = &golden->frames[i];
+    diff_drift_t *drift = &drifts[frame->opcode];
+    int64_t ns;
+
+    if(frame->match == UNMATCHED)
+    {
+      missing++;
+      continue;
+    }
+    matched++;
+    reordered += frame->reordered ? 1 : 0;
+    ns = Drift(golden, test, i);
+    drift->count++;
+    drift->total_ns += ns;
+    if(llabs(ns) > llabs(drift->max_ns))
+    {
+      drift->max_ns = ns;
+    }
+    if((uint64_t)llabs(ns) > options->tolerance_ns)
+    {
+      drift->over++;
+      late++;
+    }
+  }
+  for(uint32_t j = 0; j < test->count; j++)
+  {
+    extra += (test->frames[j].match == UNMATCHED) ? 1 : 0;
+  }
+
+  printf("Golden [%s]: %u frames\n", golden->path, golden->count);
+  printf("Test   [%s]: %u frames\n", test->path, test->count);
+  printf("Matched %u, missing %u, extra %u, reordered %u, outside the %llu ms tolerance %u\n", matched, missing, extra,
+         reordered, (unsigned long long)(options->tolerance_ns / 1000000), late);
+
+  shown = 0;
+  for(uint32_t i = 0; i < golden->count && missing > 0; i++)
+  {
+    if(golden->frames[i].match == UNMATCHED && shown++ < options->max_reported)
+    {
+      PrintFrame(golden, i, shown == 1 ? "Missing  " : "         ");
+    }
+  }
+  shown = 0;
+  for(uint32_t j = 0; j < test->count && extra > 0; j++)
+  {
+    if(test->frames[j].match == UNMATCHED && shown++ < options->max_reported)
+    {
+      PrintFrame(test, j, shown == 1 ? "Extra    " : "         ");
+    }
+  }
+  shown = 0;
+  for(uint32_t i = 0; i < golden->count && reordered > 0; i++)
+  {
+    if(golden->frames[i].match != UNMATCHED && golden->frames[i].reordered && shown++ < options->max_reported)
+    {
+      PrintFrame(golden, i, shown == 1 ? "Reordered" : "         ");
+    }
+  }
+  shown = 0;
+  for(uint32_t i = 0; i < golden->count && late > 0; i++)
+  {
+    if(golden->frames[i].match != UNMATCHED && (uint64_t)llabs(Drift(golden, test, i)) > options->tolerance_ns
+       && shown++ < options->max_reported)
+    {
+      PrintFrame(golden, i, shown == 1 ? "Drift    " : "         ");
+      printf("    %+.3f ms\n", (double)Drift(golden, test, i) / 1e6);
+    }
+  }
+
+  printf("Timing drift per opcode, test - golden:\n");
+  printf("  %-30s %8s %12s %12s %8s\n", "Opcode", "Frames", "Mean ms", "Max ms", "Over");
+  for(int opcode = 0; opcode < OPCODE_SLOTS; opcode++)
+  {
+    const char *name = (opcode == OPCODE_POLLING) ? "Polling" : vcCommand_GetOpCodeString(opcode);
+    char label[48];
+    if(drifts[opcode].count == 0)
+    {
+      continue;
+    }
+    snprintf(label, sizeof(label), "0x%02X %s", opcode & 0xFF, (name != NULL) ? name : "Unknown");
+    printf("  %-30s %8u %12.3f %12.3f %8u\n", label, drifts[opcode].count,
+           (double)drifts[opcode].total_ns / drifts[opcode].count / 1e6, (double)drifts[opcode].max_ns / 1e6, drifts[opcode].over);
+  }
+  return (missing == 0 && extra == 0 && reordered == 0 && late == 0) ? 0 : 1;
+}
+
+static void Usage(const char *name)
+{
+  printf("Usage: %s [options] <golden> <test>\n", name);
+  printf("  -k rx|tx      Compare one direction only\n");
+  printf("  -w ms         Match window, default %d\n", DEFAULT_WINDOW_MS);
+  printf("  -t ms         Timing tolerance of a matched frame, default %d\n", DEFAULT_TOLERANCE_MS);
+  printf("  -n count      Frames listed per kind of difference, default %d\n", DEFAULT_MAX_REPORTED);
+  printf("  -v            Verbose\n");
+}
+
+int main(int argc, char** argv)
+{
+  diff_options_t options = { -1, DEFAULT_WINDOW_MS * 1000000ULL, DEFAULT_TOLERANCE_MS * 1000000ULL, DEFAULT_MAX_REPORTED };
+  diff_capture_t golden, test;
+  int opt, result = -1;
+
+  while ((opt = getopt(argc, argv, "k:w:t:n:vh")) != -1)
+  {
+    switch(opt)
+    {
+      case 'k':
+        if(strcmp(optarg, "rx") && strcmp(optarg, "tx"))
+        {
+          fprintf(stderr, "Invalid direction [%s]\n", optarg);
+          return -1;
+        }
+        options.kind = strcmp(optarg, "rx") ? VCCAPTURE_RECORD_TX : VCCAPTURE_RECORD_RX;
+        break;
+      case 'w':
+        options.window_ns = strtoull(optarg, NULL, 0) * 1000000ULL;
+        break;
+      case 't':
+        options.tolerance_ns = strtoull(optarg, NULL, 0) * 1000000ULL;
+        break;
+      case 'n':
+        options.max_reported = strtoul(optarg, NULL, 0);
+        break;
+      case 'v':
+        gVerbose = true;
+        break;
+      case 'h':
+      default:
+        Usage(argv[0]);
+        return (opt == 'h') ? 0 : -1;
+    }
+  }
+  if(optind != argc - 2)
+  {
+    Usage(argv[0]);
+    return -1;
+  }
+
+  if(!LoadCapture(&golden, argv[optind], options.kind))
+  {
+    return -1;
+  }
+  if(!LoadCapture(&test, argv[optind + 1], options.kind))
+  {
+    FreeCapture(&golden);
+    return -1;
+  }
+  if(Compare(&golden, &test, options.window_ns))
+  {
+    result = Report(&golden, &test, &options);
+  }
+  FreeCapture(&golden);
+  FreeCapture(&test);
+  return result;
+}
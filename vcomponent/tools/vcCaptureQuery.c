@@ -0,0 +1,853 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2024 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file vcCaptureQuery.c
+ *
+ * Indexer and query tool for the capture files written by the vComponent (see vcCapture.h).
+ *
+ * The capture is memory mapped and scanned once to build an index next to it, <capture>.idx.
+ * The index holds the timestamp and the file offset of every frame, one list of frames per
+ * opcode, per initiator and per destination, and the first frame of every time bucket. Later
+ * queries map the index and only touch the pages of the capture holding the frames they return.
+ * The index is rebuilt when the capture changes.
+ *
+ * A query selects frames by opcode, initiator, destination, direction and time range. For a
+ * request opcode, the latency to the matching response (or Feature Abort) is reported, e.g.
+ *
+ *   vcCaptureQuery -o GiveDevicePowerStatus -i 4 -s 60 -e 120 soak.vcap
+ *
+ * lists every GiveDevicePowerStatus sent by logical address 4 between 60 s and 120 s, each with
+ * the time to the ReportPowerStatus that answered it, followed by the latency distribution.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "vcCapture.h"
+#include "vcCommand.h"
+
+#define INDEX_MAGIC                 "VCIX"
+#define INDEX_VERSION               1
+/* Opcodes 0x00..0xFF plus one list for polling messages, which carry no opcode */
+#define INDEX_OPCODE_SLOTS          257
+#define INDEX_OPCODE_POLLING        256
+#define INDEX_LIST_INITIATOR(la)    (INDEX_OPCODE_SLOTS + (la))
+#define INDEX_LIST_DESTINATION(la)  (INDEX_OPCODE_SLOTS + VCCAPTURE_NUM_ADDRESSES + (la))
+#define INDEX_NUM_LISTS             (INDEX_OPCODE_SLOTS + 2 * VCCAPTURE_NUM_ADDRESSES)
+#define INDEX_MAX_RECORDS           UINT32_MAX
+
+#define DEFAULT_BUCKET_MS           1000
+/* A follower has to answer within 1 s */
+#define DEFAULT_WINDOW_MS           1000
+#define ANY                         -1
+
+/* The index is a cache of the capture on the same machine, so it is stored in native byte order */
+typedef struct
+{
+  char magic[4];
+  uint32_t version;
+  uint64_t capture_size;
+  int64_t capture_mtime_ns;
+  uint64_t bucket_ns;
+  uint64_t num_records;
+  uint64_t num_buckets;
+  uint64_t num_names;
+  uint64_t list_start[INDEX_NUM_LISTS + 1];    /* Position of each list in the ids section */
+} index_header_t;
+
+typedef struct
+{
+  uint64_t timestamp_ns;
+  uint64_t offset;
+} index_entry_t;
+
+/* osd_name of a logical address from first_record onwards */
+typedef struct
+{
+  uint64_t first_record;
+  uint8_t la;
+  char name[VCCAPTURE_MAX_NAME_LENGTH];
+} index_name_t;
+
+typedef struct
+{
+  vcCapture_reader_t *capture;
+  void *map;
+  size_t map_size;
+  const index_header_t *header;
+  const index_entry_t *entries;
+  const uint32_t *ids;
+  const uint32_t *buckets;                      /* num_buckets + 1 entries */
+  const index_name_t *names;
+} index_t;
+
+typedef struct
+{
+  int opcode;
+  int initiator;
+  int destination;
+  int kind;
+  uint64_t from_ns;
+  uint64_t to_ns;
+  int response;
+  uint64_t window_ns;
+  bool count_only;
+} query_t;
+
+typedef struct
+{
+  int request;
+  int response;
+} response_t;
+
+/* Standard response of each request. A Feature Abort of the request is also accepted */
+const static response_t gResponses[] = {
+  { CEC_GIVE_DEVICE_POWER_STATUS, CEC_REPORT_POWER_STATUS },
+  { CEC_GIVE_PHYSICAL_ADDRESS, CEC_REPORT_PHYSICAL_ADDRESS },
+  { CEC_GIVE_OSD_NAME, CEC_SET_OSD_NAME },
+  { CEC_GIVE_DEVICE_VENDOR_ID, CEC_DEVICE_VENDOR_ID },
+  { CEC_GIVE_CEC_VERSION, CEC_CEC_VERSION },
+  { CEC_GIVE_DECK_STATUS, CEC_DECK_STATUS },
+  { CEC_GIVE_TUNER_DEVICE_STATUS, CEC_TUNER_DEVICE_STATUS },
+  { CEC_GIVE_SYSTEM_AUDIO_MODE_STATUS, CEC_SYSTEM_AUDIO_MODE_STATUS },
+  { CEC_SYSTEM_AUDIO_MODE_REQUEST, CEC_SET_SYSTEM_AUDIO_MODE },
+  { CEC_GIVE_DEVICE_FEATURE, CEC_REPORT_DEVICE_FEATURE },
+  { CEC_REQUEST_ACTIVE_SOURCE, CEC_ACTIVE_SOURCE },
+  { CEC_REQUEST_ARC_INITIATION, CEC_INITIATE_ARC },
+  { CEC_REQUEST_ARC_TERMINATION, CEC_TERMINATE_ARC }
+};
+
+static bool gVerbose = false;
+
+/* vcCapture logs through UT_logPrefix(). Errors are always shown, the rest with -v */
+void UT_logPrefix(const char *file, int line, const char *prefix, const char *format, ...)
+{
+  va_list args;
+
+  if(!gVerbose && strstr(prefix, "ERROR") == NULL)
+  {
+    return;
+  }
+  fprintf(stderr, "%s", prefix);
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fprintf(stderr, "\n");
+}
+
+static int FrameOpcode(const vcCapture_record_t *record)
+{
+  return (record->len > 1) ? record->frame[1] : INDEX_OPCODE_POLLING;
+}
+
+static const char* OpcodeName(int opcode)
+{
+  const char *name;
+
+  if(opcode == INDEX_OPCODE_POLLING)
+  {
+    return "Polling";
+  }
+  name = vcCommand_GetOpCodeString(opcode);
+  return (name != NULL) ? name : "Unknown";
+}
+
+static int ParseOpcode(const char *str)
+{
+  char *end;
+  long value = vcCommand_GetOpCode((char *)str);
+
+  if(value != CEC_OPCODE_UNKNOWN)
+  {
+    return (int)value;
+  }
+  value = strtol(str, &end, 0);
+  if(end == str || *end != '\0' || value < 0 || value > 0xFF)
+  {
+    return CEC_OPCODE_UNKNOWN;
+  }
+  return (int)value;
+}
+
+static int ParseAddress(const char *str)
+{
+  char *end;
+  long value = strtol(str, &end, 0);
+
+  if(end == str || *end != '\0' || value < 0 || value >= VCCAPTURE_NUM_ADDRESSES)
+  {
+    return CEC_OPCODE_UNKNOWN;
+  }
+  return (int)value;
+}
+
+static int64_t MtimeNs(const struct stat *st)
+{
+  return ((int64_t)st->st_mtim.tv_sec * 1000000000LL) + st->st_mtim.tv_nsec;
+}
+
+static size_t Align8(size_t size)
+{
+  return (size + 7) & ~(size_t)7;
+}
+
+/* Offsets of the sections following the header */
+static size_t IndexLayout(const index_header_t *header, size_t *entries, size_t *ids, size_t *buckets, size_t *names)
+{
+  *entries = Align8(sizeof(index_header_t));
+  *ids = *entries + header->num_records * sizeof(index_entry_t);
+  *buckets = Align8(*ids + header->list_start[INDEX_NUM_LISTS] * sizeof(uint32_t));
+  *names = Align8(*buckets + (header->num_buckets + 1) * sizeof(uint32_t));
+  return *names + header->num_names * sizeof(index_name_t);
+}
+
+static void IndexSections(index_t *index)
+{
+  size_t entries, ids, buckets, names;
+  const uint8_t *base = (const uint8_t *)index->map;
+
+  IndexLayout(index->header, &entries, &ids, &buckets, &names);
+  index->entries = (const index_entry_t *)(base + entries);
+  index->ids = (const uint32_t *)(base + ids);
+  index->buckets = (const uint32_t *)(base + buckets);
+  index->names = (const index_name_t *)(base + names);
+}
+
+/* First pass, sizes every section of the index */
+static void CountRecords(vcCapture_reader_t *capture, index_header_t *header)
+{
+  vcCapture_record_t record;
+  char names[VCCAPTURE_NUM_ADDRESSES][VCCAPTURE_MAX_NAME_LENGTH] = {{0}};
+  uint64_t counts[INDEX_NUM_LISTS] = {0};
+  uint64_t last_ns = 0;
+
+  while(vcCapture_Next(capture, &record))
+  {
+    uint8_t la = record.frame[0] >> 4;
+    if(header->num_records == INDEX_MAX_RECORDS)
+    {
+      fprintf(stderr, "More than %u frames, only the first ones are indexed\n", INDEX_MAX_RECORDS);
+      break;
+    }
+    counts[FrameOpcode(&record)]++;
+    counts[INDEX_LIST_INITIATOR(la)]++;
+    counts[INDEX_LIST_DESTINATION(record.frame[0] & 0x0F)]++;
+    if(strcmp(names[la], record.source_name) != 0)
+    {
+      strcpy(names[la], record.source_name);
+      header->num_names++;
+    }
+    last_ns = record.timestamp_ns;
+    header->num_records++;
+  }
+  header->num_buckets = last_ns / header->bucket_ns + 1;
+  header->list_start[0] = 0;
+  for(int i = 0; i < INDEX_NUM_LISTS; i++)
+  {
+    header->list_start[i + 1] = header->list_start[i] + counts[i];
+  }
+}
+
+/* Second pass, fills the sections of the mapped index. cursors start as a copy of list_start */
+static void FillIndex(vcCapture_reader_t *capture, index_t *index, uint64_t *cursors)
+{
+  vcCapture_record_t record;
+  char names[VCCAPTURE_NUM_ADDRESSES][VCCAPTURE_MAX_NAME_LENGTH] = {{0}};
+  index_entry_t *entries = (index_entry_t *)index->entries;
+  uint32_t *ids = (uint32_t *)index->ids;
+  uint32_t *buckets = (uint32_t *)index->buckets;
+  index_name_t *name = (index_name_t *)index->names;
+  uint64_t bucket = 0;
+
+  for(uint64_t id = 0; id < index->header->num_records && vcCapture_Next(capture, &record); id++)
+  {
+    uint8_t la = record.frame[0] >> 4;
+
+    entries[id].timestamp_ns = record.timestamp_ns;
+    entries[id].offset = record.offset;
+    ids[cursors[FrameOpcode(&record)]++] = (uint32_t)id;
+    ids[cursors[INDEX_LIST_INITIATOR(la)]++] = (uint32_t)id;
+    ids[cursors[INDEX_LIST_DESTINATION(record.frame[0] & 0x0F)]++] = (uint32_t)id;
+    while(bucket * index->header->bucket_ns <= record.timestamp_ns && bucket < index->header->num_buckets)
+    {
+      buckets[bucket++] = (uint32_t)id;
+    }
+    if(strcmp(names[la], record.source_name) != 0)
+    {
+      strcpy(names[la], record.source_name);
+      name->first_record = id;
+      name->la = la;
+      strcpy(name->name, record.source_name);
+      name++;
+    }
+  }
+  while(bucket <= index->header->num_buckets)
+  {
+    buckets[bucket++] = (uint32_t)index->header->num_records;
+  }
+}
+
+/* Builds the index in a temporary file, then renames it, so a reader never maps a half written index */
+static bool BuildIndex(index_t *index, const char *index_path, const struct stat *st, uint64_t bucket_ns)
+{
+  index_header_t header;
+  char tmp_path[PATH_MAX + 8];
+  uint64_t *cursors;
+  size_t size, entries, ids, buckets, names;
+  void *map;
+  int fd;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, INDEX_MAGIC, 4);
+  header.version = INDEX_VERSION;
+  header.capture_size = st->st_size;
+  header.capture_mtime_ns = MtimeNs(st);
+  header.bucket_ns = bucket_ns;
+  CountRecords(index->capture, &header);
+  size = IndexLayout(&header, &entries, &ids, &buckets, &names);
+
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", index_path);
+  fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0)
+  {
+    fprintf(stderr, "Failed to create [%s]\n", tmp_path);
+    return false;
+  }
+  if(ftruncate(fd, size) != 0)
+  {
+    fprintf(stderr, "Failed to size [%s] to %zu bytes\n", tmp_path, size);
+    close(fd);
+    unlink(tmp_path);
+    return false;
+  }
+  map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED)
+  {
+    fprintf(stderr, "Failed to map [%s]\n", tmp_path);
+    unlink(tmp_path);
+    return false;
+  }
+  memcpy(map, &header, sizeof(header));
+  index->map = map;
+  index->map_size = size;
+  index->header = (const index_header_t *)map;
+  IndexSections(index);
+
+  cursors = (uint64_t *)malloc(sizeof(header.list_start));
+  if(cursors == NULL)
+  {
+    fprintf(stderr, "Out of memory\n");
+    munmap(map, size);
+    unlink(tmp_path);
+    return false;
+  }
+  memcpy(cursors, header.list_start, sizeof(header.list_start));
+  vcCapture_Rewind(index->capture);
+  FillIndex(index->capture, index, cursors);
+  free(cursors);
+
+  msync(map, size, MS_SYNC);
+  if(rename(tmp_path, index_path) != 0)
+  {
+    fprintf(stderr, "Failed to rename [%s] to [%s]\n", tmp_path, index_path);
+    unlink(tmp_path);
+  }
+  if(gVerbose)
+  {
+    fprintf(stderr, "Indexed %llu frames into [%s], %zu bytes\n", (unsigned long long)header.num_records, index_path, size);
+  }
+  return true;
+}
+
+/* Maps the index of the capture, building it if it is missing or out of date */
+static bool OpenIndex(index_t *index, const char *capture_path, bool rebuild, uint64_t bucket_ns)
+{
+  char index_path[PATH_MAX];
+  struct stat st, index_st;
+  void *map;
+  int fd;
+
+  memset(index, 0, sizeof(index_t));
+  if(stat(capture_path, &st) != 0)
+  {
+    fprintf(stderr, "Failed to open [%s]\n", capture_path);
+    return false;
+  }
+  index->capture = vcCapture_OpenReader(capture_path);
+  if(index->capture == NULL)
+  {
+    return false;
+  }
+  snprintf(index_path, sizeof(index_path), "%s.idx", capture_path);
+
+  fd = rebuild ? -1 : open(index_path, O_RDONLY);
+  if(fd >= 0)
+  {
+    if(fstat(fd, &index_st) == 0 && index_st.st_size >= (off_t)sizeof(index_header_t))
+    {
+      map = mmap(NULL, index_st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if(map != MAP_FAILED)
+      {
+        const index_header_t *header = (const index_header_t *)map;
+        size_t entries, ids, buckets, names;
+        if(memcmp(header->magic, INDEX_MAGIC, 4) == 0 && header->version == INDEX_VERSION
+           && header->capture_size == (uint64_t)st.st_size && header->capture_mtime_ns == MtimeNs(&st)
+           && header->bucket_ns == bucket_ns
+           && IndexLayout(header, &entries, &ids, &buckets, &names) == (size_t)index_st.st_size)
+        {
+          close(fd);
+          index->map = map;
+          index->map_size = index_st.st_size;
+          index->header = header;
+          IndexSections(index);
+          return true;
+        }
+        munmap(map, index_st.st_size);
+      }
+    }
+    close(fd);
+  }
+  return BuildIndex(index, index_path, &st, bucket_ns);
+}
+
+static void CloseIndex(index_t *index)
+{
+  if(index->map != NULL)
+  {
+    munmap(index->map, index->map_size);
+  }
+  vcCapture_CloseReader(index->capture);
+}
+
+static uint64_t ListLength(const index_t *index, int list)
+{
+  return index->header->list_start[list + 1] - index->header->list_start[list];
+}
+
+/* list is NULL to walk every frame in time order */
+static uint64_t RecordAt(const uint32_t *list, uint64_t k)
+{
+  return (list != NULL) ? list[k] : k;
+}
+
+/* First position in the list with a timestamp >= timestamp_ns */
+static uint64_t LowerBound(const index_t *index, const uint32_t *list, uint64_t lo, uint64_t hi, uint64_t timestamp_ns)
+{
+  while(lo < hi)
+  {
+    uint64_t mid = lo + (hi - lo) / 2;
+    if(index->entries[RecordAt(list, mid)].timestamp_ns < timestamp_ns)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static uint64_t FirstRecordAt(const index_t *index, uint64_t timestamp_ns)
+{
+  uint64_t bucket = timestamp_ns / index->header->bucket_ns;
+
+  if(bucket >= index->header->num_buckets)
+  {
+    return index->header->num_records;
+  }
+  //The bucket narrows the search to the frames of a single bucket
+  return LowerBound(index, NULL, index->buckets[bucket], index->buckets[bucket + 1], timestamp_ns);
+}
+
+static const char* NameAt(const index_t *index, uint8_t la, uint64_t id)
+{
+  const char *name = "";
+
+  for(uint64_t i = 0; i < index->header->num_names && index->names[i].first_record <= id; i++)
+  {
+    if(index->names[i].la == la)
+    {
+      name = index->names[i].name;
+    }
+  }
+  return name;
+}
+
+static bool ReadRecord(const index_t *index, uint64_t id, vcCapture_record_t *record)
+{
+  if(!vcCapture_ReadAt(index->capture, index->entries[id].offset, record))
+  {
+    return false;
+  }
+  record->timestamp_ns = index->entries[id].timestamp_ns;
+  return true;
+}
+
+/* Earliest frame in the response list answering the request, or -1 */
+static int64_t FindResponse(const index_t *index, uint64_t request_id, const vcCapture_record_t *request, int opcode, uint64_t window_ns)
+{
+  const uint32_t *list = &index->ids[index->header->list_start[opcode]];
+  uint64_t count = ListLength(index, opcode);
+  uint8_t initiator = request->frame[0] >> 4;
+  uint8_t destination = request->frame[0] & 0x0F;
+  vcCapture_record_t record;
+
+  for(uint64_t k = LowerBound(index, list, 0, count, request->timestamp_ns); k < count; k++)
+  {
+    uint64_t id = list[k];
+    if(index->entries[id].timestamp_ns > request->timestamp_ns + window_ns)
+    {
+      break;
+    }
+    if(id <= request_id || !ReadRecord(index, id, &record))
+    {
+      continue;
+    }
+    //A broadcast request, e.g. RequestActiveSource, can be answered by any device
+    if(destination != 0x0F && (record.frame[0] >> 4) != destination)
+    {
+      continue;
+    }
+    if((record.frame[0] & 0x0F) != initiator && (record.frame[0] & 0x0F) != 0x0F)
+    {
+      continue;
+    }
+    if(opcode == CEC_FEATURE_ABORT && (record.len < 3 || record.frame[2] != request->frame[1]))
+    {
+      continue;
+    }
+    return (int64_t)id;
+  }
+  return -1;
+}
+
+static bool Matches(const query_t *query, const vcCapture_record_t *record)
+{
+  if(query->opcode != ANY && FrameOpcode(record) != query->opcode)
+  {
+    return false;
+  }
+  if(query->initiator != ANY && (record->frame[0] >> 4) != query->initiator)
+  {
+    return false;
+  }
+  if(query->destination != ANY && (record->frame[0] & 0x0F) != query->destination)
+  {
+    return false;
+  }
+  return (query->kind == ANY || (int)record->kind == query->kind);
+}
+
+static void PrintRecord(const index_t *index, uint64_t id, const vcCapture_record_t *record)
+{
+  printf("%14.6f %s %2u -> %2u %-16s %-26s", (double)record->timestamp_ns / 1e9,
+         (record->kind == VCCAPTURE_RECORD_RX) ? "RX" : "TX", record->frame[0] >> 4, record->frame[0] & 0x0F,
+         NameAt(index, record->frame[0] >> 4, id), OpcodeName(FrameOpcode(record)));
+  for(uint32_t i = 0; i < record->len; i++)
+  {
+    printf(" %02X", record->frame[i]);
+  }
+}
+
+static int CompareLatency(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int RunQuery(const index_t *index, const query_t *query)
+{
+  const uint32_t *list = NULL;
+  uint64_t lo = 0, hi = index->header->num_records, count = hi;
+  uint64_t matched = 0, answered = 0, aborted = 0;
+  uint64_t *latencies = NULL;
+  vcCapture_record_t record, response;
+
+  //Walk the shortest list that every match has to be in
+  if(query->opcode != ANY && ListLength(index, query->opcode) < count)
+  {
+    count = ListLength(index, query->opcode);
+    list = &index->ids[index->header->list_start[query->opcode]];
+  }
+  if(query->initiator != ANY && ListLength(index, INDEX_LIST_INITIATOR(query->initiator)) < count)
+  {
+    count = ListLength(index, INDEX_LIST_INITIATOR(query->initiator));
+    list = &index->ids[index->header->list_start[INDEX_LIST_INITIATOR(query->initiator)]];
+  }
+  if(query->destination != ANY && ListLength(index, INDEX_LIST_DESTINATION(query->destination)) < count)
+  {
+    count = ListLength(index, INDEX_LIST_DESTINATION(query->destination));
+    list = &index->ids[index->header->list_start[INDEX_LIST_DESTINATION(query->destination)]];
+  }
+  if(list != NULL)
+  {
+    hi = count;
+    lo = LowerBound(index, list, 0, hi, query->from_ns);
+  }
+  else
+  {
+    lo = FirstRecordAt(index, query->from_ns);
+  }
+  if(query->response != ANY)
+  {
+    latencies = (uint64_t *)malloc(sizeof(uint64_t) * ((hi > lo) ? hi - lo : 1));
+    if(latencies == NULL)
+    {
+      fprintf(stderr, "Out of memory\n");
+      return -1;
+    }
+  }
+
+  for(uint64_t k = lo; k < hi; k++)
+  {
+    uint64_t id = RecordAt(list, k);
+    int64_t response_id = -1;
+
+    if(index->entries[id].timestamp_ns > query->to_ns)
+    {
+      break;
+    }
+    if(!ReadRecord(index, id, &record) || !Matches(query, &record))
+    {
+      continue;
+    }
+    matched++;
+    if(query->response != ANY)
+    {
+      int64_t abort_id = FindResponse(index, id, &record, CEC_FEATURE_ABORT, query->window_ns);
+      response_id = FindResponse(index, id, &record, query->response, query->window_ns);
+      if(abort_id >= 0 && (response_id < 0 || abort_id < response_id))
+      {
+        response_id = abort_id;
+        aborted++;
+      }
+      if(response_id >= 0)
+      {
+        latencies[answered++] = index->entries[response_id].timestamp_ns - record.timestamp_ns;
+      }
+    }
+    if(query->count_only)
+    {
+      continue;
+    }
+    PrintRecord(index, id, &record);
+    if(query->response != ANY)
+    {
+      if(response_id >= 0 && ReadRecord(index, response_id, &response))
+      {
+        printf("  -> %s after %.3f ms", OpcodeName(FrameOpcode(&response)),
+               (double)(response.timestamp_ns - record.timestamp_ns) / 1e6);
+      }
+      else
+      {
+        printf("  -> no response");
+      }
+    }
+    printf("\n");
+  }
+
+  printf("Matched %llu frames\n", (unsigned long long)matched);
+  if(query->response != ANY)
+  {
+    printf("Answered by %s: %llu, Feature Abort: %llu, no response within %llu ms: %llu\n",
+           OpcodeName(query->response), (unsigned long long)(answered - aborted), (unsigned long long)aborted,
+           (unsigned long long)(query->window_ns / 1000000), (unsigned long long)(matched - answered));
+    if(answered > 0)
+    {
+      uint64_t total = 0;
+      qsort(latencies, answered, sizeof(uint64_t), CompareLatency);
+      for(uint64_t i = 0; i < answered; i++)
+      {
+        total += latencies[i];
+      }
+      printf("Latency: min %.3f ms, mean %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+             latencies[0] / 1e6, (double)total / answered / 1e6, latencies[answered / 2] / 1e6,
+             latencies[(answered * 95) / 100] / 1e6, latencies[(answered * 99) / 100] / 1e6, latencies[answered - 1] / 1e6);
+    }
+    free(latencies);
+  }
+  return 0;
+}
+
+static void PrintSummary(const index_t *index)
+{
+  uint64_t records = index->header->num_records;
+  uint64_t start_ns = vcCapture_GetStartTime(index->capture);
+
+  printf("Capture started at %llu.%09llu (CLOCK_REALTIME)\n", (unsigned long long)(start_ns / 1000000000ULL),
+         (unsigned long long)(start_ns % 1000000000ULL));
+  printf("Frames         : %llu\n", (unsigned long long)records);
+  if(records == 0)
+  {
+    return;
+  }
+  printf("Duration       : %.3f s\n", (double)index->entries[records - 1].timestamp_ns / 1e9);
+  printf("By opcode:\n");
+  for(int opcode = 0; opcode < INDEX_OPCODE_SLOTS; opcode++)
+  {
+    if(ListLength(index, opcode) > 0)
+    {
+      printf("  0x%02X %-26s %llu\n", opcode & 0xFF, OpcodeName(opcode), (unsigned long long)ListLength(index, opcode));
+    }
+  }
+  printf("By initiator:\n");
+  for(int la = 0; la < VCCAPTURE_NUM_ADDRESSES; la++)
+  {
+    if(ListLength(index, INDEX_LIST_INITIATOR(la)) > 0)
+    {
+      printf("  %2d   %-26s %llu\n", la, NameAt(index, la, records), (unsigned long long)ListLength(index, INDEX_LIST_INITIATOR(la)));
+    }
+  }
+}
+
+static void Usage(const char *name)
+{
+  printf("Usage: %s [options] <capture>\n", name);
+  printf("  -o opcode     Opcode name, e.g. GiveDevicePowerStatus, or number\n");
+  printf("  -i address    Initiator logical address\n");
+  printf("  -d address    Destination logical address\n");
+  printf("  -k rx|tx      Direction\n");
+  printf("  -s seconds    Start of the time range, from the start of the capture\n");
+  printf("  -e seconds    End of the time range\n");
+  printf("  -r opcode     Response to match, 'none' to disable. Defaults to the standard response of -o\n");
+  printf("  -w ms         Response window, default %d\n", DEFAULT_WINDOW_MS);
+  printf("  -c            Print the counts and latencies only\n");
+  printf("  -S            Print a summary of the capture\n");
+  printf("  -b ms         Time bucket of the index, default %d\n", DEFAULT_BUCKET_MS);
+  printf("  -f            Rebuild the index\n");
+  printf("  -v            Verbose\n");
+}
+
+int main(int argc, char** argv)
+{
+  query_t query = { ANY, ANY, ANY, ANY, 0, UINT64_MAX, ANY, DEFAULT_WINDOW_MS * 1000000ULL, false };
+  uint64_t bucket_ns = DEFAULT_BUCKET_MS * 1000000ULL;
+  bool rebuild = false, summary = false, response_set = false;
+  index_t index;
+  int opt, result;
+
+  while ((opt = getopt(argc, argv, "o:i:d:k:s:e:r:w:cSb:fvh")) != -1)
+  {
+    switch(opt)
+    {
+      case 'o':
+        query.opcode = ParseOpcode(optarg);
+        if(query.opcode == CEC_OPCODE_UNKNOWN)
+        {
+          fprintf(stderr, "Unknown opcode [%s]\n", optarg);
+          return -1;
+        }
+        break;
+      case 'i':
+      case 'd':
+        if(ParseAddress(optarg) == CEC_OPCODE_UNKNOWN)
+        {
+          fprintf(stderr, "Invalid logical address [%s]\n", optarg);
+          return -1;
+        }
+        *((opt == 'i') ? &query.initiator : &query.destination) = ParseAddress(optarg);
+        break;
+      case 'k':
+        if(strcmp(optarg, "rx") && strcmp(optarg, "tx"))
+        {
+          fprintf(stderr, "Invalid direction [%s]\n", optarg);
+          return -1;
+        }
+        query.kind = strcmp(optarg, "rx") ? VCCAPTURE_RECORD_TX : VCCAPTURE_RECORD_RX;
+        break;
+      case 's':
+        query.from_ns = (uint64_t)(strtod(optarg, NULL) * 1e9);
+        break;
+      case 'e':
+        query.to_ns = (uint64_t)(strtod(optarg, NULL) * 1e9);
+        break;
+      case 'r':
+        response_set = true;
+        query.response = strcmp(optarg, "none") ? ParseOpcode(optarg) : ANY;
+        if(query.response == CEC_OPCODE_UNKNOWN)
+        {
+          fprintf(stderr, "Unknown opcode [%s]\n", optarg);
+          return -1;
+        }
+        break;
+      case 'w':
+        query.window_ns = strtoull(optarg, NULL, 0) * 1000000ULL;
+        break;
+      case 'c':
+        query.count_only = true;
+        break;
+      case 'S':
+        summary = true;
+        break;
+      case 'b':
+        bucket_ns = strtoull(optarg, NULL, 0) * 1000000ULL;
+        if(bucket_ns == 0)
+        {
+          fprintf(stderr, "Invalid time bucket [%s]\n", optarg);
+          return -1;
+        }
+        break;
+      case 'f':
+        rebuild = true;
+        break;
+      case 'v':
+        gVerbose = true;
+        break;
+      case 'h':
+      default:
+        Usage(argv[0]);
+        return (opt == 'h') ? 0 : -1;
+    }
+  }
+  if(optind != argc - 1)
+  {
+    Usage(argv[0]);
+    return -1;
+  }
+  if(!response_set && query.opcode != ANY)
+  {
+    for(size_t i = 0; i < COUNT_OF(gResponses); i++)
+    {
+      if(gResponses[i].request == query.opcode)
+      {
+        query.response = gResponses[i].response;
+      }
+    }
+  }
+
+  if(!OpenIndex(&index, argv[optind], rebuild, bucket_ns))
+  {
+    return -1;
+  }
+  result = summary ? (PrintSummary(&index), 0) : RunQuery(&index, &query);
+  CloseIndex(&index);
+  return result;
+}